@@ -1,61 +1,397 @@
+/*
+ * Microbenchmarks for our MinHeap implementation.
+ *
+ * Times both heap builds, insert, extractMin, changePriority (decreases
+ * only) and a Dijkstra-like mix of all three, on sorted, reversed, random
+ * and duplicate-heavy priorities, and prints one CSV row per benchmark,
+ * distribution and size. plotter.py reads the CSV directly.
+ *
+ * Each sample times 'reps' back-to-back runs of a benchmark on heaps that
+ * were prepared beforehand, with reps chosen so that a sample takes at
+ * least MIN_SAMPLE_NS; that keeps clock overhead out of the small sizes.
+ * Warmup samples are thrown away, samples outside Tukey's fences
+ * (1.5 IQR beyond the quartiles) are rejected as outliers, and the
+ * mean of the rest is reported with a 95% confidence interval.
+ *
+ *  ---------------------------------------------------------------------------
+ *   Compile:
+ *   gcc -Wall -Werror -O2 minheap.c build_tester.c -o build_tester -lm
+ *
+ *   Run:
+ *   ./build_tester > heap_bench.csv
+ *   python3 plotter.py heap_bench.csv
+ *
+ *   Options:
+ *   -m size      largest heap size (sizes are powers of 10 up to it)
+ *   -s samples   timed samples per row
+ *   -w warmup    untimed warmup samples per row
+ *   -b name      only run benchmark 'name'
+ *  ---------------------------------------------------------------------------
+ */
+
+#include <math.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <time.h>
+#include <unistd.h>
+
 #include "minheap.h"
 
-void generateWorstCaseInput(int* arr, int size) {
-    for (int i = 0; i < size; i++) {
-        arr[i] = size - i;
+#define MIN_SAMPLE_NS 200000.0  // calibrate reps so a sample takes this long
+#define MAX_REPS 4096
+#define MIX_DEGREE 4            // heap operations per extractMin in "mix"
+#define MAX_WEIGHT 1024         // "mix" edge weights are priorities mod this
+#define MAX_DUPLICATE 16        // "duplicates" priorities are 0..15
+#define NUM_DISTRIBUTIONS 4
+
+const char* distributionNames[NUM_DISTRIBUTIONS] = {"sorted", "reversed",
+                                                    "random", "duplicates"};
+
+/*
+ * Inputs of one benchmark run and the heaps prepared for it.
+ */
+typedef struct run
+{
+  int size;        // number of priorities
+  int* values;     // the priorities
+  int* picks;      // random numbers for choosing heap indices
+  int reps;        // runs per sample
+  MinHeap** heaps; // one heap per rep, made by the benchmark's setup
+} Run;
+
+/*
+ * A benchmark: 'setup' prepares heaps[rep] (untimed), 'work' is timed, and
+ * heaps[rep] is deleted afterwards. 'setup' may be NULL if 'work' makes the
+ * heap itself.
+ */
+typedef struct benchmark
+{
+  const char* name;
+  void (*setup)(Run* run, int rep);
+  void (*work)(Run* run, int rep);
+} Benchmark;
+
+/*
+ * Returns the next pseudo-random 64-bit value from 'state' (splitmix64).
+ */
+uint64_t nextRandom(uint64_t* state)
+{
+  uint64_t z = (*state += 0x9e3779b97f4a7c15ull);
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+  return z ^ (z >> 31);
+}
+
+/*
+ * Fills 'values' with 'size' priorities drawn from distribution number
+ * 'distribution', and 'picks' with 'size' random non-negative ints.
+ */
+void generateInput(int* values, int* picks, int size, int distribution)
+{
+  uint64_t state = 42;
+  for (int i = 0; i < size; i++)
+  {
+    switch (distribution)
+    {
+      case 0:
+        values[i] = i;
+        break;
+      case 1:
+        values[i] = size - i;
+        break;
+      case 2:
+        values[i] = (int)(nextRandom(&state) % (uint64_t)size);
+        break;
+      default:
+        values[i] = (int)(nextRandom(&state) % MAX_DUPLICATE);
+    }
+    picks[i] = (int)(nextRandom(&state) >> 33);
+  }
+}
+
+/*
+ * Returns the current time of the monotonic clock in nanoseconds.
+ */
+double nowNanos(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+/***** Benchmarks *********************************************************/
+
+void setupEmpty(Run* run, int rep)
+{
+  run->heaps[rep] = newHeap(run->size);
+}
+
+void setupBuilt(Run* run, int rep)
+{
+  run->heaps[rep] = buildHeap_Sajad(run->values, run->size);
+}
+
+void workBuildSajad(Run* run, int rep)
+{
+  run->heaps[rep] = buildHeap_Sajad(run->values, run->size);
+}
+
+void workBuildElaheh(Run* run, int rep)
+{
+  run->heaps[rep] = buildHeap_Elaheh(run->values, run->size);
+}
+
+void workInsert(Run* run, int rep)
+{
+  MinHeap* heap = run->heaps[rep];
+  for (int i = 0; i < run->size; i++)
+    insert(heap, run->values[i], i);
+}
+
+void workExtract(Run* run, int rep)
+{
+  MinHeap* heap = run->heaps[rep];
+  while (heap->size > 0)
+    extractMin(heap);
+}
+
+void workDecrease(Run* run, int rep)
+{
+  MinHeap* heap = run->heaps[rep];
+  for (int i = 0; i < run->size; i++)
+  {
+    int index = ROOT_INDEX + run->picks[i] % heap->size;
+    int amount = 1 + run->picks[i] % MAX_DUPLICATE;
+    changePriority(heap, index, heap->arr[index].priority - amount);
+  }
+}
+
+/*
+ * Dijkstra's algorithm without the graph: each extracted node "relaxes"
+ * MIX_DEGREE edges whose weights come from the input priorities. A relaxed
+ * edge either reaches a new ID, which is inserted, or lowers the priority of
+ * a random queued node if that is an improvement. Every ID is eventually
+ * inserted and extracted once.
+ */
+void workMix(Run* run, int rep)
+{
+  MinHeap* heap = run->heaps[rep];
+  int size = run->size;
+  int nextId = 1;
+  int edge = 0;
+  insert(heap, 0, 0);
+  while (heap->size > 0)
+  {
+    HeapNode node = extractMin(heap);
+    for (int k = 0; k < MIX_DEGREE; k++)
+    {
+      int priority = node.priority + run->values[edge] % MAX_WEIGHT;
+      int pick = run->picks[edge];
+      edge = edge + 1 < size ? edge + 1 : 0;
+      if (nextId < size && (heap->size == 0 || pick % 2 == 0))
+      {
+        insert(heap, priority, nextId++);
+      }
+      else if (heap->size > 0)
+      {
+        int index = ROOT_INDEX + pick % heap->size;
+        if (priority < heap->arr[index].priority)
+          changePriority(heap, index, priority);
+      }
     }
+  }
 }
 
-double measureTime(MinHeap* (*buildHeapFunc)(int[], int), int* arr, int size) {
-    clock_t start, end;
-    double cpu_time_used;
+#define NUM_BENCHMARKS 6
 
-    start = clock();
-    MinHeap* heap = buildHeapFunc(arr, size);
-    end = clock();
+Benchmark benchmarks[NUM_BENCHMARKS] = {
+    {"build_sajad", NULL, workBuildSajad},
+    {"build_elaheh", NULL, workBuildElaheh},
+    {"insert", setupEmpty, workInsert},
+    {"extract_min", setupBuilt, workExtract},
+    {"decrease_priority", setupBuilt, workDecrease},
+    {"dijkstra_mix", setupEmpty, workMix},
+};
 
-    cpu_time_used = ((double) (end - start)) / CLOCKS_PER_SEC;
+/***** Measurement ********************************************************/
 
-    // Free the heap after use
-    deleteHeap(heap);
+/*
+ * Returns the wall time in nanoseconds of one sample: run->reps runs of
+ * 'bench'.
+ */
+double takeSample(Benchmark* bench, Run* run)
+{
+  for (int rep = 0; rep < run->reps; rep++)
+  {
+    run->heaps[rep] = NULL;
+    if (bench->setup)
+      bench->setup(run, rep);
+  }
+  double start = nowNanos();
+  for (int rep = 0; rep < run->reps; rep++)
+    bench->work(run, rep);
+  double elapsed = nowNanos() - start;
+  for (int rep = 0; rep < run->reps; rep++)
+    if (run->heaps[rep])
+      deleteHeap(run->heaps[rep]);
+  return elapsed;
+}
 
-    return cpu_time_used;
+int compareSamples(const void* a, const void* b)
+{
+  double x = *(const double*)a;
+  double y = *(const double*)b;
+  return (x > y) - (x < y);
 }
 
-int main() {
-    int sizes[] = {10, 100, 1000, 5000};
-    // int sizes[] = {10, 100, 1000, 5000, 10000, 50000, 100000, 500000, 1000000}; 
-    int numSizes = sizeof(sizes) / sizeof(sizes[0]);
-    double times_Sajad[numSizes];
-    double times_Elaheh[numSizes];
+/*
+ * Returns the 'q'-quantile of the 'count' sorted samples, interpolating
+ * between neighbours.
+ */
+double quantile(double* sorted, int count, double q)
+{
+  double at = q * (count - 1);
+  int below = (int)at;
+  if (below + 1 >= count)
+    return sorted[count - 1];
+  return sorted[below] + (at - below) * (sorted[below + 1] - sorted[below]);
+}
 
-    for (int i = 0; i < numSizes; i++) {
-        int size = sizes[i];
-        int* arr = (int*)malloc(size * sizeof(int));
-        generateWorstCaseInput(arr, size);
+/*
+ * Returns the two-sided 95% critical value of Student's t distribution
+ * with 'df' degrees of freedom.
+ */
+double studentT95(int df)
+{
+  static const double table[] = {
+      12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306, 2.262, 2.228,
+      2.201,  2.179, 2.160, 2.145, 2.131, 2.120, 2.110, 2.101, 2.093, 2.086,
+      2.080,  2.074, 2.069, 2.064, 2.060, 2.056, 2.052, 2.048, 2.045, 2.042};
+  if (df < 1)
+    return NAN;
+  if (df <= 30)
+    return table[df - 1];
+  return df <= 60 ? 2.000 : df <= 120 ? 1.980 : 1.960;
+}
 
-        double total_time_Sajad = 0.0;
-        double total_time_Elaheh = 0.0;
+/*
+ * Runs 'bench' on 'run' and prints its CSV row. 'samples' has room for
+ * 'numSamples' times.
+ */
+void measure(Benchmark* bench, Run* run, const char* distribution,
+             double* samples, int numSamples, int numWarmup)
+{
+  // calibrate: double reps until one sample is long enough to time well
+  run->reps = 1;
+  while (takeSample(bench, run) < MIN_SAMPLE_NS && run->reps < MAX_REPS)
+    run->reps *= 2;
 
-        for (int j = 0; j < 100; j++) {
-            total_time_Sajad += measureTime(buildHeap_Sajad, arr, size);
-            total_time_Elaheh += measureTime(buildHeap_Elaheh, arr, size);
-        }
+  for (int i = 0; i < numWarmup; i++)
+    takeSample(bench, run);
+  for (int i = 0; i < numSamples; i++)
+    samples[i] = takeSample(bench, run) / run->reps;
+  qsort(samples, numSamples, sizeof(double), compareSamples);
 
-        times_Sajad[i] = total_time_Sajad / 100;
-        times_Elaheh[i] = total_time_Elaheh / 100;
+  double q1 = quantile(samples, numSamples, 0.25);
+  double q3 = quantile(samples, numSamples, 0.75);
+  double low = q1 - 1.5 * (q3 - q1);
+  double high = q3 + 1.5 * (q3 - q1);
+  int kept = 0;
+  double sum = 0;
+  for (int i = 0; i < numSamples; i++)
+  {
+    if (samples[i] >= low && samples[i] <= high)
+    {
+      kept++;
+      sum += samples[i];
+    }
+  }
+  double mean = sum / kept;
+  double squares = 0;
+  for (int i = 0; i < numSamples; i++)
+    if (samples[i] >= low && samples[i] <= high)
+      squares += (samples[i] - mean) * (samples[i] - mean);
+  double ci = kept > 1 ? studentT95(kept - 1) * sqrt(squares / (kept - 1)) /
+                             sqrt(kept)
+                       : 0;
 
-        free(arr);
+  printf("%s,%s,%d,%d,%d,%d,%.9f,%.9f,%.9f,%.9f,%.3f\n", bench->name,
+         distribution, run->size, run->reps, numSamples, numSamples - kept,
+         mean / 1e9, ci / 1e9, quantile(samples, numSamples, 0.5) / 1e9,
+         samples[0] / 1e9, mean / run->size);
+  fflush(stdout);
+}
+
+int main(int argc, char* argv[])
+{
+  int maxSize = 100000;
+  int numSamples = 30;
+  int numWarmup = 5;
+  const char* only = NULL;
+
+  int option;
+  while ((option = getopt(argc, argv, "m:s:w:b:")) != -1)
+  {
+    switch (option)
+    {
+      case 'm':
+        maxSize = atoi(optarg);
+        break;
+      case 's':
+        numSamples = atoi(optarg);
+        break;
+      case 'w':
+        numWarmup = atoi(optarg);
+        break;
+      case 'b':
+        only = optarg;
+        break;
+      default:
+        maxSize = 0;
     }
+  }
+  if (maxSize < 10 || numSamples < 2 || numWarmup < 0 || optind != argc)
+  {
+    fprintf(stderr,
+            "Usage: %s [-m max size] [-s samples] [-w warmup] [-b name]\n",
+            argv[0]);
+    return 1;
+  }
+
+  Run run;
+  run.values = (int*)malloc(maxSize * sizeof(int));
+  run.picks = (int*)malloc(maxSize * sizeof(int));
+  run.heaps = (MinHeap**)malloc(MAX_REPS * sizeof(MinHeap*));
+  double* samples = (double*)malloc(numSamples * sizeof(double));
+  if (!run.values || !run.picks || !run.heaps || !samples)
+  {
+    fprintf(stderr, "Memory allocation failed\n");
+    return 1;
+  }
 
-    // Print the results
-    printf("Size\tTime_Sajad\tTime_Elaheh\n");
-    for (int i = 0; i < numSizes; i++) {
-        printf("%d\t%f\t%f\n", sizes[i], times_Sajad[i], times_Elaheh[i]);
+  printf("benchmark,distribution,size,reps,samples,outliers,mean_s,ci95_s,"
+         "median_s,min_s,ns_per_element\n");
+  for (int b = 0; b < NUM_BENCHMARKS; b++)
+  {
+    if (only && strcmp(only, benchmarks[b].name) != 0)
+      continue;
+    for (int d = 0; d < NUM_DISTRIBUTIONS; d++)
+    {
+      for (int size = 10; size <= maxSize; size *= 10)
+      {
+        run.size = size;
+        generateInput(run.values, run.picks, size, d);
+        measure(&benchmarks[b], &run, distributionNames[d], samples,
+                numSamples, numWarmup);
+      }
     }
+  }
 
-    return 0;
+  free(run.values);
+  free(run.picks);
+  free(run.heaps);
+  free(samples);
+  return 0;
 }
@@ -49,10 +49,14 @@ int getParentIdx(int nodeIndex) {
  * Precondition: 'nodeIndex' is a valid index of minheap 'heap'
  */
 void floatUp(MinHeap* heap, int nodeIndex) {
-  while (nodeIndex > ROOT_INDEX && heap->arr[getParentIdx(nodeIndex)].priority > heap->arr[nodeIndex].priority) {
-    swap(heap, nodeIndex, getParentIdx(nodeIndex));
+  // Parents move down into the hole until the node fits, and then the node
+  // is written once
+  HeapNode node = heap->arr[nodeIndex];
+  while (nodeIndex > ROOT_INDEX && heap->arr[getParentIdx(nodeIndex)].priority > node.priority) {
+    heap->arr[nodeIndex] = heap->arr[getParentIdx(nodeIndex)];
     nodeIndex = getParentIdx(nodeIndex);
   }
+  heap->arr[nodeIndex] = node;
 }
 
 /*
@@ -95,24 +99,31 @@ HeapNode getMin(MinHeap* heap)
   return heap->arr[ROOT_INDEX];
 }
 
+/*
+ * The smaller child moves up into the hole until the node fits, and then the
+ * node is written once. The smaller child is picked by adding the result of
+ * a comparison to the index, which compiles to a conditional move instead of
+ * a hard to predict branch; ties keep the left child.
+ */
 void heapify(MinHeap* heap, int nodeIndex)
 {
-  int smallest = nodeIndex;
-  int leftChild = getLeftChildIdx(nodeIndex);
-  int rightChild = getRightChildIdx(nodeIndex);
-
-  if (isValidIndex(heap, leftChild) && heap->arr[leftChild].priority < heap->arr[smallest].priority) {
-    smallest = leftChild;
-  }
-  
-  if (isValidIndex(heap, rightChild) && heap->arr[rightChild].priority < heap->arr[smallest].priority) {
-    smallest = rightChild;
-  }
-
-  if (smallest != nodeIndex) {
-    swap(heap, nodeIndex, smallest);
-    heapify(heap, smallest);
+  HeapNode* arr = heap->arr;
+  int size = heap->size;
+  HeapNode node = arr[nodeIndex];
+  int child = getLeftChildIdx(nodeIndex);
+
+  while (child <= size) {
+    if (child < size) {
+      child += arr[child + 1].priority < arr[child].priority;
+    }
+    if (!(arr[child].priority < node.priority)) {
+      break;
+    }
+    arr[nodeIndex] = arr[child];
+    nodeIndex = child;
+    child = getLeftChildIdx(nodeIndex);
   }
+  arr[nodeIndex] = node;
 }
 
 HeapNode extractMin(MinHeap* heap)
@@ -1,27 +1,82 @@
+import csv
+import sys
+from collections import defaultdict
+
 import matplotlib.pyplot as plt
 
-# Data
-sizes = [10, 100, 1000, 5000, 10000, 50000, 100000, 500000, 1000000]
-times_sajad = [0.000002, 0.000009, 0.000024, 0.000115, 0.000231, 0.001153, 0.002315, 0.011566, 0.023649]
-times_elaheh = [0.000003, 0.000024, 0.000100, 0.000630, 0.001365, 0.008066, 0.017219, 0.097876, 0.207078]
+# Results written by build_tester: ./build_tester > heap_bench.csv
+path = sys.argv[1] if len(sys.argv) > 1 else 'heap_bench.csv'
+distribution = sys.argv[2] if len(sys.argv) > 2 else 'reversed'
+
+# rows[(benchmark, distribution)] = [(size, mean_s, ci95_s, ns_per_element)]
+rows = defaultdict(list)
+with open(path, newline='') as f:
+    for row in csv.DictReader(f):
+        rows[(row['benchmark'], row['distribution'])].append(
+            (int(row['size']), float(row['mean_s']), float(row['ci95_s']),
+             float(row['ns_per_element'])))
+for series in rows.values():
+    series.sort()
+
+
+def plot_builds():
+    """Compares buildHeap_Sajad and buildHeap_Elaheh on one distribution."""
+    sizes = None
+    plt.figure(figsize=(10, 6))
+    for name, label in [('build_sajad', 'Time_Sajad'),
+                        ('build_elaheh', 'Time_Elaheh')]:
+        series = rows.get((name, distribution))
+        if not series:
+            continue
+        sizes = [s for s, _, _, _ in series]
+        # Normalize x-axis values to be equidistant
+        normalized_sizes = list(range(len(sizes)))
+        plt.errorbar(normalized_sizes, [m for _, m, _, _ in series],
+                     yerr=[c for _, _, c, _ in series], marker='o',
+                     capsize=3, label=label)
+    if sizes is None:
+        return
+
+    plt.xlabel('Input Size (normalized)')
+    plt.ylabel('Time (seconds), 95% confidence interval')
+    plt.title('Comparison of buildHeap_Sajad and buildHeap_Elaheh (%s input)'
+              % distribution)
+    plt.legend()
+    plt.grid(True, which="both", ls="--")
+
+    # Set the xticks to the original sizes for better readability
+    plt.xticks(list(range(len(sizes))), sizes)
 
-# Normalize x-axis values to be equidistant
-normalized_sizes = list(range(len(sizes)))
+    # Save as JPG
+    plt.savefig('build_heap_comparison_normalized.jpg', format='jpg')
 
-# Plotting
-plt.figure(figsize=(10, 6))
-plt.plot(normalized_sizes, times_sajad, marker='o', label='Time_Sajad')
-plt.plot(normalized_sizes, times_elaheh, marker='o', label='Time_Elaheh')
 
-plt.xlabel('Input Size (normalized)')
-plt.ylabel('Time (seconds)')
-plt.title('Comparison of buildHeap_Sajad and buildHeap_Elaheh')
-plt.legend()
-plt.grid(True, which="both", ls="--")
+def plot_operations():
+    """Plots time per element of every benchmark, one panel per benchmark."""
+    benchmarks = sorted({b for b, _ in rows})
+    distributions = sorted({d for _, d in rows})
+    columns = 3
+    lines = (len(benchmarks) + columns - 1) // columns
+    fig, axes = plt.subplots(lines, columns, figsize=(15, 4.5 * lines),
+                             squeeze=False)
+    for ax, name in zip(axes.flat, benchmarks):
+        for d in distributions:
+            series = rows.get((name, d))
+            if series:
+                ax.plot([s for s, _, _, _ in series],
+                        [n for _, _, _, n in series], marker='o', label=d)
+        ax.set_xscale('log')
+        ax.set_title(name)
+        ax.set_xlabel('Heap size')
+        ax.set_ylabel('ns per element')
+        ax.grid(True, which="both", ls="--")
+        ax.legend()
+    for ax in list(axes.flat)[len(benchmarks):]:
+        ax.set_visible(False)
+    fig.tight_layout()
+    fig.savefig('heap_operations.jpg', format='jpg')
 
-# Set the xticks to the original sizes for better readability
-plt.xticks(normalized_sizes, sizes)
 
-# Save as JPG
-plt.savefig('build_heap_comparison_normalized.jpg', format='jpg')
+plot_builds()
+plot_operations()
 plt.show()
@@ -0,0 +1,235 @@
+/*
+ * All-pairs shortest paths.
+ *
+ * The Floyd-Warshall matrix is padded to a multiple of APSP_BLOCK and
+ * processed one block of k values at a time in three phases:
+ *   1. the diagonal tile (kb, kb),
+ *   2. the tiles in block row kb and block column kb,
+ *   3. all remaining tiles.
+ * Tiles within a phase are independent and run in parallel. The innermost
+ * loop is a branch-free min over a contiguous row so that the compiler
+ * vectorizes it.
+ */
+
+#include <limits.h>
+#include <string.h>
+
+#include "apsp.h"
+#include "graph_algos.h"
+
+/*
+ * "No path" inside the Floyd-Warshall matrix. Half of INT_MAX, so that the
+ * sum of two entries never overflows.
+ */
+#define APSP_INFINITY (INT_MAX / 2)
+
+/*
+ * The padded distance matrix shared by the Floyd-Warshall workers.
+ */
+typedef struct fw_matrix
+{
+  int *dist;       // stride x stride entries, row-major
+  int stride;      // padded side length, a multiple of APSP_BLOCK
+  int numBlocks;   // stride / APSP_BLOCK
+  int kb;          // block of k values currently being processed
+} FWMatrix;
+
+/*
+ * Relaxes tile (ib, jb) of 'matrix' through every k in block 'kb':
+ *   dist[i][j] = min(dist[i][j], dist[i][k] + dist[k][j])
+ */
+void relaxTile(FWMatrix *matrix, int ib, int jb, int kb)
+{
+  int stride = matrix->stride;
+  int *dist = matrix->dist;
+  int iStart = ib * APSP_BLOCK;
+  int jStart = jb * APSP_BLOCK;
+  int kStart = kb * APSP_BLOCK;
+
+  for (int k = kStart; k < kStart + APSP_BLOCK; k++)
+  {
+    const int *kRow = dist + (size_t)k * stride + jStart;
+    for (int i = iStart; i < iStart + APSP_BLOCK; i++)
+    {
+      int *iRow = dist + (size_t)i * stride;
+      int ik = iRow[k];
+      if (ik == APSP_INFINITY)
+      {
+        continue;
+      }
+      iRow += jStart;
+      for (int j = 0; j < APSP_BLOCK; j++)
+      {
+        int through = ik + kRow[j];
+        iRow[j] = through < iRow[j] ? through : iRow[j];
+      }
+    }
+  }
+}
+
+/*
+ * Phase 2 task 'index': the tiles of block row kb come first, then those of
+ * block column kb, skipping the diagonal tile.
+ */
+void relaxCrossTile(int index, int workerId, void *context)
+{
+  (void)workerId;
+  FWMatrix *matrix = (FWMatrix *)context;
+  int kb = matrix->kb;
+  int other = index % (matrix->numBlocks - 1);
+  if (other >= kb)
+  {
+    other++;
+  }
+  if (index < matrix->numBlocks - 1)
+  {
+    relaxTile(matrix, kb, other, kb);
+  }
+  else
+  {
+    relaxTile(matrix, other, kb, kb);
+  }
+}
+
+/*
+ * Phase 3 task 'index': one tile outside block row and column kb.
+ */
+void relaxRemainingTile(int index, int workerId, void *context)
+{
+  (void)workerId;
+  FWMatrix *matrix = (FWMatrix *)context;
+  int kb = matrix->kb;
+  int ib = index / (matrix->numBlocks - 1);
+  int jb = index % (matrix->numBlocks - 1);
+  if (ib >= kb)
+  {
+    ib++;
+  }
+  if (jb >= kb)
+  {
+    jb++;
+  }
+  relaxTile(matrix, ib, jb, kb);
+}
+
+/*
+ * Shrinks the padded stride x stride matrix 'dist' in place to
+ * numVertices x numVertices, mapping APSP_INFINITY back to INT_MAX.
+ * Returns the (possibly moved) matrix.
+ */
+int *compactMatrix(int *dist, int stride, int numVertices)
+{
+  for (int u = 0; u < numVertices; u++)
+  {
+    int *row = dist + (size_t)u * numVertices;
+    memmove(row, dist + (size_t)u * stride, numVertices * sizeof(int));
+    for (int v = 0; v < numVertices; v++)
+    {
+      if (row[v] >= APSP_INFINITY)
+      {
+        row[v] = INT_MAX;
+      }
+    }
+  }
+  size_t size = (size_t)numVertices * numVertices * sizeof(int);
+  int *shrunk = (int *)realloc(dist, size > 0 ? size : sizeof(int));
+  return shrunk ? shrunk : dist;
+}
+
+int *getAllPairsFloydWarshall(Graph *graph, ThreadPool *pool)
+{
+  int numVertices = graph->numVertices;
+  int numBlocks = (numVertices + APSP_BLOCK - 1) / APSP_BLOCK;
+  int stride = numBlocks * APSP_BLOCK;
+
+  int *dist = (int *)malloc(((size_t)stride * stride + 1) * sizeof(int));
+  if (dist == NULL)
+  {
+    printf("Memory allocation for distance matrix failed.\n");
+    return NULL;
+  }
+  for (size_t i = 0; i < (size_t)stride * stride; i++)
+  {
+    dist[i] = APSP_INFINITY;
+  }
+  for (int u = 0; u < stride; u++)
+  {
+    dist[(size_t)u * stride + u] = 0;
+  }
+  for (int u = 0; u < numVertices; u++)
+  {
+    if (graph->vertices[u] == NULL)
+    {
+      continue;
+    }
+    for (EdgeList *adj = graph->vertices[u]->adjList; adj != NULL;
+         adj = adj->next)
+    {
+      int *entry = &dist[(size_t)u * stride + adj->edge->toVertex];
+      if (adj->edge->weight < *entry)
+      {
+        *entry = adj->edge->weight;
+      }
+    }
+  }
+
+  FWMatrix matrix = {dist, stride, numBlocks, 0};
+  for (int kb = 0; kb < numBlocks; kb++)
+  {
+    matrix.kb = kb;
+    relaxTile(&matrix, kb, kb, kb);
+    parallelFor(pool, 2 * (numBlocks - 1), relaxCrossTile, &matrix);
+    parallelFor(pool, (numBlocks - 1) * (numBlocks - 1), relaxRemainingTile,
+                &matrix);
+  }
+
+  return compactMatrix(dist, stride, numVertices);
+}
+
+int *getAllPairsDijkstra(Graph *graph, ThreadPool *pool)
+{
+  int numVertices = graph->numVertices;
+  int *dist = (int *)malloc(((size_t)numVertices * numVertices + 1) *
+                            sizeof(int));
+  int *sources = (int *)malloc((numVertices + 1) * sizeof(int));
+  if (dist == NULL || sources == NULL)
+  {
+    printf("Memory allocation for distance matrix failed.\n");
+    free(dist);
+    free(sources);
+    return NULL;
+  }
+  for (int u = 0; u < numVertices; u++)
+  {
+    sources[u] = u;
+  }
+
+  bool ok = getDistancesDijkstraBatch(graph, sources, numVertices, dist, pool);
+  free(sources);
+  if (!ok)
+  {
+    free(dist);
+    return NULL;
+  }
+  return dist;
+}
+
+int *getAllPairsDistances(Graph *graph, ThreadPool *pool)
+{
+  double numVertices = graph->numVertices;
+  double logV = 1;
+  for (int n = graph->numVertices; n > 1; n /= 2)
+  {
+    logV++;
+  }
+
+  // Floyd-Warshall does V^3 cheap steps; V Dijkstra runs do about
+  // V (V + E) log V expensive ones.
+  double dijkstraCost =
+      APSP_DIJKSTRA_COST * (numVertices + graph->numEdges) * logV;
+  if (dijkstraCost >= numVertices * numVertices)
+  {
+    return getAllPairsFloydWarshall(graph, pool);
+  }
+  return getAllPairsDijkstra(graph, pool);
+}
@@ -0,0 +1,54 @@
+/*
+ * Header file for our all-pairs shortest paths (APSP) algorithms.
+ *
+ * All functions return a newly allocated numVertices x numVertices matrix
+ * 'dist' in row-major order: dist[u * numVertices + v] is the length of a
+ * shortest path from u to v, or INT_MAX if v cannot be reached from u.
+ * The caller frees it with free().
+ */
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "graph.h"
+#include "threadpool.h"
+
+#ifndef __APSP_header
+#define __APSP_header
+
+/*
+ * Side length of the square tiles used by the blocked Floyd-Warshall; a
+ * tile of ints is 16 KB, so the three tiles touched by one update fit in L1.
+ */
+#define APSP_BLOCK 64
+
+/*
+ * Relative cost of one edge relaxation in Dijkstra's algorithm compared to
+ * one inner-loop step of Floyd-Warshall, used to pick an algorithm.
+ */
+#define APSP_DIJKSTRA_COST 16
+
+/*
+ * Computes all-pairs shortest path distances in 'graph', using blocked
+ * Floyd-Warshall for dense graphs and one Dijkstra run per vertex for
+ * sparse ones. Work is spread over the workers of 'pool', which may be NULL.
+ * Returns NULL if memory could not be allocated.
+ */
+int* getAllPairsDistances(Graph* graph, ThreadPool* pool);
+
+/*
+ * Computes all-pairs shortest path distances in 'graph' with a cache-blocked
+ * Floyd-Warshall. Takes O(V^3) time and O(V^2) memory regardless of the
+ * number of edges.
+ * Precondition: every shortest path has length < INT_MAX / 2
+ */
+int* getAllPairsFloydWarshall(Graph* graph, ThreadPool* pool);
+
+/*
+ * Computes all-pairs shortest path distances in 'graph' by running
+ * Dijkstra's algorithm from every vertex. Takes O(V (V + E) log V) time.
+ */
+int* getAllPairsDijkstra(Graph* graph, ThreadPool* pool);
+
+#endif
@@ -0,0 +1,202 @@
+/*
+ *  Randomized testing of our all-pairs shortest paths (see apsp.h).
+ *
+ *  On random directed graphs, dense and sparse, getAllPairsFloydWarshall,
+ *  getAllPairsDijkstra and getAllPairsDistances must give the same matrix
+ *  as a naive O(V^3) Floyd-Warshall, with and without a pool of workers.
+ *  Vertex counts around multiples of APSP_BLOCK exercise partial tiles, and
+ *  sparse graphs leave many pairs unreachable. Prints the first mismatches
+ *  found and exits with a non-zero status if there were any.
+ *
+ *  ---------------------------------------------------------------------------
+ *   Compile:
+ *   gcc -Wall -Werror -pthread graph.c minheap.c csr_graph.c \
+ *       compressed_graph.c graph_algos.c threadpool.c apsp.c apsp_tester.c \
+ *       -o apsp_tester
+ *
+ *   Run:
+ *   ./apsp_tester [seed]
+ *  ---------------------------------------------------------------------------
+ */
+
+#include <limits.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "apsp.h"
+#include "graph.h"
+#include "threadpool.h"
+
+#define MAX_WEIGHT 100
+#define POOL_THREADS 3
+#define MAX_REPORTED 10  // mismatches printed before only counting them
+
+uint64_t randomState;
+int numMismatches;
+
+/*
+ * Returns a pseudo-random number in 0, 1, ..., bound-1 (splitmix64).
+ */
+int randomBelow(int bound)
+{
+  uint64_t z = (randomState += 0x9e3779b97f4a7c15ULL);
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+  z ^= z >> 31;
+  return (int)((z >> 33) % (uint64_t)bound);
+}
+
+/*
+ * Prints a mismatch found by algorithm 'algorithm', and counts it.
+ */
+void reportMismatch(const char* algorithm, int fromVertex, int toVertex,
+                    int expected, int actual)
+{
+  if (++numMismatches <= MAX_REPORTED)
+  {
+    printf("%s: distance from %d to %d is %d, expected %d\n", algorithm,
+           fromVertex, toVertex, actual, expected);
+  }
+}
+
+/*
+ * Returns the distance matrix of 'graph', in the form of apsp.h, by the
+ * textbook triple loop.
+ */
+int* referenceDistances(Graph* graph)
+{
+  int n = graph->numVertices;
+  int* dist = (int*)malloc((size_t)n * n * sizeof(int));
+  if (dist == NULL)
+  {
+    printf("Memory allocation failed\n");
+    exit(EXIT_FAILURE);
+  }
+  for (int i = 0; i < n * n; i++)
+  {
+    dist[i] = INT_MAX;
+  }
+  for (int u = 0; u < n; u++)
+  {
+    dist[u * n + u] = 0;
+    for (EdgeList* list = graph->vertices[u]->adjList; list != NULL;
+         list = list->next)
+    {
+      int* d = &dist[u * n + list->edge->toVertex];
+      *d = list->edge->weight < *d ? list->edge->weight : *d;
+    }
+  }
+  for (int k = 0; k < n; k++)
+  {
+    for (int i = 0; i < n; i++)
+    {
+      if (dist[i * n + k] == INT_MAX)
+      {
+        continue;
+      }
+      for (int j = 0; j < n; j++)
+      {
+        if (dist[k * n + j] != INT_MAX &&
+            dist[i * n + k] + dist[k * n + j] < dist[i * n + j])
+        {
+          dist[i * n + j] = dist[i * n + k] + dist[k * n + j];
+        }
+      }
+    }
+  }
+  return dist;
+}
+
+/*
+ * Checks the matrix 'dist' found by 'algorithm' for a graph with
+ * 'numVertices' vertices against 'expected'.
+ */
+void checkMatrix(const char* algorithm, int numVertices, int* expected,
+                 int* dist)
+{
+  if (dist == NULL)
+  {
+    reportMismatch(algorithm, -1, -1, 0, -1);
+    return;
+  }
+  for (int u = 0; u < numVertices; u++)
+  {
+    for (int v = 0; v < numVertices; v++)
+    {
+      if (dist[u * numVertices + v] != expected[u * numVertices + v])
+      {
+        reportMismatch(algorithm, u, v, expected[u * numVertices + v],
+                       dist[u * numVertices + v]);
+      }
+    }
+  }
+  free(dist);
+}
+
+/*
+ * Builds a random directed graph with 'numVertices' vertices and
+ * 'numEdges' edges, and checks every APSP function on it, with pool NULL
+ * and with 'pool'.
+ */
+void testRandomGraph(int numVertices, int numEdges, ThreadPool* pool)
+{
+  Graph* graph = newGraph(numVertices);
+  for (int v = 0; v < numVertices; v++)
+    graph->vertices[v] = newVertex(v, NULL, NULL);
+  for (int i = 0; i < numEdges; i++)
+    insertGraphEdge(graph, randomBelow(numVertices), randomBelow(numVertices),
+                    randomBelow(MAX_WEIGHT + 1));
+
+  int* expected = referenceDistances(graph);
+  ThreadPool* pools[] = {NULL, pool};
+  for (int p = 0; p < 2; p++)
+  {
+    checkMatrix("getAllPairsFloydWarshall", numVertices, expected,
+                getAllPairsFloydWarshall(graph, pools[p]));
+    checkMatrix("getAllPairsDijkstra", numVertices, expected,
+                getAllPairsDijkstra(graph, pools[p]));
+    checkMatrix("getAllPairsDistances", numVertices, expected,
+                getAllPairsDistances(graph, pools[p]));
+  }
+
+  int unreachable = 0;
+  for (int i = 0; i < numVertices * numVertices; i++)
+  {
+    unreachable += expected[i] == INT_MAX;
+  }
+  printf("%d vertices, %d edges, %d unreachable pairs: %d mismatches so far\n",
+         numVertices, numEdges, unreachable, numMismatches);
+  free(expected);
+  deleteGraph(graph);
+}
+
+int main(int argc, char* argv[])
+{
+  randomState = argc > 1 ? strtoull(argv[1], NULL, 10) : 1;
+  ThreadPool* pool = newThreadPool(POOL_THREADS);
+  if (pool == NULL)
+  {
+    printf("Memory allocation failed\n");
+    exit(EXIT_FAILURE);
+  }
+
+  testRandomGraph(1, 0, pool);
+  testRandomGraph(2, 1, pool);
+  testRandomGraph(APSP_BLOCK - 1, 2000, pool);    // dense
+  testRandomGraph(APSP_BLOCK, 100, pool);         // sparse
+  testRandomGraph(APSP_BLOCK + 1, 3000, pool);
+  testRandomGraph(2 * APSP_BLOCK + 7, 20, pool);  // mostly unreachable
+  testRandomGraph(3 * APSP_BLOCK - 5, 15000, pool);
+  testRandomGraph(300, 600, pool);
+  testRandomGraph(300, 40000, pool);
+
+  deleteThreadPool(pool);
+  if (numMismatches > 0)
+  {
+    printf("FAILED: %d mismatches\n", numMismatches);
+    return EXIT_FAILURE;
+  }
+  printf("All APSP results match the reference.\n");
+  return EXIT_SUCCESS;
+}
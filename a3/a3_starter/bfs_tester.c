@@ -0,0 +1,275 @@
+/*
+ *  Randomized testing of our parallel BFS (see graph_bfs.h).
+ *
+ *  On Erdos-Renyi, R-MAT and grid graphs, and on random directed graphs,
+ *  bfsCSR and getHopDistances must give the hop counts of a plain
+ *  sequential BFS from several sources, with and without a pool of workers
+ *  and with and without a reverse graph (which lets the search go
+ *  bottom-up). Which parent a vertex gets may differ between runs, so each
+ *  parent must instead be a vertex one hop closer with an edge to it.
+ *  Prints the first mismatches found and exits with a non-zero status if
+ *  there were any.
+ *
+ *  ---------------------------------------------------------------------------
+ *   Compile:
+ *   gcc -Wall -Werror -pthread graph.c graph_generators.c graph_scc.c \
+ *       csr_graph.c threadpool.c graph_bfs.c bfs_tester.c -o bfs_tester
+ *
+ *   Run:
+ *   ./bfs_tester [seed]
+ *  ---------------------------------------------------------------------------
+ */
+
+#include <limits.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "csr_graph.h"
+#include "graph.h"
+#include "graph_algos.h"
+#include "graph_bfs.h"
+#include "graph_generators.h"
+#include "threadpool.h"
+
+#define POOL_THREADS 3
+#define SOURCES_PER_GRAPH 4
+#define MAX_REPORTED 10  // mismatches printed before only counting them
+
+uint64_t randomState;
+int numMismatches;
+
+/*
+ * Returns a pseudo-random vertex ID in 0, 1, ..., numVertices-1 (splitmix64;
+ * graph_generators.c has its own randomBelow).
+ */
+int randomVertex(int numVertices)
+{
+  uint64_t z = (randomState += 0x9e3779b97f4a7c15ULL);
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+  z ^= z >> 31;
+  return (int)((z >> 33) % (uint64_t)numVertices);
+}
+
+/*
+ * Prints a mismatch found in search 'search', and counts it.
+ */
+void reportMismatch(const char* search, const char* what, int vertex,
+                    int expected, int actual)
+{
+  if (++numMismatches <= MAX_REPORTED)
+  {
+    printf("%s: %s of vertex %d is %d, expected %d\n", search, what, vertex,
+           actual, expected);
+  }
+}
+
+/*
+ * Fills in 'distances' with the hop counts from 'source' in 'csr', or
+ * INT_MAX for unreachable vertices, by a plain queue-based BFS.
+ */
+void referenceBFS(CSRGraph* csr, int source, int* distances)
+{
+  int* queue = (int*)malloc(csr->numVertices * sizeof(int));
+  if (queue == NULL)
+  {
+    printf("Memory allocation failed\n");
+    exit(EXIT_FAILURE);
+  }
+  for (int v = 0; v < csr->numVertices; v++)
+  {
+    distances[v] = INT_MAX;
+  }
+  distances[source] = 0;
+  queue[0] = source;
+  int head = 0;
+  int tail = 1;
+  while (head < tail)
+  {
+    int u = queue[head++];
+    for (int64_t e = csr->offsets[u]; e < csr->offsets[u + 1]; e++)
+    {
+      int v = csr->targets[e];
+      if (distances[v] == INT_MAX)
+      {
+        distances[v] = distances[u] + 1;
+        queue[tail++] = v;
+      }
+    }
+  }
+  free(queue);
+}
+
+/*
+ * Returns true iff 'csr' has an edge from 'fromVertex' to 'toVertex'.
+ */
+bool hasEdge(CSRGraph* csr, int fromVertex, int toVertex)
+{
+  for (int64_t e = csr->offsets[fromVertex]; e < csr->offsets[fromVertex + 1];
+       e++)
+  {
+    if (csr->targets[e] == toVertex)
+    {
+      return true;
+    }
+  }
+  return false;
+}
+
+/*
+ * Checks the 'distances' and 'parents' found by search 'search' on 'csr'
+ * from 'source' against the 'expected' distances.
+ */
+void checkSearch(const char* search, CSRGraph* csr, int source,
+                 int* expected, int* distances, int* parents)
+{
+  for (int v = 0; v < csr->numVertices; v++)
+  {
+    if (distances[v] != expected[v])
+    {
+      reportMismatch(search, "distance", v, expected[v], distances[v]);
+    }
+    else if (v == source || expected[v] == INT_MAX)
+    {
+      if (parents[v] != NOTHING)
+      {
+        reportMismatch(search, "parent", v, NOTHING, parents[v]);
+      }
+    }
+    else if (parents[v] < 0 || parents[v] >= csr->numVertices)
+    {
+      reportMismatch(search, "parent", v, 0, parents[v]);
+    }
+    else if (expected[parents[v]] != expected[v] - 1)
+    {
+      reportMismatch(search, "distance of the parent", v, expected[v] - 1,
+                     expected[parents[v]]);
+    }
+    else if (!hasEdge(csr, parents[v], v))
+    {
+      reportMismatch(search, "edge from its parent", v, true, false);
+    }
+  }
+}
+
+/*
+ * Runs every kind of search on 'graph' from SOURCES_PER_GRAPH random
+ * sources, and checks them against the reference BFS. If 'undirected', the
+ * CSRGraph is also passed as its own reverse.
+ */
+void testGraph(const char* name, Graph* graph, bool undirected,
+               ThreadPool* pool)
+{
+  int n = graph->numVertices;
+  CSRGraph* csr = csrFromGraph(graph);
+  CSRGraph* transposed = csr ? transposeCSRGraph(csr) : NULL;
+  int* expected = (int*)malloc(n * sizeof(int));
+  int* distances = (int*)malloc(n * sizeof(int));
+  int* parents = (int*)malloc(n * sizeof(int));
+  if (csr == NULL || transposed == NULL || expected == NULL ||
+      distances == NULL || parents == NULL)
+  {
+    printf("Memory allocation failed\n");
+    exit(EXIT_FAILURE);
+  }
+
+  ThreadPool* pools[] = {NULL, pool};
+  CSRGraph* reverses[] = {NULL, transposed, undirected ? csr : NULL};
+  const char* reverseNames[] = {"no reverse", "transpose", "itself"};
+  char search[128];
+  for (int i = 0; i < SOURCES_PER_GRAPH; i++)
+  {
+    int source = randomVertex(n);
+    referenceBFS(csr, source, expected);
+    for (int p = 0; p < 2; p++)
+    {
+      for (int r = 0; r < 3; r++)
+      {
+        if (r == 2 && !undirected)
+        {
+          continue;
+        }
+        snprintf(search, sizeof(search), "%s, bfsCSR from %d, pool of %d, %s",
+                 name, source, poolSize(pools[p]), reverseNames[r]);
+        if (!bfsCSR(csr, reverses[r], source, distances, parents, pools[p]))
+        {
+          reportMismatch(search, "success", source, true, false);
+          continue;
+        }
+        checkSearch(search, csr, source, expected, distances, parents);
+      }
+      snprintf(search, sizeof(search),
+               "%s, getHopDistances from %d, pool of %d", name, source,
+               poolSize(pools[p]));
+      if (!getHopDistances(graph, source, distances, parents, pools[p]))
+      {
+        reportMismatch(search, "success", source, true, false);
+        continue;
+      }
+      checkSearch(search, csr, source, expected, distances, parents);
+    }
+  }
+
+  // Invalid sources are refused
+  if (bfsCSR(csr, transposed, -1, distances, parents, pool) ||
+      bfsCSR(csr, transposed, n, distances, parents, NULL) ||
+      getHopDistances(graph, n, distances, parents, pool))
+  {
+    reportMismatch(name, "success of a search from", n, false, true);
+  }
+
+  printf("%s: %d vertices, %d edges: %d mismatches so far\n", name, n,
+         graph->numEdges, numMismatches);
+  free(parents);
+  free(distances);
+  free(expected);
+  deleteCSRGraph(transposed);
+  deleteCSRGraph(csr);
+  deleteGraph(graph);
+}
+
+/*
+ * Returns a random directed graph with 'numVertices' vertices and
+ * 'numEdges' edges.
+ */
+Graph* newDirectedGraph(int numVertices, int numEdges)
+{
+  Graph* graph = newGraph(numVertices);
+  for (int v = 0; v < numVertices; v++)
+    graph->vertices[v] = newVertex(v, NULL, NULL);
+  for (int i = 0; i < numEdges; i++)
+    insertGraphEdge(graph, randomVertex(numVertices),
+                    randomVertex(numVertices), 1);
+  return graph;
+}
+
+int main(int argc, char* argv[])
+{
+  randomState = argc > 1 ? strtoull(argv[1], NULL, 10) : 1;
+  ThreadPool* pool = newThreadPool(POOL_THREADS);
+  if (pool == NULL)
+  {
+    printf("Memory allocation failed\n");
+    exit(EXIT_FAILURE);
+  }
+
+  testGraph("one vertex", newDirectedGraph(1, 0), true, pool);
+  testGraph("directed, sparse", newDirectedGraph(3000, 3000), false, pool);
+  testGraph("directed", newDirectedGraph(5000, 40000), false, pool);
+  testGraph("Erdos-Renyi", newErdosRenyiGraph(5000, 30000, 10, randomState),
+            true, pool);
+  testGraph("Erdos-Renyi, disconnected",
+            newErdosRenyiGraph(4000, 2000, 10, randomState), true, pool);
+  testGraph("R-MAT", newRMATGraph(14, 200000, 10, randomState), true, pool);
+  testGraph("grid", newGridGraph(150, 200, 10, randomState), true, pool);
+
+  deleteThreadPool(pool);
+  if (numMismatches > 0)
+  {
+    printf("FAILED: %d mismatches\n", numMismatches);
+    return EXIT_FAILURE;
+  }
+  printf("All BFS results match the sequential BFS.\n");
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,352 @@
+/*
+ * Our blocked priority queue.
+ *
+ * Page p of the array is arr[p * PAGE_SLOTS] to
+ * arr[(p + 1) * PAGE_SLOTS - 1]. Within a page, nodes are laid out like an
+ * implicit heap rooted at offset 1, but offsets 0 and 1 are unused except
+ * in page 0: a page holds two sibling subtrees, rooted at offsets 2 and 3,
+ * so that both children of a node are always next to each other. Leaf
+ * PAGE_LEAVES + k of page p has the roots of page p * PAGE_LEAVES + 1 + k
+ * as children, so pages are numbered in level order of the tree of pages.
+ * The root is not at offset 1 of page 0, but deeper on its left edge: that
+ * way the subtrees on the bottom level of pages are full height at full
+ * capacity.
+ *
+ * Nodes are still numbered by their position in level order, with the root
+ * at position ROOT_INDEX; slotOf maps a position to its index in the array.
+ */
+
+#include <limits.h>
+
+#include "bheap.h"
+
+#define PAGE_SHIFT (BHEAP_PAGE_LEVELS + 1)
+#define PAGE_SLOTS (1 << PAGE_SHIFT)  // entries of arr in one page
+#define PAGE_LEAVES (PAGE_SLOTS / 2)  // bottom level nodes of a page
+
+// Free entries hold emptySlot, which no node is less than
+static const HeapNode emptySlot = {INT_MAX, NOTHING};
+
+struct b_heap
+{
+  int size;       // the number of nodes in this heap
+  int capacity;   // the number of nodes that can be stored in this heap
+  HeapNode *arr;  // the pages, page aligned
+  int *indexMap;  // indexMap[id] is the index of node with ID id in arr
+  int rootIndex;  // index of the root in arr
+  int slots;      // the number of entries in arr
+};
+
+/*************************************************************************
+ ** Layout
+ *************************************************************************/
+
+/*
+ * Returns the index of the parent of the node at index 'nodeIndex'.
+ * Precondition: 'nodeIndex' is not the root
+ */
+static int parentIdx(int nodeIndex)
+{
+  int offset = nodeIndex & (PAGE_SLOTS - 1);
+  if (offset >= 4 || nodeIndex < PAGE_SLOTS)
+  {
+    return nodeIndex - offset + offset / 2;
+  }
+  int childPage = (nodeIndex >> PAGE_SHIFT) - 1; // among all child pages
+  return ((childPage >> BHEAP_PAGE_LEVELS) << PAGE_SHIFT) + PAGE_LEAVES +
+         (childPage & (PAGE_LEAVES - 1));
+}
+
+/*
+ * Returns the index of the left child of the node at index 'nodeIndex'; the
+ * right child is the next entry. It is at least heap->slots if the node has
+ * no children.
+ */
+static long leftChildIdx(int nodeIndex)
+{
+  long offset = nodeIndex & (PAGE_SLOTS - 1);
+  if (offset < PAGE_LEAVES)
+  {
+    return nodeIndex + offset;
+  }
+  long page = nodeIndex >> PAGE_SHIFT;
+  long childPage = (page << BHEAP_PAGE_LEVELS) + 1 + (offset - PAGE_LEAVES);
+  return (childPage << PAGE_SHIFT) + 2;
+}
+
+/*
+ * Returns the index in an array whose root is at 'rootIndex' of the node at
+ * position 'position' in level order, where the root is at position
+ * ROOT_INDEX.
+ */
+static long blockedSlot(int rootIndex, long position)
+{
+  int depth = 63 - __builtin_clzl(position);
+  unsigned long path = position ^ (1UL << depth); // left or right, per level
+  // Levels from offset 1 of page 0 down to the node
+  int remaining = depth + __builtin_ctz(rootIndex);
+  long page = 0;
+  while (remaining > BHEAP_PAGE_LEVELS)
+  {
+    remaining -= BHEAP_PAGE_LEVELS;
+    page = (page << BHEAP_PAGE_LEVELS) + 1 +
+           ((path >> remaining) & (PAGE_LEAVES - 1));
+  }
+  return (page << PAGE_SHIFT) + (1L << remaining) +
+         (path & ((1UL << remaining) - 1));
+}
+
+/*
+ * Returns the index in heap->arr of the node at position 'position'.
+ */
+static inline int slotOf(BHeap *heap, int position)
+{
+  return (int)blockedSlot(heap->rootIndex, position);
+}
+
+/*
+ * Allocates the array of 'heap', page aligned, fills it with emptySlot, and
+ * sets heap->rootIndex and heap->slots. Returns NULL if it cannot be
+ * allocated.
+ */
+static HeapNode *newBlockedArray(BHeap *heap)
+{
+  // Depth of the deepest node at full capacity
+  int depth = heap->capacity > 1 ? 31 - __builtin_clz(heap->capacity) : 0;
+  // Levels in page 0, which also has offset 1
+  int firstLevels = depth > 0 ? (depth - 1) % BHEAP_PAGE_LEVELS + 2 : 1;
+  heap->rootIndex = 1 << (PAGE_SHIFT - firstLevels);
+  long pages =
+      (blockedSlot(heap->rootIndex, (2L << depth) - 1) >> PAGE_SHIFT) + 1;
+  if (pages > INT_MAX / PAGE_SLOTS)
+  {
+    return NULL;
+  }
+  heap->slots = (int)pages * PAGE_SLOTS;
+  HeapNode *arr = (HeapNode *)aligned_alloc(PAGE_SLOTS * sizeof(HeapNode),
+                                            heap->slots * sizeof(HeapNode));
+  if (!arr)
+  {
+    return NULL;
+  }
+
+  // Fill the pages of each level of pages, whose tops are at depth 'top',
+  // but not the gaps between levels, which are never used
+  for (int top = 0; top <= depth;
+       top += top == 0 ? firstLevels : BHEAP_PAGE_LEVELS)
+  {
+    long first = blockedSlot(heap->rootIndex, 1L << top) & -PAGE_SLOTS;
+    long last =
+        blockedSlot(heap->rootIndex, (2L << top) - 1) | (PAGE_SLOTS - 1);
+    for (long i = first; i <= last; i++)
+    {
+      arr[i] = emptySlot;
+    }
+  }
+  return arr;
+}
+
+/*************************************************************************
+ ** Sifting
+ *************************************************************************/
+
+/*
+ * Writes 'node' to heap->arr[nodeIndex] and records its new index.
+ */
+static inline void placeNode(BHeap *heap, int nodeIndex, HeapNode node)
+{
+  heap->arr[nodeIndex] = node;
+  heap->indexMap[node.id] = nodeIndex;
+}
+
+/*
+ * Floats up the node at index 'nodeIndex' until its parent is not larger.
+ * Parents move down into the hole until the node fits, and then the node is
+ * written once.
+ */
+static void siftUp(BHeap *heap, int nodeIndex)
+{
+  HeapNode node = heap->arr[nodeIndex];
+  while (nodeIndex != heap->rootIndex)
+  {
+    int parent = parentIdx(nodeIndex);
+    if (!(node.priority < heap->arr[parent].priority))
+    {
+      break;
+    }
+    placeNode(heap, nodeIndex, heap->arr[parent]);
+    nodeIndex = parent;
+  }
+  placeNode(heap, nodeIndex, node);
+}
+
+/*
+ * Sifts the node at index 'nodeIndex' down until no child is smaller.
+ * Missing children are emptySlots, so only the end of arr needs checking.
+ */
+static void siftDown(BHeap *heap, int nodeIndex)
+{
+  HeapNode *arr = heap->arr;
+  int slots = heap->slots;
+  HeapNode node = arr[nodeIndex];
+  long child = leftChildIdx(nodeIndex);
+  while (child < slots)
+  {
+    child += arr[child + 1].priority < arr[child].priority;
+    if (!(arr[child].priority < node.priority))
+    {
+      break;
+    }
+    placeNode(heap, nodeIndex, arr[child]);
+    nodeIndex = (int)child;
+    child = leftChildIdx(nodeIndex);
+  }
+  placeNode(heap, nodeIndex, node);
+}
+
+/*
+ * Returns the index of the node with ID 'id' in 'heap', or NOTHING if it is
+ * not in 'heap'.
+ */
+static int findNode(BHeap *heap, int id)
+{
+  int index = heap->indexMap[id];
+  if (index < 0 || index >= heap->slots || heap->arr[index].id != id)
+  {
+    return NOTHING;
+  }
+  return index;
+}
+
+/*************************************************************************
+ ** Operations
+ *************************************************************************/
+
+BHeap *newBHeap(int capacity)
+{
+  BHeap *heap = (BHeap *)malloc(sizeof(BHeap));
+  if (!heap)
+  {
+    return NULL;
+  }
+  heap->size = 0;
+  heap->capacity = capacity;
+  heap->arr = newBlockedArray(heap);
+  heap->indexMap = (int *)malloc((capacity + 1) * sizeof(int));
+  if (!heap->arr || !heap->indexMap)
+  {
+    free(heap->arr);
+    free(heap->indexMap);
+    free(heap);
+    return NULL;
+  }
+  for (int id = 0; id <= capacity; id++)
+  {
+    heap->indexMap[id] = NOTHING;
+  }
+  return heap;
+}
+
+bool bheapInsert(BHeap *heap, int priority, int id)
+{
+  if (heap->size == heap->capacity)
+  {
+    return false;
+  }
+  heap->size++;
+  int index = slotOf(heap, heap->size);
+  heap->arr[index].priority = priority;
+  heap->arr[index].id = id;
+  heap->indexMap[id] = index;
+  siftUp(heap, index);
+  return true;
+}
+
+HeapNode bheapGetMin(BHeap *heap)
+{
+  return heap->arr[heap->rootIndex];
+}
+
+HeapNode bheapExtractMin(BHeap *heap)
+{
+  int root = heap->rootIndex;
+  int last = slotOf(heap, heap->size);
+  HeapNode minNode = heap->arr[root];
+  heap->arr[root] = heap->arr[last];
+  heap->indexMap[heap->arr[root].id] = root;
+  heap->arr[last] = emptySlot;
+  heap->size--;
+  if (heap->size > 0)
+  {
+    siftDown(heap, root);
+  }
+  return minNode;
+}
+
+bool bheapDecreasePriority(BHeap *heap, int id, int newPriority)
+{
+  int index = findNode(heap, id);
+  if (index == NOTHING || heap->arr[index].priority <= newPriority)
+  {
+    return false;
+  }
+  heap->arr[index].priority = newPriority;
+  siftUp(heap, index);
+  return true;
+}
+
+bool bheapPriorityOf(BHeap *heap, int id, int *priority)
+{
+  int index = findNode(heap, id);
+  if (index == NOTHING)
+  {
+    return false;
+  }
+  *priority = heap->arr[index].priority;
+  return true;
+}
+
+int bheapSize(BHeap *heap)
+{
+  return heap->size;
+}
+
+void printBHeap(BHeap *heap)
+{
+  printf("BHeap with size: %d\n\tcapacity: %d\n\n", heap->size,
+         heap->capacity);
+  printf("position (index): priority [ID]\n");
+  for (int position = ROOT_INDEX; position < ROOT_INDEX + heap->size;
+       position++)
+  {
+    int index = slotOf(heap, position);
+    printf("%d (%d): %d [%d]\n", position, index, heap->arr[index].priority,
+           heap->arr[index].id);
+  }
+  printf("\nID: index\n");
+  for (int id = 0; id < heap->capacity; id++)
+  {
+    printf("%d: %d\n", id, heap->indexMap[id]);
+  }
+  printf("\n\n");
+}
+
+void clearBHeap(BHeap *heap)
+{
+  for (int position = ROOT_INDEX; position < ROOT_INDEX + heap->size;
+       position++)
+  {
+    heap->arr[slotOf(heap, position)] = emptySlot;
+  }
+  heap->size = 0;
+}
+
+void deleteBHeap(BHeap *heap)
+{
+  if (heap)
+  {
+    free(heap->arr);
+    free(heap->indexMap);
+    free(heap);
+  }
+}
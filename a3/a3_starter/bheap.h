@@ -0,0 +1,102 @@
+/*
+ * Header file for our blocked priority queue.
+ *
+ * A BHeap is a MinHeap laid out as a B-heap. In a MinHeap, the root is at
+ * ROOT_INDEX and the children of index i are at 2i and 2i+1, so a sift
+ * through a heap much larger than the caches touches a different page at
+ * every level below the first few, and misses the TLB at almost every
+ * level.
+ *
+ * The array of a BHeap is cut into 4 KiB pages instead, and each page holds
+ * two sibling subtrees of BHEAP_PAGE_LEVELS levels. The children of a node
+ * on the bottom level of a page are the roots of another page, so a sift
+ * from the root to a leaf touches one page per BHEAP_PAGE_LEVELS levels.
+ * Subtrees are aligned to the bottom of the tree at full capacity, which
+ * keeps every page at least half full; the array may still take up to three
+ * times the memory of a MinHeap's, but the gaps are never touched.
+ *
+ * On the machines we measured, the MinHeap is still faster at every size
+ * (see heap_replay -H), so only use a BHeap after timing both.
+ *
+ * As in a MinHeap, IDs are unique and less than the capacity.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "minheap.h"
+
+#ifndef __BHeap_header
+#define __BHeap_header
+
+#define BHEAP_PAGE_LEVELS 8  // 2 subtrees of 2^8 - 1 nodes of 8 bytes: 4 KiB
+
+typedef struct b_heap BHeap;
+
+/*
+ * Returns a newly created empty BHeap for nodes with IDs
+ * 0, 1, ..., capacity-1, or NULL if memory could not be allocated.
+ * Precondition: capacity >= 0
+ */
+BHeap* newBHeap(int capacity);
+
+/*
+ * Inserts a node with priority 'priority' and ID 'id' into 'heap'.
+ * Returns: true if insert was successful, false if 'heap' is full
+ * Precondition: 0 <= 'id' < capacity of 'heap', and no node with ID 'id'
+ *               is in 'heap'
+ */
+bool bheapInsert(BHeap* heap, int priority, int id);
+
+/*
+ * Returns the node with minimum priority in 'heap'.
+ * Precondition: heap is non-empty
+ */
+HeapNode bheapGetMin(BHeap* heap);
+
+/*
+ * Removes and returns the node with minimum priority in 'heap'.
+ * Precondition: heap is non-empty
+ */
+HeapNode bheapExtractMin(BHeap* heap);
+
+/*
+ * Sets priority of node with ID 'id' in 'heap' to 'newPriority', if such a
+ * node exists in 'heap' and its priority is larger than 'newPriority', and
+ * returns True. Has no effect and returns False, otherwise.
+ * Precondition: 0 <= 'id' < capacity of 'heap'
+ */
+bool bheapDecreasePriority(BHeap* heap, int id, int newPriority);
+
+/*
+ * Returns True if a node with ID 'id' is in 'heap', and stores its priority
+ * in '*priority'. Returns False otherwise.
+ * Precondition: 0 <= 'id' < capacity of 'heap'
+ */
+bool bheapPriorityOf(BHeap* heap, int id, int* priority);
+
+/*
+ * Returns the number of nodes in 'heap'.
+ */
+int bheapSize(BHeap* heap);
+
+/*
+ * Prints the contents of 'heap', including size and capacity. For each
+ * node, in level order, its index in the heap array, ID and priority,
+ * followed by the index of every ID.
+ */
+void printBHeap(BHeap* heap);
+
+/*
+ * Removes all nodes from 'heap'.
+ */
+void clearBHeap(BHeap* heap);
+
+/*
+ * Frees all memory allocated for 'heap'.
+ */
+void deleteBHeap(BHeap* heap);
+
+#endif
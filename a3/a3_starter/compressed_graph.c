@@ -0,0 +1,258 @@
+/*
+ * Our compressed adjacency storage.
+ *
+ * Compression takes three passes over blocks of vertices, each spread over
+ * the thread pool: sort every vertex's edges into 64-bit keys
+ * (target << 32 | weight), measure the encoded size of every run, and,
+ * after a prefix sum over the sizes, write the runs.
+ */
+
+#include <string.h>
+
+#include "compressed_graph.h"
+
+#define VERTICES_PER_TASK 4096
+
+/*
+ * State shared by the compression tasks.
+ */
+typedef struct compression
+{
+  CSRGraph *csr;
+  CompressedGraph *graph;
+  int64_t *keys;        // the edges of csr as sort keys, sorted per vertex
+  int maxDegree[];      // largest degree seen by each task
+} Compression;
+
+/*
+ * Returns the number of bytes 'value' takes as a varint.
+ */
+int varintSize(uint32_t value)
+{
+  int size = 1;
+  while (value >= 0x80)
+  {
+    value >>= 7;
+    size++;
+  }
+  return size;
+}
+
+/*
+ * Writes 'value' as a varint at 'out' and returns the byte after it.
+ */
+uint8_t *writeVarint(uint8_t *out, uint32_t value)
+{
+  while (value >= 0x80)
+  {
+    *out++ = (uint8_t)(value | 0x80);
+    value >>= 7;
+  }
+  *out++ = (uint8_t)value;
+  return out;
+}
+
+/*
+ * Reads a varint at '*in' and moves '*in' past it.
+ */
+static inline uint32_t readVarint(const uint8_t **in)
+{
+  const uint8_t *p = *in;
+  uint32_t value = *p++;
+  if (value >= 0x80) // rare once the graph is reordered
+  {
+    value &= 0x7f;
+    int shift = 7;
+    uint32_t byte;
+    do
+    {
+      byte = *p++;
+      value |= (byte & 0x7f) << shift;
+      shift += 7;
+    } while (byte >= 0x80);
+  }
+  *in = p;
+  return value;
+}
+
+/*
+ * Returns 'value' zigzag-encoded: 0, -1, 1, -2, ... become 0, 1, 2, 3, ...
+ */
+uint32_t zigzag(int value)
+{
+  return ((uint32_t)value << 1) ^ (uint32_t)(value >> 31);
+}
+
+/*
+ * Returns the gap code of the edge to 'target' after the edge to 'previous'
+ * in the run of vertex 'id'; 'first' tells whether it is the first edge.
+ */
+uint32_t gapCode(int id, int previous, int target, bool first)
+{
+  return first ? zigzag(target - id) : (uint32_t)(target - previous);
+}
+
+/*
+ * qsort comparator for int64_t edge keys.
+ */
+int compareEdgeKeys(const void *a, const void *b)
+{
+  int64_t x = *(const int64_t *)a;
+  int64_t y = *(const int64_t *)b;
+  return (x > y) - (x < y);
+}
+
+/*
+ * Task 'index': sorts the edges of a block of vertices into keys and
+ * stores the encoded size of each run in graph->offsets.
+ */
+void sortAndMeasure(int index, int workerId, void *context)
+{
+  (void)workerId;
+  Compression *c = (Compression *)context;
+  CSRGraph *csr = c->csr;
+  int start = index * VERTICES_PER_TASK;
+  int end = start + VERTICES_PER_TASK;
+  end = end < csr->numVertices ? end : csr->numVertices;
+  int maxDegree = 0;
+  for (int v = start; v < end; v++)
+  {
+    int64_t first = csr->offsets[v];
+    int64_t last = csr->offsets[v + 1];
+    for (int64_t e = first; e < last; e++)
+    {
+      c->keys[e] = (int64_t)csr->targets[e] << 32 | (uint32_t)csr->weights[e];
+    }
+    qsort(c->keys + first, last - first, sizeof(int64_t), compareEdgeKeys);
+
+    int64_t size = 0;
+    int previous = v;
+    for (int64_t e = first; e < last; e++)
+    {
+      int target = (int)(c->keys[e] >> 32);
+      size += varintSize(gapCode(v, previous, target, e == first));
+      size += varintSize((uint32_t)(c->keys[e] & 0xffffffff));
+      previous = target;
+    }
+    c->graph->offsets[v] = size;
+    maxDegree = last - first > maxDegree ? (int)(last - first) : maxDegree;
+  }
+  c->maxDegree[index] = maxDegree;
+}
+
+/*
+ * Task 'index': writes the runs of a block of vertices.
+ */
+void encodeRuns(int index, int workerId, void *context)
+{
+  (void)workerId;
+  Compression *c = (Compression *)context;
+  CSRGraph *csr = c->csr;
+  int start = index * VERTICES_PER_TASK;
+  int end = start + VERTICES_PER_TASK;
+  end = end < csr->numVertices ? end : csr->numVertices;
+  for (int v = start; v < end; v++)
+  {
+    uint8_t *out = c->graph->data + c->graph->offsets[v];
+    int previous = v;
+    for (int64_t e = csr->offsets[v]; e < csr->offsets[v + 1]; e++)
+    {
+      int target = (int)(c->keys[e] >> 32);
+      out = writeVarint(out, gapCode(v, previous, target,
+                                     e == csr->offsets[v]));
+      out = writeVarint(out, (uint32_t)(c->keys[e] & 0xffffffff));
+      previous = target;
+    }
+  }
+}
+
+CompressedGraph *compressGraph(CSRGraph *csr, ThreadPool *pool)
+{
+  int numTasks = (csr->numVertices + VERTICES_PER_TASK - 1) / VERTICES_PER_TASK;
+  CompressedGraph *graph = (CompressedGraph *)malloc(sizeof(CompressedGraph));
+  Compression *c =
+      (Compression *)malloc(sizeof(Compression) + numTasks * sizeof(int));
+  int64_t *keys = (int64_t *)malloc((csr->numEdges + 1) * sizeof(int64_t));
+  int64_t *offsets =
+      (int64_t *)malloc((csr->numVertices + 1) * sizeof(int64_t));
+  if (!graph || !c || !keys || !offsets)
+  {
+    free(graph);
+    free(c);
+    free(keys);
+    free(offsets);
+    return NULL;
+  }
+  graph->numVertices = csr->numVertices;
+  graph->numEdges = csr->numEdges;
+  graph->offsets = offsets;
+  c->csr = csr;
+  c->graph = graph;
+  c->keys = keys;
+
+  parallelFor(pool, numTasks, sortAndMeasure, c);
+  int64_t size = parallelPrefixSum(pool, offsets, csr->numVertices);
+  offsets[csr->numVertices] = size;
+  graph->maxDegree = 0;
+  for (int i = 0; i < numTasks; i++)
+  {
+    graph->maxDegree =
+        c->maxDegree[i] > graph->maxDegree ? c->maxDegree[i] : graph->maxDegree;
+  }
+
+  graph->data = (uint8_t *)malloc(size + 1);
+  if (graph->data)
+  {
+    parallelFor(pool, numTasks, encodeRuns, c);
+  }
+  else
+  {
+    free(offsets);
+    free(graph);
+    graph = NULL;
+  }
+  free(keys);
+  free(c);
+  return graph;
+}
+
+int decodeNeighbors(CompressedGraph *graph, int id, int *targets,
+                    int *weights)
+{
+  const uint8_t *in = graph->data + graph->offsets[id];
+  const uint8_t *end = graph->data + graph->offsets[id + 1];
+  if (in == end)
+  {
+    return 0;
+  }
+  uint32_t code = readVarint(&in);
+  int target = id + (int)((code >> 1) ^ -(code & 1));
+  targets[0] = target;
+  weights[0] = (int)readVarint(&in);
+  int count = 1;
+  while (in < end)
+  {
+    target += (int)readVarint(&in);
+    targets[count] = target;
+    weights[count] = (int)readVarint(&in);
+    count++;
+  }
+  return count;
+}
+
+size_t compressedGraphBytes(CompressedGraph *graph)
+{
+  return sizeof(CompressedGraph) +
+         (graph->numVertices + 1) * sizeof(int64_t) +
+         graph->offsets[graph->numVertices];
+}
+
+void deleteCompressedGraph(CompressedGraph *graph)
+{
+  if (graph)
+  {
+    free(graph->offsets);
+    free(graph->data);
+    free(graph);
+  }
+}
@@ -0,0 +1,64 @@
+/*
+ * Header file for our compressed adjacency storage.
+ *
+ * A CompressedGraph keeps each vertex's edges as one run of bytes. The
+ * edges of a run are sorted by "to" vertex, and each edge is written as two
+ * varints (7 bits per byte, low bits first, high bit set on all but the
+ * last byte):
+ *   - the gap to the previous "to" vertex, or, for the first edge, the
+ *     distance from the vertex itself, zigzag-encoded since it may be
+ *     negative,
+ *   - the weight.
+ * On a graph with good locality (see graph_reorder.h) most gaps and small
+ * weights take one byte each, so an edge typically takes 2 to 4 bytes
+ * instead of 8 in a CSRGraph or 28 in a Graph.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "csr_graph.h"
+#include "threadpool.h"
+
+#ifndef __Compressed_Graph_header
+#define __Compressed_Graph_header
+
+typedef struct compressed_graph
+{
+  int numVertices;   // total number of vertices
+  int64_t numEdges;  // total number of edges
+  int maxDegree;     // largest number of edges leaving one vertex
+  int64_t* offsets;  // numVertices + 1 entries; the run of vertex v is
+                     //   data[offsets[v]], ..., data[offsets[v + 1] - 1]
+  uint8_t* data;     // the runs of all vertices, one after the other
+} CompressedGraph;
+
+/*
+ * Returns a newly created CompressedGraph with the same vertices and edges
+ * as 'csr', encoding vertices in parallel on the workers of 'pool' (which
+ * may be NULL). Each vertex's edges end up sorted by "to" vertex. Returns
+ * NULL if memory could not be allocated.
+ */
+CompressedGraph* compressGraph(CSRGraph* csr, ThreadPool* pool);
+
+/*
+ * Decodes the edges leaving vertex 'id' of 'graph' into 'targets' and
+ * 'weights', which must have room for graph->maxDegree entries each, and
+ * returns their number.
+ */
+int decodeNeighbors(CompressedGraph* graph, int id, int* targets,
+                    int* weights);
+
+/*
+ * Returns the number of bytes of memory used by 'graph'.
+ */
+size_t compressedGraphBytes(CompressedGraph* graph);
+
+/*
+ * Frees all memory allocated for 'graph'.
+ */
+void deleteCompressedGraph(CompressedGraph* graph);
+
+#endif
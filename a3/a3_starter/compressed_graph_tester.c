@@ -0,0 +1,338 @@
+/*
+ *  Randomized testing of our CompressedGraph (see compressed_graph.h).
+ *
+ *  Random graphs, directed and undirected, with parallel edges, self-loops,
+ *  edges to lower and higher IDs, hubs, and weights up to INT_MAX, are
+ *  compressed with and without a pool of workers. Every vertex must decode
+ *  to its edges in the CSRGraph, sorted by "to" vertex. Dijkstra's
+ *  algorithm must then find the same distances on both graphs, and Prim's
+ *  algorithm trees of the same weight, on graphs whose paths cannot
+ *  overflow. Prints the first mismatches found and exits with a non-zero
+ *  status if there were any.
+ *
+ *  ---------------------------------------------------------------------------
+ *   Compile:
+ *   gcc -Wall -Werror -pthread graph.c minheap.c csr_graph.c \
+ *       compressed_graph.c graph_algos.c threadpool.c \
+ *       compressed_graph_tester.c -o compressed_graph_tester
+ *
+ *   Run:
+ *   ./compressed_graph_tester [seed]
+ *  ---------------------------------------------------------------------------
+ */
+
+#include <limits.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "compressed_graph.h"
+#include "csr_graph.h"
+#include "graph.h"
+#include "graph_algos.h"
+#include "threadpool.h"
+
+#define POOL_THREADS 3
+#define SOURCES_PER_GRAPH 5
+#define MAX_REPORTED 10  // mismatches printed before only counting them
+
+uint64_t randomState;
+int numMismatches;
+
+/*
+ * Returns a pseudo-random number in 0, 1, ..., bound-1 (splitmix64).
+ */
+int randomBelow(int bound)
+{
+  uint64_t z = (randomState += 0x9e3779b97f4a7c15ULL);
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+  z ^= z >> 31;
+  return (int)((z >> 33) % (uint64_t)bound);
+}
+
+/*
+ * Prints a mismatch found on graph 'name', and counts it.
+ */
+void reportMismatch(const char* name, const char* what, int vertex,
+                    long long expected, long long actual)
+{
+  if (++numMismatches <= MAX_REPORTED)
+  {
+    printf("%s: %s of vertex %d is %lld, expected %lld\n", name, what, vertex,
+           actual, expected);
+  }
+}
+
+/*
+ * Returns a random weight: mostly small, sometimes large enough to take
+ * the longest varints, up to 'maxWeight'.
+ */
+int randomWeight(int maxWeight)
+{
+  switch (randomBelow(8))
+  {
+    case 0:
+      return maxWeight - randomBelow(3);
+    case 1:
+      return randomBelow(maxWeight);
+    default:
+      return randomBelow(128);
+  }
+}
+
+/*
+ * Returns a random graph with 'numVertices' vertices and 'numEdges' edges,
+ * or pairs of opposite edges if 'undirected'. A tenth of the edges leave
+ * vertex 0, a hub.
+ */
+Graph* newRandomGraph(int numVertices, int numEdges, int maxWeight,
+                      bool undirected)
+{
+  Graph* graph = newGraph(numVertices);
+  for (int v = 0; v < numVertices; v++)
+    graph->vertices[v] = newVertex(v, NULL, NULL);
+  for (int i = 0; i < numEdges; i++)
+  {
+    int from = randomBelow(10) == 0 ? 0 : randomBelow(numVertices);
+    int to = randomBelow(numVertices);
+    int weight = randomWeight(maxWeight);
+    insertGraphEdge(graph, from, to, weight);
+    if (undirected)
+      insertGraphEdge(graph, to, from, weight);
+  }
+  return graph;
+}
+
+int compareEdges(const void* a, const void* b)
+{
+  const int* x = (const int*)a;
+  const int* y = (const int*)b;
+  if (x[0] != y[0])
+  {
+    return x[0] < y[0] ? -1 : 1;
+  }
+  return (x[1] > y[1]) - (x[1] < y[1]);
+}
+
+/*
+ * Checks that every vertex of 'compressed' decodes to the edges of that
+ * vertex in 'csr', sorted by "to" vertex.
+ */
+void checkDecoding(const char* name, CSRGraph* csr,
+                   CompressedGraph* compressed)
+{
+  if (compressed->numVertices != csr->numVertices ||
+      compressed->numEdges != csr->numEdges)
+  {
+    reportMismatch(name, "number of edges", -1, csr->numEdges,
+                   compressed->numEdges);
+    return;
+  }
+  int maxDegree = 0;
+  for (int v = 0; v < csr->numVertices; v++)
+  {
+    int degree = (int)(csr->offsets[v + 1] - csr->offsets[v]);
+    maxDegree = degree > maxDegree ? degree : maxDegree;
+  }
+  if (compressed->maxDegree != maxDegree)
+  {
+    reportMismatch(name, "maxDegree", -1, maxDegree, compressed->maxDegree);
+    return;
+  }
+
+  int* targets = (int*)malloc((maxDegree + 1) * sizeof(int));
+  int* weights = (int*)malloc((maxDegree + 1) * sizeof(int));
+  int* expected = (int*)malloc(2 * (maxDegree + 1) * sizeof(int));
+  int* actual = (int*)malloc(2 * (maxDegree + 1) * sizeof(int));
+  if (targets == NULL || weights == NULL || expected == NULL ||
+      actual == NULL)
+  {
+    printf("Memory allocation failed\n");
+    exit(EXIT_FAILURE);
+  }
+  for (int v = 0; v < csr->numVertices; v++)
+  {
+    int degree = (int)(csr->offsets[v + 1] - csr->offsets[v]);
+    int decoded = decodeNeighbors(compressed, v, targets, weights);
+    if (decoded != degree)
+    {
+      reportMismatch(name, "decoded degree", v, degree, decoded);
+      continue;
+    }
+    for (int i = 0; i < degree; i++)
+    {
+      if (i > 0 && targets[i] < targets[i - 1])
+      {
+        reportMismatch(name, "decoded target after a larger one", v,
+                       targets[i - 1], targets[i]);
+      }
+      expected[2 * i] = csr->targets[csr->offsets[v] + i];
+      expected[2 * i + 1] = csr->weights[csr->offsets[v] + i];
+      actual[2 * i] = targets[i];
+      actual[2 * i + 1] = weights[i];
+    }
+    // Edges with the same target may come out in any order
+    qsort(expected, degree, 2 * sizeof(int), compareEdges);
+    qsort(actual, degree, 2 * sizeof(int), compareEdges);
+    for (int i = 0; i < 2 * degree; i++)
+    {
+      if (actual[i] != expected[i])
+      {
+        reportMismatch(name, i % 2 ? "decoded weight" : "decoded target", v,
+                       expected[i], actual[i]);
+        break;
+      }
+    }
+  }
+  free(actual);
+  free(expected);
+  free(weights);
+  free(targets);
+}
+
+/*
+ * Returns the total weight of the 'numEdges' edges in 'tree'.
+ */
+long long treeWeight(Edge* tree, int numEdges)
+{
+  long long total = 0;
+  for (int i = 0; i < numEdges; i++)
+  {
+    total += tree[i].weight;
+  }
+  return total;
+}
+
+/*
+ * Runs Dijkstra's algorithm, and Prim's if 'undirected', from random
+ * vertices of both 'csr' and 'compressed', and compares the results.
+ * Dijkstra's distances are unique, and so is the weight of a minimum
+ * spanning tree, though ties may pick different trees.
+ */
+void checkAlgorithms(const char* name, CSRGraph* csr,
+                     CompressedGraph* compressed, bool undirected)
+{
+  int n = csr->numVertices;
+  Workspace* csrWs = newWorkspace(n);
+  Workspace* compressedWs = newWorkspace(n);
+  Edge* csrTree = (Edge*)malloc(n * sizeof(Edge));
+  Edge* compressedTree = (Edge*)malloc(n * sizeof(Edge));
+  if (csrWs == NULL || compressedWs == NULL || csrTree == NULL ||
+      compressedTree == NULL)
+  {
+    printf("Memory allocation failed\n");
+    exit(EXIT_FAILURE);
+  }
+  for (int i = 0; i < SOURCES_PER_GRAPH; i++)
+  {
+    int source = randomBelow(n);
+    int expected = getDistanceTreeDijkstraCSR(csrWs, csr, source, csrTree);
+    int actual = getDistanceTreeDijkstraCompressed(compressedWs, compressed,
+                                                   source, compressedTree);
+    if (actual != expected)
+    {
+      reportMismatch(name, "Dijkstra tree edges from", source, expected,
+                     actual);
+    }
+    for (int v = 0; v < n; v++)
+    {
+      if (getWorkspaceDistance(compressedWs, v) !=
+          getWorkspaceDistance(csrWs, v))
+      {
+        reportMismatch(name, "Dijkstra distance", v,
+                       getWorkspaceDistance(csrWs, v),
+                       getWorkspaceDistance(compressedWs, v));
+      }
+    }
+
+    if (!undirected)
+    {
+      continue;
+    }
+    expected = getMSTprimCSR(csrWs, csr, source, csrTree);
+    actual = getMSTprimCompressed(compressedWs, compressed, source,
+                                  compressedTree);
+    if (actual != expected)
+    {
+      reportMismatch(name, "MST edges from", source, expected, actual);
+    }
+    else if (treeWeight(compressedTree, actual) !=
+             treeWeight(csrTree, expected))
+    {
+      reportMismatch(name, "MST weight from", source,
+                     treeWeight(csrTree, expected),
+                     treeWeight(compressedTree, actual));
+    }
+  }
+  free(compressedTree);
+  free(csrTree);
+  deleteWorkspace(compressedWs);
+  deleteWorkspace(csrWs);
+}
+
+/*
+ * Builds a random graph, compresses it with pool NULL and with 'pool', and
+ * checks each compressed graph.
+ */
+void testRandomGraph(const char* name, int numVertices, int numEdges,
+                     int maxWeight, bool undirected, ThreadPool* pool)
+{
+  Graph* graph = newRandomGraph(numVertices, numEdges, maxWeight, undirected);
+  CSRGraph* csr = csrFromGraph(graph);
+  if (csr == NULL)
+  {
+    printf("Memory allocation failed\n");
+    exit(EXIT_FAILURE);
+  }
+  ThreadPool* pools[] = {NULL, pool};
+  size_t bytes = 0;
+  for (int p = 0; p < 2; p++)
+  {
+    CompressedGraph* compressed = compressGraph(csr, pools[p]);
+    if (compressed == NULL)
+    {
+      printf("Memory allocation failed\n");
+      exit(EXIT_FAILURE);
+    }
+    checkDecoding(name, csr, compressed);
+    if ((long long)maxWeight * numVertices < INT_MAX)  // no path overflows
+    {
+      checkAlgorithms(name, csr, compressed, undirected);
+    }
+    bytes = compressedGraphBytes(compressed);
+    deleteCompressedGraph(compressed);
+  }
+  printf("%s: %d vertices, %lld edges, %zu bytes: %d mismatches so far\n",
+         name, numVertices, (long long)csr->numEdges, bytes, numMismatches);
+  deleteCSRGraph(csr);
+  deleteGraph(graph);
+}
+
+int main(int argc, char* argv[])
+{
+  randomState = argc > 1 ? strtoull(argv[1], NULL, 10) : 1;
+  ThreadPool* pool = newThreadPool(POOL_THREADS);
+  if (pool == NULL)
+  {
+    printf("Memory allocation failed\n");
+    exit(EXIT_FAILURE);
+  }
+
+  testRandomGraph("one vertex", 1, 3, 10, false, pool);  // self-loops
+  testRandomGraph("no edges", 100, 0, 10, false, pool);
+  testRandomGraph("directed", 2000, 10000, 1000, false, pool);
+  testRandomGraph("undirected", 2000, 8000, 1000, true, pool);
+  testRandomGraph("parallel edges", 20, 2000, 50, true, pool);
+  testRandomGraph("large weights", 5000, 20000, INT_MAX, false, pool);
+  testRandomGraph("large, undirected", 50000, 150000, 1 << 14, true, pool);
+
+  deleteThreadPool(pool);
+  if (numMismatches > 0)
+  {
+    printf("FAILED: %d mismatches\n", numMismatches);
+    return EXIT_FAILURE;
+  }
+  printf("All CompressedGraph results match the CSRGraph.\n");
+  return EXIT_SUCCESS;
+}
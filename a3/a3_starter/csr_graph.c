@@ -0,0 +1,344 @@
+/*
+ * Our CSR graph implementation.
+ *
+ * In memory and on disk a CSRGraph uses the same block layout, header
+ * included, so saving one is a single write and mapping one needs no
+ * fix-ups.
+ */
+
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "csr_graph.h"
+
+#define CSR_MAGIC "B63CSR\0"
+#define CSR_BYTE_ORDER 0x01020304u
+
+/*
+ * The first bytes of a binary graph file.
+ */
+typedef struct csr_file_header
+{
+  char magic[8];          // CSR_MAGIC
+  uint32_t byteOrder;     // CSR_BYTE_ORDER in the writer's byte order
+  uint32_t version;       // CSR_FORMAT_VERSION
+  int64_t numVertices;
+  int64_t numEdges;
+  uint64_t offsetsStart;  // byte position of the offsets array
+  uint64_t targetsStart;  // byte position of the targets array
+  uint64_t weightsStart;  // byte position of the weights array
+  uint64_t checksum;      // csrChecksum of everything after the header
+} CSRFileHeader;
+
+_Static_assert(sizeof(CSRFileHeader) == CSR_ALIGNMENT,
+               "the offsets array must start right after the header");
+
+/*
+ * Positions of the parts of a CSR block.
+ */
+typedef struct csr_layout
+{
+  size_t offsetsStart;
+  size_t targetsStart;
+  size_t weightsStart;
+  size_t totalSize;       // a multiple of CSR_ALIGNMENT
+} CSRLayout;
+
+/*
+ * Rounds 'size' up to a multiple of CSR_ALIGNMENT.
+ */
+size_t alignSize(size_t size)
+{
+  return (size + CSR_ALIGNMENT - 1) / CSR_ALIGNMENT * CSR_ALIGNMENT;
+}
+
+/*
+ * Returns the layout of a CSR block for the given graph size.
+ */
+CSRLayout csrLayout(int64_t numVertices, int64_t numEdges)
+{
+  CSRLayout layout;
+  layout.offsetsStart = alignSize(sizeof(CSRFileHeader));
+  layout.targetsStart = layout.offsetsStart +
+                        alignSize((numVertices + 1) * sizeof(int64_t));
+  layout.weightsStart =
+      layout.targetsStart + alignSize(numEdges * sizeof(int));
+  layout.totalSize = layout.weightsStart + alignSize(numEdges * sizeof(int));
+  return layout;
+}
+
+/*
+ * Points the arrays of 'csr' into the CSR block at 'memory'.
+ */
+void attachArrays(CSRGraph *csr, void *memory, CSRLayout layout)
+{
+  char *base = (char *)memory;
+  csr->memory = memory;
+  csr->offsets = (int64_t *)(base + layout.offsetsStart);
+  csr->targets = (int *)(base + layout.targetsStart);
+  csr->weights = (int *)(base + layout.weightsStart);
+}
+
+/*
+ * Returns a 64-bit FNV-1a style hash of the 'size' bytes at 'data', taken a
+ * word at a time. Precondition: 'size' is a multiple of 8
+ */
+uint64_t csrChecksum(const void *data, size_t size)
+{
+  const uint64_t *words = (const uint64_t *)data;
+  uint64_t hash = 0xcbf29ce484222325ull;
+  for (size_t i = 0; i < size / sizeof(uint64_t); i++)
+  {
+    hash = (hash ^ words[i]) * 0x100000001b3ull;
+  }
+  return hash;
+}
+
+CSRGraph *newCSRGraph(int numVertices, int64_t numEdges)
+{
+  CSRGraph *csr = (CSRGraph *)malloc(sizeof(CSRGraph));
+  if (!csr)
+  {
+    return NULL;
+  }
+  CSRLayout layout = csrLayout(numVertices, numEdges);
+  void *memory = calloc(layout.totalSize, 1); // zeroes offsets and padding
+  if (!memory)
+  {
+    free(csr);
+    return NULL;
+  }
+  csr->numVertices = numVertices;
+  csr->numEdges = numEdges;
+  csr->checksum = 0;
+  csr->mappedSize = 0;
+  attachArrays(csr, memory, layout);
+  return csr;
+}
+
+CSRGraph *csrFromGraph(Graph *graph)
+{
+  int64_t numEdges = 0;
+  for (int v = 0; v < graph->numVertices; v++)
+  {
+    if (graph->vertices[v] == NULL)
+    {
+      continue;
+    }
+    for (EdgeList *adj = graph->vertices[v]->adjList; adj; adj = adj->next)
+    {
+      numEdges++;
+    }
+  }
+
+  CSRGraph *csr = newCSRGraph(graph->numVertices, numEdges);
+  if (!csr)
+  {
+    return NULL;
+  }
+  int64_t e = 0;
+  for (int v = 0; v < graph->numVertices; v++)
+  {
+    csr->offsets[v] = e;
+    if (graph->vertices[v] == NULL)
+    {
+      continue;
+    }
+    for (EdgeList *adj = graph->vertices[v]->adjList; adj; adj = adj->next)
+    {
+      csr->targets[e] = adj->edge->toVertex;
+      csr->weights[e] = adj->edge->weight;
+      e++;
+    }
+  }
+  csr->offsets[graph->numVertices] = e;
+  return csr;
+}
+
+CSRGraph *transposeCSRGraph(CSRGraph *csr)
+{
+  CSRGraph *reversed = newCSRGraph(csr->numVertices, csr->numEdges);
+  if (!reversed)
+  {
+    return NULL;
+  }
+  int64_t *next = reversed->offsets; // next free slot of each vertex
+  for (int64_t e = 0; e < csr->numEdges; e++)
+  {
+    next[csr->targets[e] + 1]++;
+  }
+  for (int v = 0; v < csr->numVertices; v++)
+  {
+    next[v + 1] += next[v];
+  }
+  for (int u = 0; u < csr->numVertices; u++)
+  {
+    for (int64_t e = csr->offsets[u]; e < csr->offsets[u + 1]; e++)
+    {
+      int64_t slot = next[csr->targets[e]]++;
+      reversed->targets[slot] = u;
+      reversed->weights[slot] = csr->weights[e];
+    }
+  }
+  // each next[v] has moved on to the start of v + 1
+  for (int v = csr->numVertices; v > 0; v--)
+  {
+    next[v] = next[v - 1];
+  }
+  next[0] = 0;
+  return reversed;
+}
+
+bool writeCSRGraph(CSRGraph *csr, const char *path)
+{
+  CSRLayout layout = csrLayout(csr->numVertices, csr->numEdges);
+  const char *base = (const char *)csr->memory;
+
+  CSRFileHeader header;
+  memset(&header, 0, sizeof(header));
+  memcpy(header.magic, CSR_MAGIC, sizeof(header.magic));
+  header.byteOrder = CSR_BYTE_ORDER;
+  header.version = CSR_FORMAT_VERSION;
+  header.numVertices = csr->numVertices;
+  header.numEdges = csr->numEdges;
+  header.offsetsStart = layout.offsetsStart;
+  header.targetsStart = layout.targetsStart;
+  header.weightsStart = layout.weightsStart;
+  header.checksum = csrChecksum(base + layout.offsetsStart,
+                                layout.totalSize - layout.offsetsStart);
+
+  FILE *f = fopen(path, "wb");
+  if (f == NULL)
+  {
+    fprintf(stderr, "Unable to open the output file: %s\n", path);
+    return false;
+  }
+  size_t rest = layout.totalSize - layout.offsetsStart;
+  bool ok = fwrite(&header, sizeof(header), 1, f) == 1 &&
+            fwrite(base + layout.offsetsStart, 1, rest, f) == rest;
+  ok = fclose(f) == 0 && ok;
+  if (!ok)
+  {
+    fprintf(stderr, "Unable to write the output file: %s\n", path);
+  }
+  return ok;
+}
+
+CSRGraph *mapCSRGraph(const char *path)
+{
+  int fd = open(path, O_RDONLY);
+  if (fd == -1)
+  {
+    fprintf(stderr, "Unable to open the specified input file: %s\n", path);
+    return NULL;
+  }
+  struct stat info;
+  if (fstat(fd, &info) == -1 || (size_t)info.st_size < sizeof(CSRFileHeader))
+  {
+    printf("Not a binary graph file: %s. Giving up.\n", path);
+    close(fd);
+    return NULL;
+  }
+  void *memory = mmap(NULL, info.st_size, PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+  if (memory == MAP_FAILED)
+  {
+    fprintf(stderr, "Unable to map the specified input file: %s\n", path);
+    return NULL;
+  }
+
+  const CSRFileHeader *header = (const CSRFileHeader *)memory;
+  const char *problem = NULL;
+  CSRLayout layout = csrLayout(header->numVertices, header->numEdges);
+  if (memcmp(header->magic, CSR_MAGIC, sizeof(header->magic)) != 0)
+  {
+    problem = "not a binary graph file";
+  }
+  else if (header->byteOrder != CSR_BYTE_ORDER)
+  {
+    problem = "written on a machine with a different byte order";
+  }
+  else if (header->version != CSR_FORMAT_VERSION)
+  {
+    problem = "unsupported format version";
+  }
+  else if (header->numVertices < 0 || header->numVertices >= INT32_MAX ||
+           header->numEdges < 0 || header->numEdges > info.st_size ||
+           header->offsetsStart != layout.offsetsStart ||
+           header->targetsStart != layout.targetsStart ||
+           header->weightsStart != layout.weightsStart ||
+           (size_t)info.st_size < layout.totalSize)
+  {
+    problem = "corrupt header";
+  }
+
+  CSRGraph *csr = NULL;
+  if (problem == NULL)
+  {
+    csr = (CSRGraph *)malloc(sizeof(CSRGraph));
+    problem = csr ? NULL : "out of memory";
+  }
+  if (problem != NULL)
+  {
+    printf("Could not map %s: %s. Giving up.\n", path, problem);
+    munmap(memory, info.st_size);
+    return NULL;
+  }
+
+  csr->numVertices = (int)header->numVertices;
+  csr->numEdges = header->numEdges;
+  csr->checksum = header->checksum;
+  csr->mappedSize = info.st_size;
+  attachArrays(csr, memory, layout);
+  return csr;
+}
+
+bool verifyCSRGraph(CSRGraph *csr)
+{
+  CSRLayout layout = csrLayout(csr->numVertices, csr->numEdges);
+  const char *base = (const char *)csr->memory;
+  if (csrChecksum(base + layout.offsetsStart,
+                  layout.totalSize - layout.offsetsStart) != csr->checksum)
+  {
+    return false;
+  }
+  if (csr->offsets[0] != 0 || csr->offsets[csr->numVertices] != csr->numEdges)
+  {
+    return false;
+  }
+  for (int v = 0; v < csr->numVertices; v++)
+  {
+    if (csr->offsets[v] > csr->offsets[v + 1])
+    {
+      return false;
+    }
+  }
+  for (int64_t e = 0; e < csr->numEdges; e++)
+  {
+    if (csr->targets[e] < 0 || csr->targets[e] >= csr->numVertices ||
+        csr->weights[e] < 0)
+    {
+      return false;
+    }
+  }
+  return true;
+}
+
+void deleteCSRGraph(CSRGraph *csr)
+{
+  if (csr)
+  {
+    if (csr->mappedSize > 0)
+    {
+      munmap(csr->memory, csr->mappedSize);
+    }
+    else
+    {
+      free(csr->memory);
+    }
+    free(csr);
+  }
+}
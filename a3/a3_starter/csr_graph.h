@@ -0,0 +1,92 @@
+/*
+ * Header file for our compressed sparse row (CSR) graph.
+ *
+ * A CSRGraph stores all edges in three flat arrays instead of linked
+ * adjacency lists: the edges leaving vertex v are
+ *   (v -- targets[e], weights[e])  for offsets[v] <= e < offsets[v + 1]
+ * in the same order as in v's adjacency list in the Graph it was built from.
+ *
+ * CSRGraphs can be saved in a binary file and mapped back into memory
+ * without copying or parsing, so opening one takes the same time for any
+ * graph size. The file is laid out as
+ *   header | offsets (numVertices + 1 int64) | targets | weights
+ * with each array starting on a CSR_ALIGNMENT byte boundary. The header
+ * records the format version, the byte order of the machine that wrote the
+ * file, the section positions and a checksum of the three arrays.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "graph.h"
+
+#ifndef __CSR_Graph_header
+#define __CSR_Graph_header
+
+#define CSR_FORMAT_VERSION 1
+#define CSR_ALIGNMENT 64
+
+typedef struct csr_graph
+{
+  int numVertices;   // total number of vertices
+  int64_t numEdges;  // total number of edges
+  int64_t* offsets;  // numVertices + 1 entries; offsets[numVertices] = numEdges
+  int* targets;      // numEdges "to" vertex IDs
+  int* weights;      // numEdges weights; weights[e] >= 0
+  uint64_t checksum; // checksum from the file header, or 0 if not mapped
+  void* memory;      // block holding the arrays: malloc'd, or a file mapping
+  size_t mappedSize; // size of the file mapping, or 0 if 'memory' is malloc'd
+} CSRGraph;
+
+/*
+ * Returns a newly created CSRGraph with room for 'numVertices' vertices and
+ * 'numEdges' edges, with all offsets set to 0, or NULL if memory could not be
+ * allocated. The caller fills in the arrays.
+ * Precondition: numVertices >= 0, numEdges >= 0
+ */
+CSRGraph* newCSRGraph(int numVertices, int64_t numEdges);
+
+/*
+ * Returns a newly created CSRGraph with the same vertices and edges as
+ * 'graph', or NULL if memory could not be allocated.
+ */
+CSRGraph* csrFromGraph(Graph* graph);
+
+/*
+ * Returns a newly created CSRGraph with every edge of 'csr' reversed: the
+ * edges leaving v are the edges entering v in 'csr', ordered by their
+ * "from" vertex. Returns NULL if memory could not be allocated.
+ */
+CSRGraph* transposeCSRGraph(CSRGraph* csr);
+
+/*
+ * Saves 'csr' to a binary file at 'path'. Returns true iff successful.
+ */
+bool writeCSRGraph(CSRGraph* csr, const char* path);
+
+/*
+ * Maps the binary graph file at 'path' into memory and returns a CSRGraph
+ * whose arrays point straight into the mapping. The arrays are read-only:
+ * writing to them crashes. Only the header is checked, so this takes O(1)
+ * time; call verifyCSRGraph to check the contents.
+ * Returns NULL, after printing the reason, if the file cannot be mapped, is
+ * not a binary graph of version CSR_FORMAT_VERSION, or was written on a
+ * machine with a different byte order.
+ */
+CSRGraph* mapCSRGraph(const char* path);
+
+/*
+ * Returns true iff the arrays of the mapped graph 'csr' match the checksum
+ * in its file header, its offsets are non-decreasing, and every target is a
+ * valid vertex ID. Takes O(numVertices + numEdges) time.
+ */
+bool verifyCSRGraph(CSRGraph* csr);
+
+/*
+ * Frees all memory allocated for 'csr', or unmaps its file.
+ */
+void deleteCSRGraph(CSRGraph* csr);
+
+#endif
@@ -0,0 +1,384 @@
+/*
+ *  Randomized testing of our CSRGraph files (see csr_graph.h).
+ *
+ *  Random graphs are written with writeCSRGraph, mapped back with
+ *  mapCSRGraph, and must pass verifyCSRGraph and equal the original. Then
+ *  copies of each file get a wrong magic, a byte-swapped byte order mark, a
+ *  newer version, a truncated payload, or one changed payload byte in the
+ *  offsets, targets or weights: mapCSRGraph or verifyCSRGraph must reject
+ *  every one of them. Each graph's transpose must hold its edges reversed,
+ *  ordered by "from" vertex, and transposing twice must give back the
+ *  graph up to the order of each vertex's edges. Prints the first
+ *  mismatches found and exits with a non-zero status if there were any.
+ *
+ *  ---------------------------------------------------------------------------
+ *   Compile:
+ *   gcc -Wall -Werror graph.c csr_graph.c csr_graph_tester.c \
+ *       -o csr_graph_tester
+ *
+ *   Run:
+ *   ./csr_graph_tester [seed]
+ *  ---------------------------------------------------------------------------
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "csr_graph.h"
+#include "graph.h"
+
+#define MAX_WEIGHT 1000
+#define MAX_REPORTED 10  // mismatches printed before only counting them
+
+/*
+ * Byte positions of fields of the file header (see CSRFileHeader in
+ * csr_graph.c).
+ */
+#define MAGIC_BYTE 0
+#define BYTE_ORDER_BYTE 8
+#define VERSION_BYTE 12
+
+uint64_t randomState;
+int numMismatches;
+
+/*
+ * Returns a pseudo-random number in 0, 1, ..., bound-1 (splitmix64).
+ */
+int randomBelow(int bound)
+{
+  uint64_t z = (randomState += 0x9e3779b97f4a7c15ULL);
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+  z ^= z >> 31;
+  return (int)((z >> 33) % (uint64_t)bound);
+}
+
+/*
+ * Prints a mismatch found in graph 'name', and counts it.
+ */
+void reportMismatch(const char* name, const char* what, long long where,
+                    long long expected, long long actual)
+{
+  if (++numMismatches <= MAX_REPORTED)
+  {
+    printf("%s: %s %lld is %lld, expected %lld\n", name, what, where, actual,
+           expected);
+  }
+}
+
+/*
+ * Returns the CSRGraph of a random directed graph with 'numVertices'
+ * vertices and 'numEdges' edges.
+ */
+CSRGraph* newRandomCSR(int numVertices, int numEdges)
+{
+  Graph* graph = newGraph(numVertices);
+  for (int v = 0; v < numVertices; v++)
+    graph->vertices[v] = newVertex(v, NULL, NULL);
+  for (int i = 0; i < numEdges; i++)
+    insertGraphEdge(graph, randomBelow(numVertices), randomBelow(numVertices),
+                    randomBelow(MAX_WEIGHT + 1));
+  CSRGraph* csr = csrFromGraph(graph);
+  deleteGraph(graph);
+  if (csr == NULL)
+  {
+    printf("Memory allocation failed\n");
+    exit(EXIT_FAILURE);
+  }
+  return csr;
+}
+
+int compareEdges(const void* a, const void* b)
+{
+  const int* x = (const int*)a;
+  const int* y = (const int*)b;
+  if (x[0] != y[0])
+  {
+    return x[0] < y[0] ? -1 : 1;
+  }
+  return (x[1] > y[1]) - (x[1] < y[1]);
+}
+
+/*
+ * Checks that 'actual' has the vertices and edges of 'expected'. If
+ * 'anyOrder', each vertex's edges may be in any order.
+ */
+void checkSameCSR(const char* name, CSRGraph* expected, CSRGraph* actual,
+                  bool anyOrder)
+{
+  if (actual->numVertices != expected->numVertices ||
+      actual->numEdges != expected->numEdges)
+  {
+    reportMismatch(name, "edge count of a graph with vertices",
+                   actual->numVertices, expected->numEdges, actual->numEdges);
+    return;
+  }
+  for (int v = 0; v <= expected->numVertices; v++)
+  {
+    if (actual->offsets[v] != expected->offsets[v])
+    {
+      reportMismatch(name, "offset of vertex", v, expected->offsets[v],
+                     actual->offsets[v]);
+      return;
+    }
+  }
+  // (target, weight) pairs, sorted per vertex if 'anyOrder'
+  int* expectedPairs = (int*)malloc((2 * expected->numEdges + 1) * sizeof(int));
+  int* actualPairs = (int*)malloc((2 * expected->numEdges + 1) * sizeof(int));
+  if (expectedPairs == NULL || actualPairs == NULL)
+  {
+    printf("Memory allocation failed\n");
+    exit(EXIT_FAILURE);
+  }
+  for (int64_t e = 0; e < expected->numEdges; e++)
+  {
+    expectedPairs[2 * e] = expected->targets[e];
+    expectedPairs[2 * e + 1] = expected->weights[e];
+    actualPairs[2 * e] = actual->targets[e];
+    actualPairs[2 * e + 1] = actual->weights[e];
+  }
+  for (int v = 0; anyOrder && v < expected->numVertices; v++)
+  {
+    int64_t first = expected->offsets[v];
+    size_t degree = expected->offsets[v + 1] - first;
+    qsort(expectedPairs + 2 * first, degree, 2 * sizeof(int), compareEdges);
+    qsort(actualPairs + 2 * first, degree, 2 * sizeof(int), compareEdges);
+  }
+  for (int64_t i = 0; i < 2 * expected->numEdges; i++)
+  {
+    if (actualPairs[i] != expectedPairs[i])
+    {
+      reportMismatch(name, i % 2 ? "weight of edge" : "target of edge", i / 2,
+                     expectedPairs[i], actualPairs[i]);
+      break;
+    }
+  }
+  free(actualPairs);
+  free(expectedPairs);
+}
+
+/*
+ * Returns the transpose of 'csr', built by a plain counting sort: the edges
+ * entering each vertex, ordered by "from" vertex.
+ */
+CSRGraph* referenceTranspose(CSRGraph* csr)
+{
+  CSRGraph* transpose = newCSRGraph(csr->numVertices, csr->numEdges);
+  int64_t* next = (int64_t*)calloc(csr->numVertices + 1, sizeof(int64_t));
+  if (transpose == NULL || next == NULL)
+  {
+    printf("Memory allocation failed\n");
+    exit(EXIT_FAILURE);
+  }
+  for (int64_t e = 0; e < csr->numEdges; e++)
+  {
+    transpose->offsets[csr->targets[e] + 1]++;
+  }
+  for (int v = 0; v < csr->numVertices; v++)
+  {
+    transpose->offsets[v + 1] += transpose->offsets[v];
+    next[v] = transpose->offsets[v];
+  }
+  for (int u = 0; u < csr->numVertices; u++)
+  {
+    for (int64_t e = csr->offsets[u]; e < csr->offsets[u + 1]; e++)
+    {
+      int64_t slot = next[csr->targets[e]]++;
+      transpose->targets[slot] = u;
+      transpose->weights[slot] = csr->weights[e];
+    }
+  }
+  free(next);
+  return transpose;
+}
+
+/*
+ * Copies 'size' bytes from 'data' to the file at 'path'.
+ */
+void writeBytes(const char* path, const char* data, size_t size)
+{
+  FILE* file = fopen(path, "wb");
+  if (file == NULL || fwrite(data, 1, size, file) != size || fclose(file))
+  {
+    printf("Could not write %s\n", path);
+    exit(EXIT_FAILURE);
+  }
+}
+
+/*
+ * Returns the contents of the file at 'path', and sets 'size' to its size.
+ */
+char* readBytes(const char* path, size_t* size)
+{
+  FILE* file = fopen(path, "rb");
+  if (file == NULL || fseek(file, 0, SEEK_END) != 0)
+  {
+    printf("Could not read %s\n", path);
+    exit(EXIT_FAILURE);
+  }
+  *size = ftell(file);
+  char* data = (char*)malloc(*size);
+  rewind(file);
+  if (data == NULL || fread(data, 1, *size, file) != *size)
+  {
+    printf("Could not read %s\n", path);
+    exit(EXIT_FAILURE);
+  }
+  fclose(file);
+  return data;
+}
+
+/*
+ * Writes the first 'size' bytes of 'data', with 'data[at]' changed by
+ * 'delta' unless 'at' is -1, to 'path'. Checks that mapCSRGraph rejects
+ * the file if 'rejectedByMap', and otherwise that verifyCSRGraph rejects
+ * the mapped graph.
+ */
+void checkCorrupt(const char* name, const char* what, const char* path,
+                  char* data, size_t size, long long at, int delta,
+                  bool rejectedByMap)
+{
+  if (at >= 0)
+  {
+    data[at] += delta;
+  }
+  writeBytes(path, data, size);
+  if (at >= 0)
+  {
+    data[at] -= delta;
+  }
+
+  CSRGraph* mapped = mapCSRGraph(path);
+  bool verified = mapped && verifyCSRGraph(mapped);
+  if (rejectedByMap ? mapped != NULL : mapped == NULL || verified)
+  {
+    reportMismatch(name, what, at, false, mapped ? verified : -1);
+  }
+  deleteCSRGraph(mapped);
+}
+
+/*
+ * Writes 'csr' to a file, maps and verifies it, then checks that corrupt
+ * copies of the file are rejected, and checks its transposes.
+ */
+void testGraph(const char* name, CSRGraph* csr)
+{
+  char path[] = "/tmp/csr_graph_tester_XXXXXX";
+  int fd = mkstemp(path);
+  if (fd < 0)
+  {
+    printf("Could not create a temporary file\n");
+    exit(EXIT_FAILURE);
+  }
+  close(fd);
+
+  if (!writeCSRGraph(csr, path))
+  {
+    reportMismatch(name, "writeCSRGraph success, vertices", csr->numVertices,
+                   true, false);
+  }
+  CSRGraph* mapped = mapCSRGraph(path);
+  if (mapped == NULL || !verifyCSRGraph(mapped))
+  {
+    reportMismatch(name, "verified mapping, vertices", csr->numVertices, true,
+                   false);
+  }
+  else
+  {
+    checkSameCSR(name, csr, mapped, false);
+  }
+  deleteCSRGraph(mapped);
+
+  size_t size;
+  char* data = readBytes(path, &size);
+  int64_t n = csr->numVertices;
+  size_t targetsStart = 64 + (n + 1) * sizeof(int64_t);
+  targetsStart = (targetsStart + CSR_ALIGNMENT - 1) / CSR_ALIGNMENT *
+                 CSR_ALIGNMENT;
+  size_t weightsStart = targetsStart + csr->numEdges * sizeof(int);
+  weightsStart = (weightsStart + CSR_ALIGNMENT - 1) / CSR_ALIGNMENT *
+                 CSR_ALIGNMENT;
+
+  checkCorrupt(name, "magic changed at byte", path, data, size,
+               MAGIC_BYTE + randomBelow(6), 1, true);
+  uint32_t swapped;
+  memcpy(&swapped, data + BYTE_ORDER_BYTE, sizeof(swapped));
+  swapped = __builtin_bswap32(swapped);
+  char original[sizeof(swapped)];
+  memcpy(original, data + BYTE_ORDER_BYTE, sizeof(swapped));
+  memcpy(data + BYTE_ORDER_BYTE, &swapped, sizeof(swapped));
+  checkCorrupt(name, "byte order swapped at byte", path, data, size, -1, 0,
+               true);
+  memcpy(data + BYTE_ORDER_BYTE, original, sizeof(swapped));
+  checkCorrupt(name, "version changed at byte", path, data, size,
+               VERSION_BYTE, 1, true);
+  checkCorrupt(name, "file truncated at byte", path, data,
+               size - 1 - randomBelow(size - 64), -1, 0, true);
+  checkCorrupt(name, "offset changed at byte", path, data, size,
+               64 + randomBelow((n + 1) * sizeof(int64_t)),
+               1 + randomBelow(255), false);
+  if (csr->numEdges > 0)
+  {
+    checkCorrupt(name, "target changed at byte", path, data, size,
+                 targetsStart + randomBelow(csr->numEdges * sizeof(int)),
+                 1 + randomBelow(255), false);
+    checkCorrupt(name, "weight changed at byte", path, data, size,
+                 weightsStart + randomBelow(csr->numEdges * sizeof(int)),
+                 1 + randomBelow(255), false);
+  }
+  free(data);
+  unlink(path);
+
+  // Transposes
+  CSRGraph* transpose = transposeCSRGraph(csr);
+  CSRGraph* twice = transpose ? transposeCSRGraph(transpose) : NULL;
+  if (twice == NULL)
+  {
+    printf("Memory allocation failed\n");
+    exit(EXIT_FAILURE);
+  }
+  CSRGraph* expected = referenceTranspose(csr);
+  checkSameCSR(name, expected, transpose, false);
+  checkSameCSR(name, csr, twice, true);
+
+  printf("%s: %d vertices, %lld edges, %zu bytes: %d mismatches so far\n",
+         name, csr->numVertices, (long long)csr->numEdges, size,
+         numMismatches);
+  deleteCSRGraph(expected);
+  deleteCSRGraph(twice);
+  deleteCSRGraph(transpose);
+  deleteCSRGraph(csr);
+}
+
+int main(int argc, char* argv[])
+{
+  randomState = argc > 1 ? strtoull(argv[1], NULL, 10) : 1;
+
+  // mapCSRGraph prints why it rejects each corrupt file
+  testGraph("one vertex", newRandomCSR(1, 0));
+  testGraph("no edges", newRandomCSR(100, 0));
+  testGraph("self-loops", newRandomCSR(1, 20));
+  testGraph("small", newRandomCSR(10, 30));
+  testGraph("sparse", newRandomCSR(10000, 5000));
+  testGraph("dense", newRandomCSR(300, 60000));
+  testGraph("large", newRandomCSR(200000, 1000000));
+
+  CSRGraph* empty = newCSRGraph(0, 0);
+  if (mapCSRGraph("/nonexistent/graph.csr") != NULL ||
+      writeCSRGraph(empty, "/nonexistent/graph.csr"))
+  {
+    reportMismatch("missing directory", "success of mapping", 0, false, true);
+  }
+  deleteCSRGraph(empty);
+
+  if (numMismatches > 0)
+  {
+    printf("FAILED: %d mismatches\n", numMismatches);
+    return EXIT_FAILURE;
+  }
+  printf("All CSRGraph files round-trip and corrupt ones are rejected.\n");
+  return EXIT_SUCCESS;
+}
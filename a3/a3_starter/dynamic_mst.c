@@ -0,0 +1,379 @@
+/*
+ * Incremental minimum spanning forest on a link-cut tree.
+ *
+ * Every vertex and every forest edge is a node of the link-cut tree; edge
+ * nodes sit between the two vertex nodes they join and carry the edge
+ * weight, while vertex nodes carry INT_MIN. Each node also records the
+ * heaviest node in its splay subtree, so after exposing the path between
+ * two vertices the heaviest edge on it is read off the root of the splay
+ * tree. The forest has at most numVertices-1 edges, so edge nodes are
+ * recycled from a fixed pool.
+ */
+
+#include <limits.h>
+
+#include "dynamic_mst.h"
+#include "graph_algos.h"
+
+#define NO_NODE -1
+
+/*
+ * A node of the link-cut tree: a splay tree node whose 'parent' is either
+ * its splay tree parent or, for the root of a splay tree, the path-parent.
+ */
+typedef struct lct_node
+{
+  int child[2];   // left and right splay children, or NO_NODE
+  int parent;     // splay parent or path-parent, or NO_NODE
+  int maxNode;    // node with the largest weight in this splay subtree
+  int weight;     // edge weight, or INT_MIN for vertex nodes
+  bool flipped;   // the children of this subtree still have to be swapped
+} LCTNode;
+
+struct dynamic_mst
+{
+  int numVertices;
+  LCTNode *nodes;      // vertices, then numVertices-1 edge slots
+  Edge *edges;         // edges[i] is the edge held by node numVertices+i;
+                       //   fromVertex is NOTHING if the slot is free
+  int *freeSlots;      // stack of free edge slots
+  int numFreeSlots;
+  int *path;           // scratch stack for splay
+  int64_t totalWeight;
+};
+
+/*
+ * Returns true iff node 'x' is the root of its splay tree.
+ */
+bool isSplayRoot(DynamicMST *mst, int x)
+{
+  int p = mst->nodes[x].parent;
+  return p == NO_NODE ||
+         (mst->nodes[p].child[0] != x && mst->nodes[p].child[1] != x);
+}
+
+/*
+ * Pushes a pending flip of node 'x' down to its children.
+ */
+void pushFlip(DynamicMST *mst, int x)
+{
+  LCTNode *node = &mst->nodes[x];
+  if (node->flipped)
+  {
+    int left = node->child[0];
+    node->child[0] = node->child[1];
+    node->child[1] = left;
+    for (int i = 0; i < 2; i++)
+    {
+      if (node->child[i] != NO_NODE)
+      {
+        mst->nodes[node->child[i]].flipped ^= true;
+      }
+    }
+    node->flipped = false;
+  }
+}
+
+/*
+ * Recomputes the maxNode of node 'x' from its children.
+ */
+void updateMax(DynamicMST *mst, int x)
+{
+  LCTNode *node = &mst->nodes[x];
+  node->maxNode = x;
+  for (int i = 0; i < 2; i++)
+  {
+    int c = node->child[i];
+    if (c != NO_NODE &&
+        mst->nodes[mst->nodes[c].maxNode].weight >
+            mst->nodes[node->maxNode].weight)
+    {
+      node->maxNode = mst->nodes[c].maxNode;
+    }
+  }
+}
+
+/*
+ * Rotates node 'x' above its splay parent.
+ */
+void lctRotate(DynamicMST *mst, int x)
+{
+  LCTNode *nodes = mst->nodes;
+  int p = nodes[x].parent;
+  int g = nodes[p].parent;
+  int side = nodes[p].child[1] == x;
+  if (!isSplayRoot(mst, p))
+  {
+    nodes[g].child[nodes[g].child[1] == p] = x;
+  }
+  nodes[x].parent = g;
+  nodes[p].child[side] = nodes[x].child[!side];
+  if (nodes[x].child[!side] != NO_NODE)
+  {
+    nodes[nodes[x].child[!side]].parent = p;
+  }
+  nodes[x].child[!side] = p;
+  nodes[p].parent = x;
+  updateMax(mst, p);
+  updateMax(mst, x);
+}
+
+/*
+ * Makes node 'x' the root of its splay tree.
+ */
+void lctSplay(DynamicMST *mst, int x)
+{
+  int depth = 0;
+  mst->path[depth++] = x;
+  for (int y = x; !isSplayRoot(mst, y); y = mst->nodes[y].parent)
+  {
+    mst->path[depth++] = mst->nodes[y].parent;
+  }
+  while (depth > 0)
+  {
+    pushFlip(mst, mst->path[--depth]);
+  }
+
+  while (!isSplayRoot(mst, x))
+  {
+    int p = mst->nodes[x].parent;
+    if (!isSplayRoot(mst, p))
+    {
+      int g = mst->nodes[p].parent;
+      bool zigZig =
+          (mst->nodes[g].child[1] == p) == (mst->nodes[p].child[1] == x);
+      lctRotate(mst, zigZig ? p : x);
+    }
+    lctRotate(mst, x);
+  }
+}
+
+/*
+ * Makes the path from the root of its tree to node 'x' a single splay tree
+ * rooted at 'x'.
+ */
+void lctAccess(DynamicMST *mst, int x)
+{
+  int last = NO_NODE;
+  for (int y = x; y != NO_NODE; y = mst->nodes[y].parent)
+  {
+    lctSplay(mst, y);
+    mst->nodes[y].child[1] = last;
+    updateMax(mst, y);
+    last = y;
+  }
+  lctSplay(mst, x);
+}
+
+/*
+ * Makes node 'x' the root of its tree.
+ */
+void lctMakeRoot(DynamicMST *mst, int x)
+{
+  lctAccess(mst, x);
+  mst->nodes[x].flipped ^= true;
+}
+
+/*
+ * Returns the root of the tree holding node 'x'.
+ */
+int lctFindRoot(DynamicMST *mst, int x)
+{
+  lctAccess(mst, x);
+  pushFlip(mst, x);
+  while (mst->nodes[x].child[0] != NO_NODE)
+  {
+    x = mst->nodes[x].child[0];
+    pushFlip(mst, x);
+  }
+  lctSplay(mst, x);
+  return x;
+}
+
+/*
+ * Joins the trees holding nodes 'x' and 'y' with an edge between them.
+ * Precondition: 'x' and 'y' are in different trees
+ */
+void lctLink(DynamicMST *mst, int x, int y)
+{
+  lctMakeRoot(mst, x);
+  mst->nodes[x].parent = y;
+}
+
+/*
+ * Removes the edge between the adjacent nodes 'x' and 'y'.
+ */
+void lctCut(DynamicMST *mst, int x, int y)
+{
+  lctMakeRoot(mst, x);
+  lctAccess(mst, y);
+  mst->nodes[y].child[0] = NO_NODE;
+  mst->nodes[x].parent = NO_NODE;
+  updateMax(mst, y);
+}
+
+/*
+ * Returns the heaviest edge node on the path between the vertices 'u' and
+ * 'v', or NO_NODE if they are not connected.
+ */
+int pathMax(DynamicMST *mst, int u, int v)
+{
+  if (lctFindRoot(mst, u) != lctFindRoot(mst, v))
+  {
+    return NO_NODE;
+  }
+  lctMakeRoot(mst, u);
+  lctAccess(mst, v);
+  return mst->nodes[v].maxNode;
+}
+
+/*
+ * Puts the edge ('fromVertex', 'toVertex', 'weight') in the free edge slot
+ * 'slot' of 'mst' and links it into the forest.
+ */
+void linkEdge(DynamicMST *mst, int slot, int fromVertex, int toVertex,
+              int weight)
+{
+  int x = mst->numVertices + slot;
+  LCTNode *node = &mst->nodes[x];
+  node->child[0] = node->child[1] = node->parent = NO_NODE;
+  node->maxNode = x;
+  node->weight = weight;
+  node->flipped = false;
+  mst->edges[slot].fromVertex = fromVertex;
+  mst->edges[slot].toVertex = toVertex;
+  mst->edges[slot].weight = weight;
+  lctLink(mst, fromVertex, x);
+  lctLink(mst, x, toVertex);
+  mst->totalWeight += weight;
+}
+
+/*
+ * Unlinks the edge in slot 'slot' of 'mst' from the forest. The slot is
+ * left for the caller to reuse or free.
+ */
+void cutEdge(DynamicMST *mst, int slot)
+{
+  int x = mst->numVertices + slot;
+  lctCut(mst, mst->edges[slot].fromVertex, x);
+  lctCut(mst, x, mst->edges[slot].toVertex);
+  mst->totalWeight -= mst->edges[slot].weight;
+  mst->edges[slot].fromVertex = NOTHING;
+}
+
+DynamicMST *newDynamicMST(int numVertices, Edge *tree, int numTreeEdges)
+{
+  DynamicMST *mst = (DynamicMST *)malloc(sizeof(DynamicMST));
+  if (!mst)
+  {
+    return NULL;
+  }
+  int numSlots = numVertices > 0 ? numVertices - 1 : 0;
+  int numNodes = numVertices + numSlots;
+  mst->numVertices = numVertices;
+  mst->nodes = (LCTNode *)malloc((numNodes + 1) * sizeof(LCTNode));
+  mst->edges = (Edge *)malloc((numSlots + 1) * sizeof(Edge));
+  mst->freeSlots = (int *)malloc((numSlots + 1) * sizeof(int));
+  mst->path = (int *)malloc((numNodes + 1) * sizeof(int));
+  if (!mst->nodes || !mst->edges || !mst->freeSlots || !mst->path)
+  {
+    deleteDynamicMST(mst);
+    return NULL;
+  }
+
+  for (int x = 0; x < numVertices; x++)
+  {
+    LCTNode *node = &mst->nodes[x];
+    node->child[0] = node->child[1] = node->parent = NO_NODE;
+    node->maxNode = x;
+    node->weight = INT_MIN;
+    node->flipped = false;
+  }
+  mst->numFreeSlots = 0;
+  for (int slot = numSlots - 1; slot >= 0; slot--)
+  {
+    mst->edges[slot].fromVertex = NOTHING;
+    mst->freeSlots[mst->numFreeSlots++] = slot;
+  }
+  mst->totalWeight = 0;
+
+  for (int i = 0; tree != NULL && i < numTreeEdges; i++)
+  {
+    insertMSTEdge(mst, tree[i].fromVertex, tree[i].toVertex, tree[i].weight);
+  }
+  return mst;
+}
+
+void deleteDynamicMST(DynamicMST *mst)
+{
+  if (mst)
+  {
+    free(mst->nodes);
+    free(mst->edges);
+    free(mst->freeSlots);
+    free(mst->path);
+    free(mst);
+  }
+}
+
+bool insertMSTEdge(DynamicMST *mst, int fromVertex, int toVertex, int weight)
+{
+  if (fromVertex < 0 || fromVertex >= mst->numVertices || toVertex < 0 ||
+      toVertex >= mst->numVertices || fromVertex == toVertex)
+  {
+    return false;
+  }
+
+  int heaviest = pathMax(mst, fromVertex, toVertex);
+  int slot;
+  if (heaviest == NO_NODE)
+  {
+    slot = mst->freeSlots[--mst->numFreeSlots];
+  }
+  else if (mst->nodes[heaviest].weight > weight)
+  {
+    slot = heaviest - mst->numVertices;
+    cutEdge(mst, slot);
+  }
+  else
+  {
+    return false;
+  }
+  linkEdge(mst, slot, fromVertex, toVertex, weight);
+  return true;
+}
+
+bool getMSTPathMax(DynamicMST *mst, int fromVertex, int toVertex,
+                   Edge *maxEdge)
+{
+  if (fromVertex < 0 || fromVertex >= mst->numVertices || toVertex < 0 ||
+      toVertex >= mst->numVertices || fromVertex == toVertex)
+  {
+    return false;
+  }
+  int heaviest = pathMax(mst, fromVertex, toVertex);
+  if (heaviest == NO_NODE)
+  {
+    return false;
+  }
+  *maxEdge = mst->edges[heaviest - mst->numVertices];
+  return true;
+}
+
+int64_t getMSTWeight(DynamicMST *mst)
+{
+  return mst->totalWeight;
+}
+
+int getMSTEdges(DynamicMST *mst, Edge *edges)
+{
+  int numEdges = 0;
+  for (int slot = 0; slot < mst->numVertices - 1; slot++)
+  {
+    if (mst->edges[slot].fromVertex != NOTHING)
+    {
+      edges[numEdges++] = mst->edges[slot];
+    }
+  }
+  return numEdges;
+}
@@ -0,0 +1,66 @@
+/*
+ * Header file for our incrementally maintained minimum spanning tree.
+ *
+ * A DynamicMST keeps a minimum spanning forest of a growing undirected
+ * graph. When an edge (u, v) arrives, the heaviest edge on the tree path
+ * from u to v is found; if the new edge is lighter it replaces that edge,
+ * and otherwise the forest stays as it is. If u and v are in different
+ * trees, the new edge joins them.
+ *
+ * The forest is stored in a link-cut tree, so each insertion takes
+ * O(log V) amortized time instead of a new run of Prim's algorithm.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "graph.h"
+
+#ifndef __Dynamic_MST_header
+#define __Dynamic_MST_header
+
+typedef struct dynamic_mst DynamicMST;
+
+/*
+ * Returns a new DynamicMST on vertices 0, ..., numVertices-1 into which the
+ * 'numTreeEdges' edges of 'tree' (which may be NULL) have been inserted.
+ * Pass the result of getMSTprim to continue from an existing MST.
+ * Returns NULL if memory could not be allocated.
+ */
+DynamicMST* newDynamicMST(int numVertices, Edge* tree, int numTreeEdges);
+
+/*
+ * Frees all memory allocated for 'mst'.
+ */
+void deleteDynamicMST(DynamicMST* mst);
+
+/*
+ * Adds an undirected edge between 'fromVertex' and 'toVertex' with weight
+ * 'weight' to the graph 'mst' spans, and updates the forest. Returns true
+ * iff the edge became part of the forest. Self-loops and invalid IDs are
+ * ignored.
+ */
+bool insertMSTEdge(DynamicMST* mst, int fromVertex, int toVertex, int weight);
+
+/*
+ * Stores the heaviest edge on the forest path between 'fromVertex' and
+ * 'toVertex' in 'maxEdge'. Returns false if the two vertices are equal, not
+ * connected, or not valid IDs.
+ */
+bool getMSTPathMax(DynamicMST* mst, int fromVertex, int toVertex,
+                   Edge* maxEdge);
+
+/*
+ * Returns the total weight of the forest.
+ */
+int64_t getMSTWeight(DynamicMST* mst);
+
+/*
+ * Copies the edges of the forest, in no particular order, into 'edges',
+ * which must have room for numVertices-1 of them. Returns their number.
+ */
+int getMSTEdges(DynamicMST* mst, Edge* edges);
+
+#endif
@@ -0,0 +1,259 @@
+/*
+ *  Randomized testing of our DynamicMST (see dynamic_mst.h).
+ *
+ *  Random undirected edges are inserted one at a time into a DynamicMST
+ *  and into a list of all edges. After every insertion, the weight of the
+ *  forest must equal that of a minimum spanning forest found by Kruskal's
+ *  algorithm on all edges so far, and at the end the forest's edges must
+ *  add up to its weight and form a forest. Prints the first mismatches
+ *  found and exits with a non-zero status if there were any.
+ *
+ *  ---------------------------------------------------------------------------
+ *   Compile:
+ *   gcc -Wall -Werror dynamic_mst.c dynamic_mst_tester.c -o dynamic_mst_tester
+ *
+ *   Run:
+ *   ./dynamic_mst_tester [seed]
+ *  ---------------------------------------------------------------------------
+ */
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "dynamic_mst.h"
+
+#define MAX_WEIGHT 50
+#define MAX_REPORTED 10  // mismatches printed before only counting them
+
+uint64_t randomState;
+int numMismatches;
+
+/*
+ * Returns a pseudo-random number in 0, 1, ..., bound-1 (splitmix64).
+ */
+int randomBelow(int bound)
+{
+  uint64_t z = (randomState += 0x9e3779b97f4a7c15ULL);
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+  z ^= z >> 31;
+  return (int)((z >> 33) % (uint64_t)bound);
+}
+
+/*
+ * Returns the representative of the set of 'id' in union-find 'parents',
+ * halving the path to it.
+ */
+int findSet(int* parents, int id)
+{
+  while (parents[id] != id)
+  {
+    parents[id] = parents[parents[id]];
+    id = parents[id];
+  }
+  return id;
+}
+
+/*
+ * qsort comparator for Edges by weight.
+ */
+int compareWeights(const void* a, const void* b)
+{
+  int x = ((const Edge*)a)->weight;
+  int y = ((const Edge*)b)->weight;
+  return (x > y) - (x < y);
+}
+
+/*
+ * Returns the weight of a minimum spanning forest of the 'numEdges' edges
+ * in 'edges' on 'numVertices' vertices, by Kruskal's algorithm. Sorts
+ * 'edges'.
+ */
+int64_t kruskalWeight(Edge* edges, int numEdges, int numVertices,
+                      int* parents)
+{
+  qsort(edges, numEdges, sizeof(Edge), compareWeights);
+  for (int v = 0; v < numVertices; v++)
+    parents[v] = v;
+  int64_t weight = 0;
+  for (int i = 0; i < numEdges; i++)
+  {
+    int a = findSet(parents, edges[i].fromVertex);
+    int b = findSet(parents, edges[i].toVertex);
+    if (a != b)
+    {
+      parents[a] = b;
+      weight += edges[i].weight;
+    }
+  }
+  return weight;
+}
+
+/*
+ * Checks that the edges of 'mst' add up to its weight and form a forest on
+ * 'numVertices' vertices.
+ */
+void checkForestEdges(DynamicMST* mst, int numVertices, int* parents)
+{
+  Edge* forest = (Edge*)malloc(numVertices * sizeof(Edge));
+  if (forest == NULL)
+  {
+    printf("Memory allocation failed\n");
+    exit(EXIT_FAILURE);
+  }
+  int numForestEdges = getMSTEdges(mst, forest);
+  for (int v = 0; v < numVertices; v++)
+    parents[v] = v;
+  int64_t weight = 0;
+  for (int i = 0; i < numForestEdges; i++)
+  {
+    int a = findSet(parents, forest[i].fromVertex);
+    int b = findSet(parents, forest[i].toVertex);
+    if (a == b)
+    {
+      printf("forest edge (%d, %d) closes a cycle\n", forest[i].fromVertex,
+             forest[i].toVertex);
+      numMismatches++;
+    }
+    parents[a] = b;
+    weight += forest[i].weight;
+  }
+  if (weight != getMSTWeight(mst))
+  {
+    printf("forest edges weigh %lld, but getMSTWeight says %lld\n",
+           (long long)weight, (long long)getMSTWeight(mst));
+    numMismatches++;
+  }
+  free(forest);
+}
+
+/*
+ * Inserts 'numEdges' random edges on 'numVertices' vertices into a new
+ * DynamicMST, checking it against Kruskal's algorithm after each of them.
+ */
+void testRandomEdges(int numVertices, int numEdges)
+{
+  DynamicMST* mst = newDynamicMST(numVertices, NULL, 0);
+  Edge* edges = (Edge*)malloc(numEdges * sizeof(Edge));
+  Edge* sorted = (Edge*)malloc(numEdges * sizeof(Edge));
+  int* parents = (int*)malloc(numVertices * sizeof(int));
+  if (mst == NULL || edges == NULL || sorted == NULL || parents == NULL)
+  {
+    printf("Memory allocation failed\n");
+    exit(EXIT_FAILURE);
+  }
+
+  int numInserted = 0;
+  for (int i = 0; i < numEdges; i++)
+  {
+    Edge edge = {randomBelow(numVertices), randomBelow(numVertices),
+                 randomBelow(MAX_WEIGHT + 1)};
+    insertMSTEdge(mst, edge.fromVertex, edge.toVertex, edge.weight);
+    if (edge.fromVertex != edge.toVertex)
+      edges[numInserted++] = edge;
+
+    for (int e = 0; e < numInserted; e++)
+      sorted[e] = edges[e];
+    int64_t expected = kruskalWeight(sorted, numInserted, numVertices,
+                                     parents);
+    if (getMSTWeight(mst) != expected && ++numMismatches <= MAX_REPORTED)
+    {
+      printf("after edge %d: forest weighs %lld, expected %lld\n", i,
+             (long long)getMSTWeight(mst), (long long)expected);
+    }
+  }
+  checkForestEdges(mst, numVertices, parents);
+
+  printf("%d vertices, %d edges: %d mismatches so far\n", numVertices,
+         numEdges, numMismatches);
+  free(parents);
+  free(sorted);
+  free(edges);
+  deleteDynamicMST(mst);
+}
+
+/*
+ * Starts a DynamicMST from a path 0 - 1 - ... - numVertices-1 of heavy
+ * edges, as from getMSTprim, and checks that light shortcuts replace them.
+ */
+void testInitialTree(int numVertices)
+{
+  Edge* tree = (Edge*)malloc(numVertices * sizeof(Edge));
+  int* parents = (int*)malloc(numVertices * sizeof(int));
+  if (tree == NULL || parents == NULL)
+  {
+    printf("Memory allocation failed\n");
+    exit(EXIT_FAILURE);
+  }
+  for (int v = 1; v < numVertices; v++)
+    tree[v - 1] = (Edge){v, v - 1, MAX_WEIGHT};
+  DynamicMST* mst = newDynamicMST(numVertices, tree, numVertices - 1);
+  if (mst == NULL)
+  {
+    printf("Memory allocation failed\n");
+    exit(EXIT_FAILURE);
+  }
+
+  // Every edge (0, v) is lighter than the heaviest edge on the path to v
+  for (int v = 2; v < numVertices; v++)
+  {
+    if (!insertMSTEdge(mst, 0, v, 1))
+    {
+      printf("edge (0, %d) was not taken into the forest\n", v);
+      numMismatches++;
+    }
+  }
+  int64_t expected = MAX_WEIGHT + (int64_t)(numVertices - 2);
+  if (getMSTWeight(mst) != expected)
+  {
+    printf("star forest weighs %lld, expected %lld\n",
+           (long long)getMSTWeight(mst), (long long)expected);
+    numMismatches++;
+  }
+  Edge maxEdge;
+  if (numVertices > 2 && (!getMSTPathMax(mst, 1, 2, &maxEdge) ||
+                          maxEdge.weight != MAX_WEIGHT))
+  {
+    printf("heaviest edge between 1 and 2 should weigh %d\n", MAX_WEIGHT);
+    numMismatches++;
+  }
+  if (getMSTPathMax(mst, 0, 0, &maxEdge))
+  {
+    printf("getMSTPathMax found a path from 0 to itself\n");
+    numMismatches++;
+  }
+  if (getMSTPathMax(mst, -1, 0, &maxEdge) ||
+      getMSTPathMax(mst, 0, numVertices, &maxEdge))
+  {
+    printf("getMSTPathMax found a path to an invalid vertex\n");
+    numMismatches++;
+  }
+  checkForestEdges(mst, numVertices, parents);
+
+  printf("path of %d vertices: %d mismatches so far\n", numVertices,
+         numMismatches);
+  free(parents);
+  free(tree);
+  deleteDynamicMST(mst);
+}
+
+int main(int argc, char* argv[])
+{
+  randomState = argc > 1 ? strtoull(argv[1], NULL, 10) : 1;
+
+  testRandomEdges(1, 10);
+  testRandomEdges(2, 50);
+  testRandomEdges(20, 200);    // dense: many replacements
+  testRandomEdges(200, 600);   // sparse: many separate trees
+  testRandomEdges(1000, 2000);
+  testInitialTree(500);
+
+  if (numMismatches > 0)
+  {
+    printf("FAILED: %d mismatches\n", numMismatches);
+    return EXIT_FAILURE;
+  }
+  printf("All DynamicMST results match Kruskal's algorithm.\n");
+  return EXIT_SUCCESS;
+}
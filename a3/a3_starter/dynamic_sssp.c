@@ -0,0 +1,402 @@
+/*
+ * Dynamic single-source shortest paths.
+ *
+ * Updates are repaired in the style of Ramalingam and Reps:
+ *   - An edge that gets cheaper (or is inserted) can only shorten paths
+ *     through its head, so Dijkstra's algorithm is restarted from there and
+ *     stops as soon as no distance improves.
+ *   - An edge that gets dearer (or is deleted) can only lengthen paths if it
+ *     is the tree edge of its head. Then the subtree below it is the
+ *     affected set: each affected vertex gets its best distance through an
+ *     incoming edge from an unaffected vertex, and Dijkstra's algorithm,
+ *     run on the affected vertices only, settles the rest.
+ * Finding those incoming edges needs the reverse adjacency lists, which a
+ * Graph does not have, so a DynamicSSSP keeps its own.
+ */
+
+#include <limits.h>
+#include <string.h>
+
+#include "dynamic_sssp.h"
+#include "graph_algos.h"
+#include "minheap.h"
+
+#define FIRST_INCOMING_EDGES 4
+
+/*
+ * The edges into one vertex, in no particular order.
+ */
+typedef struct incoming_edges
+{
+  Edge **edges;   // pointers to the Edges in the adjacency lists
+  int count;
+  int capacity;
+} IncomingEdges;
+
+struct dynamic_sssp
+{
+  Graph *graph;
+  int startVertex;
+  int *distances;          // distances[id] is INT_MAX if id is unreachable
+  int *predecessors;       // predecessors[id] is NOTHING for the start vertex
+  IncomingEdges *incoming; // incoming[id] lists the edges to id
+  MinHeap *heap;           // vertices whose distance changed in this update
+  unsigned int generation; // number of the current update; never 0
+  unsigned int *queued;    // queued[id] == generation iff id entered the heap
+  unsigned int *affected;  // affected[id] == generation iff id's tree path
+                           //   got longer in this update
+  int *affectedList;       // the affected vertices, in discovery order
+  int work;                // vertices recomputed by the last update
+};
+
+/*
+ * Returns the adjacency list of vertex 'id' in 'graph', which is NULL if
+ * the vertex was never created.
+ */
+EdgeList *outgoingEdges(Graph *graph, int id)
+{
+  Vertex *vertex = graph->vertices[id];
+  return vertex ? vertex->adjList : NULL;
+}
+
+/*
+ * Adds 'edge' to the incoming edges of its head in 'sssp'.
+ */
+void addIncomingEdge(DynamicSSSP *sssp, Edge *edge)
+{
+  IncomingEdges *in = &sssp->incoming[edge->toVertex];
+  if (in->count == in->capacity)
+  {
+    int capacity = in->capacity ? 2 * in->capacity : FIRST_INCOMING_EDGES;
+    Edge **edges = (Edge **)realloc(in->edges, capacity * sizeof(Edge *));
+    if (!edges)
+    {
+      printf("Memory allocation failed\n");
+      exit(EXIT_FAILURE);
+    }
+    in->edges = edges;
+    in->capacity = capacity;
+  }
+  in->edges[in->count++] = edge;
+}
+
+/*
+ * Removes 'edge' from the incoming edges of its head in 'sssp'.
+ * Precondition: 'edge' was added with addIncomingEdge
+ */
+void removeIncomingEdge(DynamicSSSP *sssp, Edge *edge)
+{
+  IncomingEdges *in = &sssp->incoming[edge->toVertex];
+  for (int i = 0; i < in->count; i++)
+  {
+    if (in->edges[i] == edge)
+    {
+      in->edges[i] = in->edges[--in->count];
+      return;
+    }
+  }
+}
+
+/*
+ * Starts a new update of 'sssp'. Only clears the generation arrays when the
+ * counter wraps around.
+ */
+void beginUpdate(DynamicSSSP *sssp)
+{
+  sssp->generation++;
+  if (sssp->generation == 0)
+  {
+    int numVertices = sssp->graph->numVertices;
+    memset(sssp->queued, 0, numVertices * sizeof(unsigned int));
+    memset(sssp->affected, 0, numVertices * sizeof(unsigned int));
+    sssp->generation = 1;
+  }
+  clearHeap(sssp->heap);
+  sssp->work = 0;
+}
+
+/*
+ * Gives vertex 'id' of 'sssp' the shorter distance 'distance' through
+ * 'predecessor', and queues it so the change is passed on.
+ */
+void improveVertex(DynamicSSSP *sssp, int id, int distance, int predecessor)
+{
+  sssp->distances[id] = distance;
+  sssp->predecessors[id] = predecessor;
+  if (sssp->queued[id] != sssp->generation)
+  {
+    sssp->queued[id] = sssp->generation;
+    insert(sssp->heap, distance, id);
+  }
+  else
+  {
+    decreasePriority(sssp->heap, id, distance);
+  }
+}
+
+/*
+ * Runs Dijkstra's algorithm from the vertices queued in 'sssp', passing on
+ * improvements until none are left. Weights are not negative, so a vertex
+ * taken from the heap is never improved again in the same update.
+ */
+void propagateImprovements(DynamicSSSP *sssp)
+{
+  while (sssp->heap->size > 0)
+  {
+    int u = extractMin(sssp->heap).id;
+    int distance = sssp->distances[u];
+    sssp->work++;
+    for (EdgeList *adj = outgoingEdges(sssp->graph, u); adj != NULL;
+         adj = adj->next)
+    {
+      int v = adj->edge->toVertex;
+      int newDist = distance + adj->edge->weight;
+      if (newDist < sssp->distances[v])
+      {
+        improveVertex(sssp, v, newDist, u);
+      }
+    }
+  }
+}
+
+/*
+ * Repairs 'sssp' after the edge from 'fromVertex' to 'toVertex' got cheaper
+ * or was inserted.
+ */
+void repairDecrease(DynamicSSSP *sssp, int fromVertex, int toVertex,
+                    int weight)
+{
+  beginUpdate(sssp);
+  int distance = sssp->distances[fromVertex];
+  if (distance != INT_MAX && distance + weight < sssp->distances[toVertex])
+  {
+    improveVertex(sssp, toVertex, distance + weight, fromVertex);
+    propagateImprovements(sssp);
+  }
+}
+
+/*
+ * Marks the subtree of the shortest path tree of 'sssp' below 'root' as
+ * affected and forgets the distances in it. Returns its number of vertices.
+ */
+int collectAffected(DynamicSSSP *sssp, int root)
+{
+  int numAffected = 0;
+  sssp->affected[root] = sssp->generation;
+  sssp->affectedList[numAffected++] = root;
+  for (int i = 0; i < numAffected; i++)
+  {
+    int u = sssp->affectedList[i];
+    for (EdgeList *adj = outgoingEdges(sssp->graph, u); adj != NULL;
+         adj = adj->next)
+    {
+      int v = adj->edge->toVertex;
+      if (sssp->predecessors[v] == u && sssp->affected[v] != sssp->generation)
+      {
+        sssp->affected[v] = sssp->generation;
+        sssp->affectedList[numAffected++] = v;
+      }
+    }
+    sssp->distances[u] = INT_MAX;
+    sssp->predecessors[u] = NOTHING;
+  }
+  return numAffected;
+}
+
+/*
+ * Repairs 'sssp' after the edge from 'fromVertex' to 'toVertex' got dearer
+ * or was deleted.
+ */
+void repairIncrease(DynamicSSSP *sssp, int fromVertex, int toVertex)
+{
+  beginUpdate(sssp);
+  if (sssp->predecessors[toVertex] != fromVertex)
+  {
+    return; // not a tree edge, so no shortest path used it
+  }
+  IncomingEdges *in = &sssp->incoming[toVertex];
+  for (int i = 0; i < in->count; i++)
+  {
+    Edge *edge = in->edges[i];
+    if (edge->fromVertex == fromVertex &&
+        sssp->distances[fromVertex] + edge->weight ==
+            sssp->distances[toVertex])
+    {
+      return; // a parallel edge is just as short
+    }
+  }
+
+  int numAffected = collectAffected(sssp, toVertex);
+  for (int i = 0; i < numAffected; i++)
+  {
+    int v = sssp->affectedList[i];
+    int best = INT_MAX;
+    int bestPred = NOTHING;
+    in = &sssp->incoming[v];
+    for (int j = 0; j < in->count; j++)
+    {
+      int u = in->edges[j]->fromVertex;
+      if (sssp->affected[u] != sssp->generation &&
+          sssp->distances[u] != INT_MAX &&
+          sssp->distances[u] + in->edges[j]->weight < best)
+      {
+        best = sssp->distances[u] + in->edges[j]->weight;
+        bestPred = u;
+      }
+    }
+    if (best != INT_MAX)
+    {
+      improveVertex(sssp, v, best, bestPred);
+    }
+  }
+  propagateImprovements(sssp);
+  sssp->work = numAffected;
+}
+
+DynamicSSSP *newDynamicSSSP(Graph *graph, int startVertex)
+{
+  if (startVertex < 0 || startVertex >= graph->numVertices)
+  {
+    return NULL;
+  }
+  DynamicSSSP *sssp = (DynamicSSSP *)calloc(1, sizeof(DynamicSSSP));
+  if (!sssp)
+  {
+    return NULL;
+  }
+  int numVertices = graph->numVertices;
+  sssp->graph = graph;
+  sssp->startVertex = startVertex;
+  sssp->distances = (int *)malloc(numVertices * sizeof(int));
+  sssp->predecessors = (int *)malloc(numVertices * sizeof(int));
+  sssp->incoming =
+      (IncomingEdges *)calloc(numVertices, sizeof(IncomingEdges));
+  sssp->heap = newHeap(numVertices);
+  sssp->queued = (unsigned int *)calloc(numVertices, sizeof(unsigned int));
+  sssp->affected = (unsigned int *)calloc(numVertices, sizeof(unsigned int));
+  sssp->affectedList = (int *)malloc(numVertices * sizeof(int));
+  if (!sssp->distances || !sssp->predecessors || !sssp->incoming ||
+      !sssp->heap || !sssp->queued || !sssp->affected || !sssp->affectedList)
+  {
+    deleteDynamicSSSP(sssp);
+    return NULL;
+  }
+
+  for (int v = 0; v < numVertices; v++)
+  {
+    sssp->distances[v] = INT_MAX;
+    sssp->predecessors[v] = NOTHING;
+    for (EdgeList *adj = outgoingEdges(graph, v); adj != NULL;
+         adj = adj->next)
+    {
+      addIncomingEdge(sssp, adj->edge);
+    }
+  }
+
+  beginUpdate(sssp);
+  improveVertex(sssp, startVertex, 0, NOTHING);
+  propagateImprovements(sssp);
+  return sssp;
+}
+
+void deleteDynamicSSSP(DynamicSSSP *sssp)
+{
+  if (sssp)
+  {
+    for (int v = 0; sssp->incoming && v < sssp->graph->numVertices; v++)
+    {
+      free(sssp->incoming[v].edges);
+    }
+    free(sssp->incoming);
+    free(sssp->distances);
+    free(sssp->predecessors);
+    deleteHeap(sssp->heap);
+    free(sssp->queued);
+    free(sssp->affected);
+    free(sssp->affectedList);
+    free(sssp);
+  }
+}
+
+int getDynamicDistance(DynamicSSSP *sssp, int id)
+{
+  return sssp->distances[id];
+}
+
+int getDynamicPredecessor(DynamicSSSP *sssp, int id)
+{
+  return sssp->predecessors[id];
+}
+
+int getDynamicWork(DynamicSSSP *sssp)
+{
+  return sssp->work;
+}
+
+/*
+ * Returns true iff 'id' is a valid vertex ID in the graph of 'sssp'.
+ */
+bool isDynamicVertex(DynamicSSSP *sssp, int id)
+{
+  return id >= 0 && id < sssp->graph->numVertices;
+}
+
+bool insertDynamicEdge(DynamicSSSP *sssp, int fromVertex, int toVertex,
+                       int weight)
+{
+  if (!isDynamicVertex(sssp, fromVertex) ||
+      !isDynamicVertex(sssp, toVertex) || weight < 0)
+  {
+    return false;
+  }
+  Edge *edge = insertGraphEdge(sssp->graph, fromVertex, toVertex, weight);
+  addIncomingEdge(sssp, edge);
+  repairDecrease(sssp, fromVertex, toVertex, weight);
+  return true;
+}
+
+bool deleteDynamicEdge(DynamicSSSP *sssp, int fromVertex, int toVertex)
+{
+  if (!isDynamicVertex(sssp, fromVertex))
+  {
+    return false;
+  }
+  Edge *edge = findGraphEdge(sssp->graph, fromVertex, toVertex);
+  if (edge == NULL)
+  {
+    return false;
+  }
+  removeIncomingEdge(sssp, edge);
+  deleteGraphEdge(sssp->graph, fromVertex, toVertex);
+  repairIncrease(sssp, fromVertex, toVertex);
+  return true;
+}
+
+bool reweightDynamicEdge(DynamicSSSP *sssp, int fromVertex, int toVertex,
+                         int weight)
+{
+  if (!isDynamicVertex(sssp, fromVertex) || weight < 0)
+  {
+    return false;
+  }
+  Edge *edge = findGraphEdge(sssp->graph, fromVertex, toVertex);
+  if (edge == NULL)
+  {
+    return false;
+  }
+  int oldWeight = edge->weight;
+  edge->weight = weight;
+  if (weight < oldWeight)
+  {
+    repairDecrease(sssp, fromVertex, toVertex, weight);
+  }
+  else if (weight > oldWeight)
+  {
+    repairIncrease(sssp, fromVertex, toVertex);
+  }
+  else
+  {
+    beginUpdate(sssp);
+  }
+  return true;
+}
@@ -0,0 +1,80 @@
+/*
+ * Header file for our dynamic single-source shortest paths.
+ *
+ * A DynamicSSSP keeps the distances and the shortest path tree from one
+ * start vertex of a Graph up to date while edges of the graph are inserted,
+ * deleted and reweighted. Each update only revisits the vertices whose
+ * distance can change, instead of rerunning Dijkstra's algorithm on the
+ * whole graph.
+ *
+ * Edges are directed, like the adjacency lists of Graph: update both
+ * directions of an undirected edge. While a DynamicSSSP exists, all changes
+ * to the edges of its graph must go through it.
+ */
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "graph.h"
+
+#ifndef __Dynamic_SSSP_header
+#define __Dynamic_SSSP_header
+
+typedef struct dynamic_sssp DynamicSSSP;
+
+/*
+ * Runs Dijkstra's algorithm on 'graph' from vertex with ID 'startVertex' and
+ * returns a DynamicSSSP holding the result. Returns NULL if 'startVertex'
+ * is not valid in 'graph' or memory could not be allocated.
+ * Precondition: every vertex of 'graph' has been created
+ */
+DynamicSSSP* newDynamicSSSP(Graph* graph, int startVertex);
+
+/*
+ * Frees all memory allocated for 'sssp', but not its graph.
+ */
+void deleteDynamicSSSP(DynamicSSSP* sssp);
+
+/*
+ * Returns the length of a shortest path to vertex with ID 'id', or INT_MAX
+ * if it cannot be reached.
+ */
+int getDynamicDistance(DynamicSSSP* sssp, int id);
+
+/*
+ * Returns the predecessor of vertex with ID 'id' in the shortest path tree,
+ * or NOTHING for the start vertex and vertices that cannot be reached.
+ */
+int getDynamicPredecessor(DynamicSSSP* sssp, int id);
+
+/*
+ * Adds an edge from 'fromVertex' to 'toVertex' with weight 'weight' to the
+ * graph of 'sssp' (see insertGraphEdge) and updates the shortest paths.
+ * Returns false, changing nothing, if an ID is not valid or 'weight' is
+ * negative.
+ */
+bool insertDynamicEdge(DynamicSSSP* sssp, int fromVertex, int toVertex,
+                       int weight);
+
+/*
+ * Removes the edge deleteGraphEdge would remove from the graph of 'sssp'
+ * and updates the shortest paths. Returns false if there is no such edge.
+ */
+bool deleteDynamicEdge(DynamicSSSP* sssp, int fromVertex, int toVertex);
+
+/*
+ * Sets the weight of the edge reweightGraphEdge would change in the graph of
+ * 'sssp' and updates the shortest paths. Returns false, changing nothing, if
+ * there is no such edge or 'weight' is negative.
+ */
+bool reweightDynamicEdge(DynamicSSSP* sssp, int fromVertex, int toVertex,
+                         int weight);
+
+/*
+ * Returns the number of vertices whose distance was recomputed by the last
+ * update, a measure of how much work it took.
+ */
+int getDynamicWork(DynamicSSSP* sssp);
+
+#endif
@@ -0,0 +1,211 @@
+/*
+ *  Randomized testing of our DynamicSSSP (see dynamic_sssp.h).
+ *
+ *  Random directed graphs get random edge insertions, deletions and
+ *  reweightings. After every update, the distances of the DynamicSSSP must
+ *  match those of a fresh run of Dijkstra's algorithm, and every
+ *  predecessor must end a shortest path to its vertex. Prints the first
+ *  mismatches found and exits with a non-zero status if there were any.
+ *
+ *  ---------------------------------------------------------------------------
+ *   Compile:
+ *   gcc -Wall -Werror -pthread graph.c minheap.c csr_graph.c \
+ *       compressed_graph.c graph_algos.c threadpool.c dynamic_sssp.c \
+ *       dynamic_sssp_tester.c -o dynamic_sssp_tester
+ *
+ *   Run:
+ *   ./dynamic_sssp_tester [seed]
+ *  ---------------------------------------------------------------------------
+ */
+
+#include <limits.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "dynamic_sssp.h"
+#include "graph.h"
+#include "graph_algos.h"
+
+#define MAX_WEIGHT 20
+#define MAX_REPORTED 10  // mismatches printed before only counting them
+
+uint64_t randomState;
+int numMismatches;
+
+/*
+ * Returns a pseudo-random number in 0, 1, ..., bound-1 (splitmix64).
+ */
+int randomBelow(int bound)
+{
+  uint64_t z = (randomState += 0x9e3779b97f4a7c15ULL);
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+  z ^= z >> 31;
+  return (int)((z >> 33) % (uint64_t)bound);
+}
+
+/*
+ * Prints a mismatch found after update 'update', and counts it.
+ */
+void reportMismatch(int update, const char* what, int vertex, int expected,
+                    int actual)
+{
+  if (++numMismatches <= MAX_REPORTED)
+  {
+    printf("after update %d: %s of vertex %d is %d, expected %d\n", update,
+           what, vertex, actual, expected);
+  }
+}
+
+/*
+ * Returns the weight of the lightest edge from 'fromVertex' to 'toVertex'
+ * in 'graph', or INT_MAX if there is none.
+ */
+int lightestEdge(Graph* graph, int fromVertex, int toVertex)
+{
+  int lightest = INT_MAX;
+  for (EdgeList* adj = graph->vertices[fromVertex]->adjList; adj != NULL;
+       adj = adj->next)
+  {
+    if (adj->edge->toVertex == toVertex && adj->edge->weight < lightest)
+      lightest = adj->edge->weight;
+  }
+  return lightest;
+}
+
+/*
+ * Compares 'sssp' on 'graph' with Dijkstra's algorithm from 'startVertex'
+ * run in 'ws'.
+ */
+void checkAgainstDijkstra(DynamicSSSP* sssp, Graph* graph, int startVertex,
+                          Workspace* ws, int update)
+{
+  getDistanceTreeDijkstraInto(ws, graph, startVertex, NULL);
+  for (int v = 0; v < graph->numVertices; v++)
+  {
+    int distance = getDynamicDistance(sssp, v);
+    int expected = getWorkspaceDistance(ws, v);
+    if (distance != expected)
+    {
+      reportMismatch(update, "distance", v, expected, distance);
+      continue;
+    }
+
+    int pred = getDynamicPredecessor(sssp, v);
+    if (v == startVertex || distance == INT_MAX)
+    {
+      if (pred != NOTHING)
+        reportMismatch(update, "predecessor", v, NOTHING, pred);
+      continue;
+    }
+    int throughPred = INT_MAX;
+    if (pred >= 0 && pred < graph->numVertices &&
+        getDynamicDistance(sssp, pred) != INT_MAX &&
+        lightestEdge(graph, pred, v) != INT_MAX)
+    {
+      throughPred = getDynamicDistance(sssp, pred) +
+                    lightestEdge(graph, pred, v);
+    }
+    if (throughPred != distance)
+      reportMismatch(update, "distance through predecessor", v, distance,
+                     throughPred);
+  }
+}
+
+/*
+ * Makes one random update to 'sssp': an insertion, or a deletion or
+ * reweighting of a random existing edge. Returns false if the update was
+ * refused although it was valid.
+ */
+bool randomUpdate(DynamicSSSP* sssp, Graph* graph)
+{
+  int n = graph->numVertices;
+  int u = randomBelow(n);
+  int kind = randomBelow(3);
+  EdgeList* adj = graph->vertices[u]->adjList;
+  if (kind == 0 || adj == NULL)
+    return insertDynamicEdge(sssp, u, randomBelow(n),
+                             randomBelow(MAX_WEIGHT + 1));
+
+  int degree = 0;
+  for (EdgeList* e = adj; e != NULL; e = e->next)
+    degree++;
+  for (int skip = randomBelow(degree); skip > 0; skip--)
+    adj = adj->next;
+  int v = adj->edge->toVertex;
+  if (kind == 1)
+    return deleteDynamicEdge(sssp, u, v);
+  return reweightDynamicEdge(sssp, u, v, randomBelow(MAX_WEIGHT + 1));
+}
+
+/*
+ * Builds a random graph with 'numVertices' vertices and 'numEdges' edges,
+ * makes 'numUpdates' random updates to a DynamicSSSP on it, and checks it
+ * after each of them.
+ */
+void testRandomGraph(int numVertices, int numEdges, int numUpdates)
+{
+  Graph* graph = newGraph(numVertices);
+  for (int v = 0; v < numVertices; v++)
+    graph->vertices[v] = newVertex(v, NULL, NULL);
+  for (int i = 0; i < numEdges; i++)
+    insertGraphEdge(graph, randomBelow(numVertices), randomBelow(numVertices),
+                    randomBelow(MAX_WEIGHT + 1));
+
+  int startVertex = randomBelow(numVertices);
+  DynamicSSSP* sssp = newDynamicSSSP(graph, startVertex);
+  Workspace* ws = newWorkspace(numVertices);
+  if (sssp == NULL || ws == NULL)
+  {
+    printf("Memory allocation failed\n");
+    exit(EXIT_FAILURE);
+  }
+  checkAgainstDijkstra(sssp, graph, startVertex, ws, 0);
+
+  for (int update = 1; update <= numUpdates; update++)
+  {
+    if (!randomUpdate(sssp, graph))
+    {
+      printf("update %d was refused\n", update);
+      numMismatches++;
+    }
+    checkAgainstDijkstra(sssp, graph, startVertex, ws, update);
+  }
+
+  // Invalid updates are refused and change nothing
+  if (insertDynamicEdge(sssp, -1, 0, 1) ||
+      insertDynamicEdge(sssp, 0, numVertices, 1) ||
+      insertDynamicEdge(sssp, 0, 0, -1) ||
+      reweightDynamicEdge(sssp, 0, 0, -1))
+  {
+    printf("an invalid update was accepted\n");
+    numMismatches++;
+  }
+  checkAgainstDijkstra(sssp, graph, startVertex, ws, numUpdates);
+
+  printf("%d vertices, %d edges, %d updates: %d mismatches so far\n",
+         numVertices, numEdges, numUpdates, numMismatches);
+  deleteWorkspace(ws);
+  deleteDynamicSSSP(sssp);
+  deleteGraph(graph);
+}
+
+int main(int argc, char* argv[])
+{
+  randomState = argc > 1 ? strtoull(argv[1], NULL, 10) : 1;
+
+  testRandomGraph(1, 0, 20);
+  testRandomGraph(50, 100, 2000);      // sparse: many unreachable vertices
+  testRandomGraph(300, 1200, 3000);
+  testRandomGraph(100, 2000, 2000);    // dense: many parallel edges
+  testRandomGraph(2000, 8000, 1000);
+
+  if (numMismatches > 0)
+  {
+    printf("FAILED: %d mismatches\n", numMismatches);
+    return EXIT_FAILURE;
+  }
+  printf("All DynamicSSSP results match Dijkstra's algorithm.\n");
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,539 @@
+/*
+ * Our external-memory priority queue.
+ *
+ * The buffer is a MinHeap whose node IDs are slots in 'bufferIds', where
+ * the caller's IDs are kept, so that any ID can be buffered. A run is an
+ * unlinked temporary file of nodes in sorted order; the run heap holds the
+ * smallest unextracted node of every open run, with the run's slot in
+ * 'runs' as its ID.
+ */
+
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "external_heap.h"
+
+#define BLOCK_BYTES (EXTERNAL_BLOCK_NODES * sizeof(HeapNode))
+
+/*
+ * A sorted run on disk, and the block of it that was last read.
+ */
+typedef struct run
+{
+  int fd;             // the run's file, or -1 if this slot is free
+  int64_t length;     // nodes in the file
+  int64_t remaining;  // nodes not yet extracted, 'head' included
+  int64_t nextRead;   // position in the file, in nodes, of the next block
+  HeapNode head;      // the smallest node not yet extracted
+  HeapNode *block;    // nodes read from the file
+  int blockLength;    // nodes in 'block'
+  int blockNext;      // position in 'block' of the node after 'head'
+} Run;
+
+struct external_heap
+{
+  char *directory;        // where run files are created
+  int64_t size;
+  MinHeap *buffer;        // IDs are slots in bufferIds
+  int *bufferIds;         // bufferIds[slot]: ID of the node in that slot
+  int *freeSlots;         // stack of slots not in use
+  int numFree;
+  HeapNode *sorted;       // the buffer in sorted order, while spilling it
+  MinHeap *runHeap;       // head of every open run; IDs are slots in runs
+  Run runs[EXTERNAL_MAX_RUNS];
+  int numRuns;
+  HeapNode *writeBlock;   // nodes waiting to be written to a merged run
+  int writeLength;
+};
+
+/*************************************************************************
+ ** File access
+ *************************************************************************/
+
+/*
+ * Returns a file descriptor for a new, empty, already unlinked file in
+ * 'heap->directory', or -1 if it could not be created.
+ */
+int newRunFile(ExternalHeap *heap)
+{
+  const char *name = "/b63-run-XXXXXX";
+  char *path = (char *)malloc(strlen(heap->directory) + strlen(name) + 1);
+  if (!path)
+  {
+    return -1;
+  }
+  strcpy(path, heap->directory);
+  strcat(path, name);
+  int fd = mkstemp(path);
+  if (fd != -1)
+  {
+    unlink(path);
+    posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+  }
+  free(path);
+  return fd;
+}
+
+/*
+ * Writes the 'count' nodes in 'nodes' at the end of the file 'fd'.
+ * Returns false if they could not all be written.
+ */
+bool writeNodes(int fd, HeapNode *nodes, int64_t count)
+{
+  const char *data = (const char *)nodes;
+  size_t left = count * sizeof(HeapNode);
+  while (left > 0)
+  {
+    ssize_t written = write(fd, data, left);
+    if (written <= 0)
+    {
+      return false;
+    }
+    data += written;
+    left -= written;
+  }
+  return true;
+}
+
+/*
+ * Reads the next block of 'run' into run->block. Returns false if it could
+ * not be read.
+ */
+bool readBlock(Run *run)
+{
+  int64_t count = run->length - run->nextRead;
+  count = count < EXTERNAL_BLOCK_NODES ? count : EXTERNAL_BLOCK_NODES;
+  off_t offset = run->nextRead * sizeof(HeapNode);
+  char *data = (char *)run->block;
+  size_t left = count * sizeof(HeapNode);
+  while (left > 0)
+  {
+    ssize_t got = pread(run->fd, data, left, offset);
+    if (got <= 0)
+    {
+      return false;
+    }
+    data += got;
+    offset += got;
+    left -= got;
+  }
+  // What came before is done with, and the next block is needed soon:
+  // let the kernel drop the one and start reading the other
+  posix_fadvise(run->fd, 0, offset - count * sizeof(HeapNode),
+                POSIX_FADV_DONTNEED);
+  posix_fadvise(run->fd, offset, BLOCK_BYTES, POSIX_FADV_WILLNEED);
+  run->nextRead += count;
+  run->blockLength = (int)count;
+  run->blockNext = 0;
+  return true;
+}
+
+/*
+ * Positions 'run' after its first 'extracted' nodes, so that its head is
+ * the next one. Returns false if the run could not be read.
+ */
+bool seekRun(Run *run, int64_t extracted)
+{
+  run->remaining = run->length - extracted;
+  run->nextRead = extracted;
+  if (run->remaining == 0)
+  {
+    return true;
+  }
+  if (!readBlock(run))
+  {
+    return false;
+  }
+  run->head = run->block[run->blockNext++];
+  return true;
+}
+
+/*
+ * Moves the head of 'run' to its next node, if there is one. Returns false
+ * if the run could not be read.
+ */
+bool advanceRun(Run *run)
+{
+  if (--run->remaining == 0)
+  {
+    return true;
+  }
+  if (run->blockNext == run->blockLength && !readBlock(run))
+  {
+    return false;
+  }
+  run->head = run->block[run->blockNext++];
+  return true;
+}
+
+/*
+ * Makes run slot 'slot' of 'heap' the run of the 'length' nodes in file
+ * 'fd', and adds it to the run heap. Returns false if it could not be read,
+ * in which case the slot is left free and 'fd' is not closed.
+ * Precondition: length >= 1
+ */
+bool openRun(ExternalHeap *heap, int slot, int fd, int64_t length)
+{
+  Run *run = &heap->runs[slot];
+  if (!run->block)
+  {
+    run->block = (HeapNode *)malloc(BLOCK_BYTES);
+    if (!run->block)
+    {
+      return false;
+    }
+  }
+  run->fd = fd;
+  run->length = length;
+  if (!seekRun(run, 0))
+  {
+    run->fd = -1;
+    return false;
+  }
+  insert(heap->runHeap, run->head.priority, slot);
+  heap->numRuns++;
+  return true;
+}
+
+/*
+ * Closes run slot 'slot' of 'heap', whose head must not be in the run heap.
+ */
+void closeRun(ExternalHeap *heap, int slot)
+{
+  close(heap->runs[slot].fd);
+  heap->runs[slot].fd = -1;
+  heap->numRuns--;
+}
+
+/*
+ * Returns a free run slot of 'heap'.
+ * Precondition: heap->numRuns < EXTERNAL_MAX_RUNS
+ */
+int freeRunSlot(ExternalHeap *heap)
+{
+  int slot = 0;
+  while (heap->runs[slot].fd != -1)
+  {
+    slot++;
+  }
+  return slot;
+}
+
+/*************************************************************************
+ ** Spilling and merging runs
+ *************************************************************************/
+
+/*
+ * Adds the head of every open run of 'heap' to its run heap again.
+ */
+void rebuildRunHeap(ExternalHeap *heap)
+{
+  clearHeap(heap->runHeap);
+  for (int slot = 0; slot < EXTERNAL_MAX_RUNS; slot++)
+  {
+    if (heap->runs[slot].fd != -1)
+    {
+      insert(heap->runHeap, heap->runs[slot].head.priority, slot);
+    }
+  }
+}
+
+/*
+ * Appends 'node' to the merged run in file 'fd', through heap->writeBlock.
+ * Returns false if it could not be written.
+ */
+bool appendNode(ExternalHeap *heap, int fd, HeapNode node)
+{
+  if (heap->writeLength == EXTERNAL_BLOCK_NODES)
+  {
+    if (!writeNodes(fd, heap->writeBlock, heap->writeLength))
+    {
+      return false;
+    }
+    heap->writeLength = 0;
+  }
+  heap->writeBlock[heap->writeLength++] = node;
+  return true;
+}
+
+/*
+ * Merges the open runs of 'heap' with the fewest remaining nodes, half of
+ * them, into one new run. Returns false if the new run could not be
+ * written, in which case the runs are put back as they were.
+ */
+bool mergeSmallerRuns(ExternalHeap *heap)
+{
+  // Order the open runs by remaining nodes, and take the first half
+  int order[EXTERNAL_MAX_RUNS];
+  int numOpen = 0;
+  for (int slot = 0; slot < EXTERNAL_MAX_RUNS; slot++)
+  {
+    if (heap->runs[slot].fd == -1)
+    {
+      continue;
+    }
+    int k = numOpen++;
+    while (k > 0 &&
+           heap->runs[order[k - 1]].remaining > heap->runs[slot].remaining)
+    {
+      order[k] = order[k - 1];
+      k--;
+    }
+    order[k] = slot;
+  }
+  int numMerged = numOpen / 2;
+  int64_t extracted[EXTERNAL_MAX_RUNS]; // to put the runs back on failure
+  MinHeap *merge = newHeap(EXTERNAL_MAX_RUNS);
+  for (int k = 0; k < numMerged; k++)
+  {
+    Run *run = &heap->runs[order[k]];
+    extracted[k] = run->length - run->remaining;
+    insert(merge, run->head.priority, order[k]);
+  }
+
+  int fd = newRunFile(heap);
+  bool ok = fd != -1;
+  int64_t length = 0;
+  heap->writeLength = 0;
+  while (ok && merge->size > 0)
+  {
+    int slot = extractMin(merge).id;
+    Run *run = &heap->runs[slot];
+    ok = appendNode(heap, fd, run->head) && advanceRun(run);
+    length++;
+    if (ok && run->remaining > 0)
+    {
+      insert(merge, run->head.priority, slot);
+    }
+  }
+  ok = ok && writeNodes(fd, heap->writeBlock, heap->writeLength);
+  deleteHeap(merge);
+
+  if (ok)
+  {
+    for (int k = 0; k < numMerged; k++)
+    {
+      closeRun(heap, order[k]);
+    }
+    rebuildRunHeap(heap);
+    ok = openRun(heap, order[0], fd, length);
+    if (ok)
+    {
+      return true;
+    }
+    // The merged runs are gone, and so is the new one
+    fprintf(stderr, "Unable to read back a run in %s\n", heap->directory);
+    exit(EXIT_FAILURE);
+  }
+
+  if (fd != -1)
+  {
+    close(fd);
+  }
+  for (int k = 0; k < numMerged; k++)
+  {
+    if (!seekRun(&heap->runs[order[k]], extracted[k]))
+    {
+      fprintf(stderr, "Unable to read back a run in %s\n", heap->directory);
+      exit(EXIT_FAILURE);
+    }
+  }
+  rebuildRunHeap(heap);
+  return false;
+}
+
+/*
+ * Writes the buffer of 'heap', which must be full, to a new run, and
+ * empties it. Returns false if the run could not be written, in which case
+ * the buffer is left full.
+ */
+bool spillBuffer(ExternalHeap *heap)
+{
+  if (heap->numRuns == EXTERNAL_MAX_RUNS && !mergeSmallerRuns(heap))
+  {
+    return false;
+  }
+
+  int count = heap->buffer->size;
+  for (int i = 0; i < count; i++)
+  {
+    HeapNode node = extractMin(heap->buffer);
+    heap->sorted[i].priority = node.priority;
+    heap->sorted[i].id = heap->bufferIds[node.id];
+  }
+  int fd = newRunFile(heap);
+  if (fd != -1 && writeNodes(fd, heap->sorted, count) &&
+      openRun(heap, freeRunSlot(heap), fd, count))
+  {
+    heap->numFree = 0;
+    for (int slot = count - 1; slot >= 0; slot--)
+    {
+      heap->freeSlots[heap->numFree++] = slot;
+    }
+    return true;
+  }
+
+  if (fd != -1)
+  {
+    close(fd);
+  }
+  for (int slot = 0; slot < count; slot++)
+  {
+    heap->bufferIds[slot] = heap->sorted[slot].id;
+    insert(heap->buffer, heap->sorted[slot].priority, slot);
+  }
+  return false;
+}
+
+/*********************************************************************
+ * Public functions
+ ********************************************************************/
+
+ExternalHeap *newExternalHeap(int bufferCapacity, const char *directory)
+{
+  ExternalHeap *heap = (ExternalHeap *)calloc(1, sizeof(ExternalHeap));
+  if (!heap)
+  {
+    return NULL;
+  }
+  if (directory == NULL)
+  {
+    directory = getenv("TMPDIR") ? getenv("TMPDIR") : "/tmp";
+  }
+  heap->directory = (char *)malloc(strlen(directory) + 1);
+  heap->bufferIds = (int *)malloc(bufferCapacity * sizeof(int));
+  heap->freeSlots = (int *)malloc(bufferCapacity * sizeof(int));
+  heap->sorted = (HeapNode *)malloc(bufferCapacity * sizeof(HeapNode));
+  heap->writeBlock = (HeapNode *)malloc(BLOCK_BYTES);
+  for (int slot = 0; slot < EXTERNAL_MAX_RUNS; slot++)
+  {
+    heap->runs[slot].fd = -1;
+  }
+  if (!heap->directory || !heap->bufferIds || !heap->freeSlots ||
+      !heap->sorted || !heap->writeBlock)
+  {
+    deleteExternalHeap(heap);
+    return NULL;
+  }
+  strcpy(heap->directory, directory);
+  heap->buffer = newHeap(bufferCapacity);
+  heap->runHeap = newHeap(EXTERNAL_MAX_RUNS);
+  for (int slot = bufferCapacity - 1; slot >= 0; slot--)
+  {
+    heap->freeSlots[heap->numFree++] = slot;
+  }
+  return heap;
+}
+
+bool externalInsert(ExternalHeap *heap, int priority, int id)
+{
+  if (heap->numFree == 0 && !spillBuffer(heap))
+  {
+    fprintf(stderr, "Unable to write a run to %s\n", heap->directory);
+    return false;
+  }
+  int slot = heap->freeSlots[--heap->numFree];
+  heap->bufferIds[slot] = id;
+  insert(heap->buffer, priority, slot);
+  heap->size++;
+  return true;
+}
+
+/*
+ * Returns True if the minimum of 'heap' is in its buffer rather than in a
+ * run.
+ * Precondition: heap is non-empty
+ */
+bool minIsBuffered(ExternalHeap *heap)
+{
+  return heap->runHeap->size == 0 ||
+         (heap->buffer->size > 0 &&
+          getMin(heap->buffer).priority <= getMin(heap->runHeap).priority);
+}
+
+HeapNode externalGetMin(ExternalHeap *heap)
+{
+  if (heap->size == 0)
+  {
+    printf("Heap is empty\n");
+    exit(EXIT_FAILURE);
+  }
+  if (minIsBuffered(heap))
+  {
+    HeapNode node = getMin(heap->buffer);
+    node.id = heap->bufferIds[node.id];
+    return node;
+  }
+  return heap->runs[getMin(heap->runHeap).id].head;
+}
+
+HeapNode externalExtractMin(ExternalHeap *heap)
+{
+  if (heap->size == 0)
+  {
+    printf("Heap is empty\n");
+    exit(EXIT_FAILURE);
+  }
+  heap->size--;
+  if (minIsBuffered(heap))
+  {
+    HeapNode node = extractMin(heap->buffer);
+    heap->freeSlots[heap->numFree++] = node.id;
+    node.id = heap->bufferIds[node.id];
+    return node;
+  }
+
+  int slot = extractMin(heap->runHeap).id;
+  Run *run = &heap->runs[slot];
+  HeapNode node = run->head;
+  if (!advanceRun(run))
+  {
+    fprintf(stderr, "Unable to read back a run in %s\n", heap->directory);
+    exit(EXIT_FAILURE);
+  }
+  if (run->remaining > 0)
+  {
+    insert(heap->runHeap, run->head.priority, slot);
+  }
+  else
+  {
+    closeRun(heap, slot);
+  }
+  return node;
+}
+
+int64_t externalHeapSize(ExternalHeap *heap)
+{
+  return heap->size;
+}
+
+void deleteExternalHeap(ExternalHeap *heap)
+{
+  if (!heap)
+  {
+    return;
+  }
+  for (int slot = 0; slot < EXTERNAL_MAX_RUNS; slot++)
+  {
+    if (heap->runs[slot].fd != -1)
+    {
+      close(heap->runs[slot].fd);
+    }
+    free(heap->runs[slot].block);
+  }
+  if (heap->buffer)
+  {
+    deleteHeap(heap->buffer);
+  }
+  if (heap->runHeap)
+  {
+    deleteHeap(heap->runHeap);
+  }
+  free(heap->directory);
+  free(heap->bufferIds);
+  free(heap->freeSlots);
+  free(heap->sorted);
+  free(heap->writeBlock);
+  free(heap);
+}
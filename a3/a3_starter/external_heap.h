@@ -0,0 +1,75 @@
+/*
+ * Header file for our external-memory priority queue.
+ *
+ * An ExternalHeap holds more nodes than fit in memory. New nodes go to an
+ * in-memory MinHeap of 'bufferCapacity' nodes; when it is full, it is
+ * emptied in sorted order into a run, an anonymous temporary file. Runs
+ * are merged lazily: each keeps its smallest node not yet extracted, a
+ * second MinHeap picks the smallest of those, and externalExtractMin
+ * compares it with the smallest buffered node. Runs are read sequentially
+ * in large blocks, and the kernel is asked to read the next block of a run
+ * ahead while the current one is consumed.
+ *
+ * At most EXTERNAL_MAX_RUNS runs are open at a time. When another is
+ * needed, the smaller half of them are first merged into a single run, so
+ * that a node is copied to disk O(log(size / bufferCapacity)) times.
+ *
+ * Unlike in a MinHeap, IDs are only carried along: they need not be unique
+ * or smaller than any capacity, and priorities cannot be changed.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "minheap.h"
+
+#ifndef __External_Heap_header
+#define __External_Heap_header
+
+#define EXTERNAL_MAX_RUNS 64
+#define EXTERNAL_BLOCK_NODES (1 << 16)  // nodes per read or write: 512 KiB
+
+typedef struct external_heap ExternalHeap;
+
+/*
+ * Returns a newly created empty ExternalHeap that buffers up to
+ * 'bufferCapacity' nodes in memory, and keeps its runs in directory
+ * 'directory' (or in $TMPDIR, or /tmp, if 'directory' is NULL). Returns
+ * NULL if memory could not be allocated.
+ * Precondition: bufferCapacity >= 1
+ */
+ExternalHeap* newExternalHeap(int bufferCapacity, const char* directory);
+
+/*
+ * Inserts a node with priority 'priority' and ID 'id' into 'heap'.
+ * Returns: true if insert was successful, false if a run could not be
+ * written, in which case 'heap' is unchanged
+ */
+bool externalInsert(ExternalHeap* heap, int priority, int id);
+
+/*
+ * Returns the node with minimum priority in 'heap'.
+ * Precondition: heap is non-empty
+ */
+HeapNode externalGetMin(ExternalHeap* heap);
+
+/*
+ * Removes and returns the node with minimum priority in 'heap'. Exits if a
+ * run cannot be read back.
+ * Precondition: heap is non-empty
+ */
+HeapNode externalExtractMin(ExternalHeap* heap);
+
+/*
+ * Returns the number of nodes in 'heap', in memory and on disk.
+ */
+int64_t externalHeapSize(ExternalHeap* heap);
+
+/*
+ * Frees all memory allocated for 'heap', and removes its runs.
+ */
+void deleteExternalHeap(ExternalHeap* heap);
+
+#endif
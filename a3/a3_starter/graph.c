@@ -7,6 +7,32 @@
 
 #include "graph.h"
 
+#define FIRST_CHUNK_EDGES 1024
+#define MAX_CHUNK_EDGES (1 << 20)
+
+/*
+ * An Edge and the EdgeList node that holds it, allocated side by side.
+ */
+typedef struct edge_node
+{
+  EdgeList list;
+  Edge edge;
+} EdgeNode;
+
+/*
+ * A block of EdgeNodes in the edge arena of a graph. The arena is a list of
+ * chunks, newest first; nodes are only handed out from the newest one.
+ */
+typedef struct edge_chunk
+{
+  struct edge_chunk *next;  // the chunk added before this one
+  int used;                 // number of nodes handed out from this chunk
+  int capacity;             // number of nodes in this chunk
+  EdgeList *freeList;       // deleted nodes to hand out again; only kept
+                            //   in the newest chunk
+  EdgeNode nodes[];
+} EdgeChunk;
+
 /*********************************************************************
  ** Helper function provided in the starter code
  *********************************************************************/
@@ -127,9 +153,77 @@ Graph *newGraph(int numVertices)
   {
     graph->vertices[i] = NULL;
   }
+  graph->edgeArena = NULL;
   return graph;
 }
 
+/*
+ * Adds a chunk with room for 'capacity' edges to the edge arena of 'graph'.
+ */
+void addEdgeChunk(Graph *graph, int capacity)
+{
+  EdgeChunk *chunk =
+      (EdgeChunk *)malloc(sizeof(EdgeChunk) + capacity * sizeof(EdgeNode));
+  if (!chunk)
+  {
+    printf("Memory allocation failed\n");
+    exit(EXIT_FAILURE);
+  }
+  chunk->next = graph->edgeArena;
+  chunk->used = 0;
+  chunk->capacity = capacity;
+  chunk->freeList = NULL;
+  if (chunk->next)
+  {
+    chunk->freeList = chunk->next->freeList;
+    chunk->next->freeList = NULL;
+  }
+  graph->edgeArena = chunk;
+}
+
+void reserveGraphEdges(Graph *graph, int numEdges)
+{
+  EdgeChunk *chunk = graph->edgeArena;
+  if (numEdges > 0 &&
+      (chunk == NULL || chunk->capacity - chunk->used < numEdges))
+  {
+    addEdgeChunk(graph, numEdges);
+  }
+}
+
+EdgeList *newGraphEdgeList(Graph *graph, int fromVertex, int toVertex,
+                           int weight, EdgeList *next)
+{
+  EdgeChunk *chunk = graph->edgeArena;
+  EdgeNode *node;
+  if (chunk && chunk->freeList)
+  {
+    node = (EdgeNode *)chunk->freeList; // list is the first member
+    chunk->freeList = chunk->freeList->next;
+  }
+  else
+  {
+    if (chunk == NULL || chunk->used == chunk->capacity)
+    {
+      // chunks double in size, so E edges take O(log E) mallocs
+      int capacity = chunk && chunk->capacity > FIRST_CHUNK_EDGES / 2
+                         ? 2 * chunk->capacity
+                         : FIRST_CHUNK_EDGES;
+      addEdgeChunk(graph,
+                   capacity < MAX_CHUNK_EDGES ? capacity : MAX_CHUNK_EDGES);
+      chunk = graph->edgeArena;
+    }
+    node = &chunk->nodes[chunk->used++];
+  }
+
+  node->edge.fromVertex = fromVertex;
+  node->edge.toVertex = toVertex;
+  node->edge.weight = weight;
+  node->list.edge = &node->edge;
+  node->list.next = next;
+  return &node->list;
+}
+
 void deleteEdgeList(EdgeList *head)
 {
   while (head != NULL)
@@ -156,9 +250,108 @@ void deleteGraph(Graph *graph)
   {
     for (int i = 0; i < graph->numVertices; i++)
     {
-      deleteVertex(graph->vertices[i]);
+      if (graph->edgeArena)
+      {
+        free(graph->vertices[i]); // its edges live in the arena
+      }
+      else
+      {
+        deleteVertex(graph->vertices[i]);
+      }
+    }
+    while (graph->edgeArena)
+    {
+      EdgeChunk *chunk = graph->edgeArena;
+      graph->edgeArena = chunk->next;
+      free(chunk);
     }
     free(graph->vertices);
     free(graph);
   }
 }
+
+/*********************************************************************
+ ** Updating edges
+ *********************************************************************/
+
+/*
+ * Returns the link that points at the first EdgeList node of 'fromVertex'
+ * holding an edge to 'toVertex', or at the NULL that ends its adjacency list
+ * if there is no such node.
+ */
+EdgeList **findEdgeLink(Graph *graph, int fromVertex, int toVertex)
+{
+  Vertex *vertex = graph->vertices[fromVertex];
+  if (vertex == NULL)
+  {
+    static EdgeList *none = NULL;
+    return &none;
+  }
+  EdgeList **link = &vertex->adjList;
+  while (*link != NULL && (*link)->edge->toVertex != toVertex)
+  {
+    link = &(*link)->next;
+  }
+  return link;
+}
+
+Edge *findGraphEdge(Graph *graph, int fromVertex, int toVertex)
+{
+  EdgeList *adj = *findEdgeLink(graph, fromVertex, toVertex);
+  return adj ? adj->edge : NULL;
+}
+
+Edge *insertGraphEdge(Graph *graph, int fromVertex, int toVertex, int weight)
+{
+  if (graph->vertices[fromVertex] == NULL)
+  {
+    graph->vertices[fromVertex] = newVertex(fromVertex, NULL, NULL);
+  }
+  Vertex *vertex = graph->vertices[fromVertex];
+  if (graph->edgeArena)
+  {
+    vertex->adjList = newGraphEdgeList(graph, fromVertex, toVertex, weight,
+                                       vertex->adjList);
+  }
+  else
+  {
+    vertex->adjList = newEdgeList(newEdge(fromVertex, toVertex, weight),
+                                  vertex->adjList);
+  }
+  graph->numEdges++;
+  return vertex->adjList->edge;
+}
+
+bool deleteGraphEdge(Graph *graph, int fromVertex, int toVertex)
+{
+  EdgeList **link = findEdgeLink(graph, fromVertex, toVertex);
+  EdgeList *adj = *link;
+  if (adj == NULL)
+  {
+    return false;
+  }
+  *link = adj->next;
+  if (graph->edgeArena)
+  {
+    adj->next = graph->edgeArena->freeList;
+    graph->edgeArena->freeList = adj;
+  }
+  else
+  {
+    free(adj->edge);
+    free(adj);
+  }
+  graph->numEdges--;
+  return true;
+}
+
+bool reweightGraphEdge(Graph *graph, int fromVertex, int toVertex, int weight)
+{
+  Edge *edge = findGraphEdge(graph, fromVertex, toVertex);
+  if (edge == NULL)
+  {
+    return false;
+  }
+  edge->weight = weight;
+  return true;
+}
@@ -39,6 +39,7 @@ typedef struct graph {
   int numVertices;    // total number of vertices
   int numEdges;       // total number of edges
   Vertex** vertices;  // numVertices Vertex pointers; vertices[v.id] = v
+  struct edge_chunk* edgeArena;  // storage for edges made by newGraphEdgeList
 } Graph;
 
 /***** Displaying graph elements ********************************************/
@@ -91,6 +92,25 @@ Vertex* newVertex(int id, void* value, EdgeList* adjList);
  */
 Graph* newGraph(int numVertices);
 
+/*
+ * Returns a newly created EdgeList node containing a new Edge from vertex
+ * with ID 'fromVertex' to vertex with ID 'toVertex' with weight 'weight',
+ * and pointing to the next EdgeList node 'next'.
+ * Both are carved out of the edge arena of 'graph' instead of being
+ * malloc'd one by one, and are freed all at once by deleteGraph. Do not
+ * pass them to deleteEdgeList or deleteVertex, and do not mix them with
+ * newEdge / newEdgeList nodes in the adjacency lists of 'graph'.
+ */
+EdgeList* newGraphEdgeList(Graph* graph, int fromVertex, int toVertex,
+                           int weight, EdgeList* next);
+
+/*
+ * Makes sure the edge arena of 'graph' can hand out at least 'numEdges'
+ * more edges from a single contiguous block.
+ * Precondition: numEdges >= 0
+ */
+void reserveGraphEdges(Graph* graph, int numEdges);
+
 /*
  * Frees memory allocated for EdgeList starting at 'head'.
  */
@@ -102,8 +122,43 @@ void deleteEdgeList(EdgeList* head);
 void deleteVertex(Vertex* vertex);
 
 /*
- * Frees memory allocated for 'graph'.
+ * Frees memory allocated for 'graph', including its edge arena.
  */
 void deleteGraph(Graph* graph);
 
+/***** Updating edges ******************************************************/
+
+/*
+ * Returns the first Edge from vertex with ID 'fromVertex' to vertex with ID
+ * 'toVertex' in the adjacency list of 'fromVertex', or NULL if there is none.
+ * Precondition: 'fromVertex' is valid in 'graph'
+ */
+Edge* findGraphEdge(Graph* graph, int fromVertex, int toVertex);
+
+/*
+ * Adds a new Edge from vertex with ID 'fromVertex' to vertex with ID
+ * 'toVertex' with weight 'weight' to the front of the adjacency list of
+ * 'fromVertex', creating that Vertex if needed, and returns it. The edge is
+ * taken from the edge arena of 'graph' if it has one, and malloc'd
+ * otherwise.
+ * Precondition: both IDs are valid in 'graph' and weight >= 0
+ */
+Edge* insertGraphEdge(Graph* graph, int fromVertex, int toVertex, int weight);
+
+/*
+ * Removes the Edge findGraphEdge would return from 'graph' and frees it, or
+ * hands it back to the edge arena for reuse. Returns false if there is no
+ * such edge.
+ * Precondition: 'fromVertex' is valid in 'graph'
+ */
+bool deleteGraphEdge(Graph* graph, int fromVertex, int toVertex);
+
+/*
+ * Sets the weight of the Edge findGraphEdge would return to 'weight'.
+ * Returns false if there is no such edge.
+ * Precondition: 'fromVertex' is valid in 'graph' and weight >= 0
+ */
+bool reweightGraphEdge(Graph* graph, int fromVertex, int toVertex,
+                       int weight);
+
 #endif
@@ -6,9 +6,13 @@
  */
 
 #include <limits.h>
+#include <stdatomic.h>
+#include <string.h>
 
 #include "graph.h"
+#include "graph_algos.h"
 #include "minheap.h"
+#include "perf_counters.h"
 
 /*
  * A structure to keep record of the current running algorithm.
@@ -199,6 +203,59 @@ void cleanupRecords(Records *records)
   }
 }
 
+/*
+ * Runs the main loop of Dijkstra's algorithm on Graph 'graph' with freshly
+ * initialized 'records', filling in records->distances and
+ * records->predecessors, and adding the distance tree edges to
+ * records->tree in the order their vertices are finished. Vertices that
+ * cannot be reached keep distance INT_MAX.
+ */
+void computeDistanceTree(Graph *graph, Records *records, int startVertex)
+{
+  while (!isEmpty(records->heap))
+  {
+    HeapNode minNode = extractMin(records->heap);
+    int u = minNode.id;
+    records->finished[u] = true;
+
+    EdgeList *adj = graph->vertices[u]->adjList;
+    int currentDist = records->distances[u];
+    if (currentDist == INT_MAX)
+    {
+      continue; // u and everything left in the heap are unreachable
+    }
+
+    PERF_BEGIN(PERF_RELAX);
+    while (adj != NULL)
+    {
+      int v = adj->edge->toVertex;
+      int weight = adj->edge->weight;
+      int newDist = currentDist + weight;
+
+      if (!records->finished[v] && records->distances[v] > newDist)
+      {
+        records->distances[v] = newDist;
+        decreasePriority(records->heap, v, newDist);
+        records->predecessors[v] = u;
+      }
+      adj = adj->next;
+    }
+    PERF_END(PERF_RELAX);
+
+    if (u != startVertex)
+    {
+      for (EdgeList *adj = graph->vertices[records->predecessors[u]]->adjList; adj != NULL; adj = adj->next)
+      {
+        if (adj->edge->toVertex == u)
+        {
+          addTreeEdge(records, records->numTreeEdges, records->predecessors[u], u, adj->edge->weight);
+          break;
+        }
+      }
+    }
+  }
+}
+
 /*************************************************************************
  ** Required functions
  *************************************************************************/
@@ -280,42 +337,7 @@ Edge *getDistanceTreeDijkstra(Graph *graph, int startVertex)
     return NULL;
   }
 
-  while (!isEmpty(records->heap))
-  {
-    HeapNode minNode = extractMin(records->heap);
-    int u = minNode.id;
-    records->finished[u] = true;
-
-    EdgeList *adj = graph->vertices[u]->adjList;
-    int currentDist = records->distances[u];
-
-    while (adj != NULL)
-    {
-      int v = adj->edge->toVertex;
-      int weight = adj->edge->weight;
-      int newDist = currentDist + weight;
-
-      if (!records->finished[v] && records->distances[v] > newDist)
-      {
-        records->distances[v] = newDist;
-        decreasePriority(records->heap, v, newDist);
-        records->predecessors[v] = u;
-      }
-      adj = adj->next;
-    }
-
-    if (u != startVertex)
-    {
-      for (EdgeList *adj = graph->vertices[records->predecessors[u]]->adjList; adj != NULL; adj = adj->next)
-      {
-        if (adj->edge->toVertex == u)
-        {
-          addTreeEdge(records, records->numTreeEdges, records->predecessors[u], u, adj->edge->weight);
-          break;
-        }
-      }
-    }
-  }
+  computeDistanceTree(graph, records, startVertex);
 
   Edge *distTree = (Edge *)malloc(records->numTreeEdges * sizeof(Edge));
   if (distTree == NULL)
@@ -351,6 +373,436 @@ EdgeList **getShortestPaths(Edge *distTree, int numVertices, int startVertex)
   return paths;
 }
 
+/*************************************************************************
+ ** Workspaces
+ *************************************************************************/
+
+/*
+ * Largest generation a workspace counts up to before it clears its arrays
+ * and starts again at 1. Build with a small value, e.g.
+ * -DWORKSPACE_MAX_GENERATION=5, to make the wrap around happen in tests.
+ */
+#ifndef WORKSPACE_MAX_GENERATION
+#define WORKSPACE_MAX_GENERATION UINT_MAX
+#endif
+
+/*
+ * Reusable memory for Prim's and Dijkstra's algorithms. Instead of clearing
+ * its arrays before every run, a workspace bumps 'generation': an entry of
+ * 'keys' or 'predecessors' is only meaningful if the matching entry of
+ * 'reached' equals the current generation, so a run only ever touches the
+ * vertices it reaches.
+ */
+struct workspace
+{
+  int numVertices;        // largest graph this workspace can be used for
+  unsigned int generation; // number of the current run; never 0
+  unsigned int *reached;  // reached[id] == generation iff id was reached
+  unsigned int *finished; // finished[id] == generation iff id left the PQ
+  int *keys;              // PQ priority of id: its distance or MST key
+  int *predecessors;      // predecessor of id in the current tree
+  MinHeap *heap;          // holds reached but unfinished vertices only
+  int *decoded;           // targets, then weights, of one CompressedGraph run
+  int decodedCapacity;    // edges 'decoded' has room for
+};
+
+Workspace *newWorkspace(int numVertices)
+{
+  Workspace *ws = (Workspace *)malloc(sizeof(Workspace));
+  if (!ws)
+  {
+    return NULL;
+  }
+  ws->numVertices = numVertices;
+  ws->generation = 1;
+  ws->reached = (unsigned int *)calloc(numVertices + 1, sizeof(unsigned int));
+  ws->finished = (unsigned int *)calloc(numVertices + 1, sizeof(unsigned int));
+  ws->keys = (int *)malloc((numVertices + 1) * sizeof(int));
+  ws->predecessors = (int *)malloc((numVertices + 1) * sizeof(int));
+  ws->heap = newHeap(numVertices);
+  ws->decoded = NULL;
+  ws->decodedCapacity = 0;
+  if (!ws->reached || !ws->finished || !ws->keys || !ws->predecessors ||
+      !ws->heap)
+  {
+    deleteWorkspace(ws);
+    return NULL;
+  }
+  return ws;
+}
+
+void deleteWorkspace(Workspace *ws)
+{
+  if (ws)
+  {
+    free(ws->reached);
+    free(ws->finished);
+    free(ws->keys);
+    free(ws->predecessors);
+    deleteHeap(ws->heap);
+    free(ws->decoded);
+    free(ws);
+  }
+}
+
+/*
+ * Starts a new run in 'ws', invalidating the results of the previous one.
+ * Only clears the generation arrays when the counter wraps around.
+ */
+void beginRun(Workspace *ws)
+{
+  ws->generation++;
+  if (ws->generation == 0 || ws->generation > WORKSPACE_MAX_GENERATION)
+  {
+    memset(ws->reached, 0, ws->numVertices * sizeof(unsigned int));
+    memset(ws->finished, 0, ws->numVertices * sizeof(unsigned int));
+    ws->generation = 1;
+  }
+  clearHeap(ws->heap);
+}
+
+/*
+ * Offers priority 'key' with predecessor 'predecessor' to the unfinished
+ * vertex 'id' in 'ws', inserting it into the PQ the first time it is
+ * reached in this run and decreasing its priority afterwards.
+ */
+void reachVertex(Workspace *ws, int id, int key, int predecessor)
+{
+  if (ws->reached[id] != ws->generation)
+  {
+    ws->reached[id] = ws->generation;
+    ws->keys[id] = key;
+    ws->predecessors[id] = predecessor;
+    insert(ws->heap, key, id);
+  }
+  else if (key < ws->keys[id])
+  {
+    ws->keys[id] = key;
+    ws->predecessors[id] = predecessor;
+    decreasePriority(ws->heap, id, key);
+  }
+}
+
+/*
+ * Starts a run of Prim's or Dijkstra's algorithm in 'ws' on a graph with
+ * 'numVertices' vertices from 'startVertex'. Returns false if 'startVertex'
+ * is not valid or the graph is too large for 'ws'.
+ */
+bool startRun(Workspace *ws, int numVertices, int startVertex)
+{
+  if (numVertices > ws->numVertices || startVertex < 0 ||
+      startVertex >= numVertices)
+  {
+    return false;
+  }
+  beginRun(ws);
+  reachVertex(ws, startVertex, 0, NOTHING);
+  return true;
+}
+
+/*
+ * Marks vertex 'u', just taken from the PQ of 'ws', as finished and, unless
+ * it is 'startVertex', writes its tree edge to tree[numTreeEdges] in the
+ * same orientation as getMSTprim (if 'prim' is true) or
+ * getDistanceTreeDijkstra. 'tree' may be NULL.
+ * Returns the new number of tree edges.
+ */
+int finishVertex(Workspace *ws, int u, int startVertex, bool prim, Edge *tree,
+                 int numTreeEdges)
+{
+  ws->finished[u] = ws->generation;
+  if (u == startVertex)
+  {
+    return numTreeEdges;
+  }
+  if (tree != NULL)
+  {
+    int pred = ws->predecessors[u];
+    Edge *edge = &tree[numTreeEdges];
+    edge->fromVertex = prim ? u : pred;
+    edge->toVertex = prim ? pred : u;
+    edge->weight = prim ? ws->keys[u] : ws->keys[u] - ws->keys[pred];
+  }
+  return numTreeEdges + 1;
+}
+
+/*
+ * Runs Prim's algorithm (if 'prim' is true) or Dijkstra's algorithm on
+ * Graph 'graph' from 'startVertex' using 'ws', writing the tree edges to
+ * 'tree' (which may be NULL) in the order their vertices are finished.
+ * Returns the number of tree edges, or -1 if the arguments are not valid.
+ */
+int runWithWorkspace(Workspace *ws, Graph *graph, int startVertex, bool prim,
+                     Edge *tree)
+{
+  if (!startRun(ws, graph->numVertices, startVertex))
+  {
+    return -1;
+  }
+
+  int numTreeEdges = 0;
+  while (!isEmpty(ws->heap))
+  {
+    int u = extractMin(ws->heap).id;
+    numTreeEdges = finishVertex(ws, u, startVertex, prim, tree, numTreeEdges);
+
+    int base = prim ? 0 : ws->keys[u];
+    PERF_BEGIN(PERF_RELAX);
+    for (EdgeList *adj = graph->vertices[u]->adjList; adj != NULL;
+         adj = adj->next)
+    {
+      int v = adj->edge->toVertex;
+      if (ws->finished[v] != ws->generation)
+      {
+        reachVertex(ws, v, base + adj->edge->weight, u);
+      }
+    }
+    PERF_END(PERF_RELAX);
+  }
+  return numTreeEdges;
+}
+
+/*
+ * Same as runWithWorkspace, for CSRGraph 'csr'.
+ */
+int runWithWorkspaceCSR(Workspace *ws, CSRGraph *csr, int startVertex,
+                        bool prim, Edge *tree)
+{
+  if (!startRun(ws, csr->numVertices, startVertex))
+  {
+    return -1;
+  }
+
+  int numTreeEdges = 0;
+  while (!isEmpty(ws->heap))
+  {
+    int u = extractMin(ws->heap).id;
+    numTreeEdges = finishVertex(ws, u, startVertex, prim, tree, numTreeEdges);
+
+    int base = prim ? 0 : ws->keys[u];
+    PERF_BEGIN(PERF_RELAX);
+    for (int64_t e = csr->offsets[u]; e < csr->offsets[u + 1]; e++)
+    {
+      int v = csr->targets[e];
+      if (ws->finished[v] != ws->generation)
+      {
+        reachVertex(ws, v, base + csr->weights[e], u);
+      }
+    }
+    PERF_END(PERF_RELAX);
+  }
+  return numTreeEdges;
+}
+
+/*
+ * Same as runWithWorkspace, for CompressedGraph 'graph'.
+ */
+int runWithWorkspaceCompressed(Workspace *ws, CompressedGraph *graph,
+                               int startVertex, bool prim, Edge *tree)
+{
+  if (graph->maxDegree > ws->decodedCapacity)
+  {
+    int *decoded =
+        (int *)realloc(ws->decoded, 2 * (size_t)graph->maxDegree * sizeof(int));
+    if (!decoded)
+    {
+      return -1;
+    }
+    ws->decoded = decoded;
+    ws->decodedCapacity = graph->maxDegree;
+  }
+  if (!startRun(ws, graph->numVertices, startVertex))
+  {
+    return -1;
+  }
+  int *targets = ws->decoded;
+  int *weights = ws->decoded + graph->maxDegree;
+
+  int numTreeEdges = 0;
+  while (!isEmpty(ws->heap))
+  {
+    int u = extractMin(ws->heap).id;
+    numTreeEdges = finishVertex(ws, u, startVertex, prim, tree, numTreeEdges);
+
+    int base = prim ? 0 : ws->keys[u];
+    int degree = decodeNeighbors(graph, u, targets, weights);
+    PERF_BEGIN(PERF_RELAX);
+    for (int i = 0; i < degree; i++)
+    {
+      int v = targets[i];
+      if (ws->finished[v] != ws->generation)
+      {
+        reachVertex(ws, v, base + weights[i], u);
+      }
+    }
+    PERF_END(PERF_RELAX);
+  }
+  return numTreeEdges;
+}
+
+int getMSTprimInto(Workspace *ws, Graph *graph, int startVertex, Edge *mst)
+{
+  return runWithWorkspace(ws, graph, startVertex, true, mst);
+}
+
+int getDistanceTreeDijkstraInto(Workspace *ws, Graph *graph, int startVertex,
+                                Edge *distTree)
+{
+  return runWithWorkspace(ws, graph, startVertex, false, distTree);
+}
+
+int getMSTprimCSR(Workspace *ws, CSRGraph *csr, int startVertex, Edge *mst)
+{
+  return runWithWorkspaceCSR(ws, csr, startVertex, true, mst);
+}
+
+int getDistanceTreeDijkstraCSR(Workspace *ws, CSRGraph *csr, int startVertex,
+                               Edge *distTree)
+{
+  return runWithWorkspaceCSR(ws, csr, startVertex, false, distTree);
+}
+
+int getMSTprimCompressed(Workspace *ws, CompressedGraph *graph,
+                         int startVertex, Edge *mst)
+{
+  return runWithWorkspaceCompressed(ws, graph, startVertex, true, mst);
+}
+
+int getDistanceTreeDijkstraCompressed(Workspace *ws, CompressedGraph *graph,
+                                      int startVertex, Edge *distTree)
+{
+  return runWithWorkspaceCompressed(ws, graph, startVertex, false, distTree);
+}
+
+int getWorkspaceDistance(Workspace *ws, int id)
+{
+  return ws->reached[id] == ws->generation ? ws->keys[id] : INT_MAX;
+}
+
+int getWorkspacePredecessor(Workspace *ws, int id)
+{
+  return ws->reached[id] == ws->generation ? ws->predecessors[id] : NOTHING;
+}
+
+/*************************************************************************
+ ** Batch queries
+ *************************************************************************/
+
+/*
+ * Everything the workers of a batch Dijkstra run share.
+ */
+typedef struct dijkstra_batch
+{
+  Graph *graph;          // the graph being queried; not modified
+  int *sources;          // the start vertex of each query
+  Workspace **workspaces; // workspaces[w] is reused by every query of worker w
+  DistanceFn fn;         // receives the result of each query
+  void *context;         // passed through to 'fn'
+  atomic_bool failed;    // a query could not allocate its results
+} DijkstraBatch;
+
+/*
+ * Runs query 'index' of the DijkstraBatch 'context' on worker 'workerId'.
+ */
+void runBatchQuery(int index, int workerId, void *context)
+{
+  DijkstraBatch *batch = (DijkstraBatch *)context;
+  Workspace *ws = batch->workspaces[workerId];
+  int numVertices = batch->graph->numVertices;
+  int *distances = (int *)taskAlloc((size_t)2 * numVertices * sizeof(int));
+  if (distances == NULL)
+  {
+    atomic_store(&batch->failed, true);
+    return;
+  }
+  int *predecessors = distances + numVertices;
+  int source = batch->sources[index];
+
+  getDistanceTreeDijkstraInto(ws, batch->graph, source, NULL);
+  for (int v = 0; v < numVertices; v++)
+  {
+    distances[v] = getWorkspaceDistance(ws, v);
+    predecessors[v] = getWorkspacePredecessor(ws, v);
+  }
+  batch->fn(source, index, distances, predecessors, batch->context);
+}
+
+bool runDijkstraBatch(Graph *graph, int *sources, int numSources,
+                      DistanceFn fn, void *context, ThreadPool *pool)
+{
+  for (int i = 0; i < numSources; i++)
+  {
+    if (sources[i] < 0 || sources[i] >= graph->numVertices)
+    {
+      return false;
+    }
+  }
+  if (numSources == 0)
+  {
+    return true;
+  }
+
+  int numWorkers = poolSize(pool);
+  Workspace **workspaces =
+      (Workspace **)calloc(numWorkers, sizeof(Workspace *));
+  bool ok = workspaces != NULL;
+  for (int w = 0; w < numWorkers && ok; w++)
+  {
+    workspaces[w] = newWorkspace(graph->numVertices);
+    ok = workspaces[w] != NULL;
+  }
+
+  if (ok)
+  {
+    DijkstraBatch batch = {graph, sources, workspaces, fn, context, false};
+    parallelFor(pool, numSources, runBatchQuery, &batch);
+    ok = !atomic_load(&batch.failed);
+  }
+  if (!ok)
+  {
+    printf("Memory allocation for batch workspaces failed.\n");
+  }
+
+  for (int w = 0; workspaces != NULL && w < numWorkers; w++)
+  {
+    deleteWorkspace(workspaces[w]);
+  }
+  free(workspaces);
+  return ok;
+}
+
+/*
+ * A row-major matrix of distances with one row of 'numVertices' entries per
+ * query, as filled in by getDistancesDijkstraBatch.
+ */
+typedef struct distance_matrix
+{
+  int *rows;        // rows[i * numVertices + v] is the distance to v in query i
+  int numVertices;  // number of columns
+} DistanceMatrix;
+
+/*
+ * DistanceFn that copies the distances of query 'index' into row 'index' of
+ * the DistanceMatrix 'context'.
+ */
+void copyDistanceRow(int source, int index, int *distances, int *predecessors,
+                     void *context)
+{
+  (void)source;
+  (void)predecessors;
+  DistanceMatrix *matrix = (DistanceMatrix *)context;
+  memcpy(matrix->rows + (size_t)index * matrix->numVertices, distances,
+         matrix->numVertices * sizeof(int));
+}
+
+bool getDistancesDijkstraBatch(Graph *graph, int *sources, int numSources,
+                               int *distances, ThreadPool *pool)
+{
+  DistanceMatrix matrix = {distances, graph->numVertices};
+  return runDijkstraBatch(graph, sources, numSources, copyDistanceRow, &matrix,
+                          pool);
+}
+
 /*************************************************************************
  ** Provided helper functions -- part of starter code to help you debug!
  *************************************************************************/
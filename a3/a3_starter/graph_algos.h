@@ -12,7 +12,10 @@
 #include <stdio.h>
 #include <stdlib.h>
 
+#include "compressed_graph.h"
+#include "csr_graph.h"
 #include "graph.h"
+#include "threadpool.h"
 
 #ifndef __Graph_Algos_header
 #define __Graph_Algos_header
@@ -48,4 +51,111 @@ Edge* getDistanceTreeDijkstra(Graph* graph, int startVertex);
  */
 EdgeList** getShortestPaths(Edge* distTree, int numVertices, int startVertex);
 
+/***** Workspaces **********************************************************/
+
+/*
+ * Memory for repeated runs of Prim's and Dijkstra's algorithms, allocated
+ * once and reused. Starting a new run costs O(1) rather than O(numVertices):
+ * a run only touches the vertices it reaches. Runs on a CompressedGraph
+ * also decode adjacency runs into it; it grows to fit the first time it is
+ * used on a graph with more edges per vertex than before, and such a graph
+ * counts as too large for it if it cannot grow.
+ */
+typedef struct workspace Workspace;
+
+/*
+ * Returns a newly created Workspace for graphs with at most 'numVertices'
+ * vertices, or NULL if memory could not be allocated.
+ * Precondition: numVertices >= 0
+ */
+Workspace* newWorkspace(int numVertices);
+
+/*
+ * Frees all memory allocated for 'ws'.
+ */
+void deleteWorkspace(Workspace* ws);
+
+/*
+ * Runs Prim's algorithm on Graph 'graph' starting from vertex with ID
+ * 'startVertex' using workspace 'ws', and writes the MST edges to 'mst' in
+ * the same form as getMSTprim. 'mst' must have room for numVertices - 1
+ * edges, or be NULL if only the workspace results are wanted.
+ * Returns the number of edges written, which is less than numVertices - 1
+ * if 'graph' is not connected, or -1 if 'startVertex' is not valid in
+ * 'graph' or 'graph' is too large for 'ws'.
+ */
+int getMSTprimInto(Workspace* ws, Graph* graph, int startVertex, Edge* mst);
+
+/*
+ * Runs Dijkstra's algorithm on Graph 'graph' starting from vertex with ID
+ * 'startVertex' using workspace 'ws', and writes the distance tree edges
+ * (predecessor -- vertex, edge weight) to 'distTree'. 'distTree' must have
+ * room for numVertices - 1 edges, or be NULL.
+ * Returns the number of edges written, or -1 as for getMSTprimInto.
+ */
+int getDistanceTreeDijkstraInto(Workspace* ws, Graph* graph, int startVertex,
+                                Edge* distTree);
+
+/*
+ * Same as getMSTprimInto and getDistanceTreeDijkstraInto, for a CSRGraph,
+ * e.g. one mapped from a binary graph file with mapCSRGraph.
+ */
+int getMSTprimCSR(Workspace* ws, CSRGraph* csr, int startVertex, Edge* mst);
+int getDistanceTreeDijkstraCSR(Workspace* ws, CSRGraph* csr, int startVertex,
+                               Edge* distTree);
+
+/*
+ * Same as getMSTprimInto and getDistanceTreeDijkstraInto, for a
+ * CompressedGraph, whose adjacency runs are decoded as they are visited.
+ */
+int getMSTprimCompressed(Workspace* ws, CompressedGraph* graph,
+                         int startVertex, Edge* mst);
+int getDistanceTreeDijkstraCompressed(Workspace* ws, CompressedGraph* graph,
+                                      int startVertex, Edge* distTree);
+
+/*
+ * Returns the distance (after Dijkstra's) or MST key (after Prim's) of
+ * vertex 'id' from the last run in 'ws', or INT_MAX if it was not reached.
+ */
+int getWorkspaceDistance(Workspace* ws, int id);
+
+/*
+ * Returns the predecessor of vertex 'id' in the tree from the last run in
+ * 'ws', or NOTHING if it is the start vertex or was not reached.
+ */
+int getWorkspacePredecessor(Workspace* ws, int id);
+
+/***** Batch queries *******************************************************/
+
+/*
+ * Receives the result of one query of runDijkstraBatch: the query number
+ * 'index', its start vertex 'source', and arrays 'distances' and
+ * 'predecessors' of numVertices entries each. Unreachable vertices have
+ * distance INT_MAX and predecessor NOTHING. The arrays are reused for the
+ * next query once this returns, and calls for different queries may run
+ * concurrently on different threads.
+ */
+typedef void (*DistanceFn)(int source, int index, int* distances,
+                           int* predecessors, void* context);
+
+/*
+ * Runs Dijkstra's algorithm on Graph 'graph' from each of the 'numSources'
+ * vertices in 'sources', spreading the queries over the workers of 'pool'
+ * (or the calling thread if 'pool' is NULL), and passes each result to
+ * fn(source, index, distances, predecessors, context).
+ * Each worker allocates one Workspace and reuses it for all of its
+ * queries. 'graph' must not be modified while the batch runs.
+ * Returns false if any source is not valid in 'graph' or memory could not be
+ * allocated.
+ */
+bool runDijkstraBatch(Graph* graph, int* sources, int numSources,
+                      DistanceFn fn, void* context, ThreadPool* pool);
+
+/*
+ * Same as runDijkstraBatch, but copies the distances of query i into row i
+ * of 'distances', a numSources x numVertices row-major matrix.
+ */
+bool getDistancesDijkstraBatch(Graph* graph, int* sources, int numSources,
+                               int* distances, ThreadPool* pool);
+
 #endif
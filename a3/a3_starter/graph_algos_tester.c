@@ -0,0 +1,471 @@
+/*
+ *  Randomized testing of our Workspaces and batch queries (see graph_algos.h).
+ *
+ *  One Workspace runs hundreds of queries, Dijkstra's and Prim's algorithm
+ *  from random sources, on graphs of different sizes in random order, some
+ *  of them directed with vertices the source cannot reach. Each query must
+ *  find the distances of getDistanceTreeDijkstra, or a minimum spanning
+ *  tree of the weight of getMSTprim's, and must not see anything left over
+ *  from earlier queries: a vertex the query does not reach has distance
+ *  INT_MAX and predecessor NOTHING. The compile line below makes the
+ *  generation counter of the Workspace wrap around every few queries.
+ *
+ *  Batches of queries from random sources, with repeats, run through
+ *  getDistancesDijkstraBatch and runDijkstraBatch with and without a pool
+ *  of workers: each row must hold the distances and predecessors a single
+ *  run from its source leaves in a Workspace. Prints the first mismatches
+ *  found and exits with a non-zero status if there were any.
+ *
+ *  ---------------------------------------------------------------------------
+ *   Compile:
+ *   gcc -Wall -Werror -pthread -DWORKSPACE_MAX_GENERATION=5 graph.c \
+ *       minheap.c csr_graph.c compressed_graph.c graph_algos.c threadpool.c \
+ *       graph_algos_tester.c -o graph_algos_tester
+ *
+ *   Run:
+ *   ./graph_algos_tester [seed]
+ *  ---------------------------------------------------------------------------
+ */
+
+#include <limits.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "graph.h"
+#include "graph_algos.h"
+#include "threadpool.h"
+
+#define NUM_GRAPHS 6
+#define NUM_QUERIES 600
+#define MAX_WEIGHT 1000
+#define MAX_SOURCES 40
+#define POOL_THREADS 3
+#define MAX_REPORTED 10  // mismatches printed before only counting them
+
+uint64_t randomState;
+int numMismatches;
+
+/*
+ * A graph the queries run on.
+ */
+typedef struct test_graph
+{
+  const char* name;
+  Graph* graph;
+  bool undirected;  // and connected, so Prim's algorithm can run on it
+} TestGraph;
+
+/*
+ * Rows of predecessors of a batch, filled in by copyPredecessors.
+ */
+typedef struct predecessor_rows
+{
+  int* rows;        // rows[i * numVertices + v] is v's predecessor in query i
+  int numVertices;  // number of columns
+} PredecessorRows;
+
+/*
+ * Returns a pseudo-random number in 0, 1, ..., bound-1 (splitmix64).
+ */
+int randomBelow(int bound)
+{
+  uint64_t z = (randomState += 0x9e3779b97f4a7c15ULL);
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+  z ^= z >> 31;
+  return (int)((z >> 33) % (uint64_t)bound);
+}
+
+/*
+ * Prints a mismatch found on graph 'name', and counts it.
+ */
+void reportMismatch(const char* name, const char* what, int vertex,
+                    int expected, int actual)
+{
+  if (++numMismatches <= MAX_REPORTED)
+  {
+    printf("%s: %s of vertex %d is %d, expected %d\n", name, what, vertex,
+           actual, expected);
+  }
+}
+
+/*
+ * Adds an edge from 'from' to 'to' to 'graph', and one back if
+ * 'undirected', unless it would be a self-loop or a parallel edge: the
+ * trees of getDistanceTreeDijkstra and getMSTprim hold the first edge
+ * between two vertices, which need not be the lightest.
+ */
+void addEdge(Graph* graph, int from, int to, bool undirected)
+{
+  if (from == to || findGraphEdge(graph, from, to) != NULL)
+  {
+    return;
+  }
+  int weight = 1 + randomBelow(MAX_WEIGHT);
+  insertGraphEdge(graph, from, to, weight);
+  if (undirected)
+    insertGraphEdge(graph, to, from, weight);
+}
+
+/*
+ * Returns a random graph with 'numVertices' vertices and about 'numEdges'
+ * edges. An undirected graph also gets a random spanning tree, so that it
+ * is connected.
+ */
+TestGraph newRandomGraph(const char* name, int numVertices, int numEdges,
+                         bool undirected)
+{
+  Graph* graph = newGraph(numVertices);
+  for (int v = 0; v < numVertices; v++)
+    graph->vertices[v] = newVertex(v, NULL, NULL);
+  for (int v = 1; undirected && v < numVertices; v++)
+    addEdge(graph, randomBelow(v), v, true);
+  for (int i = 0; i < numEdges; i++)
+    addEdge(graph, randomBelow(numVertices), randomBelow(numVertices),
+            undirected);
+  TestGraph test = {name, graph, undirected};
+  return test;
+}
+
+/*
+ * Returns the number of vertices of 'graph' reachable from 'source', found
+ * by BFS using 'reached' and 'queue' of numVertices entries.
+ */
+int countReachable(Graph* graph, int source, bool* reached, int* queue)
+{
+  memset(reached, 0, graph->numVertices * sizeof(bool));
+  reached[source] = true;
+  queue[0] = source;
+  int head = 0;
+  int tail = 1;
+  while (head < tail)
+  {
+    for (EdgeList* list = graph->vertices[queue[head++]]->adjList; list;
+         list = list->next)
+    {
+      int v = list->edge->toVertex;
+      if (!reached[v])
+      {
+        reached[v] = true;
+        queue[tail++] = v;
+      }
+    }
+  }
+  return tail;
+}
+
+/*
+ * Runs Dijkstra's algorithm on 'test' from 'source' in 'ws', writing its
+ * tree to 'tree' (which may be NULL), and checks it against
+ * getDistanceTreeDijkstra. 'expected', 'reached' and 'queue' have room for
+ * numVertices entries.
+ */
+void checkDijkstra(TestGraph test, Workspace* ws, int source, Edge* tree,
+                   int* expected, bool* reached, int* queue)
+{
+  Graph* graph = test.graph;
+  int n = graph->numVertices;
+  int numReached = countReachable(graph, source, reached, queue);
+
+  // Distances from the legacy tree, whose edges come in the order their
+  // "to" vertices were finished
+  Edge* legacy = getDistanceTreeDijkstra(graph, source);
+  if (legacy == NULL)
+  {
+    printf("Memory allocation failed\n");
+    exit(EXIT_FAILURE);
+  }
+  for (int v = 0; v < n; v++)
+  {
+    expected[v] = INT_MAX;
+  }
+  expected[source] = 0;
+  for (int i = 0; i < numReached - 1; i++)
+  {
+    expected[legacy[i].toVertex] =
+        expected[legacy[i].fromVertex] + legacy[i].weight;
+  }
+  free(legacy);
+
+  int numEdges = getDistanceTreeDijkstraInto(ws, graph, source, tree);
+  if (numEdges != numReached - 1)
+  {
+    reportMismatch(test.name, "Dijkstra tree edges from", source,
+                   numReached - 1, numEdges);
+    return;
+  }
+  for (int v = 0; v < n; v++)
+  {
+    int distance = getWorkspaceDistance(ws, v);
+    int pred = getWorkspacePredecessor(ws, v);
+    Edge* edge = pred < 0 || pred >= n ? NULL : findGraphEdge(graph, pred, v);
+    if (distance != expected[v])
+    {
+      reportMismatch(test.name, "Dijkstra distance", v, expected[v],
+                     distance);
+    }
+    else if (v == source || !reached[v]
+                 ? pred != NOTHING
+                 : edge == NULL || expected[pred] + edge->weight != distance)
+    {
+      reportMismatch(test.name, "Dijkstra predecessor", v, NOTHING, pred);
+    }
+  }
+  for (int i = 0; tree != NULL && i < numEdges; i++)
+  {
+    int to = tree[i].toVertex;
+    if (to < 0 || to >= n ||
+        tree[i].fromVertex != getWorkspacePredecessor(ws, to) ||
+        tree[i].weight != expected[to] - expected[tree[i].fromVertex])
+    {
+      reportMismatch(test.name, "Dijkstra tree edge weight into", to,
+                     -1, tree[i].weight);
+    }
+  }
+}
+
+/*
+ * Runs Prim's algorithm on 'test' from 'source' in 'ws', writing its tree
+ * to 'tree' (which may be NULL), and checks it against getMSTprim.
+ * 'inTree' has room for numVertices entries.
+ */
+void checkPrim(TestGraph test, Workspace* ws, int source, Edge* tree,
+               bool* inTree)
+{
+  Graph* graph = test.graph;
+  int n = graph->numVertices;
+  Edge* legacy = getMSTprim(graph, source);
+  if (legacy == NULL)
+  {
+    printf("Memory allocation failed\n");
+    exit(EXIT_FAILURE);
+  }
+  long long expectedWeight = 0;
+  for (int i = 0; i < n - 1; i++)
+  {
+    expectedWeight += legacy[i].weight;
+  }
+  free(legacy);
+
+  int numEdges = getMSTprimInto(ws, graph, source, tree);
+  if (numEdges != n - 1)
+  {
+    reportMismatch(test.name, "MST edges from", source, n - 1, numEdges);
+    return;
+  }
+  // Each vertex but the source joins the tree by the edge from its
+  // predecessor, of weight its key
+  long long weight = 0;
+  for (int v = 0; v < n; v++)
+  {
+    int key = getWorkspaceDistance(ws, v);
+    int pred = getWorkspacePredecessor(ws, v);
+    Edge* edge = pred < 0 || pred >= n ? NULL : findGraphEdge(graph, pred, v);
+    if (v == source ? key != 0 || pred != NOTHING
+                    : edge == NULL || edge->weight != key)
+    {
+      reportMismatch(test.name, "MST key", v, edge ? edge->weight : 0, key);
+    }
+    weight += v == source ? 0 : key;
+  }
+  if (weight != expectedWeight)
+  {
+    reportMismatch(test.name, "MST weight from", source, (int)expectedWeight,
+                   (int)weight);
+  }
+  memset(inTree, 0, n * sizeof(bool));
+  for (int i = 0; tree != NULL && i < numEdges; i++)
+  {
+    int v = tree[i].fromVertex;
+    if (v < 0 || v >= n || v == source || inTree[v] ||
+        tree[i].toVertex != getWorkspacePredecessor(ws, v) ||
+        tree[i].weight != getWorkspaceDistance(ws, v))
+    {
+      reportMismatch(test.name, "MST edge from", v, -1, tree[i].toVertex);
+      continue;
+    }
+    inTree[v] = true;
+  }
+}
+
+/*
+ * DistanceFn that copies the predecessors of query 'index' into row 'index'
+ * of the PredecessorRows 'context'.
+ */
+void copyPredecessors(int source, int index, int* distances,
+                      int* predecessors, void* context)
+{
+  PredecessorRows* rows = (PredecessorRows*)context;
+  memcpy(rows->rows + (size_t)index * rows->numVertices, predecessors,
+         rows->numVertices * sizeof(int));
+}
+
+/*
+ * Runs a batch of queries from random sources on 'test' with 'pool', and
+ * checks every row against a single run in 'ws'. Then checks that a batch
+ * with an invalid source fails.
+ */
+void checkBatch(TestGraph test, Workspace* ws, ThreadPool* pool)
+{
+  Graph* graph = test.graph;
+  int n = graph->numVertices;
+  int numSources = randomBelow(MAX_SOURCES + 1);
+  int* sources = (int*)malloc((numSources + 1) * sizeof(int));
+  int* distances = (int*)malloc(((size_t)numSources * n + 1) * sizeof(int));
+  PredecessorRows rows = {
+      (int*)malloc(((size_t)numSources * n + 1) * sizeof(int)), n};
+  if (sources == NULL || distances == NULL || rows.rows == NULL)
+  {
+    printf("Memory allocation failed\n");
+    exit(EXIT_FAILURE);
+  }
+  for (int i = 0; i < numSources; i++)
+  {
+    sources[i] = randomBelow(n);
+  }
+
+  if (!getDistancesDijkstraBatch(graph, sources, numSources, distances,
+                                 pool) ||
+      !runDijkstraBatch(graph, sources, numSources, copyPredecessors, &rows,
+                        pool))
+  {
+    reportMismatch(test.name, "batch success, with sources", numSources, 1,
+                   0);
+  }
+  else
+  {
+    for (int i = 0; i < numSources; i++)
+    {
+      getDistanceTreeDijkstraInto(ws, graph, sources[i], NULL);
+      int* distanceRow = distances + (size_t)i * n;
+      int* predecessorRow = rows.rows + (size_t)i * n;
+      for (int v = 0; v < n; v++)
+      {
+        if (distanceRow[v] != getWorkspaceDistance(ws, v))
+        {
+          reportMismatch(test.name, "batch distance", v,
+                         getWorkspaceDistance(ws, v), distanceRow[v]);
+        }
+        if (predecessorRow[v] != getWorkspacePredecessor(ws, v))
+        {
+          reportMismatch(test.name, "batch predecessor", v,
+                         getWorkspacePredecessor(ws, v), predecessorRow[v]);
+        }
+      }
+    }
+  }
+
+  sources[numSources] = randomBelow(2) ? -1 : n;
+  if (getDistancesDijkstraBatch(graph, sources, numSources + 1, distances,
+                                pool))
+  {
+    reportMismatch(test.name, "batch success, with invalid source",
+                   sources[numSources], 0, 1);
+  }
+  free(rows.rows);
+  free(distances);
+  free(sources);
+}
+
+int main(int argc, char* argv[])
+{
+  randomState = argc > 1 ? strtoull(argv[1], NULL, 10) : 1;
+
+  TestGraph tests[NUM_GRAPHS] = {
+      newRandomGraph("one vertex", 1, 0, true),
+      newRandomGraph("two vertices", 2, 0, true),
+      newRandomGraph("small, directed", 10, 15, false),
+      newRandomGraph("undirected", 100, 300, true),
+      newRandomGraph("directed", 1000, 2500, false),
+      newRandomGraph("large, undirected", 5000, 15000, true),
+  };
+  int maxVertices = 0;
+  for (int g = 0; g < NUM_GRAPHS; g++)
+  {
+    if (tests[g].graph->numVertices > maxVertices)
+    {
+      maxVertices = tests[g].graph->numVertices;
+    }
+  }
+  ThreadPool* pool = newThreadPool(POOL_THREADS);
+  Workspace* ws = newWorkspace(maxVertices);
+  Workspace* small = newWorkspace(maxVertices - 1);
+  Edge* tree = (Edge*)malloc(maxVertices * sizeof(Edge));
+  int* expected = (int*)malloc(maxVertices * sizeof(int));
+  bool* reached = (bool*)malloc(maxVertices * sizeof(bool));
+  int* queue = (int*)malloc(maxVertices * sizeof(int));
+  if (pool == NULL || ws == NULL || small == NULL || tree == NULL ||
+      expected == NULL || reached == NULL || queue == NULL)
+  {
+    printf("Memory allocation failed\n");
+    exit(EXIT_FAILURE);
+  }
+#ifndef WORKSPACE_MAX_GENERATION
+  printf("Built without -DWORKSPACE_MAX_GENERATION: the generation counter "
+         "will not wrap around.\n");
+#endif
+
+  for (int q = 1; q <= NUM_QUERIES; q++)
+  {
+    TestGraph test = tests[randomBelow(NUM_GRAPHS)];
+    int source = randomBelow(test.graph->numVertices);
+    Edge* output = randomBelow(4) == 0 ? NULL : tree;
+    if (test.undirected && randomBelow(2) == 0)
+    {
+      checkPrim(test, ws, source, output, reached);
+    }
+    else
+    {
+      checkDijkstra(test, ws, source, output, expected, reached, queue);
+    }
+    if (q % 100 == 0)
+    {
+      printf("%d queries on one Workspace: %d mismatches so far\n", q,
+             numMismatches);
+    }
+  }
+
+  for (int g = 0; g < NUM_GRAPHS; g++)
+  {
+    checkBatch(tests[g], ws, NULL);
+    checkBatch(tests[g], ws, pool);
+    printf("%s: batches: %d mismatches so far\n", tests[g].name,
+           numMismatches);
+  }
+
+  // Invalid arguments
+  for (int g = 0; g < NUM_GRAPHS; g++)
+  {
+    Graph* graph = tests[g].graph;
+    if (getDistanceTreeDijkstraInto(ws, graph, -1, tree) != -1 ||
+        getMSTprimInto(ws, graph, graph->numVertices, tree) != -1)
+    {
+      reportMismatch(tests[g].name, "result for an invalid source", -1, -1,
+                     0);
+    }
+    if (graph->numVertices == maxVertices &&
+        getDistanceTreeDijkstraInto(small, graph, 0, tree) != -1)
+    {
+      reportMismatch(tests[g].name, "result for a too small Workspace", 0,
+                     -1, 0);
+    }
+    deleteGraph(graph);
+  }
+
+  free(queue);
+  free(reached);
+  free(expected);
+  free(tree);
+  deleteWorkspace(small);
+  deleteWorkspace(ws);
+  deleteThreadPool(pool);
+  if (numMismatches > 0)
+  {
+    printf("FAILED: %d mismatches\n", numMismatches);
+    return EXIT_FAILURE;
+  }
+  printf("All Workspace and batch results match the original algorithms.\n");
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,325 @@
+/*
+ *  Benchmarks Prim's algorithm, Dijkstra's algorithm and getShortestPaths
+ *  on synthetic graphs (see graph_generators.h), and prints the median, p99,
+ *  minimum and mean wall time of each as CSV or JSON.
+ *
+ *  Every graph is built from the seed, so two runs with the same options
+ *  time exactly the same work. Each algorithm is run once as a warmup before
+ *  the timed runs.
+ *
+ *  ---------------------------------------------------------------------------
+ *   Compile:
+ *   gcc -Wall -Werror -O2 -pthread graph.c graph_generators.c graph_scc.c \
+ *       minheap.c csr_graph.c compressed_graph.c graph_algos.c threadpool.c \
+ *       graph_bench.c -o graph_bench -lm
+ *
+ *   Run:
+ *   ./graph_bench -n 2000 -d 8 -r 11 -s 1 -f csv > results.csv
+ *
+ *   Add -DPERF_COUNTERS perf_counters.c to the compile line to also print
+ *   hardware counters of the heap and relaxation loops to stderr, and
+ *   -DMINHEAP_STATS to print the heap operation statistics.
+ *
+ *   Options:
+ *   -n vertices   vertices in the Erdos-Renyi, R-MAT and grid graphs
+ *   -d degree     average degree of the Erdos-Renyi and R-MAT graphs
+ *   -c vertices   vertices in the complete graph
+ *   -w weight     largest edge weight
+ *   -r runs       timed runs per algorithm and graph
+ *   -s seed       seed for the graph generators
+ *   -f format     csv or json
+ *   -t trace      write a binary trace of all heap operations to 'trace'
+ *                 (needs -DMINHEAP_TRACE)
+ *  ---------------------------------------------------------------------------
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "graph_algos.h"
+#include "graph_generators.h"
+#include "minheap.h"
+#include "perf_counters.h"
+
+#define NUM_GRAPHS 4
+#define NUM_ALGORITHMS 5
+
+const char* graphNames[NUM_GRAPHS] = {"erdos_renyi", "rmat", "grid",
+                                      "complete"};
+const char* algorithmNames[NUM_ALGORITHMS] = {
+    "prim", "dijkstra", "shortest_paths", "prim_workspace",
+    "dijkstra_workspace"};
+
+/*
+ * What one timed run needs: the graph, a workspace and output array for the
+ * workspace variants, and a distance tree for getShortestPaths.
+ */
+typedef struct bench
+{
+  Graph* graph;
+  Workspace* ws;
+  Edge* tree;
+  Edge* distTree;
+} Bench;
+
+/*
+ * Returns the current time of the monotonic clock in milliseconds.
+ */
+double nowMillis(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1e3 + ts.tv_nsec / 1e6;
+}
+
+/*
+ * Runs algorithm number 'algorithm' once on 'bench', and returns its wall
+ * time in milliseconds, including freeing what it returned.
+ */
+double timeAlgorithm(Bench* bench, int algorithm)
+{
+  Graph* graph = bench->graph;
+  int n = graph->numVertices;
+  double start = nowMillis();
+  switch (algorithm)
+  {
+    case 0:
+      free(getMSTprim(graph, 0));
+      break;
+    case 1:
+      free(getDistanceTreeDijkstra(graph, 0));
+      break;
+    case 2:
+    {
+      EdgeList** paths = getShortestPaths(bench->distTree, n, 0);
+      for (int i = 0; i < n; i++)
+      {
+        // the edges belong to distTree: only free the list nodes
+        while (paths[i] != NULL)
+        {
+          EdgeList* next = paths[i]->next;
+          free(paths[i]);
+          paths[i] = next;
+        }
+      }
+      free(paths);
+      break;
+    }
+    case 3:
+      getMSTprimInto(bench->ws, graph, 0, bench->tree);
+      break;
+    case 4:
+      getDistanceTreeDijkstraInto(bench->ws, graph, 0, bench->tree);
+      break;
+  }
+  return nowMillis() - start;
+}
+
+int compareTimes(const void* a, const void* b)
+{
+  double x = *(const double*)a;
+  double y = *(const double*)b;
+  return (x > y) - (x < y);
+}
+
+/*
+ * Prints one result row in 'format'. 'times' holds 'runs' sorted times.
+ */
+void printResult(const char* format, bool first, const char* graphName,
+                 Graph* graph, uint64_t seed, int algorithm, double* times,
+                 int runs)
+{
+  double mean = 0;
+  for (int i = 0; i < runs; i++)
+    mean += times[i];
+  mean /= runs;
+  double median = runs % 2 ? times[runs / 2]
+                           : (times[runs / 2 - 1] + times[runs / 2]) / 2;
+  double p99 = times[(int)ceil(0.99 * runs) - 1]; // nearest rank
+
+  if (strcmp(format, "json") == 0)
+    printf("%s\n  {\"graph\": \"%s\", \"vertices\": %d, \"edges\": %d, "
+           "\"seed\": %llu, \"algorithm\": \"%s\", \"runs\": %d, "
+           "\"median_ms\": %.4f, \"p99_ms\": %.4f, \"min_ms\": %.4f, "
+           "\"mean_ms\": %.4f}",
+           first ? "" : ",", graphName, graph->numVertices, graph->numEdges,
+           (unsigned long long)seed, algorithmNames[algorithm], runs, median,
+           p99, times[0], mean);
+  else
+    printf("%s,%d,%d,%llu,%s,%d,%.4f,%.4f,%.4f,%.4f\n", graphName,
+           graph->numVertices, graph->numEdges, (unsigned long long)seed,
+           algorithmNames[algorithm], runs, median, p99, times[0], mean);
+}
+
+/*
+ * Returns synthetic graph number 'index', connected so that every
+ * algorithm can run on it from vertex 0.
+ */
+Graph* makeGraph(int index, int numVertices, int degree, int completeVertices,
+                 int maxWeight, uint64_t seed)
+{
+  int64_t numEdges = (int64_t)numVertices * degree / 2;
+  Graph* graph = NULL;
+  switch (index)
+  {
+    case 0:
+      graph = newErdosRenyiGraph(numVertices, numEdges, maxWeight, seed);
+      break;
+    case 1:
+    {
+      int scale = 1;
+      while ((1 << scale) < numVertices)
+        scale++;
+      graph = newRMATGraph(scale, numEdges, maxWeight, seed);
+      break;
+    }
+    case 2:
+    {
+      int side = (int)ceil(sqrt(numVertices));
+      graph = newGridGraph(side, side, maxWeight, seed);
+      break;
+    }
+    case 3:
+      graph = newCompleteGraph(completeVertices, maxWeight, seed);
+      break;
+  }
+  connectComponents(graph, maxWeight, seed + 1);
+  return graph;
+}
+
+int main(int argc, char* argv[])
+{
+  int numVertices = 2000;
+  int degree = 8;
+  int completeVertices = 300;
+  int maxWeight = 100;
+  int runs = 11;
+  uint64_t seed = 1;
+  const char* format = "csv";
+  const char* tracePath = NULL;
+
+  int option;
+  while ((option = getopt(argc, argv, "n:d:c:w:r:s:f:t:")) != -1)
+  {
+    switch (option)
+    {
+      case 'n':
+        numVertices = atoi(optarg);
+        break;
+      case 'd':
+        degree = atoi(optarg);
+        break;
+      case 'c':
+        completeVertices = atoi(optarg);
+        break;
+      case 'w':
+        maxWeight = atoi(optarg);
+        break;
+      case 'r':
+        runs = atoi(optarg);
+        break;
+      case 's':
+        seed = strtoull(optarg, NULL, 10);
+        break;
+      case 'f':
+        format = optarg;
+        break;
+      case 't':
+        tracePath = optarg;
+        break;
+      default:
+        numVertices = 0;
+    }
+  }
+  if (numVertices < 2 || degree < 1 || completeVertices < 2 || maxWeight < 1 ||
+      runs < 1 || optind != argc ||
+      (strcmp(format, "csv") != 0 && strcmp(format, "json") != 0))
+  {
+    printf("Usage: %s [-n vertices] [-d degree] [-c vertices] [-w weight] "
+           "[-r runs] [-s seed] [-f csv|json] [-t trace]\n",
+           argv[0]);
+    return 1;
+  }
+
+  FILE* trace = NULL;
+  if (tracePath != NULL)
+  {
+#ifdef MINHEAP_TRACE
+    trace = fopen(tracePath, "wb");
+    if (trace == NULL)
+    {
+      printf("Unable to open the trace file: %s\n", tracePath);
+      return 1;
+    }
+    traceHeaps(trace);
+#else
+    printf("Tracing needs a build with -DMINHEAP_TRACE\n");
+    return 1;
+#endif
+  }
+
+  double* times = (double*)malloc(runs * sizeof(double));
+  if (times == NULL)
+  {
+    printf("Memory allocation failed\n");
+    return 1;
+  }
+  if (strcmp(format, "json") == 0)
+    printf("[");
+  else
+    printf("graph,vertices,edges,seed,algorithm,runs,median_ms,p99_ms,"
+           "min_ms,mean_ms\n");
+
+  bool first = true;
+  for (int g = 0; g < NUM_GRAPHS; g++)
+  {
+    Bench bench;
+    bench.graph = makeGraph(g, numVertices, degree, completeVertices,
+                            maxWeight, seed + 2 * g);
+    int n = bench.graph->numVertices;
+    bench.ws = newWorkspace(n);
+    bench.tree = (Edge*)malloc(n * sizeof(Edge));
+    bench.distTree = getDistanceTreeDijkstra(bench.graph, 0);
+    if (bench.ws == NULL || bench.tree == NULL || bench.distTree == NULL)
+    {
+      printf("Memory allocation failed\n");
+      return 1;
+    }
+
+    for (int a = 0; a < NUM_ALGORITHMS; a++)
+    {
+      timeAlgorithm(&bench, a); // warmup
+      for (int i = 0; i < runs; i++)
+        times[i] = timeAlgorithm(&bench, a);
+      qsort(times, runs, sizeof(double), compareTimes);
+      printResult(format, first, graphNames[g], bench.graph, seed + 2 * g, a,
+                  times, runs);
+      first = false;
+      fflush(stdout);
+    }
+
+    deleteWorkspace(bench.ws);
+    free(bench.tree);
+    free(bench.distTree);
+    deleteGraph(bench.graph);
+  }
+
+  if (strcmp(format, "json") == 0)
+    printf("\n]\n");
+  PERF_REPORT(stderr);
+#ifdef MINHEAP_STATS
+  HeapStats stats = getAllHeapStats();
+  printHeapStats(&stats, stderr);
+#endif
+#ifdef MINHEAP_TRACE
+  traceHeaps(NULL);
+#endif
+  if (trace != NULL)
+    fclose(trace);
+  free(times);
+  return 0;
+}
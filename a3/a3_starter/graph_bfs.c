@@ -0,0 +1,309 @@
+/*
+ * Parallel direction-optimizing breadth-first search.
+ *
+ * Visited vertices are tracked in an atomic bitmap: in a top-down step,
+ * whichever task sets a vertex's bit first becomes its parent. Each task
+ * collects the vertices it claims in a small local buffer and appends them
+ * to the next frontier queue with one atomic add per flush.
+ *
+ * In a bottom-up step the frontier is a plain bitmap, and tasks own whole
+ * 64-vertex words of the visited and next-frontier bitmaps, so they need no
+ * atomic read-modify-writes at all.
+ */
+
+#include <limits.h>
+#include <stdatomic.h>
+#include <string.h>
+
+#include "graph_algos.h"
+#include "graph_bfs.h"
+
+#define BITS_PER_WORD 64
+#define CLAIM_BUFFER 256      // vertices a top-down task buffers per flush
+#define MIN_FRONTIER_TASK 64  // frontier vertices per top-down task, at least
+#define VERTICES_PER_TASK 4096 // vertices per bottom-up task; a multiple of 64
+
+/*
+ * State shared by the tasks of one BFS.
+ */
+typedef struct bfs
+{
+  CSRGraph *csr;
+  CSRGraph *reverse;
+  int *distances;
+  int *parents;
+  int level;                   // distance of the current frontier
+  _Atomic uint64_t *visited;   // bit v is set iff v has been reached
+  uint64_t *frontierBits;      // bottom-up: bit v is set iff v is in the
+  uint64_t *nextBits;          //   frontier / the next frontier
+  int *frontier;               // top-down: the frontier vertices
+  int frontierSize;
+  int *next;                   // top-down: the next frontier so far
+  atomic_int nextSize;
+  int chunkSize;               // top-down: frontier vertices per task
+  atomic_llong nextEdges;      // edges leaving the next frontier
+} BFS;
+
+/*
+ * Returns the number of edges leaving vertex 'v' of 'csr'.
+ */
+int64_t degreeOf(CSRGraph *csr, int v)
+{
+  return csr->offsets[v + 1] - csr->offsets[v];
+}
+
+/*
+ * Appends the 'count' vertices in 'buffer' to the next frontier of 'bfs'.
+ */
+void flushClaims(BFS *bfs, int *buffer, int count)
+{
+  int at = atomic_fetch_add(&bfs->nextSize, count);
+  memcpy(bfs->next + at, buffer, count * sizeof(int));
+}
+
+/*
+ * Top-down task 'index': claims the unvisited neighbours of one chunk of
+ * the frontier.
+ */
+void expandTopDown(int index, int workerId, void *context)
+{
+  (void)workerId;
+  BFS *bfs = (BFS *)context;
+  CSRGraph *csr = bfs->csr;
+  int buffer[CLAIM_BUFFER];
+  int count = 0;
+  int64_t edges = 0;
+  int start = index * bfs->chunkSize;
+  int end = start + bfs->chunkSize;
+  end = end < bfs->frontierSize ? end : bfs->frontierSize;
+
+  for (int i = start; i < end; i++)
+  {
+    int u = bfs->frontier[i];
+    for (int64_t e = csr->offsets[u]; e < csr->offsets[u + 1]; e++)
+    {
+      int v = csr->targets[e];
+      _Atomic uint64_t *word = &bfs->visited[v / BITS_PER_WORD];
+      uint64_t bit = (uint64_t)1 << (v % BITS_PER_WORD);
+      if ((atomic_load_explicit(word, memory_order_relaxed) & bit) ||
+          (atomic_fetch_or_explicit(word, bit, memory_order_relaxed) & bit))
+      {
+        continue;
+      }
+      bfs->parents[v] = u;
+      bfs->distances[v] = bfs->level + 1;
+      edges += degreeOf(csr, v);
+      buffer[count++] = v;
+      if (count == CLAIM_BUFFER)
+      {
+        flushClaims(bfs, buffer, count);
+        count = 0;
+      }
+    }
+  }
+  flushClaims(bfs, buffer, count);
+  atomic_fetch_add(&bfs->nextEdges, edges);
+}
+
+/*
+ * Bottom-up task 'index': finds a frontier parent for each unvisited
+ * vertex of one block.
+ */
+void expandBottomUp(int index, int workerId, void *context)
+{
+  (void)workerId;
+  BFS *bfs = (BFS *)context;
+  CSRGraph *reverse = bfs->reverse;
+  int start = index * VERTICES_PER_TASK;
+  int end = start + VERTICES_PER_TASK;
+  end = end < reverse->numVertices ? end : reverse->numVertices;
+  int count = 0;
+  int64_t edges = 0;
+
+  for (int v = start; v < end; v++)
+  {
+    int w = v / BITS_PER_WORD;
+    uint64_t bit = (uint64_t)1 << (v % BITS_PER_WORD);
+    if (atomic_load_explicit(&bfs->visited[w], memory_order_relaxed) & bit)
+    {
+      continue;
+    }
+    for (int64_t e = reverse->offsets[v]; e < reverse->offsets[v + 1]; e++)
+    {
+      int u = reverse->targets[e];
+      if (bfs->frontierBits[u / BITS_PER_WORD] &
+          ((uint64_t)1 << (u % BITS_PER_WORD)))
+      {
+        bfs->parents[v] = u;
+        bfs->distances[v] = bfs->level + 1;
+        atomic_fetch_or_explicit(&bfs->visited[w], bit, memory_order_relaxed);
+        bfs->nextBits[w] |= bit;
+        edges += degreeOf(bfs->csr, v);
+        count++;
+        break;
+      }
+    }
+  }
+  atomic_fetch_add(&bfs->nextSize, count);
+  atomic_fetch_add(&bfs->nextEdges, edges);
+}
+
+/*
+ * Runs one top-down step of 'bfs': the frontier queue becomes the queue of
+ * vertices one level further out.
+ */
+void stepTopDown(BFS *bfs, ThreadPool *pool)
+{
+  int numTasks = 8 * poolSize(pool);
+  bfs->chunkSize = (bfs->frontierSize + numTasks - 1) / numTasks;
+  if (bfs->chunkSize < MIN_FRONTIER_TASK)
+  {
+    bfs->chunkSize = MIN_FRONTIER_TASK;
+  }
+  numTasks = (bfs->frontierSize + bfs->chunkSize - 1) / bfs->chunkSize;
+  parallelFor(pool, numTasks, expandTopDown, bfs);
+
+  int *frontier = bfs->frontier;
+  bfs->frontier = bfs->next;
+  bfs->next = frontier;
+  bfs->frontierSize = atomic_load(&bfs->nextSize);
+}
+
+/*
+ * Runs one bottom-up step of 'bfs': the frontier bitmap becomes the bitmap
+ * of vertices one level further out.
+ */
+void stepBottomUp(BFS *bfs, ThreadPool *pool)
+{
+  int numVertices = bfs->csr->numVertices;
+  int numWords = (numVertices + BITS_PER_WORD - 1) / BITS_PER_WORD;
+  memset(bfs->nextBits, 0, numWords * sizeof(uint64_t));
+  int numTasks = (numVertices + VERTICES_PER_TASK - 1) / VERTICES_PER_TASK;
+  parallelFor(pool, numTasks, expandBottomUp, bfs);
+
+  uint64_t *frontierBits = bfs->frontierBits;
+  bfs->frontierBits = bfs->nextBits;
+  bfs->nextBits = frontierBits;
+  bfs->frontierSize = atomic_load(&bfs->nextSize);
+}
+
+/*
+ * Turns the frontier queue of 'bfs' into the frontier bitmap.
+ */
+void queueToBitmap(BFS *bfs)
+{
+  int numWords = (bfs->csr->numVertices + BITS_PER_WORD - 1) / BITS_PER_WORD;
+  memset(bfs->frontierBits, 0, numWords * sizeof(uint64_t));
+  for (int i = 0; i < bfs->frontierSize; i++)
+  {
+    int v = bfs->frontier[i];
+    bfs->frontierBits[v / BITS_PER_WORD] |= (uint64_t)1 << (v % BITS_PER_WORD);
+  }
+}
+
+/*
+ * Turns the frontier bitmap of 'bfs' into the frontier queue.
+ */
+void bitmapToQueue(BFS *bfs)
+{
+  int numWords = (bfs->csr->numVertices + BITS_PER_WORD - 1) / BITS_PER_WORD;
+  int size = 0;
+  for (int w = 0; w < numWords; w++)
+  {
+    for (uint64_t bits = bfs->frontierBits[w]; bits != 0; bits &= bits - 1)
+    {
+      bfs->frontier[size++] = w * BITS_PER_WORD + __builtin_ctzll(bits);
+    }
+  }
+  bfs->frontierSize = size;
+}
+
+bool bfsCSR(CSRGraph *csr, CSRGraph *reverse, int source, int *distances,
+            int *parents, ThreadPool *pool)
+{
+  int n = csr->numVertices;
+  if (source < 0 || source >= n)
+  {
+    return false;
+  }
+  int numWords = (n + BITS_PER_WORD - 1) / BITS_PER_WORD;
+  BFS bfs;
+  bfs.csr = csr;
+  bfs.reverse = reverse;
+  bfs.distances = distances;
+  bfs.parents = parents;
+  bfs.visited =
+      (_Atomic uint64_t *)calloc(numWords, sizeof(_Atomic uint64_t));
+  bfs.frontierBits = (uint64_t *)malloc(numWords * sizeof(uint64_t));
+  bfs.nextBits = (uint64_t *)malloc(numWords * sizeof(uint64_t));
+  bfs.frontier = (int *)malloc(n * sizeof(int));
+  bfs.next = (int *)malloc(n * sizeof(int));
+  bool ok = bfs.visited && bfs.frontierBits && bfs.nextBits && bfs.frontier &&
+            bfs.next;
+
+  if (ok)
+  {
+    for (int v = 0; v < n; v++)
+    {
+      distances[v] = INT_MAX;
+      parents[v] = NOTHING;
+    }
+    distances[source] = 0;
+    atomic_store(&bfs.visited[source / BITS_PER_WORD],
+                 (uint64_t)1 << (source % BITS_PER_WORD));
+    bfs.frontier[0] = source;
+    bfs.frontierSize = 1;
+    bfs.level = 0;
+
+    int64_t frontierEdges = degreeOf(csr, source);
+    int64_t unvisitedEdges = csr->numEdges - frontierEdges;
+    bool topDown = true;
+    while (bfs.frontierSize > 0)
+    {
+      if (topDown && reverse != NULL &&
+          frontierEdges > unvisitedEdges / BFS_ALPHA)
+      {
+        queueToBitmap(&bfs);
+        topDown = false;
+      }
+      else if (!topDown && bfs.frontierSize < n / BFS_BETA)
+      {
+        bitmapToQueue(&bfs);
+        topDown = true;
+      }
+
+      atomic_store(&bfs.nextSize, 0);
+      atomic_store(&bfs.nextEdges, 0);
+      if (topDown)
+      {
+        stepTopDown(&bfs, pool);
+      }
+      else
+      {
+        stepBottomUp(&bfs, pool);
+      }
+      frontierEdges = atomic_load(&bfs.nextEdges);
+      unvisitedEdges -= frontierEdges;
+      bfs.level++;
+    }
+  }
+
+  free(bfs.visited);
+  free(bfs.frontierBits);
+  free(bfs.nextBits);
+  free(bfs.frontier);
+  free(bfs.next);
+  return ok;
+}
+
+bool getHopDistances(Graph *graph, int source, int *distances, int *parents,
+                     ThreadPool *pool)
+{
+  CSRGraph *csr = csrFromGraph(graph);
+  CSRGraph *reverse = csr ? transposeCSRGraph(csr) : NULL;
+  bool ok = reverse != NULL &&
+            bfsCSR(csr, reverse, source, distances, parents, pool);
+  deleteCSRGraph(csr);
+  deleteCSRGraph(reverse);
+  return ok;
+}
@@ -0,0 +1,63 @@
+/*
+ * Header file for our parallel breadth-first search.
+ *
+ * Hop counts need no priority queue: BFS visits vertices level by level.
+ * Each level is expanded in parallel, in one of two directions:
+ *   - top-down: every frontier vertex claims its unvisited neighbours,
+ *   - bottom-up: every unvisited vertex looks for a parent in the frontier,
+ *     and stops at the first one it finds.
+ * Top-down is cheaper while the frontier is small; bottom-up wins once the
+ * frontier's edges outnumber those of the unvisited vertices, since most of
+ * those would only find already-visited neighbours. The search switches
+ * between the two as the frontier grows and shrinks (Beamer et al.).
+ */
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "csr_graph.h"
+#include "graph.h"
+#include "threadpool.h"
+
+#ifndef __Graph_BFS_header
+#define __Graph_BFS_header
+
+/*
+ * Switch to bottom-up once the edges leaving the frontier are more than
+ * 1/BFS_ALPHA of the edges leaving unvisited vertices.
+ */
+#define BFS_ALPHA 14
+
+/*
+ * Switch back to top-down once fewer than 1/BFS_BETA of the vertices are in
+ * the frontier.
+ */
+#define BFS_BETA 24
+
+/*
+ * Runs a BFS on 'csr' from vertex with ID 'source', using the workers of
+ * 'pool' (which may be NULL), and fills in 'distances' and 'parents', which
+ * must have room for numVertices entries each, in the same form as the
+ * records of Dijkstra's algorithm: distances[v] is the number of edges on a
+ * shortest path to v, or INT_MAX if v cannot be reached, and parents[v] is
+ * v's predecessor on such a path, or NOTHING for 'source' and unreachable
+ * vertices. With several shortest paths, which parent is chosen depends on
+ * thread timing.
+ * 'reverse' is the transpose of 'csr' (see transposeCSRGraph), or 'csr'
+ * itself if every edge has a reverse edge. If it is NULL, the search only
+ * runs top-down.
+ * Returns false if 'source' is not valid or memory could not be allocated.
+ */
+bool bfsCSR(CSRGraph* csr, CSRGraph* reverse, int source, int* distances,
+            int* parents, ThreadPool* pool);
+
+/*
+ * Same as bfsCSR, for Graph 'graph', which is first converted to a CSRGraph
+ * and its transpose. To run several searches on one graph, convert it once
+ * and call bfsCSR instead.
+ */
+bool getHopDistances(Graph* graph, int source, int* distances, int* parents,
+                     ThreadPool* pool);
+
+#endif
@@ -0,0 +1,44 @@
+/*
+ *  Converts a graph from the text adjacency-list format (see
+ *  sample_input.txt) to the binary CSR format of csr_graph.h, which
+ *  mapCSRGraph opens without parsing.
+ *
+ *  ---------------------------------------------------------------------------
+ *   Compile:
+ *   gcc -Wall -Werror -pthread graph.c graph_loader.c csr_graph.c threadpool.c \
+ *       graph_convert.c -o graph_convert
+ *
+ *   Run:
+ *   ./graph_convert sample_input.txt sample_input.bin
+ *  ---------------------------------------------------------------------------
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "csr_graph.h"
+#include "graph_loader.h"
+#include "threadpool.h"
+
+int main(int argc, char* argv[])
+{
+  if (argc != 3)
+  {
+    printf("Usage: %s input.txt output.bin\n", argv[0]);
+    return 1;
+  }
+
+  ThreadPool* pool = newThreadPool(sysconf(_SC_NPROCESSORS_ONLN));
+  CSRGraph* csr = loadGraphCSR(argv[1], pool);
+  deleteThreadPool(pool);
+  if (csr == NULL)
+    return 1;
+
+  bool ok = writeCSRGraph(csr, argv[2]);
+  if (ok)
+    printf("Wrote %d vertices and %lld edges to %s\n", csr->numVertices,
+           (long long)csr->numEdges, argv[2]);
+  deleteCSRGraph(csr);
+  return ok ? 0 : 1;
+}
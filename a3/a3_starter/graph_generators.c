@@ -0,0 +1,182 @@
+/*
+ * Synthetic graph generators.
+ *
+ * Randomness comes from splitmix64, which is tiny, fast and has no state
+ * beyond one 64-bit word, so each generator is fully determined by its seed.
+ */
+
+#include "graph_generators.h"
+#include "graph_scc.h"
+
+/*
+ * Returns the next pseudo-random 64-bit value from 'state' (splitmix64).
+ */
+uint64_t nextRandom(uint64_t *state)
+{
+  uint64_t z = (*state += 0x9e3779b97f4a7c15ull);
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+  return z ^ (z >> 31);
+}
+
+/*
+ * Returns a pseudo-random integer in 0, ..., bound-1.
+ * Precondition: bound >= 1
+ */
+int randomBelow(uint64_t *state, int bound)
+{
+  return (int)((nextRandom(state) >> 11) % (uint64_t)bound);
+}
+
+/*
+ * Returns a pseudo-random double in [0, 1).
+ */
+double randomUnit(uint64_t *state)
+{
+  return (nextRandom(state) >> 11) * (1.0 / 9007199254740992.0);
+}
+
+/*
+ * Returns a new Graph with 'numVertices' vertices, all created, and room in
+ * its edge arena for 'numEdges' undirected edges.
+ */
+Graph *newEmptyGraph(int numVertices, int64_t numEdges)
+{
+  Graph *graph = newGraph(numVertices);
+  for (int v = 0; v < numVertices; v++)
+  {
+    graph->vertices[v] = newVertex(v, NULL, NULL);
+  }
+  reserveGraphEdges(graph, (int)(2 * numEdges));
+  return graph;
+}
+
+/*
+ * Adds an undirected edge between 'u' and 'v' with a random weight.
+ */
+void addRandomEdge(Graph *graph, int u, int v, int maxWeight,
+                   uint64_t *state)
+{
+  int weight = 1 + randomBelow(state, maxWeight);
+  insertGraphEdge(graph, u, v, weight);
+  insertGraphEdge(graph, v, u, weight);
+}
+
+Graph *newErdosRenyiGraph(int numVertices, int64_t numEdges, int maxWeight,
+                          uint64_t seed)
+{
+  Graph *graph = newEmptyGraph(numVertices, numEdges);
+  for (int64_t i = 0; i < numEdges; i++)
+  {
+    int u = randomBelow(&seed, numVertices);
+    int v = randomBelow(&seed, numVertices - 1);
+    v += v >= u; // skip u itself
+    addRandomEdge(graph, u, v, maxWeight, &seed);
+  }
+  return graph;
+}
+
+Graph *newRMATGraph(int scale, int64_t numEdges, int maxWeight,
+                    uint64_t seed)
+{
+  int numVertices = 1 << scale;
+  int *label = (int *)malloc(numVertices * sizeof(int));
+  if (!label)
+  {
+    printf("Memory allocation failed\n");
+    exit(EXIT_FAILURE);
+  }
+  for (int v = 0; v < numVertices; v++)
+  {
+    int j = randomBelow(&seed, v + 1); // inside-out Fisher-Yates shuffle
+    label[v] = j < v ? label[j] : v;
+    label[j] = v;
+  }
+
+  Graph *graph = newEmptyGraph(numVertices, numEdges);
+  for (int64_t i = 0; i < numEdges; i++)
+  {
+    int u = 0;
+    int v = 0;
+    for (int bit = 0; bit < scale; bit++)
+    {
+      // quadrants a: [0, .57), b: [.57, .76), c: [.76, .95), d: [.95, 1)
+      double r = randomUnit(&seed);
+      u = 2 * u + (r >= 0.76);                            // c or d
+      v = 2 * v + (r >= 0.57 && r < 0.76) + (r >= 0.95);  // b or d
+    }
+    if (u != v)
+    {
+      addRandomEdge(graph, label[u], label[v], maxWeight, &seed);
+    }
+  }
+  free(label);
+  return graph;
+}
+
+Graph *newGridGraph(int rows, int cols, int maxWeight, uint64_t seed)
+{
+  Graph *graph = newEmptyGraph(rows * cols, 2 * (int64_t)rows * cols);
+  for (int r = 0; r < rows; r++)
+  {
+    for (int c = 0; c < cols; c++)
+    {
+      int v = r * cols + c;
+      if (c + 1 < cols)
+      {
+        addRandomEdge(graph, v, v + 1, maxWeight, &seed);
+      }
+      if (r + 1 < rows)
+      {
+        addRandomEdge(graph, v, v + cols, maxWeight, &seed);
+      }
+    }
+  }
+  return graph;
+}
+
+Graph *newCompleteGraph(int numVertices, int maxWeight, uint64_t seed)
+{
+  Graph *graph =
+      newEmptyGraph(numVertices, (int64_t)numVertices * (numVertices - 1) / 2);
+  for (int u = 0; u < numVertices; u++)
+  {
+    for (int v = u + 1; v < numVertices; v++)
+    {
+      addRandomEdge(graph, u, v, maxWeight, &seed);
+    }
+  }
+  return graph;
+}
+
+int connectComponents(Graph *graph, int maxWeight, uint64_t seed)
+{
+  int n = graph->numVertices;
+  int *component = (int *)malloc((n + 1) * sizeof(int));
+  int numComponents =
+      component ? getStronglyConnectedComponents(graph, component) : -1;
+  // one random member of each component: reservoir sampling
+  int *member = (int *)malloc((numComponents + 1) * sizeof(int));
+  int *seen = (int *)calloc(numComponents + 1, sizeof(int));
+  if (numComponents < 0 || !member || !seen)
+  {
+    printf("Memory allocation failed\n");
+    exit(EXIT_FAILURE);
+  }
+  for (int v = 0; v < n; v++)
+  {
+    int c = component[v];
+    if (randomBelow(&seed, ++seen[c]) == 0)
+    {
+      member[c] = v;
+    }
+  }
+  for (int c = 0; c + 1 < numComponents; c++)
+  {
+    addRandomEdge(graph, member[c], member[c + 1], maxWeight, &seed);
+  }
+  free(component);
+  free(member);
+  free(seen);
+  return numComponents > 1 ? numComponents - 1 : 0;
+}
@@ -0,0 +1,63 @@
+/*
+ * Header file for our synthetic graph generators.
+ *
+ * All generators build undirected graphs, storing each edge in both
+ * directions as in sample_input.txt, with weights drawn uniformly from
+ * 1, ..., maxWeight. They use their own pseudo-random generator, so the
+ * same arguments and seed give the same graph on every machine.
+ * Edges come from the edge arena of the new Graph.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "graph.h"
+
+#ifndef __Graph_Generators_header
+#define __Graph_Generators_header
+
+/*
+ * Returns a G(n, m) Erdos-Renyi graph: 'numEdges' edges between uniformly
+ * random pairs of distinct vertices. Parallel edges are possible.
+ * Precondition: numVertices >= 2
+ */
+Graph* newErdosRenyiGraph(int numVertices, int64_t numEdges, int maxWeight,
+                          uint64_t seed);
+
+/*
+ * Returns an R-MAT (recursive matrix) graph on 2^scale vertices with
+ * 'numEdges' edges, each placed by descending the quadrants of the
+ * adjacency matrix with probabilities 0.57, 0.19, 0.19, 0.05 as in the
+ * Graph500 Kronecker generator. This gives the skewed degrees of social
+ * graphs. Vertex IDs are shuffled so that hubs are not all at low IDs.
+ * Self-loops are dropped, so there may be slightly fewer edges.
+ * Precondition: 1 <= scale <= 30
+ */
+Graph* newRMATGraph(int scale, int64_t numEdges, int maxWeight,
+                    uint64_t seed);
+
+/*
+ * Returns a 'rows' x 'cols' grid graph in which vertex r * cols + c is
+ * joined to its neighbours above, below, left and right: a road-like graph
+ * with long shortest paths.
+ * Precondition: rows >= 1, cols >= 1
+ */
+Graph* newGridGraph(int rows, int cols, int maxWeight, uint64_t seed);
+
+/*
+ * Returns the complete graph on 'numVertices' vertices.
+ * Precondition: numVertices >= 1
+ */
+Graph* newCompleteGraph(int numVertices, int maxWeight, uint64_t seed);
+
+/*
+ * Joins the connected components of the undirected graph 'graph' into one
+ * by adding an edge from a random vertex of each component to a random
+ * vertex of the next one, so that getMSTprim and getShortestPaths can be
+ * run on it. Returns the number of edges added.
+ */
+int connectComponents(Graph* graph, int maxWeight, uint64_t seed);
+
+#endif
@@ -0,0 +1,713 @@
+/*
+ * Our graph loader.
+ *
+ * The input is parsed in two passes over the mapped file: the first counts
+ * the numbers in it so that the edge arena can be reserved in one block,
+ * the second parses each line and fills in the graph.
+ *
+ * The CSR loader instead splits the file into newline-aligned chunks that
+ * are parsed in parallel into per-chunk buffers. The last line of each
+ * vertex then claims it, the per-vertex edge counts are prefix-summed into
+ * CSR offsets, and the chunks copy their edges into place in parallel.
+ */
+
+#include <fcntl.h>
+#include <limits.h>
+#include <stdatomic.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "graph_loader.h"
+#include "perf_counters.h"
+
+/*
+ * Results of readNumber.
+ */
+#define NUMBER_OK 1
+#define NUMBER_NONE 0     // end of line reached before a token
+#define NUMBER_BAD -1     // token is not a number that fits in an int
+
+/*
+ * A position in one line of the text being parsed.
+ */
+typedef struct scanner
+{
+  const char *pos;  // next character to read
+  const char *end;  // end of the line (newline or end of input)
+} Scanner;
+
+/*
+ * Returns 1 if 'c' can be part of a number, 0 otherwise. Branch-free so that
+ * countNumbers vectorizes.
+ */
+static inline int isNumberChar(char c)
+{
+  return ((unsigned char)(c - '0') < 10) | (c == '-');
+}
+
+/*
+ * Returns the number of tokens that start with a digit or '-' in the 'size'
+ * bytes at 'data'. This is an upper bound on the number of integers in it.
+ */
+size_t countNumbers(const char *data, size_t size)
+{
+  if (size == 0)
+  {
+    return 0;
+  }
+  size_t count = isNumberChar(data[0]);
+  for (size_t i = 1; i < size; i++)
+  {
+    count += isNumberChar(data[i]) & !isNumberChar(data[i - 1]);
+  }
+  return count;
+}
+
+/*
+ * Skips spaces, tabs and carriage returns on the line of 'scanner'.
+ * Returns true iff there is another token on the line.
+ */
+bool skipBlanks(Scanner *scanner)
+{
+  const char *p = scanner->pos;
+  while (p < scanner->end && (*p == ' ' || *p == '\t' || *p == '\r'))
+  {
+    p++;
+  }
+  scanner->pos = p;
+  return p < scanner->end;
+}
+
+/*
+ * Reads the next integer on the line of 'scanner' into 'value'.
+ * Returns NUMBER_OK, NUMBER_NONE or NUMBER_BAD.
+ */
+int readNumber(Scanner *scanner, int *value)
+{
+  if (!skipBlanks(scanner))
+  {
+    return NUMBER_NONE;
+  }
+
+  const char *p = scanner->pos;
+  bool negative = false;
+  if (*p == '-')
+  {
+    negative = true;
+    p++;
+  }
+  const char *digits = p;
+  long long number = 0;
+  while (p < scanner->end && (unsigned char)(*p - '0') < 10)
+  {
+    number = number * 10 + (*p - '0');
+    if (number > (long long)INT_MAX + 1)
+    {
+      return NUMBER_BAD;
+    }
+    p++;
+  }
+  if (p == digits ||
+      (p < scanner->end && *p != ' ' && *p != '\t' && *p != '\r'))
+  {
+    return NUMBER_BAD;
+  }
+  number = negative ? -number : number;
+  if (number > INT_MAX || number < INT_MIN)
+  {
+    return NUMBER_BAD;
+  }
+
+  *value = (int)number;
+  scanner->pos = p;
+  return NUMBER_OK;
+}
+
+/*
+ * Why scanVertexID or scanWeight rejected a token.
+ */
+#define PROBLEM_NONE 0
+#define PROBLEM_NO_VERTEX 1
+#define PROBLEM_BAD_VERTEX 2
+#define PROBLEM_NO_WEIGHT 3
+#define PROBLEM_BAD_WEIGHT 4
+#define PROBLEM_NO_MEMORY 5
+
+typedef struct parse_error
+{
+  int problem;  // one of the PROBLEM_* values
+  int value;    // the offending number, if there is one
+} ParseError;
+
+/*
+ * Prints the reason for 'error', the way readVertexID and readWeight in
+ * graph_tester.c used to.
+ */
+void printParseError(ParseError error)
+{
+  switch (error.problem)
+  {
+  case PROBLEM_NO_VERTEX:
+    printf("Could not read vertex ID from input file. Giving up.\n");
+    break;
+  case PROBLEM_BAD_VERTEX:
+    printf("Invalid vertex ID: %d. Giving up.\n", error.value);
+    break;
+  case PROBLEM_NO_WEIGHT:
+    printf("Could not read edge weight from input file. Giving up.\n");
+    break;
+  case PROBLEM_BAD_WEIGHT:
+    printf("Invalid edge weight: %d. Giving up.\n", error.value);
+    break;
+  case PROBLEM_NO_MEMORY:
+    printf("Memory allocation failed\n");
+    break;
+  }
+  printf("Could not get vertex info from a line. Giving up.\n");
+}
+
+/*
+ * Reads and validates a vertex ID for a graph with 'numVertices' vertices.
+ * Returns the ID, or -1 after recording the reason in 'error'.
+ */
+int scanVertexID(Scanner *scanner, int numVertices, ParseError *error)
+{
+  int id = 0;
+  if (readNumber(scanner, &id) != NUMBER_OK)
+  {
+    error->problem = PROBLEM_NO_VERTEX;
+    return -1;
+  }
+  if (id < 0 || id >= numVertices)
+  {
+    error->problem = PROBLEM_BAD_VERTEX;
+    error->value = id;
+    return -1;
+  }
+  return id;
+}
+
+/*
+ * Reads and validates an edge weight. Returns the weight, or -1 after
+ * recording the reason in 'error'.
+ */
+int scanWeight(Scanner *scanner, ParseError *error)
+{
+  int weight = 0;
+  if (readNumber(scanner, &weight) != NUMBER_OK)
+  {
+    error->problem = PROBLEM_NO_WEIGHT;
+    return -1;
+  }
+  if (weight < 0)
+  {
+    error->problem = PROBLEM_BAD_WEIGHT;
+    error->value = weight;
+    return -1;
+  }
+  return weight;
+}
+
+/*
+ * Populates the vertex described by the line of 'scanner' in 'graph'.
+ * Returns true iff the line is valid. Blank lines are skipped.
+ */
+bool scanVertex(Graph *graph, Scanner *scanner, ParseError *error)
+{
+  if (!skipBlanks(scanner))
+  {
+    return true;
+  }
+
+  int id = scanVertexID(scanner, graph->numVertices, error);
+  if (id == -1)
+  {
+    return false;
+  }
+
+  EdgeList *head = NULL;
+  int toVertex = 0;
+  while (skipBlanks(scanner))
+  {
+    toVertex = scanVertexID(scanner, graph->numVertices, error);
+    if (toVertex == -1)
+    {
+      return false;
+    }
+    int weight = scanWeight(scanner, error);
+    if (weight == -1)
+    {
+      return false;
+    }
+    head = newGraphEdgeList(graph, id, toVertex, weight, head);
+    graph->numEdges++;
+  }
+
+  free(graph->vertices[id]); // a repeated line replaces the vertex
+  graph->vertices[id] = newVertex(id, NULL, head);
+  return true;
+}
+
+/*
+ * Reads the number of vertices from the first line of the 'size' bytes at
+ * 'data', and sets 'rest' to the start of the next line (or NULL if there
+ * is none). Returns the number, or -1 after printing the reason.
+ */
+int scanNumVertices(const char *data, size_t size, const char **rest)
+{
+  const char *lineEnd = memchr(data, '\n', size);
+  Scanner scanner = {data, lineEnd ? lineEnd : data + size};
+  *rest = lineEnd ? lineEnd + 1 : NULL;
+
+  int numVertices = 0;
+  if (readNumber(&scanner, &numVertices) != NUMBER_OK)
+  {
+    printf("Could not read number of vertices from input file. Giving up.\n");
+    return -1;
+  }
+  if (numVertices < 0)
+  {
+    printf("Number of vertices must be positive. Read: %d. Giving up.\n",
+           numVertices);
+    return -1;
+  }
+  return numVertices;
+}
+
+Graph *parseGraph(const char *data, size_t size)
+{
+  const char *end = data + size;
+  const char *line = NULL;
+  int numVertices = scanNumVertices(data, size, &line);
+  if (numVertices == -1)
+  {
+    return NULL;
+  }
+
+  Graph *graph = newGraph(numVertices);
+  // every edge takes two numbers, and the first line one
+  size_t maxEdges = (countNumbers(data, size) - 1) / 2;
+  reserveGraphEdges(graph, maxEdges < INT_MAX ? (int)maxEdges : INT_MAX);
+
+  while (line != NULL)
+  {
+    const char *lineEnd = memchr(line, '\n', end - line);
+    Scanner scanner = {line, lineEnd ? lineEnd : end};
+    ParseError error = {PROBLEM_NONE, 0};
+    if (!scanVertex(graph, &scanner, &error))
+    {
+      printParseError(error);
+      deleteGraph(graph);
+      return NULL;
+    }
+    line = lineEnd ? lineEnd + 1 : NULL;
+  }
+  return graph;
+}
+
+/*
+ * Maps the file at 'path' into memory, setting 'size' to its length.
+ * Returns the mapping, "" for an empty file, or NULL after printing why.
+ */
+const char *mapInputFile(const char *path, size_t *size)
+{
+  int fd = open(path, O_RDONLY);
+  if (fd == -1)
+  {
+    fprintf(stderr, "Unable to open the specified input file: %s\n", path);
+    return NULL;
+  }
+  struct stat info;
+  if (fstat(fd, &info) == -1)
+  {
+    fprintf(stderr, "Unable to read the specified input file: %s\n", path);
+    close(fd);
+    return NULL;
+  }
+  *size = info.st_size;
+  if (info.st_size == 0)
+  {
+    close(fd);
+    return "";
+  }
+
+  void *data = mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (data == MAP_FAILED)
+  {
+    fprintf(stderr, "Unable to map the specified input file: %s\n", path);
+    return NULL;
+  }
+  madvise(data, info.st_size, MADV_SEQUENTIAL);
+  return (const char *)data;
+}
+
+/*
+ * Undoes mapInputFile.
+ */
+void unmapInputFile(const char *data, size_t size)
+{
+  if (size > 0)
+  {
+    munmap((void *)data, size);
+  }
+}
+
+Graph *loadGraph(const char *path)
+{
+  size_t size = 0;
+  const char *data = mapInputFile(path, &size);
+  if (data == NULL)
+  {
+    return NULL;
+  }
+  PERF_BEGIN(PERF_LOAD_GRAPH);
+  Graph *graph = parseGraph(data, size);
+  PERF_END(PERF_LOAD_GRAPH);
+  unmapInputFile(data, size);
+  return graph;
+}
+
+/*************************************************************************
+ ** Parallel CSR loader
+ *************************************************************************/
+
+#define MIN_CHUNK_BYTES (1 << 20)
+#define CHUNKS_PER_WORKER 4
+
+/*
+ * One vertex line parsed by parseChunk.
+ */
+typedef struct parsed_line
+{
+  int vertex;         // the vertex this line describes
+  int numEdges;       // number of edges on this line
+  int64_t firstEdge;  // index of its first edge in the chunk's edge buffers
+} ParsedLine;
+
+/*
+ * A newline-aligned part of the input and everything parsed from it.
+ */
+typedef struct chunk
+{
+  const char *start;   // first byte of the chunk
+  const char *end;     // one past its last byte
+  ParsedLine *lines;   // the vertex lines in the chunk, in file order
+  int numLines;
+  int lineCapacity;
+  int *targets;        // "to" vertex of each edge, in file order
+  int *weights;        // weight of each edge
+  int64_t numEdges;
+  int64_t edgeCapacity;
+  int64_t firstLine;   // number of vertex lines in all earlier chunks
+  ParseError error;    // why parsing stopped early, if it did
+} Chunk;
+
+/*
+ * State shared by the tasks of parseGraphCSR.
+ */
+typedef struct csr_load
+{
+  int numVertices;
+  Chunk *chunks;
+  atomic_llong *owner;  // owner[v]: number of the last line describing v
+  int64_t *offsets;     // edge counts, then CSR offsets
+  CSRGraph *csr;
+} CSRLoad;
+
+/*
+ * Grows the buffers of 'chunk' to make room for one more line or edge.
+ * Returns false if memory could not be allocated.
+ */
+bool growChunk(Chunk *chunk, bool line)
+{
+  if (line && chunk->numLines == chunk->lineCapacity)
+  {
+    int capacity = chunk->lineCapacity ? 2 * chunk->lineCapacity : 256;
+    ParsedLine *lines =
+        (ParsedLine *)realloc(chunk->lines, capacity * sizeof(ParsedLine));
+    if (!lines)
+    {
+      return false;
+    }
+    chunk->lines = lines;
+    chunk->lineCapacity = capacity;
+  }
+  if (!line && chunk->numEdges == chunk->edgeCapacity)
+  {
+    int64_t capacity = chunk->edgeCapacity ? 2 * chunk->edgeCapacity : 1024;
+    int *targets = (int *)realloc(chunk->targets, capacity * sizeof(int));
+    if (targets)
+    {
+      chunk->targets = targets;
+    }
+    int *weights = (int *)realloc(chunk->weights, capacity * sizeof(int));
+    if (weights)
+    {
+      chunk->weights = weights;
+    }
+    if (!targets || !weights)
+    {
+      return false;
+    }
+    chunk->edgeCapacity = capacity;
+  }
+  return true;
+}
+
+/*
+ * Task 'index': parses the lines of chunk 'index' into its buffers,
+ * stopping at the first invalid line.
+ */
+void parseChunk(int index, int workerId, void *context)
+{
+  (void)workerId;
+  CSRLoad *load = (CSRLoad *)context;
+  Chunk *chunk = &load->chunks[index];
+  ParseError *error = &chunk->error;
+
+  const char *line = chunk->start;
+  while (line < chunk->end)
+  {
+    const char *lineEnd = memchr(line, '\n', chunk->end - line);
+    Scanner scanner = {line, lineEnd ? lineEnd : chunk->end};
+    line = lineEnd ? lineEnd + 1 : chunk->end;
+    if (!skipBlanks(&scanner))
+    {
+      continue;
+    }
+
+    int id = scanVertexID(&scanner, load->numVertices, error);
+    if (id == -1)
+    {
+      return;
+    }
+    if (!growChunk(chunk, true))
+    {
+      error->problem = PROBLEM_NO_MEMORY;
+      return;
+    }
+    ParsedLine *parsed = &chunk->lines[chunk->numLines++];
+    parsed->vertex = id;
+    parsed->numEdges = 0;
+    parsed->firstEdge = chunk->numEdges;
+
+    while (skipBlanks(&scanner))
+    {
+      int toVertex = scanVertexID(&scanner, load->numVertices, error);
+      if (toVertex == -1)
+      {
+        return;
+      }
+      int weight = scanWeight(&scanner, error);
+      if (weight == -1)
+      {
+        return;
+      }
+      if (!growChunk(chunk, false))
+      {
+        error->problem = PROBLEM_NO_MEMORY;
+        return;
+      }
+      chunk->targets[chunk->numEdges] = toVertex;
+      chunk->weights[chunk->numEdges] = weight;
+      chunk->numEdges++;
+      parsed->numEdges++;
+    }
+  }
+}
+
+/*
+ * Task 'index': records each line of chunk 'index' as the owner of its
+ * vertex unless a later line already is, so that a repeated line replaces
+ * the earlier ones as in parseGraph.
+ */
+void claimVertices(int index, int workerId, void *context)
+{
+  (void)workerId;
+  CSRLoad *load = (CSRLoad *)context;
+  Chunk *chunk = &load->chunks[index];
+  for (int i = 0; i < chunk->numLines; i++)
+  {
+    atomic_llong *owner = &load->owner[chunk->lines[i].vertex];
+    long long lineNumber = chunk->firstLine + i;
+    long long current = atomic_load(owner);
+    while (current < lineNumber &&
+           !atomic_compare_exchange_weak(owner, &current, lineNumber))
+    {
+    }
+  }
+}
+
+/*
+ * Task 'index': stores the edge count of every vertex owned by a line of
+ * chunk 'index'.
+ */
+void countOwnedEdges(int index, int workerId, void *context)
+{
+  (void)workerId;
+  CSRLoad *load = (CSRLoad *)context;
+  Chunk *chunk = &load->chunks[index];
+  for (int i = 0; i < chunk->numLines; i++)
+  {
+    ParsedLine *line = &chunk->lines[i];
+    if (atomic_load(&load->owner[line->vertex]) == chunk->firstLine + i)
+    {
+      load->offsets[line->vertex] = line->numEdges;
+    }
+  }
+}
+
+/*
+ * Task 'index': copies the edges of every line of chunk 'index' that owns
+ * its vertex into the CSR graph, in reverse line order like the adjacency
+ * lists built by parseGraph.
+ */
+void fillOwnedEdges(int index, int workerId, void *context)
+{
+  (void)workerId;
+  CSRLoad *load = (CSRLoad *)context;
+  Chunk *chunk = &load->chunks[index];
+  CSRGraph *csr = load->csr;
+  for (int i = 0; i < chunk->numLines; i++)
+  {
+    ParsedLine *line = &chunk->lines[i];
+    if (atomic_load(&load->owner[line->vertex]) != chunk->firstLine + i)
+    {
+      continue;
+    }
+    int64_t e = csr->offsets[line->vertex];
+    for (int j = line->numEdges - 1; j >= 0; j--, e++)
+    {
+      csr->targets[e] = chunk->targets[line->firstEdge + j];
+      csr->weights[e] = chunk->weights[line->firstEdge + j];
+    }
+  }
+}
+
+/*
+ * Splits the 'size' bytes at 'data' into at most 'numChunks' chunks that
+ * each end just after a newline (or at the end of the input).
+ * Returns the number of chunks.
+ */
+int splitChunks(const char *data, size_t size, Chunk *chunks, int numChunks)
+{
+  const char *end = data + size;
+  const char *start = data;
+  int count = 0;
+  while (start < end)
+  {
+    const char *split = end;
+    if (count < numChunks - 1)
+    {
+      const char *target = data + size / numChunks * (count + 1);
+      target = target > start ? target : start;
+      const char *newline = memchr(target, '\n', end - target);
+      split = newline ? newline + 1 : end;
+    }
+    memset(&chunks[count], 0, sizeof(Chunk));
+    chunks[count].start = start;
+    chunks[count].end = split;
+    count++;
+    start = split;
+  }
+  return count;
+}
+
+CSRGraph *parseGraphCSR(const char *data, size_t size, ThreadPool *pool)
+{
+  const char *rest = NULL;
+  int numVertices = scanNumVertices(data, size, &rest);
+  if (numVertices == -1)
+  {
+    return NULL;
+  }
+  size_t restSize = rest ? (size_t)(data + size - rest) : 0;
+
+  int numChunks = CHUNKS_PER_WORKER * poolSize(pool);
+  if (restSize / MIN_CHUNK_BYTES + 1 < (size_t)numChunks)
+  {
+    numChunks = restSize / MIN_CHUNK_BYTES + 1;
+  }
+  CSRLoad load = {numVertices, NULL, NULL, NULL, NULL};
+  load.chunks = (Chunk *)malloc(numChunks * sizeof(Chunk));
+  load.owner = (atomic_llong *)malloc((numVertices + 1) * sizeof(atomic_llong));
+  load.offsets = (int64_t *)calloc(numVertices + 1, sizeof(int64_t));
+  if (!load.chunks || !load.owner || !load.offsets)
+  {
+    printf("Memory allocation failed\n");
+    free(load.chunks);
+    free(load.owner);
+    free(load.offsets);
+    return NULL;
+  }
+  numChunks = splitChunks(rest ? rest : data + size, restSize, load.chunks,
+                          numChunks);
+
+  parallelFor(pool, numChunks, parseChunk, &load);
+
+  bool ok = true;
+  int64_t numLines = 0;
+  for (int c = 0; c < numChunks && ok; c++)
+  {
+    if (load.chunks[c].error.problem != PROBLEM_NONE)
+    {
+      printParseError(load.chunks[c].error);
+      ok = false;
+    }
+    load.chunks[c].firstLine = numLines;
+    numLines += load.chunks[c].numLines;
+  }
+
+  if (ok)
+  {
+    for (int v = 0; v < numVertices; v++)
+    {
+      atomic_init(&load.owner[v], -1);
+    }
+    parallelFor(pool, numChunks, claimVertices, &load);
+    parallelFor(pool, numChunks, countOwnedEdges, &load);
+    int64_t numEdges = parallelPrefixSum(pool, load.offsets, numVertices);
+    load.offsets[numVertices] = numEdges;
+
+    load.csr = newCSRGraph(numVertices, numEdges);
+    if (load.csr)
+    {
+      memcpy(load.csr->offsets, load.offsets,
+             (numVertices + 1) * sizeof(int64_t));
+      parallelFor(pool, numChunks, fillOwnedEdges, &load);
+    }
+    else
+    {
+      printf("Memory allocation failed\n");
+    }
+  }
+
+  for (int c = 0; c < numChunks; c++)
+  {
+    free(load.chunks[c].lines);
+    free(load.chunks[c].targets);
+    free(load.chunks[c].weights);
+  }
+  free(load.chunks);
+  free(load.owner);
+  free(load.offsets);
+  return load.csr;
+}
+
+CSRGraph *loadGraphCSR(const char *path, ThreadPool *pool)
+{
+  size_t size = 0;
+  const char *data = mapInputFile(path, &size);
+  if (data == NULL)
+  {
+    return NULL;
+  }
+  PERF_BEGIN(PERF_LOAD_GRAPH);
+  CSRGraph *csr = parseGraphCSR(data, size, pool);
+  PERF_END(PERF_LOAD_GRAPH);
+  unmapInputFile(data, size);
+  return csr;
+}
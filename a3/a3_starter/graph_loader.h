@@ -0,0 +1,50 @@
+/*
+ * Header file for our graph loader.
+ *
+ * Reads graphs in the adjacency-list text format of sample_input.txt:
+ *   numVertices
+ *   id toVertex_1 weight_1 toVertex_2 weight_2 ...
+ *   ...
+ * with one line per vertex. Edges are allocated from the edge arena of the
+ * new Graph, and each adjacency list lists its edges in reverse file order.
+ */
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "csr_graph.h"
+#include "graph.h"
+#include "threadpool.h"
+
+#ifndef __Graph_Loader_header
+#define __Graph_Loader_header
+
+/*
+ * Creates and returns a new Graph from the file at 'path', which is mapped
+ * into memory rather than read line by line, so lines may be of any length.
+ * Returns NULL, after printing the reason, if the file cannot be read or is
+ * not a valid graph: a vertex ID outside 0, ..., numVertices-1, a negative
+ * weight, or a missing or non-numeric token.
+ */
+Graph* loadGraph(const char* path);
+
+/*
+ * Same as loadGraph, but parses the 'size' bytes at 'data'.
+ */
+Graph* parseGraph(const char* data, size_t size);
+
+/*
+ * Same as loadGraph, but builds a CSRGraph and parses newline-aligned parts
+ * of the file in parallel on the workers of 'pool' (which may be NULL).
+ * Accepts and rejects the same files as loadGraph, and gives each vertex
+ * its edges in the same order as the adjacency lists built by loadGraph.
+ */
+CSRGraph* loadGraphCSR(const char* path, ThreadPool* pool);
+
+/*
+ * Same as loadGraphCSR, but parses the 'size' bytes at 'data'.
+ */
+CSRGraph* parseGraphCSR(const char* data, size_t size, ThreadPool* pool);
+
+#endif
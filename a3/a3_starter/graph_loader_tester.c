@@ -0,0 +1,430 @@
+/*
+ *  Randomized testing of our graph loader (see graph_loader.h).
+ *
+ *  Generates graph files of up to several MiB, large enough that
+ *  parseGraphCSR splits them into several chunks and claims vertices
+ *  across chunks, with CRLF line ends, tabs and runs of blanks, blank
+ *  lines, repeated vertex lines and a missing final newline. The CSRGraph
+ *  from parseGraphCSR, with and without a pool of workers, must equal
+ *  csrFromGraph of the Graph from parseGraph. Malformed tokens placed
+ *  anywhere in the file must make both loaders fail (each prints why).
+ *  Prints the first mismatches found and exits with a non-zero status if
+ *  there were any.
+ *
+ *  ---------------------------------------------------------------------------
+ *   Compile:
+ *   gcc -Wall -Werror -pthread graph.c graph_loader.c csr_graph.c \
+ *       threadpool.c graph_loader_tester.c -o graph_loader_tester
+ *
+ *   Run:
+ *   ./graph_loader_tester [seed]
+ *  ---------------------------------------------------------------------------
+ */
+
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "csr_graph.h"
+#include "graph.h"
+#include "graph_loader.h"
+#include "threadpool.h"
+
+#define POOL_THREADS 4
+#define MAX_WEIGHT 1000000
+#define MAX_REPORTED 10  // mismatches printed before only counting them
+
+uint64_t randomState;
+int numMismatches;
+
+/*
+ * Returns a pseudo-random number in 0, 1, ..., bound-1 (splitmix64).
+ */
+int randomBelow(int bound)
+{
+  uint64_t z = (randomState += 0x9e3779b97f4a7c15ULL);
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+  z ^= z >> 31;
+  return (int)((z >> 33) % (uint64_t)bound);
+}
+
+/*
+ * Prints a mismatch found in input 'input', and counts it.
+ */
+void reportMismatch(const char* input, const char* what, long long where,
+                    long long expected, long long actual)
+{
+  if (++numMismatches <= MAX_REPORTED)
+  {
+    printf("%s: %s %lld is %lld, expected %lld\n", input, what, where, actual,
+           expected);
+  }
+}
+
+/*
+ * A growing text buffer.
+ */
+typedef struct text
+{
+  char* data;
+  size_t size;
+  size_t capacity;
+} Text;
+
+/*
+ * Appends printf-style output to 'text'.
+ */
+void appendText(Text* text, const char* format, ...)
+{
+  va_list args;
+  va_start(args, format);
+  int length = vsnprintf(NULL, 0, format, args);
+  va_end(args);
+  if (text->size + length + 1 > text->capacity)
+  {
+    size_t capacity = text->capacity ? 2 * text->capacity : 4096;
+    while (text->size + length + 1 > capacity)
+    {
+      capacity *= 2;
+    }
+    text->data = (char*)realloc(text->data, capacity);
+    if (text->data == NULL)
+    {
+      printf("Memory allocation failed\n");
+      exit(EXIT_FAILURE);
+    }
+    text->capacity = capacity;
+  }
+  va_start(args, format);
+  vsnprintf(text->data + text->size, length + 1, format, args);
+  va_end(args);
+  text->size += length;
+}
+
+/*
+ * How a generated file is written.
+ */
+typedef struct style
+{
+  bool crlf;          // lines end with "\r\n" rather than "\n"
+  bool messyBlanks;   // tokens are separated by tabs and runs of blanks
+  bool blankLines;    // some lines are empty or only blanks
+  bool repeats;       // some vertices have more than one line
+  bool finalNewline;  // the last line ends with a line end
+} Style;
+
+/*
+ * Returns a separator between tokens in 'style'.
+ */
+const char* separator(Style style)
+{
+  const char* separators[] = {" ", "\t", "  ", " \t ", "   "};
+  return style.messyBlanks ? separators[randomBelow(5)] : " ";
+}
+
+/*
+ * Appends a graph file with 'numVertices' vertices in 'style', with about
+ * 'targetBytes' bytes and up to 'maxDegree' edges per line, to 'text'.
+ * Vertices are written in order, each one skipped now and then; with
+ * repeats, random vertices are written again after them.
+ */
+void writeGraphText(Text* text, int numVertices, size_t targetBytes,
+                    int maxDegree, Style style)
+{
+  const char* lineEnd = style.crlf ? "\r\n" : "\n";
+  appendText(text, "%d%s", numVertices, lineEnd);
+  for (int line = 0; text->size < targetBytes || line < numVertices; line++)
+  {
+    if (style.blankLines && randomBelow(20) == 0)
+    {
+      appendText(text, "%s%s", randomBelow(2) ? "" : " \t", lineEnd);
+    }
+    int v = line;
+    if (line >= numVertices)
+    {
+      if (!style.repeats)
+      {
+        break;
+      }
+      v = randomBelow(numVertices);
+    }
+    else if (randomBelow(50) == 0)
+    {
+      continue;  // a vertex with no line has no edges
+    }
+    bool indent = style.messyBlanks && randomBelow(4) == 0;
+    appendText(text, "%s%d", indent ? "\t" : "", v);
+    int degree = randomBelow(maxDegree + 1);
+    for (int i = 0; i < degree; i++)
+    {
+      appendText(text, "%s%d", separator(style), randomBelow(numVertices));
+      appendText(text, "%s%d", separator(style), randomBelow(MAX_WEIGHT));
+    }
+    if (style.messyBlanks && randomBelow(4) == 0)
+    {
+      appendText(text, "%s", separator(style));
+    }
+    appendText(text, "%s", lineEnd);
+  }
+  if (!style.finalNewline)
+  {
+    text->size -= strlen(lineEnd);
+  }
+}
+
+/*
+ * Checks that 'actual' has the same vertices and edges, in the same order,
+ * as 'expected'.
+ */
+void checkSameCSR(const char* input, CSRGraph* expected, CSRGraph* actual)
+{
+  if (actual->numVertices != expected->numVertices ||
+      actual->numEdges != expected->numEdges)
+  {
+    reportMismatch(input, "edge count of a graph with vertices",
+                   actual->numVertices, expected->numEdges, actual->numEdges);
+    return;
+  }
+  for (int v = 0; v <= expected->numVertices; v++)
+  {
+    if (actual->offsets[v] != expected->offsets[v])
+    {
+      reportMismatch(input, "offset of vertex", v, expected->offsets[v],
+                     actual->offsets[v]);
+      return;
+    }
+  }
+  for (int64_t e = 0; e < expected->numEdges; e++)
+  {
+    if (actual->targets[e] != expected->targets[e] ||
+        actual->weights[e] != expected->weights[e])
+    {
+      reportMismatch(input, "target of edge", e, expected->targets[e],
+                     actual->targets[e]);
+      return;
+    }
+  }
+}
+
+/*
+ * Parses the 'size' bytes at 'data' with parseGraph, and checks that
+ * parseGraphCSR with pool NULL and with 'pool' gives the same graph, or
+ * fails like it.
+ */
+void checkParsers(const char* input, const char* data, size_t size,
+                  ThreadPool* pool)
+{
+  Graph* graph = parseGraph(data, size);
+  CSRGraph* expected = graph ? csrFromGraph(graph) : NULL;
+  if (graph && !expected)
+  {
+    printf("Memory allocation failed\n");
+    exit(EXIT_FAILURE);
+  }
+  ThreadPool* pools[] = {NULL, pool};
+  for (int p = 0; p < 2; p++)
+  {
+    CSRGraph* csr = parseGraphCSR(data, size, pools[p]);
+    if ((csr == NULL) != (expected == NULL))
+    {
+      reportMismatch(input, "success with pool size", poolSize(pools[p]),
+                     expected != NULL, csr != NULL);
+    }
+    else if (csr)
+    {
+      checkSameCSR(input, expected, csr);
+    }
+    deleteCSRGraph(csr);
+  }
+  deleteCSRGraph(expected);
+  deleteGraph(graph);
+}
+
+/*
+ * Generates a file of about 'targetBytes' bytes in 'style' and checks the
+ * parsers on it, and through loadGraph and loadGraphCSR on a copy on disk.
+ */
+void testFile(const char* input, int numVertices, size_t targetBytes,
+              int maxDegree, Style style, ThreadPool* pool)
+{
+  Text text = {NULL, 0, 0};
+  writeGraphText(&text, numVertices, targetBytes, maxDegree, style);
+  checkParsers(input, text.data, text.size, pool);
+
+  char path[] = "/tmp/graph_loader_tester_XXXXXX";
+  int fd = mkstemp(path);
+  FILE* file = fd >= 0 ? fdopen(fd, "wb") : NULL;
+  if (file == NULL || fwrite(text.data, 1, text.size, file) != text.size ||
+      fclose(file) != 0)
+  {
+    printf("Could not write %s\n", path);
+    exit(EXIT_FAILURE);
+  }
+  Graph* graph = loadGraph(path);
+  CSRGraph* expected = graph ? csrFromGraph(graph) : NULL;
+  CSRGraph* csr = loadGraphCSR(path, pool);
+  if (expected == NULL || csr == NULL)
+  {
+    reportMismatch(input, "success of loading from", 0, true, false);
+  }
+  else
+  {
+    checkSameCSR(input, expected, csr);
+  }
+  unlink(path);
+
+  printf("%s: %zu bytes, %d vertices, %lld edges: %d mismatches so far\n",
+         input, text.size, numVertices,
+         expected ? (long long)expected->numEdges : -1LL, numMismatches);
+  deleteCSRGraph(csr);
+  deleteCSRGraph(expected);
+  deleteGraph(graph);
+  free(text.data);
+}
+
+/*
+ * Where testMalformed puts its token on a line.
+ */
+#define PLACE_VERTEX 0  // instead of the vertex ID
+#define PLACE_ANY 1     // instead of a random token
+#define PLACE_END 2     // after the last token
+
+/*
+ * Returns the start of the first line at or after 'pos' in 'text' that has
+ * a token, wrapping around to the second line of the file.
+ */
+size_t findVertexLine(Text* text, size_t pos)
+{
+  size_t secondLine = strchr(text->data, '\n') - text->data + 1;
+  while (pos > 0 && pos < text->size && text->data[pos - 1] != '\n')
+  {
+    pos++;
+  }
+  while (true)
+  {
+    if (pos >= text->size)
+    {
+      pos = secondLine;
+    }
+    size_t first = pos + strspn(text->data + pos, " \t");
+    if (first < text->size && strchr("\r\n", text->data[first]) == NULL)
+    {
+      return pos;
+    }
+    const char* next = memchr(text->data + pos, '\n', text->size - pos);
+    pos = next ? next - text->data + 1 : text->size;
+  }
+}
+
+/*
+ * Generates a file of about 'targetBytes' bytes in 'style', puts 'token' at
+ * 'place' on a random vertex line, and checks that both parsers reject it.
+ */
+void testMalformed(const char* input, const char* token, int place,
+                   size_t targetBytes, Style style, ThreadPool* pool)
+{
+  Text text = {NULL, 0, 0};
+  style.repeats = true;  // to reach 'targetBytes' with 1000 vertices
+  writeGraphText(&text, 1000, targetBytes, 20, style);
+  text.data[text.size] = '\0';  // appendText leaves room for it
+
+  size_t line = findVertexLine(&text, randomBelow((int)text.size));
+  size_t lineEnd = line + strcspn(text.data + line, "\r\n");
+  size_t tokenStart = line + strspn(text.data + line, " \t");
+  if (place == PLACE_ANY)
+  {
+    // Move on by a random number of tokens, staying on the line
+    for (int skip = randomBelow(8); skip > 0; skip--)
+    {
+      size_t next = tokenStart + strcspn(text.data + tokenStart, " \t\r\n");
+      next += strspn(text.data + next, " \t");
+      if (next >= lineEnd)
+      {
+        break;
+      }
+      tokenStart = next;
+    }
+  }
+  size_t tokenEnd = tokenStart + strcspn(text.data + tokenStart, " \t\r\n");
+  if (place == PLACE_END)
+  {
+    tokenStart = tokenEnd = lineEnd;
+  }
+
+  Text broken = {NULL, 0, 0};
+  appendText(&broken, "%.*s%s%s%.*s", (int)tokenStart, text.data,
+             place == PLACE_END ? " " : "", token,
+             (int)(text.size - tokenEnd), text.data + tokenEnd);
+
+  Graph* graph = parseGraph(broken.data, broken.size);
+  if (graph)
+  {
+    reportMismatch(input, "parseGraph success at byte", tokenStart, false,
+                   true);
+  }
+  ThreadPool* pools[] = {NULL, pool};
+  for (int p = 0; p < 2; p++)
+  {
+    CSRGraph* csr = parseGraphCSR(broken.data, broken.size, pools[p]);
+    if (csr)
+    {
+      reportMismatch(input, "parseGraphCSR success at byte", tokenStart, false,
+                     true);
+    }
+    deleteCSRGraph(csr);
+  }
+  printf("%s at byte %zu of %zu: %d mismatches so far\n", input, tokenStart,
+         broken.size, numMismatches);
+  deleteGraph(graph);
+  free(broken.data);
+  free(text.data);
+}
+
+int main(int argc, char* argv[])
+{
+  randomState = argc > 1 ? strtoull(argv[1], NULL, 10) : 1;
+  ThreadPool* pool = newThreadPool(POOL_THREADS);
+  if (pool == NULL)
+  {
+    printf("Memory allocation failed\n");
+    exit(EXIT_FAILURE);
+  }
+  Style plain = {false, false, false, false, true};
+  Style messy = {true, true, true, true, false};
+  Style crlf = {true, false, false, false, true};
+  Style repeats = {false, false, true, true, true};
+  const size_t MiB = 1 << 20;
+
+  testFile("small", 10, 0, 3, plain, pool);
+  testFile("no final newline", 300, 0, 5, (Style){false, false, false, false,
+                                                  false}, pool);
+  testFile("plain", 50000, 3 * MiB, 10, plain, pool);
+  testFile("CRLF", 50000, 3 * MiB, 10, crlf, pool);
+  testFile("repeated lines", 20000, 5 * MiB, 10, repeats, pool);
+  testFile("messy", 100000, 6 * MiB, 8, messy, pool);
+  testFile("long lines", 100, 4 * MiB, 20000, messy, pool);
+
+  // Each loader prints why it rejects these
+  testMalformed("vertex ID too large", "1000", PLACE_VERTEX, 3 * MiB, messy,
+                pool);
+  testMalformed("negative number", "-3", PLACE_ANY, 3 * MiB, plain, pool);
+  testMalformed("negative weight", "0 -7", PLACE_END, 3 * MiB, crlf, pool);
+  testMalformed("missing weight", "5", PLACE_END, 3 * MiB, messy, pool);
+  testMalformed("letter", "x", PLACE_ANY, 3 * MiB, repeats, pool);
+  testMalformed("digits then a letter", "12a", PLACE_ANY, 3 * MiB, plain,
+                pool);
+  testMalformed("overflow", "99999999999", PLACE_ANY, 3 * MiB, crlf, pool);
+
+  deleteThreadPool(pool);
+  if (numMismatches > 0)
+  {
+    printf("FAILED: %d mismatches\n", numMismatches);
+    return EXIT_FAILURE;
+  }
+  printf("All parseGraphCSR results match parseGraph.\n");
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,244 @@
+/*
+ * Vertex reordering.
+ *
+ * All orders are computed on the out-degrees and adjacency lists of the
+ * graph. BFS and reverse Cuthill-McKee visit each connected part in turn
+ * with the same queue; Cuthill-McKee starts each part at its vertex of
+ * lowest degree and queues neighbours by increasing degree, and the final
+ * order is reversed.
+ */
+
+#include <stdint.h>
+#include <string.h>
+
+#include "graph_algos.h"
+#include "graph_reorder.h"
+
+/*
+ * Returns the number of edges in the adjacency list of vertex 'id'.
+ */
+int outDegree(Graph *graph, int id)
+{
+  int degree = 0;
+  if (graph->vertices[id] != NULL)
+  {
+    for (EdgeList *adj = graph->vertices[id]->adjList; adj; adj = adj->next)
+    {
+      degree++;
+    }
+  }
+  return degree;
+}
+
+/*
+ * qsort comparator for int64_t keys.
+ */
+int compareKeys(const void *a, const void *b)
+{
+  int64_t x = *(const int64_t *)a;
+  int64_t y = *(const int64_t *)b;
+  return (x > y) - (x < y);
+}
+
+/*
+ * Sorts 'ids' by increasing 'degrees', breaking ties by ID, using 'keys' as
+ * scratch space for 'count' entries.
+ */
+void sortByDegree(int *ids, int count, const int *degrees, int64_t *keys)
+{
+  for (int i = 0; i < count; i++)
+  {
+    keys[i] = (int64_t)degrees[ids[i]] * ((int64_t)1 << 32) + ids[i];
+  }
+  qsort(keys, count, sizeof(int64_t), compareKeys);
+  for (int i = 0; i < count; i++)
+  {
+    ids[i] = (int)(keys[i] & 0xffffffff);
+  }
+}
+
+/*
+ * Lists the vertices of 'graph' in 'order' breadth first, starting a new
+ * search from each vertex of 'starts' not yet visited. If 'degrees' is not
+ * NULL, the new neighbours of each vertex are queued by increasing degree.
+ */
+void breadthFirstOrder(Graph *graph, const int *starts, const int *degrees,
+                       int *order, bool *visited, int64_t *keys)
+{
+  int tail = 0;
+  for (int s = 0; s < graph->numVertices; s++)
+  {
+    if (visited[starts[s]])
+    {
+      continue;
+    }
+    visited[starts[s]] = true;
+    order[tail++] = starts[s];
+    for (int head = tail - 1; head < tail; head++)
+    {
+      Vertex *vertex = graph->vertices[order[head]];
+      int firstNew = tail;
+      for (EdgeList *adj = vertex ? vertex->adjList : NULL; adj;
+           adj = adj->next)
+      {
+        int v = adj->edge->toVertex;
+        if (!visited[v])
+        {
+          visited[v] = true;
+          order[tail++] = v;
+        }
+      }
+      if (degrees != NULL)
+      {
+        sortByDegree(order + firstNew, tail - firstNew, degrees, keys);
+      }
+    }
+  }
+}
+
+Permutation *getVertexOrder(Graph *graph, int order)
+{
+  if (order != ORDER_BFS && order != ORDER_RCM && order != ORDER_DEGREE)
+  {
+    return NULL;
+  }
+  int n = graph->numVertices;
+  Permutation *perm = (Permutation *)malloc(sizeof(Permutation));
+  int *degrees = (int *)malloc((n + 1) * sizeof(int));
+  int *starts = (int *)malloc((n + 1) * sizeof(int));
+  bool *visited = (bool *)calloc(n + 1, sizeof(bool));
+  int64_t *keys = (int64_t *)malloc((n + 1) * sizeof(int64_t));
+  if (perm)
+  {
+    perm->numVertices = n;
+    perm->newToOld = (int *)malloc((n + 1) * sizeof(int));
+    perm->oldToNew = (int *)malloc((n + 1) * sizeof(int));
+  }
+  if (!perm || !perm->newToOld || !perm->oldToNew || !degrees || !starts ||
+      !visited || !keys)
+  {
+    deletePermutation(perm);
+    perm = NULL;
+  }
+  else
+  {
+    for (int v = 0; v < n; v++)
+    {
+      degrees[v] = order == ORDER_DEGREE ? -outDegree(graph, v)
+                                         : outDegree(graph, v);
+      starts[v] = v;
+    }
+    if (order == ORDER_BFS)
+    {
+      breadthFirstOrder(graph, starts, NULL, perm->newToOld, visited, keys);
+    }
+    else
+    {
+      sortByDegree(starts, n, degrees, keys);
+    }
+    if (order == ORDER_DEGREE)
+    {
+      memcpy(perm->newToOld, starts, n * sizeof(int));
+    }
+    else if (order == ORDER_RCM)
+    {
+      breadthFirstOrder(graph, starts, degrees, perm->newToOld, visited, keys);
+      for (int i = 0, j = n - 1; i < j; i++, j--)
+      {
+        int id = perm->newToOld[i];
+        perm->newToOld[i] = perm->newToOld[j];
+        perm->newToOld[j] = id;
+      }
+    }
+    for (int i = 0; i < n; i++)
+    {
+      perm->oldToNew[perm->newToOld[i]] = i;
+    }
+  }
+
+  free(degrees);
+  free(starts);
+  free(visited);
+  free(keys);
+  return perm;
+}
+
+Graph *reorderGraph(Graph *graph, Permutation *perm)
+{
+  Graph *reordered = newGraph(graph->numVertices);
+  reserveGraphEdges(reordered, graph->numEdges);
+  for (int v = 0; v < graph->numVertices; v++)
+  {
+    Vertex *vertex = graph->vertices[perm->newToOld[v]];
+    if (vertex == NULL)
+    {
+      continue;
+    }
+    reordered->vertices[v] = newVertex(v, vertex->value, NULL);
+    EdgeList **tail = &reordered->vertices[v]->adjList;
+    for (EdgeList *adj = vertex->adjList; adj; adj = adj->next)
+    {
+      *tail = newGraphEdgeList(reordered, v,
+                               perm->oldToNew[adj->edge->toVertex],
+                               adj->edge->weight, NULL);
+      tail = &(*tail)->next;
+    }
+  }
+  reordered->numEdges = graph->numEdges;
+  return reordered;
+}
+
+CSRGraph *reorderCSRGraph(CSRGraph *csr, Permutation *perm)
+{
+  CSRGraph *reordered = newCSRGraph(csr->numVertices, csr->numEdges);
+  if (!reordered)
+  {
+    return NULL;
+  }
+  int64_t e = 0;
+  for (int v = 0; v < csr->numVertices; v++)
+  {
+    int old = perm->newToOld[v];
+    reordered->offsets[v] = e;
+    for (int64_t i = csr->offsets[old]; i < csr->offsets[old + 1]; i++, e++)
+    {
+      reordered->targets[e] = perm->oldToNew[csr->targets[i]];
+      reordered->weights[e] = csr->weights[i];
+    }
+  }
+  reordered->offsets[csr->numVertices] = e;
+  return reordered;
+}
+
+void restoreEdgeIDs(Permutation *perm, Edge *edges, int numEdges)
+{
+  for (int i = 0; i < numEdges; i++)
+  {
+    edges[i].fromVertex = perm->newToOld[edges[i].fromVertex];
+    edges[i].toVertex = perm->newToOld[edges[i].toVertex];
+  }
+}
+
+void restoreVertexArray(Permutation *perm, const int *byNewId, int *byOldId,
+                        bool valuesAreIDs)
+{
+  for (int v = 0; v < perm->numVertices; v++)
+  {
+    int value = byNewId[v];
+    if (valuesAreIDs && value != NOTHING)
+    {
+      value = perm->newToOld[value];
+    }
+    byOldId[perm->newToOld[v]] = value;
+  }
+}
+
+void deletePermutation(Permutation *perm)
+{
+  if (perm)
+  {
+    free(perm->newToOld);
+    free(perm->oldToNew);
+    free(perm);
+  }
+}
@@ -0,0 +1,82 @@
+/*
+ * Header file for our vertex reordering.
+ *
+ * The IDs in an input file rarely say anything about which vertices are
+ * used together, so the per-vertex arrays of Prim's and Dijkstra's
+ * algorithms (distances, finished flags, the heap's indexMap) are accessed
+ * all over the place. Relabelling the vertices so that neighbours get
+ * nearby IDs keeps more of those accesses in cache.
+ *
+ * Algorithms run on the relabelled graph; a Permutation translates their
+ * results back to the original IDs.
+ */
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "csr_graph.h"
+#include "graph.h"
+
+#ifndef __Graph_Reorder_header
+#define __Graph_Reorder_header
+
+/*
+ * Vertex orders for getVertexOrder.
+ */
+#define ORDER_BFS 0     // breadth-first from the lowest unvisited ID
+#define ORDER_RCM 1     // reverse Cuthill-McKee: minimizes bandwidth
+#define ORDER_DEGREE 2  // highest out-degree first
+
+typedef struct permutation
+{
+  int numVertices;
+  int* newToOld;  // newToOld[newId] is the original ID of vertex newId
+  int* oldToNew;  // oldToNew[oldId] is the new ID of vertex oldId
+} Permutation;
+
+/*
+ * Returns a newly created Permutation listing the vertices of 'graph' in
+ * the order 'order', one of the ORDER_* values. BFS and RCM number each
+ * connected part of the graph before the next, following edges in their
+ * stored direction. Returns NULL if 'order' is not valid or memory could
+ * not be allocated.
+ */
+Permutation* getVertexOrder(Graph* graph, int order);
+
+/*
+ * Returns a newly created Graph isomorphic to 'graph' in which vertex v of
+ * 'graph' has ID perm->oldToNew[v]. Adjacency lists keep their order, and
+ * vertex values are shared with 'graph'. Edges come from the edge arena of
+ * the new graph.
+ * Precondition: 'perm' was made for 'graph'
+ */
+Graph* reorderGraph(Graph* graph, Permutation* perm);
+
+/*
+ * Same as reorderGraph, for CSRGraph 'csr'. Returns NULL if memory could
+ * not be allocated.
+ */
+CSRGraph* reorderCSRGraph(CSRGraph* csr, Permutation* perm);
+
+/*
+ * Renames the endpoints of the 'numEdges' edges in 'edges', such as an MST
+ * or distance tree of a reordered graph, back to their original IDs.
+ */
+void restoreEdgeIDs(Permutation* perm, Edge* edges, int numEdges);
+
+/*
+ * Copies 'byNewId', an array indexed by new vertex ID such as the
+ * distances of a reordered graph, to 'byOldId' indexed by original ID.
+ * If 'valuesAreIDs' is true, the values themselves are vertex IDs, such as
+ * predecessors, and are translated too; NOTHING is left as it is.
+ */
+void restoreVertexArray(Permutation* perm, const int* byNewId, int* byOldId,
+                        bool valuesAreIDs);
+
+/*
+ * Frees all memory allocated for 'perm'.
+ */
+void deletePermutation(Permutation* perm);
+
+#endif
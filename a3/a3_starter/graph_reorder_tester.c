@@ -0,0 +1,451 @@
+/*
+ *  Randomized testing of our vertex reordering (see graph_reorder.h).
+ *
+ *  For every ORDER_* on random directed and undirected graphs, some of them
+ *  in several parts, the Permutation must list every vertex once, with
+ *  oldToNew the inverse of newToOld. The reordered Graph and CSRGraph must
+ *  hold the same edges, renamed, in the same order. Dijkstra's algorithm on
+ *  them must give, once mapped back with restoreVertexArray and
+ *  restoreEdgeIDs, the distances of the original graph and a tree of
+ *  shortest paths in it; Prim's algorithm must give a tree of the original
+ *  weight. Prints the first mismatches found and exits with a non-zero
+ *  status if there were any.
+ *
+ *  ---------------------------------------------------------------------------
+ *   Compile:
+ *   gcc -Wall -Werror -pthread graph.c minheap.c csr_graph.c \
+ *       compressed_graph.c graph_algos.c threadpool.c graph_reorder.c \
+ *       graph_reorder_tester.c -o graph_reorder_tester
+ *
+ *   Run:
+ *   ./graph_reorder_tester [seed]
+ *  ---------------------------------------------------------------------------
+ */
+
+#include <limits.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "csr_graph.h"
+#include "graph.h"
+#include "graph_algos.h"
+#include "graph_reorder.h"
+
+#define MAX_WEIGHT 50
+#define SOURCES_PER_GRAPH 3
+#define MAX_REPORTED 10  // mismatches printed before only counting them
+
+const char* orderNames[] = {"ORDER_BFS", "ORDER_RCM", "ORDER_DEGREE"};
+
+uint64_t randomState;
+int numMismatches;
+
+/*
+ * Returns a pseudo-random number in 0, 1, ..., bound-1 (splitmix64).
+ */
+int randomBelow(int bound)
+{
+  uint64_t z = (randomState += 0x9e3779b97f4a7c15ULL);
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+  z ^= z >> 31;
+  return (int)((z >> 33) % (uint64_t)bound);
+}
+
+/*
+ * Prints a mismatch found with order 'order', and counts it.
+ */
+void reportMismatch(int order, const char* what, int vertex, long long expected,
+                    long long actual)
+{
+  if (++numMismatches <= MAX_REPORTED)
+  {
+    printf("%s: %s of vertex %d is %lld, expected %lld\n", orderNames[order],
+           what, vertex, actual, expected);
+  }
+}
+
+/*
+ * Returns a random graph with 'numVertices' vertices and 'numEdges' edges,
+ * or pairs of opposite edges if 'undirected', all between vertices in the
+ * same one of 'numParts' parts of consecutive IDs.
+ */
+Graph* newRandomGraph(int numVertices, int numEdges, int numParts,
+                      bool undirected)
+{
+  Graph* graph = newGraph(numVertices);
+  for (int v = 0; v < numVertices; v++)
+    graph->vertices[v] = newVertex(v, NULL, NULL);
+  int partSize = (numVertices + numParts - 1) / numParts;
+  for (int i = 0; i < numEdges; i++)
+  {
+    int from = randomBelow(numVertices);
+    int partStart = from / partSize * partSize;
+    int partEnd = partStart + partSize < numVertices ? partStart + partSize
+                                                     : numVertices;
+    int to = partStart + randomBelow(partEnd - partStart);
+    int weight = 1 + randomBelow(MAX_WEIGHT);
+    insertGraphEdge(graph, from, to, weight);
+    if (undirected)
+      insertGraphEdge(graph, to, from, weight);
+  }
+  return graph;
+}
+
+/*
+ * Returns the number of edges leaving vertex 'v' of 'graph'.
+ */
+int degreeOf(Graph* graph, int v)
+{
+  int degree = 0;
+  for (EdgeList* list = graph->vertices[v]->adjList; list; list = list->next)
+  {
+    degree++;
+  }
+  return degree;
+}
+
+/*
+ * Checks that 'perm' is a permutation of the vertices of 'graph' in order
+ * 'order'.
+ */
+void checkPermutation(int order, Graph* graph, Permutation* perm)
+{
+  int n = graph->numVertices;
+  if (perm->numVertices != n)
+  {
+    reportMismatch(order, "numVertices", -1, n, perm->numVertices);
+    return;
+  }
+  int* seen = (int*)calloc(n, sizeof(int));
+  if (seen == NULL)
+  {
+    printf("Memory allocation failed\n");
+    exit(EXIT_FAILURE);
+  }
+  for (int newId = 0; newId < n; newId++)
+  {
+    int oldId = perm->newToOld[newId];
+    if (oldId < 0 || oldId >= n || seen[oldId]++)
+    {
+      reportMismatch(order, "newToOld", newId, -1, oldId);
+    }
+    else if (perm->oldToNew[oldId] != newId)
+    {
+      reportMismatch(order, "oldToNew", oldId, newId, perm->oldToNew[oldId]);
+    }
+  }
+  // Properties of each order that are easy to check
+  if (order == ORDER_BFS && n > 0 && perm->newToOld[0] != 0)
+  {
+    reportMismatch(order, "first vertex", 0, 0, perm->newToOld[0]);
+  }
+  for (int newId = 1; order == ORDER_DEGREE && newId < n; newId++)
+  {
+    int degree = degreeOf(graph, perm->newToOld[newId]);
+    int before = degreeOf(graph, perm->newToOld[newId - 1]);
+    if (degree > before)
+    {
+      reportMismatch(order, "degree after a smaller one", newId, before,
+                     degree);
+    }
+  }
+  free(seen);
+}
+
+/*
+ * Checks that 'reordered' and 'reorderedCSR' have the edges of 'graph',
+ * renamed by 'perm', in the same order.
+ */
+void checkReorderedEdges(int order, Graph* graph, Permutation* perm,
+                         Graph* reordered, CSRGraph* reorderedCSR)
+{
+  if (reordered->numEdges != graph->numEdges ||
+      reorderedCSR->numEdges != graph->numEdges)
+  {
+    reportMismatch(order, "number of edges", -1, graph->numEdges,
+                   reordered->numEdges);
+    return;
+  }
+  for (int v = 0; v < graph->numVertices; v++)
+  {
+    int newId = perm->oldToNew[v];
+    EdgeList* list = graph->vertices[v]->adjList;
+    EdgeList* newList = reordered->vertices[newId]->adjList;
+    int64_t e = reorderedCSR->offsets[newId];
+    for (; list; list = list->next, e++)
+    {
+      int target = perm->oldToNew[list->edge->toVertex];
+      if (newList == NULL || newList->edge->fromVertex != newId ||
+          newList->edge->toVertex != target ||
+          newList->edge->weight != list->edge->weight)
+      {
+        reportMismatch(order, "Graph edge list", v, target,
+                       newList ? newList->edge->toVertex : -1);
+        break;
+      }
+      if (e >= reorderedCSR->offsets[newId + 1] ||
+          reorderedCSR->targets[e] != target ||
+          reorderedCSR->weights[e] != list->edge->weight)
+      {
+        reportMismatch(order, "CSRGraph edge list", v, target,
+                       e < reorderedCSR->offsets[newId + 1]
+                           ? reorderedCSR->targets[e]
+                           : -1);
+        break;
+      }
+      newList = newList->next;
+    }
+    if (list == NULL && (newList != NULL ||
+                         e != reorderedCSR->offsets[newId + 1]))
+    {
+      reportMismatch(order, "degree", v, degreeOf(graph, v),
+                     degreeOf(reordered, newId));
+    }
+  }
+}
+
+/*
+ * Returns the weight of the lightest edge from 'fromVertex' to 'toVertex'
+ * in 'graph', or INT_MAX if there is none.
+ */
+int lightestEdge(Graph* graph, int fromVertex, int toVertex)
+{
+  int lightest = INT_MAX;
+  for (EdgeList* list = graph->vertices[fromVertex]->adjList; list;
+       list = list->next)
+  {
+    if (list->edge->toVertex == toVertex && list->edge->weight < lightest)
+    {
+      lightest = list->edge->weight;
+    }
+  }
+  return lightest;
+}
+
+/*
+ * Checks that the 'numEdges' edges in 'tree', in original IDs, form a
+ * shortest path tree of 'graph' with the distances 'expected' from
+ * 'source': one edge into every other reachable vertex, each ending a
+ * shortest path.
+ */
+void checkDistanceTree(int order, Graph* graph, int source, int* expected,
+                       Edge* tree, int numEdges)
+{
+  int reachable = 0;
+  for (int v = 0; v < graph->numVertices; v++)
+  {
+    reachable += v != source && expected[v] != INT_MAX;
+  }
+  if (numEdges != reachable)
+  {
+    reportMismatch(order, "distance tree edges from", source, reachable,
+                   numEdges);
+    return;
+  }
+  bool* hasEdgeInto = (bool*)calloc(graph->numVertices, sizeof(bool));
+  if (hasEdgeInto == NULL)
+  {
+    printf("Memory allocation failed\n");
+    exit(EXIT_FAILURE);
+  }
+  for (int i = 0; i < numEdges; i++)
+  {
+    Edge edge = tree[i];
+    if (edge.fromVertex < 0 || edge.fromVertex >= graph->numVertices ||
+        edge.toVertex < 0 || edge.toVertex >= graph->numVertices ||
+        edge.toVertex == source || hasEdgeInto[edge.toVertex] ||
+        expected[edge.fromVertex] == INT_MAX ||
+        lightestEdge(graph, edge.fromVertex, edge.toVertex) != edge.weight ||
+        expected[edge.fromVertex] + edge.weight != expected[edge.toVertex])
+    {
+      reportMismatch(order, "distance tree edge into", edge.toVertex,
+                     edge.fromVertex, -1);
+      continue;
+    }
+    hasEdgeInto[edge.toVertex] = true;
+  }
+  free(hasEdgeInto);
+}
+
+/*
+ * Runs Dijkstra's algorithm, and Prim's if 'undirected', on 'graph' and on
+ * its reordered copies from random sources, and checks the results mapped
+ * back to the original IDs.
+ */
+void checkAlgorithms(int order, Graph* graph, bool undirected,
+                     Permutation* perm, Graph* reordered,
+                     CSRGraph* reorderedCSR)
+{
+  int n = graph->numVertices;
+  Workspace* ws = newWorkspace(n);
+  int* expected = (int*)malloc(n * sizeof(int));
+  int* byNewId = (int*)malloc(n * sizeof(int));
+  int* byOldId = (int*)malloc(n * sizeof(int));
+  Edge* tree = (Edge*)malloc(n * sizeof(Edge));
+  if (ws == NULL || expected == NULL || byNewId == NULL || byOldId == NULL ||
+      tree == NULL)
+  {
+    printf("Memory allocation failed\n");
+    exit(EXIT_FAILURE);
+  }
+  for (int i = 0; i < SOURCES_PER_GRAPH; i++)
+  {
+    int source = randomBelow(n);
+    int newSource = perm->oldToNew[source];
+    getDistanceTreeDijkstraInto(ws, graph, source, NULL);
+    for (int v = 0; v < n; v++)
+    {
+      expected[v] = getWorkspaceDistance(ws, v);
+    }
+
+    // Reordered Graph: distances and predecessors by vertex
+    int numEdges = getDistanceTreeDijkstraInto(ws, reordered, newSource, tree);
+    for (int v = 0; v < n; v++)
+    {
+      byNewId[v] = getWorkspaceDistance(ws, v);
+    }
+    restoreVertexArray(perm, byNewId, byOldId, false);
+    for (int v = 0; v < n; v++)
+    {
+      if (byOldId[v] != expected[v])
+      {
+        reportMismatch(order, "restored distance", v, expected[v],
+                       byOldId[v]);
+      }
+    }
+    for (int v = 0; v < n; v++)
+    {
+      byNewId[v] = getWorkspacePredecessor(ws, v);
+    }
+    restoreVertexArray(perm, byNewId, byOldId, true);
+    for (int v = 0; v < n; v++)
+    {
+      int pred = byOldId[v];
+      bool ok;
+      if (v == source || expected[v] == INT_MAX)
+      {
+        ok = pred == NOTHING;
+      }
+      else
+      {
+        int weight = pred >= 0 && pred < n ? lightestEdge(graph, pred, v)
+                                           : INT_MAX;
+        ok = weight != INT_MAX && expected[pred] != INT_MAX &&
+             expected[pred] + weight == expected[v];
+      }
+      if (!ok)
+      {
+        reportMismatch(order, "restored predecessor", v, -1, pred);
+      }
+    }
+    restoreEdgeIDs(perm, tree, numEdges);
+    checkDistanceTree(order, graph, source, expected, tree, numEdges);
+
+    // Reordered CSRGraph: tree edges
+    numEdges = getDistanceTreeDijkstraCSR(ws, reorderedCSR, newSource, tree);
+    restoreEdgeIDs(perm, tree, numEdges);
+    checkDistanceTree(order, graph, source, expected, tree, numEdges);
+
+    if (undirected)
+    {
+      int mstEdges = getMSTprimInto(ws, graph, source, tree);
+      long long weight = 0;
+      for (int e = 0; e < mstEdges; e++)
+      {
+        weight += tree[e].weight;
+      }
+      int newMstEdges = getMSTprimCSR(ws, reorderedCSR, newSource, tree);
+      restoreEdgeIDs(perm, tree, newMstEdges);
+      long long newWeight = 0;
+      for (int e = 0; e < newMstEdges; e++)
+      {
+        newWeight += tree[e].weight;
+        if (lightestEdge(graph, tree[e].fromVertex, tree[e].toVertex) ==
+            INT_MAX)
+        {
+          reportMismatch(order, "MST edge into", tree[e].toVertex,
+                         tree[e].fromVertex, -1);
+        }
+      }
+      if (newMstEdges != mstEdges || newWeight != weight)
+      {
+        reportMismatch(order, "MST weight from", source, weight, newWeight);
+      }
+    }
+  }
+  free(tree);
+  free(byOldId);
+  free(byNewId);
+  free(expected);
+  deleteWorkspace(ws);
+}
+
+/*
+ * Builds a random graph and checks every order on it.
+ */
+void testRandomGraph(const char* name, int numVertices, int numEdges,
+                     int numParts, bool undirected)
+{
+  Graph* graph = newRandomGraph(numVertices, numEdges, numParts, undirected);
+  CSRGraph* csr = csrFromGraph(graph);
+  if (csr == NULL)
+  {
+    printf("Memory allocation failed\n");
+    exit(EXIT_FAILURE);
+  }
+  for (int order = ORDER_BFS; order <= ORDER_DEGREE; order++)
+  {
+    Permutation* perm = getVertexOrder(graph, order);
+    if (perm == NULL)
+    {
+      reportMismatch(order, "success", -1, true, false);
+      continue;
+    }
+    checkPermutation(order, graph, perm);
+    Graph* reordered = reorderGraph(graph, perm);
+    CSRGraph* reorderedCSR = reorderCSRGraph(csr, perm);
+    if (reorderedCSR == NULL)
+    {
+      printf("Memory allocation failed\n");
+      exit(EXIT_FAILURE);
+    }
+    checkReorderedEdges(order, graph, perm, reordered, reorderedCSR);
+    checkAlgorithms(order, graph, undirected, perm, reordered, reorderedCSR);
+    deleteCSRGraph(reorderedCSR);
+    deleteGraph(reordered);
+    deletePermutation(perm);
+  }
+  if (getVertexOrder(graph, -1) != NULL ||
+      getVertexOrder(graph, ORDER_DEGREE + 1) != NULL)
+  {
+    reportMismatch(ORDER_BFS, "success of an invalid order", -1, false, true);
+  }
+
+  printf("%s: %d vertices, %d edges: %d mismatches so far\n", name,
+         numVertices, graph->numEdges, numMismatches);
+  deleteCSRGraph(csr);
+  deleteGraph(graph);
+}
+
+int main(int argc, char* argv[])
+{
+  randomState = argc > 1 ? strtoull(argv[1], NULL, 10) : 1;
+
+  testRandomGraph("one vertex", 1, 0, 1, true);
+  testRandomGraph("directed", 500, 2000, 1, false);
+  testRandomGraph("directed, sparse", 1000, 800, 1, false);
+  testRandomGraph("undirected", 2000, 6000, 1, true);
+  testRandomGraph("undirected, 5 parts", 2000, 6000, 5, true);
+  testRandomGraph("undirected, isolated vertices", 3000, 1000, 1, true);
+  testRandomGraph("directed, 4 parts", 5000, 30000, 4, false);
+
+  if (numMismatches > 0)
+  {
+    printf("FAILED: %d mismatches\n", numMismatches);
+    return EXIT_FAILURE;
+  }
+  printf("All reordered results match the original graph.\n");
+  return EXIT_SUCCESS;
+}
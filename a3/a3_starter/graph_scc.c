@@ -0,0 +1,217 @@
+/*
+ * Connectivity algorithms.
+ *
+ * Tarjan's algorithm keeps, for each vertex on the depth-first path, the
+ * rest of its adjacency list still to be explored, so returning from a
+ * "call" just pops that frame and carries on where the vertex left off.
+ */
+
+#include "graph_algos.h"
+#include "graph_scc.h"
+
+#define UNVISITED -1
+
+/*
+ * Returns the adjacency list of vertex 'id' in 'graph', which is NULL if
+ * the vertex was never created.
+ */
+EdgeList *adjacencyOf(Graph *graph, int id)
+{
+  Vertex *vertex = graph->vertices[id];
+  return vertex ? vertex->adjList : NULL;
+}
+
+int getStronglyConnectedComponents(Graph *graph, int *component)
+{
+  int n = graph->numVertices;
+  int *order = (int *)malloc((n + 1) * sizeof(int));   // discovery index
+  int *low = (int *)malloc((n + 1) * sizeof(int));     // lowlink
+  int *stack = (int *)malloc((n + 1) * sizeof(int));   // Tarjan's stack
+  int *path = (int *)malloc((n + 1) * sizeof(int));    // depth-first path
+  EdgeList **next = (EdgeList **)malloc((n + 1) * sizeof(EdgeList *));
+  int numComponents = 0;
+  if (!order || !low || !stack || !path || !next)
+  {
+    numComponents = -1;
+    n = 0;
+  }
+
+  for (int v = 0; v < n; v++)
+  {
+    order[v] = UNVISITED;
+    component[v] = UNVISITED;
+  }
+  int numVisited = 0;
+  int stackSize = 0;
+  for (int root = 0; root < n; root++)
+  {
+    if (order[root] != UNVISITED)
+    {
+      continue;
+    }
+    int depth = 0;
+    path[depth++] = root;
+    order[root] = low[root] = numVisited++;
+    stack[stackSize++] = root;
+    next[root] = adjacencyOf(graph, root);
+
+    while (depth > 0)
+    {
+      int u = path[depth - 1];
+      if (next[u] != NULL)
+      {
+        int v = next[u]->edge->toVertex;
+        next[u] = next[u]->next;
+        if (order[v] == UNVISITED)
+        {
+          path[depth++] = v;
+          order[v] = low[v] = numVisited++;
+          stack[stackSize++] = v;
+          next[v] = adjacencyOf(graph, v);
+        }
+        else if (component[v] == UNVISITED && order[v] < low[u])
+        {
+          low[u] = order[v]; // v is still on Tarjan's stack
+        }
+        continue;
+      }
+
+      depth--;
+      if (depth > 0 && low[u] < low[path[depth - 1]])
+      {
+        low[path[depth - 1]] = low[u];
+      }
+      if (low[u] == order[u])
+      {
+        int v;
+        do
+        {
+          v = stack[--stackSize];
+          component[v] = numComponents;
+        } while (v != u);
+        numComponents++;
+      }
+    }
+  }
+
+  // Tarjan finishes components in reverse topological order
+  for (int v = 0; v < n; v++)
+  {
+    component[v] = numComponents - 1 - component[v];
+  }
+
+  free(order);
+  free(low);
+  free(stack);
+  free(path);
+  free(next);
+  return numComponents;
+}
+
+Graph *getCondensation(Graph *graph, int *component, int numComponents)
+{
+  Graph *dag = newGraph(numComponents);
+  for (int c = 0; c < numComponents; c++)
+  {
+    dag->vertices[c] = newVertex(c, NULL, NULL);
+  }
+
+  // lightest[c] is the edge to c from the component being built, if any
+  Edge **lightest = (Edge **)calloc(numComponents + 1, sizeof(Edge *));
+  int *members = (int *)malloc((graph->numVertices + 1) * sizeof(int));
+  int *firstMember = (int *)calloc(numComponents + 2, sizeof(int));
+  if (!lightest || !members || !firstMember)
+  {
+    printf("Memory allocation failed\n");
+    exit(EXIT_FAILURE);
+  }
+
+  // bucket the vertices by component
+  for (int v = 0; v < graph->numVertices; v++)
+  {
+    firstMember[component[v] + 2]++;
+  }
+  for (int c = 0; c < numComponents; c++)
+  {
+    firstMember[c + 2] += firstMember[c + 1];
+  }
+  for (int v = 0; v < graph->numVertices; v++)
+  {
+    members[firstMember[component[v] + 1]++] = v;
+  }
+
+  for (int c = 0; c < numComponents; c++)
+  {
+    Vertex *vertex = dag->vertices[c];
+    for (int i = firstMember[c]; i < firstMember[c + 1]; i++)
+    {
+      for (EdgeList *adj = adjacencyOf(graph, members[i]); adj;
+           adj = adj->next)
+      {
+        int to = component[adj->edge->toVertex];
+        if (to == c)
+        {
+          continue;
+        }
+        if (lightest[to] == NULL)
+        {
+          vertex->adjList = newGraphEdgeList(dag, c, to, adj->edge->weight,
+                                             vertex->adjList);
+          lightest[to] = vertex->adjList->edge;
+          dag->numEdges++;
+        }
+        else if (adj->edge->weight < lightest[to]->weight)
+        {
+          lightest[to]->weight = adj->edge->weight;
+        }
+      }
+    }
+    for (EdgeList *adj = vertex->adjList; adj; adj = adj->next)
+    {
+      lightest[adj->edge->toVertex] = NULL;
+    }
+  }
+
+  free(lightest);
+  free(members);
+  free(firstMember);
+  return dag;
+}
+
+bool reachesAllVertices(Graph *graph, int startVertex)
+{
+  int n = graph->numVertices;
+  if (startVertex < 0 || startVertex >= n)
+  {
+    return false;
+  }
+  bool *seen = (bool *)calloc(n, sizeof(bool));
+  int *queue = (int *)malloc(n * sizeof(int));
+  if (!seen || !queue)
+  {
+    free(seen);
+    free(queue);
+    return false;
+  }
+
+  int tail = 0;
+  seen[startVertex] = true;
+  queue[tail++] = startVertex;
+  for (int head = 0; head < tail && tail < n; head++)
+  {
+    for (EdgeList *adj = adjacencyOf(graph, queue[head]); adj;
+         adj = adj->next)
+    {
+      int v = adj->edge->toVertex;
+      if (!seen[v])
+      {
+        seen[v] = true;
+        queue[tail++] = v;
+      }
+    }
+  }
+
+  free(seen);
+  free(queue);
+  return tail == n;
+}
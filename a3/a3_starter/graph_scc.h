@@ -0,0 +1,45 @@
+/*
+ * Header file for our connectivity algorithms.
+ *
+ * Strongly connected components are found with Tarjan's algorithm, run
+ * with an explicit stack instead of recursion so that graphs with millions
+ * of vertices (and paths just as long) do not overflow the call stack.
+ */
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "graph.h"
+
+#ifndef __Graph_SCC_header
+#define __Graph_SCC_header
+
+/*
+ * Stores the strongly connected component of each vertex v of 'graph' in
+ * component[v], which must have room for numVertices entries, and returns
+ * the number of components. Components are numbered in topological order:
+ * every edge goes from a component to itself or to a later one.
+ * Returns -1 if memory could not be allocated.
+ */
+int getStronglyConnectedComponents(Graph* graph, int* component);
+
+/*
+ * Returns the condensation of 'graph': a newly created Graph with one
+ * vertex per component, as numbered by getStronglyConnectedComponents, and
+ * an edge from component a to component b != a iff 'graph' has an edge
+ * from a vertex of a to a vertex of b. Its weight is the lightest such
+ * edge. The result is a DAG whose edges all go from lower to higher IDs.
+ */
+Graph* getCondensation(Graph* graph, int* component, int numComponents);
+
+/*
+ * Returns true iff every vertex of 'graph' can be reached from vertex with
+ * ID 'startVertex', which is what getMSTprim and getDistanceTreeDijkstra
+ * need to return numVertices - 1 edges. Takes O(V + E) time, with no heap.
+ * Returns false if 'startVertex' is not valid or memory could not be
+ * allocated.
+ */
+bool reachesAllVertices(Graph* graph, int startVertex);
+
+#endif
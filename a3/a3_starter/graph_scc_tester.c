@@ -0,0 +1,389 @@
+/*
+ *  Randomized testing of our connectivity algorithms (see graph_scc.h).
+ *
+ *  On random directed graphs, two vertices must share a strongly connected
+ *  component exactly when each reaches the other by a plain BFS, and every
+ *  edge must go from a component to itself or to a later one. The
+ *  condensation must have one edge, of the lightest weight, for each pair
+ *  of components joined by an edge, and reachesAllVertices must agree with
+ *  the BFS. Long paths and cycles check that nothing recurses once per
+ *  vertex. Prints the first mismatches found and exits with a non-zero
+ *  status if there were any.
+ *
+ *  ---------------------------------------------------------------------------
+ *   Compile:
+ *   gcc -Wall -Werror graph.c graph_scc.c graph_scc_tester.c \
+ *       -o graph_scc_tester
+ *
+ *   Run:
+ *   ./graph_scc_tester [seed]
+ *  ---------------------------------------------------------------------------
+ */
+
+#include <limits.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "graph.h"
+#include "graph_scc.h"
+
+#define MAX_WEIGHT 100
+#define MAX_REPORTED 10  // mismatches printed before only counting them
+
+uint64_t randomState;
+int numMismatches;
+
+/*
+ * Returns a pseudo-random number in 0, 1, ..., bound-1 (splitmix64).
+ */
+int randomBelow(int bound)
+{
+  uint64_t z = (randomState += 0x9e3779b97f4a7c15ULL);
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+  z ^= z >> 31;
+  return (int)((z >> 33) % (uint64_t)bound);
+}
+
+/*
+ * Prints a mismatch found in graph 'name', and counts it.
+ */
+void reportMismatch(const char* name, const char* what, int vertex,
+                    int expected, int actual)
+{
+  if (++numMismatches <= MAX_REPORTED)
+  {
+    printf("%s: %s of %d is %d, expected %d\n", name, what, vertex, actual,
+           expected);
+  }
+}
+
+/*
+ * Returns a new graph with 'numVertices' vertices and no edges.
+ */
+Graph* newEmptyGraph(int numVertices)
+{
+  Graph* graph = newGraph(numVertices);
+  for (int v = 0; v < numVertices; v++)
+    graph->vertices[v] = newVertex(v, NULL, NULL);
+  return graph;
+}
+
+/*
+ * Returns a random directed graph with 'numVertices' vertices and
+ * 'numEdges' edges. Edges to a higher ID are 'forwardBias' times as likely
+ * as others, so that the graph has many components rather than one.
+ */
+Graph* newRandomGraph(int numVertices, int numEdges, int forwardBias)
+{
+  Graph* graph = newEmptyGraph(numVertices);
+  for (int i = 0; i < numEdges; i++)
+  {
+    int from = randomBelow(numVertices);
+    int to = randomBelow(numVertices);
+    for (int tries = 1; tries < forwardBias && to < from; tries++)
+    {
+      to = randomBelow(numVertices);
+    }
+    insertGraphEdge(graph, from, to, 1 + randomBelow(MAX_WEIGHT));
+  }
+  return graph;
+}
+
+/*
+ * Marks in 'reached' the vertices of 'graph' reachable from 'source', by
+ * BFS, using 'queue' of numVertices entries. Returns their number.
+ */
+int reachFrom(Graph* graph, int source, bool* reached, int* queue)
+{
+  memset(reached, 0, graph->numVertices * sizeof(bool));
+  reached[source] = true;
+  queue[0] = source;
+  int head = 0;
+  int tail = 1;
+  while (head < tail)
+  {
+    int u = queue[head++];
+    for (EdgeList* list = graph->vertices[u]->adjList; list;
+         list = list->next)
+    {
+      int v = list->edge->toVertex;
+      if (!reached[v])
+      {
+        reached[v] = true;
+        queue[tail++] = v;
+      }
+    }
+  }
+  return tail;
+}
+
+/*
+ * Checks the numbering in 'component', of 'numComponents' components, and
+ * the condensation against the edges of 'graph'.
+ */
+void checkStructure(const char* name, Graph* graph, int* component,
+                    int numComponents)
+{
+  int n = graph->numVertices;
+  bool* used = (bool*)calloc(numComponents + 1, sizeof(bool));
+  int* lightest = (int*)malloc((numComponents + 1) * sizeof(int));
+  if (used == NULL || lightest == NULL)
+  {
+    printf("Memory allocation failed\n");
+    exit(EXIT_FAILURE);
+  }
+  for (int v = 0; v < n; v++)
+  {
+    if (component[v] < 0 || component[v] >= numComponents)
+    {
+      reportMismatch(name, "component", v, 0, component[v]);
+      free(lightest);
+      free(used);
+      return;
+    }
+    used[component[v]] = true;
+  }
+  for (int c = 0; c < numComponents; c++)
+  {
+    if (!used[c])
+    {
+      reportMismatch(name, "vertices in component", c, 1, 0);
+    }
+  }
+
+  // Components in topological order
+  for (int u = 0; u < n; u++)
+  {
+    for (EdgeList* list = graph->vertices[u]->adjList; list;
+         list = list->next)
+    {
+      if (component[list->edge->toVertex] < component[u])
+      {
+        reportMismatch(name, "component of the target of an edge from", u,
+                       component[u], component[list->edge->toVertex]);
+      }
+    }
+  }
+
+  // The condensation, one component at a time: lightest[b] is the weight
+  // of the lightest edge from component a to component b
+  Graph* condensation = getCondensation(graph, component, numComponents);
+  if (condensation->numVertices != numComponents)
+  {
+    reportMismatch(name, "condensation vertices, for components",
+                   numComponents, numComponents, condensation->numVertices);
+    deleteGraph(condensation);
+    free(lightest);
+    free(used);
+    return;
+  }
+  int** members = (int**)malloc(numComponents * sizeof(int*));
+  int* sizes = (int*)calloc(numComponents, sizeof(int));
+  int* order = (int*)malloc(n * sizeof(int));
+  int* touched = (int*)malloc(numComponents * sizeof(int));
+  if (members == NULL || sizes == NULL || order == NULL || touched == NULL)
+  {
+    printf("Memory allocation failed\n");
+    exit(EXIT_FAILURE);
+  }
+  for (int v = 0; v < n; v++)
+  {
+    sizes[component[v]]++;
+  }
+  for (int c = 0, start = 0; c < numComponents; c++)
+  {
+    members[c] = order + start;
+    start += sizes[c];
+    sizes[c] = 0;
+  }
+  for (int v = 0; v < n; v++)
+  {
+    members[component[v]][sizes[component[v]]++] = v;
+  }
+  for (int b = 0; b < numComponents; b++)
+  {
+    lightest[b] = INT_MAX;
+  }
+  for (int a = 0; a < numComponents; a++)
+  {
+    // 'touched' lists the b with lightest[b] set, to reset them after
+    int numTouched = 0;
+    for (int i = 0; i < sizes[a]; i++)
+    {
+      for (EdgeList* list = graph->vertices[members[a][i]]->adjList; list;
+           list = list->next)
+      {
+        int b = component[list->edge->toVertex];
+        if (b == a)
+        {
+          continue;
+        }
+        if (lightest[b] == INT_MAX)
+        {
+          touched[numTouched++] = b;
+        }
+        if (list->edge->weight < lightest[b])
+        {
+          lightest[b] = list->edge->weight;
+        }
+      }
+    }
+    int numEdges = 0;
+    for (EdgeList* list = condensation->vertices[a]->adjList; list;
+         list = list->next)
+    {
+      int b = list->edge->toVertex;
+      numEdges++;
+      if (b <= a || b >= numComponents)
+      {
+        reportMismatch(name, "condensation edge target from component", a,
+                       a + 1, b);
+      }
+      else if (list->edge->weight != lightest[b])
+      {
+        reportMismatch(name, "condensation edge weight from component", a,
+                       lightest[b], list->edge->weight);
+      }
+      else
+      {
+        lightest[b] = -1;  // a second edge to b is a mismatch
+      }
+    }
+    if (numEdges != numTouched)
+    {
+      reportMismatch(name, "condensation edges from component", a,
+                     numTouched, numEdges);
+    }
+    for (int i = 0; i < numTouched; i++)
+    {
+      lightest[touched[i]] = INT_MAX;
+    }
+  }
+  free(touched);
+  free(order);
+  free(sizes);
+  free(members);
+  deleteGraph(condensation);
+  free(lightest);
+  free(used);
+}
+
+/*
+ * Checks the components of 'graph' against mutual reachability, and
+ * reachesAllVertices from every vertex. Takes O(V (V + E)) time.
+ */
+void checkReachability(const char* name, Graph* graph, int* component)
+{
+  int n = graph->numVertices;
+  bool* reach = (bool*)malloc((size_t)n * n * sizeof(bool));
+  int* queue = (int*)malloc(n * sizeof(int));
+  if (reach == NULL || queue == NULL)
+  {
+    printf("Memory allocation failed\n");
+    exit(EXIT_FAILURE);
+  }
+  for (int u = 0; u < n; u++)
+  {
+    bool all = reachFrom(graph, u, reach + (size_t)u * n, queue) == n;
+    if (reachesAllVertices(graph, u) != all)
+    {
+      reportMismatch(name, "reachesAllVertices", u, all, !all);
+    }
+  }
+  for (int u = 0; u < n; u++)
+  {
+    for (int v = 0; v < n; v++)
+    {
+      bool mutual = reach[(size_t)u * n + v] && reach[(size_t)v * n + u];
+      if (mutual != (component[u] == component[v]))
+      {
+        reportMismatch(name, "component, as mutually reachable with",
+                       v, mutual ? component[u] : -1, component[v]);
+      }
+    }
+  }
+  free(queue);
+  free(reach);
+}
+
+/*
+ * Runs getStronglyConnectedComponents on 'graph' and checks it, against
+ * reachability too if 'small', and that it has 'expectedComponents'
+ * components unless that is -1. Deletes 'graph'.
+ */
+void testGraph(const char* name, Graph* graph, bool small,
+               int expectedComponents)
+{
+  int n = graph->numVertices;
+  int* component = (int*)malloc(n * sizeof(int));
+  if (component == NULL)
+  {
+    printf("Memory allocation failed\n");
+    exit(EXIT_FAILURE);
+  }
+  int numComponents = getStronglyConnectedComponents(graph, component);
+  if (expectedComponents != -1 && numComponents != expectedComponents)
+  {
+    reportMismatch(name, "number of components, of vertices", n,
+                   expectedComponents, numComponents);
+  }
+  checkStructure(name, graph, component, numComponents);
+  if (small)
+  {
+    checkReachability(name, graph, component);
+  }
+  if (reachesAllVertices(graph, -1) || reachesAllVertices(graph, n))
+  {
+    reportMismatch(name, "reachesAllVertices from an invalid ID", n, false,
+                   true);
+  }
+
+  printf("%s: %d vertices, %d edges, %d components: %d mismatches so far\n",
+         name, n, graph->numEdges, numComponents, numMismatches);
+  free(component);
+  deleteGraph(graph);
+}
+
+/*
+ * Returns a path 0 -> 1 -> ... -> numVertices-1, closed into a cycle if
+ * 'cycle'.
+ */
+Graph* newPathGraph(int numVertices, bool cycle)
+{
+  Graph* graph = newEmptyGraph(numVertices);
+  for (int v = 0; v + 1 < numVertices; v++)
+  {
+    insertGraphEdge(graph, v, v + 1, 1);
+  }
+  if (cycle)
+  {
+    insertGraphEdge(graph, numVertices - 1, 0, 1);
+  }
+  return graph;
+}
+
+int main(int argc, char* argv[])
+{
+  randomState = argc > 1 ? strtoull(argv[1], NULL, 10) : 1;
+
+  testGraph("one vertex", newEmptyGraph(1), true, 1);
+  testGraph("no edges", newEmptyGraph(50), true, 50);
+  testGraph("sparse", newRandomGraph(300, 400, 1), true, -1);
+  testGraph("one large component", newRandomGraph(300, 1500, 1), true, -1);
+  testGraph("mostly forward", newRandomGraph(400, 1200, 8), true, -1);
+  testGraph("parallel edges", newRandomGraph(30, 400, 4), true, -1);
+  testGraph("long path", newPathGraph(1000000, false), false, 1000000);
+  testGraph("long cycle", newPathGraph(1000000, true), false, 1);
+  testGraph("large", newRandomGraph(200000, 300000, 3), false, -1);
+
+  if (numMismatches > 0)
+  {
+    printf("FAILED: %d mismatches\n", numMismatches);
+    return EXIT_FAILURE;
+  }
+  printf("All component results match reachability.\n");
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,351 @@
+/*
+ * Our streaming graph builder.
+ *
+ * Edges are appended to a pending buffer under a short lock. Compaction
+ * takes the whole buffer, merges it with the previous snapshot into a new
+ * CSRGraph without holding that lock, and swaps the new snapshot in.
+ * Snapshots are reference counted so readers never block writers.
+ */
+
+#include <limits.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <string.h>
+
+#include "graph_stream.h"
+
+#define FIRST_PENDING_EDGES 1024
+
+struct graph_snapshot
+{
+  CSRGraph *graph;     // immutable once published
+  atomic_int holders;  // callers holding it, plus 1 while it is the latest
+};
+
+struct graph_stream
+{
+  int compactEvery;             // pending edges that make a compaction due
+  pthread_mutex_t ingestLock;   // guards the six fields below
+  Edge *pending;                // edges added since the last compaction
+  int64_t numPending;
+  int64_t pendingCapacity;
+  Edge *deferred;               // edges of a failed compaction, or NULL;
+  int64_t numDeferred;          // they go before 'pending'
+  int maxVertex;                // largest vertex ID seen so far, or -1
+  pthread_mutex_t compactLock;  // held for the whole of a compaction
+  pthread_mutex_t publishLock;  // guards 'current'
+  GraphSnapshot *current;       // the latest published snapshot
+};
+
+/*
+ * A compaction in progress: the old snapshot and pending edges being merged
+ * into 'csr'.
+ */
+typedef struct merge
+{
+  CSRGraph *old;    // the previous snapshot
+  CSRGraph *csr;    // the snapshot being built
+  int blockSize;    // vertices copied per task
+} Merge;
+
+/*
+ * Returns a newly created snapshot holding 'graph', held once on behalf of
+ * the stream, or NULL if memory could not be allocated.
+ */
+GraphSnapshot *newSnapshot(CSRGraph *graph)
+{
+  GraphSnapshot *snapshot = (GraphSnapshot *)malloc(sizeof(GraphSnapshot));
+  if (!snapshot)
+  {
+    return NULL;
+  }
+  snapshot->graph = graph;
+  atomic_init(&snapshot->holders, 1);
+  return snapshot;
+}
+
+GraphStream *newGraphStream(int compactEvery)
+{
+  GraphStream *stream = (GraphStream *)malloc(sizeof(GraphStream));
+  if (!stream)
+  {
+    return NULL;
+  }
+  CSRGraph *empty = newCSRGraph(0, 0);
+  stream->current = empty ? newSnapshot(empty) : NULL;
+  if (!stream->current)
+  {
+    deleteCSRGraph(empty);
+    free(stream);
+    return NULL;
+  }
+  stream->compactEvery = compactEvery;
+  stream->pending = NULL;
+  stream->numPending = 0;
+  stream->pendingCapacity = 0;
+  stream->deferred = NULL;
+  stream->numDeferred = 0;
+  stream->maxVertex = -1;
+  pthread_mutex_init(&stream->ingestLock, NULL);
+  pthread_mutex_init(&stream->compactLock, NULL);
+  pthread_mutex_init(&stream->publishLock, NULL);
+  return stream;
+}
+
+/*
+ * Makes room for 'numEdges' more pending edges in 'stream'.
+ * Returns false if memory could not be allocated.
+ * Precondition: the caller holds stream->ingestLock
+ */
+bool reservePending(GraphStream *stream, int64_t numEdges)
+{
+  int64_t needed = stream->numPending + numEdges;
+  if (needed <= stream->pendingCapacity)
+  {
+    return true;
+  }
+  int64_t capacity = stream->pendingCapacity ? stream->pendingCapacity
+                                             : FIRST_PENDING_EDGES;
+  while (capacity < needed)
+  {
+    capacity *= 2;
+  }
+  Edge *pending = (Edge *)realloc(stream->pending, capacity * sizeof(Edge));
+  if (!pending)
+  {
+    return false;
+  }
+  stream->pending = pending;
+  stream->pendingCapacity = capacity;
+  return true;
+}
+
+bool addStreamEdges(GraphStream *stream, Edge *edges, int numEdges,
+                    bool *compactNow)
+{
+  int maxVertex = -1;
+  for (int i = 0; i < numEdges; i++)
+  {
+    if (edges[i].fromVertex < 0 || edges[i].toVertex < 0 ||
+        edges[i].fromVertex == INT_MAX || edges[i].toVertex == INT_MAX ||
+        edges[i].weight < 0)
+    {
+      *compactNow = false;
+      return false;
+    }
+    maxVertex = edges[i].fromVertex > maxVertex ? edges[i].fromVertex
+                                                : maxVertex;
+    maxVertex = edges[i].toVertex > maxVertex ? edges[i].toVertex : maxVertex;
+  }
+
+  pthread_mutex_lock(&stream->ingestLock);
+  bool ok = reservePending(stream, numEdges);
+  if (ok)
+  {
+    memcpy(stream->pending + stream->numPending, edges,
+           numEdges * sizeof(Edge));
+    stream->numPending += numEdges;
+    if (maxVertex > stream->maxVertex)
+    {
+      stream->maxVertex = maxVertex;
+    }
+  }
+  *compactNow =
+      stream->numDeferred + stream->numPending >= stream->compactEvery;
+  pthread_mutex_unlock(&stream->ingestLock);
+  return ok;
+}
+
+/*
+ * Task 'index': copies the edges of one block of vertices of the old
+ * snapshot to the start of their ranges in the new one.
+ */
+void copyOldEdges(int index, int workerId, void *context)
+{
+  (void)workerId;
+  Merge *merge = (Merge *)context;
+  CSRGraph *old = merge->old;
+  CSRGraph *csr = merge->csr;
+  int start = index * merge->blockSize;
+  int end = start + merge->blockSize;
+  end = end < old->numVertices ? end : old->numVertices;
+  for (int v = start; v < end; v++)
+  {
+    int64_t count = old->offsets[v + 1] - old->offsets[v];
+    memcpy(csr->targets + csr->offsets[v], old->targets + old->offsets[v],
+           count * sizeof(int));
+    memcpy(csr->weights + csr->offsets[v], old->weights + old->offsets[v],
+           count * sizeof(int));
+  }
+}
+
+/*
+ * Returns a new CSRGraph with 'numVertices' vertices holding the edges of
+ * 'old' followed by the 'numPending' edges in 'pending', or NULL if memory
+ * could not be allocated.
+ */
+CSRGraph *mergeEdges(CSRGraph *old, Edge *pending, int64_t numPending,
+                     int numVertices, ThreadPool *pool)
+{
+  int64_t *cursors = (int64_t *)calloc(numVertices + 1, sizeof(int64_t));
+  if (!cursors)
+  {
+    return NULL;
+  }
+  for (int v = 0; v < old->numVertices; v++)
+  {
+    cursors[v] = old->offsets[v + 1] - old->offsets[v];
+  }
+  for (int64_t e = 0; e < numPending; e++)
+  {
+    cursors[pending[e].fromVertex]++;
+  }
+  int64_t numEdges = parallelPrefixSum(pool, cursors, numVertices);
+  cursors[numVertices] = numEdges;
+
+  CSRGraph *csr = newCSRGraph(numVertices, numEdges);
+  if (!csr)
+  {
+    free(cursors);
+    return NULL;
+  }
+  memcpy(csr->offsets, cursors, (numVertices + 1) * sizeof(int64_t));
+
+  int numBlocks = 4 * poolSize(pool);
+  Merge merge = {old, csr, (old->numVertices + numBlocks - 1) / numBlocks};
+  parallelFor(pool, merge.blockSize > 0 ? numBlocks : 0, copyOldEdges, &merge);
+
+  for (int v = 0; v < old->numVertices; v++)
+  {
+    cursors[v] += old->offsets[v + 1] - old->offsets[v];
+  }
+  for (int64_t e = 0; e < numPending; e++)
+  {
+    int64_t slot = cursors[pending[e].fromVertex]++;
+    csr->targets[slot] = pending[e].toVertex;
+    csr->weights[slot] = pending[e].weight;
+  }
+  free(cursors);
+  return csr;
+}
+
+/*
+ * Takes all edges waiting in 'stream' into '*taken', those deferred by a
+ * failed compaction first. Returns false, and takes nothing, if memory
+ * could not be allocated.
+ * Precondition: the caller holds stream->ingestLock
+ */
+bool takePending(GraphStream *stream, Edge **taken, int64_t *numTaken)
+{
+  if (!stream->deferred)
+  {
+    *taken = stream->pending;
+    *numTaken = stream->numPending;
+    stream->pending = NULL;
+    stream->numPending = 0;
+    stream->pendingCapacity = 0;
+    return true;
+  }
+  if (stream->numPending > 0)
+  {
+    Edge *joined = (Edge *)realloc(
+        stream->deferred,
+        (stream->numDeferred + stream->numPending) * sizeof(Edge));
+    if (!joined)
+    {
+      return false;
+    }
+    memcpy(joined + stream->numDeferred, stream->pending,
+           stream->numPending * sizeof(Edge));
+    stream->deferred = joined;
+    stream->numDeferred += stream->numPending;
+    stream->numPending = 0;
+  }
+  *taken = stream->deferred;
+  *numTaken = stream->numDeferred;
+  stream->deferred = NULL;
+  stream->numDeferred = 0;
+  return true;
+}
+
+bool compactGraphStream(GraphStream *stream, ThreadPool *pool)
+{
+  pthread_mutex_lock(&stream->compactLock);
+
+  Edge *taken;
+  int64_t numTaken;
+  pthread_mutex_lock(&stream->ingestLock);
+  bool ok = takePending(stream, &taken, &numTaken);
+  int numVertices = stream->maxVertex + 1;
+  pthread_mutex_unlock(&stream->ingestLock);
+  if (!ok)
+  {
+    pthread_mutex_unlock(&stream->compactLock);
+    return false;
+  }
+
+  GraphSnapshot *old = acquireSnapshot(stream);
+  CSRGraph *csr = mergeEdges(old->graph, taken, numTaken, numVertices, pool);
+  GraphSnapshot *snapshot = csr ? newSnapshot(csr) : NULL;
+  releaseSnapshot(old);
+
+  ok = snapshot != NULL;
+  if (ok)
+  {
+    pthread_mutex_lock(&stream->publishLock);
+    GraphSnapshot *previous = stream->current;
+    stream->current = snapshot;
+    pthread_mutex_unlock(&stream->publishLock);
+    releaseSnapshot(previous);
+    free(taken);
+  }
+  else
+  {
+    // Keep the taken edges, without copying them, for the next compaction
+    deleteCSRGraph(csr);
+    pthread_mutex_lock(&stream->ingestLock);
+    stream->deferred = taken;
+    stream->numDeferred = numTaken;
+    pthread_mutex_unlock(&stream->ingestLock);
+  }
+
+  pthread_mutex_unlock(&stream->compactLock);
+  return ok;
+}
+
+GraphSnapshot *acquireSnapshot(GraphStream *stream)
+{
+  pthread_mutex_lock(&stream->publishLock);
+  GraphSnapshot *snapshot = stream->current;
+  atomic_fetch_add(&snapshot->holders, 1);
+  pthread_mutex_unlock(&stream->publishLock);
+  return snapshot;
+}
+
+CSRGraph *snapshotGraph(GraphSnapshot *snapshot)
+{
+  return snapshot->graph;
+}
+
+void releaseSnapshot(GraphSnapshot *snapshot)
+{
+  if (snapshot && atomic_fetch_sub(&snapshot->holders, 1) == 1)
+  {
+    deleteCSRGraph(snapshot->graph);
+    free(snapshot);
+  }
+}
+
+void deleteGraphStream(GraphStream *stream)
+{
+  if (stream)
+  {
+    releaseSnapshot(stream->current);
+    free(stream->pending);
+    free(stream->deferred);
+    pthread_mutex_destroy(&stream->ingestLock);
+    pthread_mutex_destroy(&stream->compactLock);
+    pthread_mutex_destroy(&stream->publishLock);
+    free(stream);
+  }
+}
@@ -0,0 +1,79 @@
+/*
+ * Header file for our streaming graph builder.
+ *
+ * A GraphStream accepts edges in batches, as (fromVertex, toVertex, weight)
+ * records, without knowing the number of vertices up front: the vertex
+ * table grows to the largest ID seen. New edges are buffered until
+ * compactGraphStream merges them into a new immutable CSRGraph snapshot.
+ *
+ * Algorithms run against a snapshot obtained with acquireSnapshot. Adding
+ * edges and compacting never wait for them, and a snapshot stays valid until
+ * it is released, even after newer ones have been published.
+ */
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "csr_graph.h"
+#include "graph.h"
+#include "threadpool.h"
+
+#ifndef __Graph_Stream_header
+#define __Graph_Stream_header
+
+typedef struct graph_stream GraphStream;
+typedef struct graph_snapshot GraphSnapshot;
+
+/*
+ * Returns a newly created, empty GraphStream, or NULL if memory could not
+ * be allocated. addStreamEdges reports when 'compactEvery' or more edges
+ * are waiting to be compacted.
+ * Precondition: compactEvery >= 1
+ */
+GraphStream* newGraphStream(int compactEvery);
+
+/*
+ * Appends the 'numEdges' edges in 'edges' to 'stream'. The whole batch is
+ * rejected if any edge has a negative weight, a vertex ID that is negative
+ * or INT_MAX, or if memory could not be allocated.
+ * Returns false if the batch was rejected, and sets 'compactNow' to true iff
+ * enough edges are waiting that compactGraphStream should be called.
+ * Safe to call from several threads at once.
+ */
+bool addStreamEdges(GraphStream* stream, Edge* edges, int numEdges,
+                    bool* compactNow);
+
+/*
+ * Merges all edges added so far into a new snapshot and publishes it, using
+ * the workers of 'pool' (which may be NULL). In each vertex's edge list,
+ * edges appear in the order they were added. Only one compaction runs at a
+ * time; others wait for it. Returns false if memory could not be allocated,
+ * in which case the pending edges are kept for the next compaction.
+ */
+bool compactGraphStream(GraphStream* stream, ThreadPool* pool);
+
+/*
+ * Returns the latest published snapshot of 'stream' (an empty graph before
+ * the first compaction). The caller must release it with releaseSnapshot.
+ */
+GraphSnapshot* acquireSnapshot(GraphStream* stream);
+
+/*
+ * Returns the read-only graph held by 'snapshot'.
+ */
+CSRGraph* snapshotGraph(GraphSnapshot* snapshot);
+
+/*
+ * Gives up the caller's hold on 'snapshot', freeing it if it is no longer
+ * the latest one and nobody else holds it.
+ */
+void releaseSnapshot(GraphSnapshot* snapshot);
+
+/*
+ * Frees all memory allocated for 'stream'. Snapshots still held by callers
+ * remain valid until released.
+ */
+void deleteGraphStream(GraphStream* stream);
+
+#endif
@@ -0,0 +1,460 @@
+/*
+ *  Randomized testing of our GraphStream (see graph_stream.h).
+ *
+ *  Several writer threads add random batches of edges while a compactor
+ *  thread and the writers themselves compact, and reader threads acquire
+ *  and check snapshots. The weight of every edge encodes the writer that
+ *  added it and its place in that writer's sequence, so a snapshot can be
+ *  checked on its own: its edge count never decreases from one snapshot to
+ *  the next, and each writer's edges appear in the order they were added
+ *  within every vertex. Writers also add batches that must be rejected, with
+ *  a negative weight or a vertex ID of INT_MAX. After the last compaction,
+ *  every accepted edge must be in the graph exactly once, and no edge of a
+ *  rejected batch. Prints the first mismatches found and exits with a
+ *  non-zero status if there were any.
+ *
+ *  ---------------------------------------------------------------------------
+ *   Compile:
+ *   gcc -Wall -Werror -pthread graph.c csr_graph.c threadpool.c \
+ *       graph_stream.c graph_stream_tester.c -o graph_stream_tester
+ *
+ *   Run:
+ *   ./graph_stream_tester [seed]
+ *
+ *   Also worth running built with -fsanitize=thread and with
+ *   -fsanitize=address,undefined.
+ *  ---------------------------------------------------------------------------
+ */
+
+#include <limits.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "csr_graph.h"
+#include "graph_stream.h"
+#include "threadpool.h"
+
+#define MAX_BATCH 64     // edges per batch
+#define REJECT_EVERY 16  // about one batch in this many must be rejected
+#define MAX_REPORTED 10  // mismatches printed before only counting them
+
+uint64_t seed;
+atomic_int numMismatches;
+
+/*
+ * Returns a pseudo-random number in 0, 1, ..., bound-1 (splitmix64), and
+ * advances 'state'.
+ */
+int randomBelow(uint64_t* state, int bound)
+{
+  uint64_t z = (*state += 0x9e3779b97f4a7c15ULL);
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+  z ^= z >> 31;
+  return (int)((z >> 33) % (uint64_t)bound);
+}
+
+/*
+ * Prints a mismatch found at vertex 'vertex', and counts it.
+ */
+void reportMismatch(const char* what, int vertex, int64_t expected,
+                    int64_t actual)
+{
+  if (atomic_fetch_add(&numMismatches, 1) < MAX_REPORTED)
+  {
+    printf("vertex %d: %s is %lld, expected %lld\n", vertex, what,
+           (long long)actual, (long long)expected);
+  }
+}
+
+/*
+ * What the threads of testStream share. Writer w gives its edge number s
+ * the weight s * numWriters + w, and records it in added[w][s], with a
+ * "from" vertex of -1 if its batch was rejected.
+ */
+typedef struct shared
+{
+  GraphStream* stream;
+  ThreadPool* pool;
+  int numWriters;
+  int edgesPerWriter;  // numbered edges each writer adds, accepted or not
+  int maxVertices;     // vertex IDs are below this
+  Edge** added;
+  atomic_int writersRunning;
+  atomic_int numCompactions;
+} Shared;
+
+typedef struct worker
+{
+  Shared* shared;
+  int index;
+} Worker;
+
+/*
+ * Checks 'csr', a snapshot of the stream of 'shared': targets are vertices,
+ * and within each vertex, the edges of each writer are in the order the
+ * writer added them. Uses 'lastEdge', of numWriters entries, as scratch.
+ */
+void checkSnapshot(Shared* shared, CSRGraph* csr, int* lastEdge)
+{
+  for (int v = 0; v < csr->numVertices; v++)
+  {
+    if (csr->offsets[v + 1] < csr->offsets[v])
+    {
+      reportMismatch("offset", v + 1, csr->offsets[v], csr->offsets[v + 1]);
+      return;
+    }
+    for (int w = 0; w < shared->numWriters; w++)
+    {
+      lastEdge[w] = -1;
+    }
+    for (int64_t e = csr->offsets[v]; e < csr->offsets[v + 1]; e++)
+    {
+      if (csr->targets[e] < 0 || csr->targets[e] >= csr->numVertices)
+      {
+        reportMismatch("edge target", v, 0, csr->targets[e]);
+      }
+      int writer = csr->weights[e] % shared->numWriters;
+      int number = csr->weights[e] / shared->numWriters;
+      if (csr->weights[e] < 0 || number >= shared->edgesPerWriter)
+      {
+        reportMismatch("edge weight", v, 0, csr->weights[e]);
+        continue;
+      }
+      if (number <= lastEdge[writer])
+      {
+        reportMismatch("writer's edge after its edge", v, lastEdge[writer] + 1,
+                       number);
+      }
+      lastEdge[writer] = number;
+    }
+  }
+  if (csr->offsets[csr->numVertices] != csr->numEdges)
+  {
+    reportMismatch("last offset", csr->numVertices, csr->numEdges,
+                   csr->offsets[csr->numVertices]);
+  }
+}
+
+/*
+ * Adds a batch of 'size' edges of writer 'writer', numbered from 'first'.
+ * One batch in about REJECT_EVERY gets a bad edge, and must be rejected.
+ */
+void addBatch(Shared* shared, int writer, int first, int size,
+              uint64_t* state)
+{
+  Edge batch[MAX_BATCH];
+  // Vertex IDs grow with the edge numbers, so the vertex table grows too
+  int range = 1 + (int64_t)shared->maxVertices * (first + size) /
+                      shared->edgesPerWriter;
+  for (int i = 0; i < size; i++)
+  {
+    int number = first + i;
+    batch[i].fromVertex = randomBelow(state, range);
+    batch[i].toVertex = randomBelow(state, range);
+    batch[i].weight = number * shared->numWriters + writer;
+  }
+  bool reject = randomBelow(state, REJECT_EVERY) == 0;
+  if (reject)
+  {
+    Edge* bad = &batch[randomBelow(state, size)];
+    switch (randomBelow(state, 3))
+    {
+      case 0:
+        bad->weight = -1 - bad->weight;
+        break;
+      case 1:
+        bad->fromVertex = INT_MAX;
+        break;
+      default:
+        bad->toVertex = INT_MAX;
+    }
+  }
+
+  bool compactNow;
+  bool accepted = addStreamEdges(shared->stream, batch, size, &compactNow);
+  if (accepted == reject)
+  {
+    reportMismatch(reject ? "bad batch accepted" : "good batch accepted", -1,
+                   !reject, accepted);
+  }
+  for (int i = 0; i < size; i++)
+  {
+    shared->added[writer][first + i] = batch[i];
+    if (!accepted)
+    {
+      shared->added[writer][first + i].fromVertex = -1;
+    }
+  }
+  if (compactNow && compactGraphStream(shared->stream, shared->pool))
+  {
+    atomic_fetch_add(&shared->numCompactions, 1);
+  }
+}
+
+void* writerMain(void* arg)
+{
+  Worker* worker = (Worker*)arg;
+  Shared* shared = worker->shared;
+  uint64_t state = seed * 1000003 + worker->index;
+  for (int first = 0; first < shared->edgesPerWriter;)
+  {
+    int size = 1 + randomBelow(&state, MAX_BATCH);
+    if (size > shared->edgesPerWriter - first)
+    {
+      size = shared->edgesPerWriter - first;
+    }
+    addBatch(shared, worker->index, first, size, &state);
+    first += size;
+  }
+  atomic_fetch_sub(&shared->writersRunning, 1);
+  return NULL;
+}
+
+void* compactorMain(void* arg)
+{
+  Shared* shared = (Shared*)arg;
+  while (atomic_load(&shared->writersRunning) > 0)
+  {
+    if (compactGraphStream(shared->stream, shared->pool))
+    {
+      atomic_fetch_add(&shared->numCompactions, 1);
+    }
+    sched_yield();  // let the writers add more before the next one
+  }
+  return NULL;
+}
+
+/*
+ * Acquires snapshots until the writers are done, checking each one, and
+ * that it has no fewer vertices or edges than the one before, which it
+ * keeps holding until the next is checked.
+ */
+void* readerMain(void* arg)
+{
+  Shared* shared = (Shared*)arg;
+  int* lastEdge = (int*)malloc(shared->numWriters * sizeof(int));
+  if (lastEdge == NULL)
+  {
+    printf("Memory allocation failed\n");
+    exit(EXIT_FAILURE);
+  }
+  GraphSnapshot* previous = acquireSnapshot(shared->stream);
+  while (atomic_load(&shared->writersRunning) > 0)
+  {
+    GraphSnapshot* snapshot = acquireSnapshot(shared->stream);
+    CSRGraph* csr = snapshotGraph(snapshot);
+    CSRGraph* old = snapshotGraph(previous);
+    checkSnapshot(shared, csr, lastEdge);
+    if (csr->numEdges < old->numEdges)
+    {
+      reportMismatch("edges in a later snapshot", -1, old->numEdges,
+                     csr->numEdges);
+    }
+    if (csr->numVertices < old->numVertices)
+    {
+      reportMismatch("vertices in a later snapshot", -1, old->numVertices,
+                     csr->numVertices);
+    }
+    releaseSnapshot(previous);
+    previous = snapshot;
+    sched_yield();
+  }
+  releaseSnapshot(previous);
+  free(lastEdge);
+  return NULL;
+}
+
+/*
+ * Checks that the graph 'csr' holds exactly the accepted edges of 'shared',
+ * each under its "from" vertex.
+ */
+void checkFinalGraph(Shared* shared, CSRGraph* csr)
+{
+  int maxVertex = -1;
+  int64_t numAccepted = 0;
+  for (int w = 0; w < shared->numWriters; w++)
+  {
+    for (int s = 0; s < shared->edgesPerWriter; s++)
+    {
+      Edge* edge = &shared->added[w][s];
+      if (edge->fromVertex >= 0)
+      {
+        numAccepted++;
+        maxVertex = edge->fromVertex > maxVertex ? edge->fromVertex : maxVertex;
+        maxVertex = edge->toVertex > maxVertex ? edge->toVertex : maxVertex;
+      }
+    }
+  }
+  if (csr->numEdges != numAccepted)
+  {
+    reportMismatch("number of edges", -1, numAccepted, csr->numEdges);
+  }
+  if (csr->numVertices != maxVertex + 1)
+  {
+    reportMismatch("number of vertices", -1, maxVertex + 1, csr->numVertices);
+  }
+
+  // Count each edge found against the edge its weight names
+  int* found = (int*)calloc((size_t)shared->numWriters * shared->edgesPerWriter,
+                            sizeof(int));
+  if (found == NULL)
+  {
+    printf("Memory allocation failed\n");
+    exit(EXIT_FAILURE);
+  }
+  for (int v = 0; v < csr->numVertices; v++)
+  {
+    for (int64_t e = csr->offsets[v]; e < csr->offsets[v + 1]; e++)
+    {
+      int weight = csr->weights[e];
+      if (weight < 0 || weight / shared->numWriters >= shared->edgesPerWriter)
+      {
+        continue;  // reported by checkSnapshot
+      }
+      Edge* edge = &shared->added[weight % shared->numWriters]
+                                 [weight / shared->numWriters];
+      found[weight]++;
+      if (edge->fromVertex < 0)
+      {
+        reportMismatch("edge of a rejected batch, weight", v, -1, weight);
+      }
+      else if (edge->fromVertex != v || edge->toVertex != csr->targets[e])
+      {
+        reportMismatch("edge with weight", v, edge->fromVertex, weight);
+      }
+    }
+  }
+  for (int w = 0; w < shared->numWriters; w++)
+  {
+    for (int s = 0; s < shared->edgesPerWriter; s++)
+    {
+      int weight = s * shared->numWriters + w;
+      if (shared->added[w][s].fromVertex >= 0 && found[weight] != 1)
+      {
+        reportMismatch("copies of the edge with weight",
+                       shared->added[w][s].fromVertex, 1, found[weight]);
+      }
+    }
+  }
+  free(found);
+}
+
+/*
+ * Has 'numWriters' writers add 'edgesPerWriter' edges each, between vertices
+ * below 'maxVertices', to a new GraphStream compacting every
+ * 'compactEvery' edges with a pool of 'poolThreads' workers (none if 0),
+ * while 'numReaders' readers check snapshots.
+ */
+void testStream(int numWriters, int numReaders, int edgesPerWriter,
+                int maxVertices, int compactEvery, int poolThreads)
+{
+  Shared shared = {newGraphStream(compactEvery),
+                   poolThreads > 0 ? newThreadPool(poolThreads) : NULL,
+                   numWriters, edgesPerWriter, maxVertices,
+                   (Edge**)malloc(numWriters * sizeof(Edge*))};
+  int numThreads = numWriters + numReaders + 1;
+  Worker* workers = (Worker*)malloc(numWriters * sizeof(Worker));
+  pthread_t* threads = (pthread_t*)malloc(numThreads * sizeof(pthread_t));
+  if (shared.stream == NULL || (poolThreads > 0 && shared.pool == NULL) ||
+      shared.added == NULL || workers == NULL || threads == NULL)
+  {
+    printf("Memory allocation failed\n");
+    exit(EXIT_FAILURE);
+  }
+  for (int w = 0; w < numWriters; w++)
+  {
+    shared.added[w] = (Edge*)malloc(edgesPerWriter * sizeof(Edge));
+    if (shared.added[w] == NULL)
+    {
+      printf("Memory allocation failed\n");
+      exit(EXIT_FAILURE);
+    }
+  }
+  atomic_init(&shared.writersRunning, numWriters);
+  atomic_init(&shared.numCompactions, 0);
+
+  int started = 0;
+  for (int w = 0; w < numWriters; w++)
+  {
+    workers[w] = (Worker){&shared, w};
+    started += pthread_create(&threads[w], NULL, writerMain, &workers[w]) == 0;
+  }
+  for (int r = 0; r < numReaders; r++)
+  {
+    started += pthread_create(&threads[numWriters + r], NULL, readerMain,
+                              &shared) == 0;
+  }
+  started += pthread_create(&threads[numThreads - 1], NULL, compactorMain,
+                            &shared) == 0;
+  if (started != numThreads)
+  {
+    printf("Could not create %d threads\n", numThreads);
+    exit(EXIT_FAILURE);
+  }
+  for (int t = 0; t < numThreads; t++)
+  {
+    pthread_join(threads[t], NULL);
+  }
+
+  if (!compactGraphStream(shared.stream, shared.pool))
+  {
+    reportMismatch("last compaction", -1, true, false);
+  }
+  GraphSnapshot* snapshot = acquireSnapshot(shared.stream);
+  int* lastEdge = (int*)malloc(numWriters * sizeof(int));
+  if (lastEdge == NULL)
+  {
+    printf("Memory allocation failed\n");
+    exit(EXIT_FAILURE);
+  }
+  checkSnapshot(&shared, snapshotGraph(snapshot), lastEdge);
+  checkFinalGraph(&shared, snapshotGraph(snapshot));
+
+  // The snapshot outlives the stream
+  deleteGraphStream(shared.stream);
+  if (snapshotGraph(snapshot)->offsets[0] != 0)
+  {
+    reportMismatch("first offset after deleting the stream", 0, 0,
+                   snapshotGraph(snapshot)->offsets[0]);
+  }
+  releaseSnapshot(snapshot);
+
+  printf("%d writer(s), %d reader(s), %d edges each, %d compactions, "
+         "pool of %d: %d mismatches so far\n",
+         numWriters, numReaders, edgesPerWriter,
+         atomic_load(&shared.numCompactions), poolThreads,
+         atomic_load(&numMismatches));
+  free(lastEdge);
+  for (int w = 0; w < numWriters; w++)
+  {
+    free(shared.added[w]);
+  }
+  free(shared.added);
+  free(threads);
+  free(workers);
+  deleteThreadPool(shared.pool);
+}
+
+int main(int argc, char* argv[])
+{
+  seed = argc > 1 ? strtoull(argv[1], NULL, 10) : 1;
+
+  testStream(1, 1, 1000, 50, 100, 0);
+  testStream(4, 2, 5000, 2000, 256, 0);
+  testStream(4, 2, 5000, 2000, 256, 2);
+  testStream(8, 1, 3000, 20, 64, 3);      // many edges per vertex
+  testStream(3, 2, 20000, 100000, 4096, 2);
+
+  if (atomic_load(&numMismatches) > 0)
+  {
+    printf("FAILED: %d mismatches\n", atomic_load(&numMismatches));
+    return EXIT_FAILURE;
+  }
+  printf("All GraphStream snapshots match the edges added.\n");
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,761 @@
+/*
+ *  Replays a trace of priority queue operations against one or more heap
+ *  implementations at full speed, checks every result against a reference
+ *  queue, and reports throughput.
+ *
+ *  Traces come in two formats:
+ *   - binary: HeapTraceRecords, as written by a -DMINHEAP_TRACE build (see
+ *     minheap.h), possibly for many heaps;
+ *   - text: the capacity first, as in minheap_tester's input files, then
+ *     commands for one heap, separated by any whitespace:
+ *       g           getMin
+ *       e           extractMin
+ *       i P ID      insert node ID with priority P
+ *       c ID P      decreasePriority of node ID to P
+ *       p ID        getPriority of node ID
+ *       r           clear the heap
+ *       q           end of trace
+ *     so "i 5 3" may also be written on three lines, as typed into the
+ *     tester.
+ *
+ *  With ties, implementations may extract different nodes than the traced
+ *  run did. The reference follows the implementation being checked rather
+ *  than the trace: a node an implementation returns is correct if the
+ *  reference holds it with the minimum priority.
+ *
+ *  Instead of a trace, -H runs the hold model on a heap of a given size:
+ *  fill it with random priorities, then repeatedly extract the minimum and
+ *  insert it again with a larger priority. Every extractMin sifts down to
+ *  near a leaf, so with sizes well beyond the last level cache this shows
+ *  the cost of the heap's memory layout.
+ *
+ *  ---------------------------------------------------------------------------
+ *   Compile:
+ *   gcc -Wall -Werror -O2 minheap.c bheap.c heap_replay.c -o heap_replay
+ *
+ *   Run:
+ *   ./heap_replay [-r runs] [-i implementation] [-n] trace
+ *   ./heap_replay [-r runs] [-i implementation] -H size
+ *
+ *   -r runs   timed replays per implementation (default 5)
+ *   -i name   only replay against implementation 'name'
+ *   -n        skip checking against the reference
+ *   -H size   time the hold model on 'size' nodes instead of a trace
+ *  ---------------------------------------------------------------------------
+ */
+
+#include <limits.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "bheap.h"
+#include "minheap.h"
+
+/*
+ * The operations replay needs from a heap implementation. Heaps hold nodes
+ * with IDs 0, ..., capacity-1.
+ */
+typedef struct heap_impl
+{
+  const char* name;
+  void* (*create)(int capacity);
+  void (*destroy)(void* heap);
+  bool (*insert)(void* heap, int priority, int id);
+  HeapNode (*getMin)(void* heap);
+  HeapNode (*extractMin)(void* heap);
+  bool (*decrease)(void* heap, int id, int priority);
+  bool (*priorityOf)(void* heap, int id, int* priority); // false if absent
+  void (*clear)(void* heap);
+  int (*size)(void* heap);
+} HeapImpl;
+
+/***** Our MinHeap **********************************************************/
+
+void* minHeapCreate(int capacity)
+{
+  return newHeap(capacity);
+}
+
+void minHeapDestroy(void* heap)
+{
+  deleteHeap((MinHeap*)heap);
+}
+
+bool minHeapInsert(void* heap, int priority, int id)
+{
+  return insert((MinHeap*)heap, priority, id);
+}
+
+HeapNode minHeapGetMin(void* heap)
+{
+  return getMin((MinHeap*)heap);
+}
+
+HeapNode minHeapExtractMin(void* heap)
+{
+  return extractMin((MinHeap*)heap);
+}
+
+bool minHeapDecrease(void* heap, int id, int priority)
+{
+  return decreasePriority((MinHeap*)heap, id, priority);
+}
+
+bool minHeapPriorityOf(void* heap, int id, int* priority)
+{
+  MinHeap* minHeap = (MinHeap*)heap;
+  int index = minHeap->indexMap[id];
+  if (index < ROOT_INDEX || index > minHeap->size ||
+      minHeap->arr[index].id != id)
+  {
+    return false;
+  }
+  *priority = getPriority(minHeap, id);
+  return true;
+}
+
+void minHeapClear(void* heap)
+{
+  clearHeap((MinHeap*)heap);
+}
+
+int minHeapSize(void* heap)
+{
+  return ((MinHeap*)heap)->size;
+}
+
+/***** Our BHeap ************************************************************/
+
+void* blockedHeapCreate(int capacity)
+{
+  BHeap* heap = newBHeap(capacity);
+  if (heap == NULL)
+  {
+    printf("Memory allocation failed\n");
+    exit(EXIT_FAILURE);
+  }
+  return heap;
+}
+
+void blockedHeapDestroy(void* heap)
+{
+  deleteBHeap((BHeap*)heap);
+}
+
+bool blockedHeapInsert(void* heap, int priority, int id)
+{
+  return bheapInsert((BHeap*)heap, priority, id);
+}
+
+HeapNode blockedHeapGetMin(void* heap)
+{
+  return bheapGetMin((BHeap*)heap);
+}
+
+HeapNode blockedHeapExtractMin(void* heap)
+{
+  return bheapExtractMin((BHeap*)heap);
+}
+
+bool blockedHeapDecrease(void* heap, int id, int priority)
+{
+  return bheapDecreasePriority((BHeap*)heap, id, priority);
+}
+
+bool blockedHeapPriorityOf(void* heap, int id, int* priority)
+{
+  return bheapPriorityOf((BHeap*)heap, id, priority);
+}
+
+void blockedHeapClear(void* heap)
+{
+  clearBHeap((BHeap*)heap);
+}
+
+int blockedHeapSize(void* heap)
+{
+  return bheapSize((BHeap*)heap);
+}
+
+/***** Reference: a tournament tree over IDs *******************************/
+
+/*
+ * A complete binary tree whose leaves are the IDs: each leaf holds its ID's
+ * priority (or ABSENT), and each inner node the leaf with the smallest
+ * priority below it. Simple enough to trust, and O(log n) per operation.
+ */
+#define ABSENT INT64_MAX
+
+typedef struct tournament
+{
+  int width;        // number of leaves, a power of 2 >= capacity
+  int size;
+  int64_t* keys;    // keys[id]: priority of 'id', or ABSENT
+  int* winner;      // winner[node]: ID with the smallest key below node
+} Tournament;
+
+/*
+ * Recomputes the winners on the path from the leaf of 'id' to the root.
+ */
+void replayMatches(Tournament* t, int id)
+{
+  for (int node = (t->width + id) / 2; node >= 1; node /= 2)
+  {
+    int left = t->winner[2 * node];
+    int right = t->winner[2 * node + 1];
+    t->winner[node] = t->keys[right] < t->keys[left] ? right : left;
+  }
+}
+
+void* tournamentCreate(int capacity)
+{
+  Tournament* t = (Tournament*)malloc(sizeof(Tournament));
+  if (t == NULL)
+  {
+    printf("Memory allocation failed\n");
+    exit(EXIT_FAILURE);
+  }
+  t->width = 1;
+  while (t->width < capacity)
+    t->width *= 2;
+  t->size = 0;
+  t->keys = (int64_t*)malloc(t->width * sizeof(int64_t));
+  t->winner = (int*)malloc(2 * t->width * sizeof(int));
+  if (!t->keys || !t->winner)
+  {
+    printf("Memory allocation failed\n");
+    exit(EXIT_FAILURE);
+  }
+  for (int id = 0; id < t->width; id++)
+  {
+    t->keys[id] = ABSENT;
+    t->winner[t->width + id] = id;
+  }
+  for (int node = t->width - 1; node >= 1; node--)
+    t->winner[node] = t->winner[2 * node];
+  return t;
+}
+
+void tournamentDestroy(void* heap)
+{
+  Tournament* t = (Tournament*)heap;
+  free(t->keys);
+  free(t->winner);
+  free(t);
+}
+
+/*
+ * Sets the key of 'id' in 't' to 'key'.
+ */
+void tournamentSet(Tournament* t, int id, int64_t key)
+{
+  t->size += (key != ABSENT) - (t->keys[id] != ABSENT);
+  t->keys[id] = key;
+  replayMatches(t, id);
+}
+
+bool tournamentInsert(void* heap, int priority, int id)
+{
+  Tournament* t = (Tournament*)heap;
+  if (id < 0 || id >= t->width || t->keys[id] != ABSENT)
+    return false;
+  tournamentSet(t, id, priority);
+  return true;
+}
+
+HeapNode tournamentGetMin(void* heap)
+{
+  Tournament* t = (Tournament*)heap;
+  HeapNode node = {(int)t->keys[t->winner[1]], t->winner[1]};
+  return node;
+}
+
+HeapNode tournamentExtractMin(void* heap)
+{
+  HeapNode node = tournamentGetMin(heap);
+  tournamentSet((Tournament*)heap, node.id, ABSENT);
+  return node;
+}
+
+bool tournamentDecrease(void* heap, int id, int priority)
+{
+  Tournament* t = (Tournament*)heap;
+  if (t->keys[id] == ABSENT || t->keys[id] <= priority)
+    return false;
+  tournamentSet(t, id, priority);
+  return true;
+}
+
+bool tournamentPriorityOf(void* heap, int id, int* priority)
+{
+  Tournament* t = (Tournament*)heap;
+  if (t->keys[id] == ABSENT)
+    return false;
+  *priority = (int)t->keys[id];
+  return true;
+}
+
+void tournamentClear(void* heap)
+{
+  Tournament* t = (Tournament*)heap;
+  for (int id = 0; id < t->width && t->size > 0; id++)
+    if (t->keys[id] != ABSENT)
+      tournamentSet(t, id, ABSENT);
+}
+
+int tournamentSize(void* heap)
+{
+  return ((Tournament*)heap)->size;
+}
+
+/***** Replay ***************************************************************/
+
+#define NUM_IMPLS 3
+
+HeapImpl impls[NUM_IMPLS] = {
+    {"minheap", minHeapCreate, minHeapDestroy, minHeapInsert, minHeapGetMin,
+     minHeapExtractMin, minHeapDecrease, minHeapPriorityOf, minHeapClear,
+     minHeapSize},
+    {"bheap", blockedHeapCreate, blockedHeapDestroy, blockedHeapInsert,
+     blockedHeapGetMin, blockedHeapExtractMin, blockedHeapDecrease,
+     blockedHeapPriorityOf, blockedHeapClear, blockedHeapSize},
+    {"tournament", tournamentCreate, tournamentDestroy, tournamentInsert,
+     tournamentGetMin, tournamentExtractMin, tournamentDecrease,
+     tournamentPriorityOf, tournamentClear, tournamentSize},
+};
+
+/*
+ * A trace in memory.
+ */
+typedef struct trace
+{
+  HeapTraceRecord* records;
+  long numRecords;
+  int numHeaps;      // heap numbers are 0, ..., numHeaps-1
+  int* capacities;   // capacities[h]: capacity heap h was created with
+} Trace;
+
+/*
+ * Prints why the replay of record 'index' of 'trace' failed, and returns
+ * false.
+ */
+bool mismatch(Trace* trace, long index, const char* what)
+{
+  HeapTraceRecord* r = &trace->records[index];
+  printf("  record %ld (%c heap %d id %d priority %d): %s\n", index, r->op,
+         r->heap, r->id, r->priority, what);
+  return false;
+}
+
+/*
+ * Replays 'trace' against 'impl'. If 'check' is true, every result is
+ * checked against a Tournament run alongside. Returns false at the first
+ * wrong result.
+ */
+bool replay(HeapImpl* impl, Trace* trace, bool check)
+{
+  void** heaps = (void**)calloc(trace->numHeaps, sizeof(void*));
+  void** refs = (void**)calloc(trace->numHeaps, sizeof(void*));
+  if (!heaps || !refs)
+  {
+    printf("Memory allocation failed\n");
+    exit(EXIT_FAILURE);
+  }
+  bool ok = true;
+  for (long i = 0; i < trace->numRecords && ok; i++)
+  {
+    HeapTraceRecord* r = &trace->records[i];
+    void* heap = heaps[r->heap];
+    void* ref = refs[r->heap];
+    if (r->op != TRACE_NEW && heap == NULL)
+    {
+      ok = mismatch(trace, i, "heap does not exist");
+      break;
+    }
+    int priority = 0;
+    int expected = 0;
+    switch (r->op)
+    {
+      case TRACE_NEW:
+        heaps[r->heap] = impl->create(r->priority);
+        if (check)
+          refs[r->heap] = tournamentCreate(r->priority);
+        break;
+      case TRACE_INSERT:
+        if (r->id < 0 || r->id >= trace->capacities[r->heap] ||
+            (check && tournamentPriorityOf(ref, r->id, &priority)))
+        {
+          ok = mismatch(trace, i, "ID is out of range or already queued");
+          break;
+        }
+        if (!impl->insert(heap, r->priority, r->id))
+          ok = mismatch(trace, i, "insert failed");
+        else if (check)
+          tournamentInsert(ref, r->priority, r->id);
+        break;
+      case TRACE_GET_MIN:
+      case TRACE_EXTRACT:
+      {
+        if (impl->size(heap) == 0)
+        {
+          if (check && tournamentSize(ref) != 0)
+            ok = mismatch(trace, i, "heap is empty but should not be");
+          break;
+        }
+        HeapNode node = r->op == TRACE_GET_MIN ? impl->getMin(heap)
+                                               : impl->extractMin(heap);
+        if (!check)
+          break;
+        if (tournamentSize(ref) == 0 ||
+            !tournamentPriorityOf(ref, node.id, &priority) ||
+            priority != node.priority ||
+            node.priority != tournamentGetMin(ref).priority)
+          ok = mismatch(trace, i, "returned a node that is not a minimum");
+        else if (r->op == TRACE_EXTRACT)
+          tournamentSet((Tournament*)ref, node.id, ABSENT);
+        break;
+      }
+      case TRACE_DECREASE:
+      {
+        if (r->id < 0 || r->id >= trace->capacities[r->heap])
+        {
+          ok = mismatch(trace, i, "ID is out of range");
+          break;
+        }
+        bool decreased = impl->decrease(heap, r->id, r->priority);
+        if (check && decreased != tournamentDecrease(ref, r->id, r->priority))
+          ok = mismatch(trace, i, "decrease succeeded or failed wrongly");
+        break;
+      }
+      case TRACE_PRIORITY:
+      {
+        if (r->id < 0 || r->id >= trace->capacities[r->heap])
+        {
+          ok = mismatch(trace, i, "ID is out of range");
+          break;
+        }
+        bool found = impl->priorityOf(heap, r->id, &priority);
+        if (check && (found != tournamentPriorityOf(ref, r->id, &expected) ||
+                      (found && priority != expected)))
+          ok = mismatch(trace, i, "wrong priority");
+        break;
+      }
+      case TRACE_CLEAR:
+        impl->clear(heap);
+        if (check)
+          tournamentClear(ref);
+        break;
+      case TRACE_DELETE:
+        impl->destroy(heap);
+        heaps[r->heap] = NULL;
+        if (check)
+        {
+          tournamentDestroy(ref);
+          refs[r->heap] = NULL;
+        }
+        break;
+      default:
+        ok = mismatch(trace, i, "unknown operation");
+    }
+  }
+
+  for (int h = 0; h < trace->numHeaps; h++)
+  {
+    if (heaps[h])
+      impl->destroy(heaps[h]);
+    if (refs[h])
+      tournamentDestroy(refs[h]);
+  }
+  free(heaps);
+  free(refs);
+  return ok;
+}
+
+/***** Reading traces *******************************************************/
+
+/*
+ * Appends 'record' to 'trace', growing it if needed.
+ */
+void appendRecord(Trace* trace, long* capacity, HeapTraceRecord record)
+{
+  if (trace->numRecords == *capacity)
+  {
+    *capacity = *capacity ? 2 * *capacity : 1024;
+    trace->records = (HeapTraceRecord*)realloc(
+        trace->records, *capacity * sizeof(HeapTraceRecord));
+    if (trace->records == NULL)
+    {
+      printf("Memory allocation failed\n");
+      exit(EXIT_FAILURE);
+    }
+  }
+  trace->records[trace->numRecords++] = record;
+}
+
+/*
+ * Parses the text trace in 'data' into 'trace'. Returns false if it is
+ * malformed.
+ */
+bool parseTextTrace(char* data, Trace* trace)
+{
+  long capacity = 0;
+  char* save = NULL;
+  char* token = strtok_r(data, " \t\r\n", &save);
+  if (token == NULL || atoi(token) < 0)
+    return false;
+  HeapTraceRecord record = {TRACE_NEW, 0, NOTHING, atoi(token), true};
+  appendRecord(trace, &capacity, record);
+
+  while ((token = strtok_r(NULL, " \t\r\n", &save)) != NULL && token[0] != 'q')
+  {
+    record.op = token[0];
+    int numArgs = strchr("ic", token[0]) ? 2 : token[0] == 'p' ? 1 : 0;
+    if (token[1] != '\0' || !strchr("geicpr", token[0]))
+      return false;
+    int args[2] = {NOTHING, NOTHING};
+    for (int a = 0; a < numArgs; a++)
+    {
+      token = strtok_r(NULL, " \t\r\n", &save);
+      if (token == NULL)
+        return false;
+      args[a] = atoi(token);
+    }
+    // "i priority id", but "c id priority"
+    record.id = record.op == TRACE_INSERT ? args[1] : args[0];
+    record.priority = record.op == TRACE_INSERT ? args[0] : args[1];
+    appendRecord(trace, &capacity, record);
+  }
+  return true;
+}
+
+/*
+ * Reads the trace at 'path' into 'trace', in either format. Returns false
+ * after printing why if it cannot be read.
+ */
+bool readTrace(const char* path, Trace* trace)
+{
+  FILE* f = fopen(path, "rb");
+  if (f == NULL)
+  {
+    printf("Unable to open the specified trace file: %s\n", path);
+    return false;
+  }
+  fseek(f, 0, SEEK_END);
+  long size = ftell(f);
+  fseek(f, 0, SEEK_SET);
+  char* data = (char*)malloc(size + 1);
+  if (data == NULL || fread(data, 1, size, f) != (size_t)size)
+  {
+    printf("Unable to read the specified trace file: %s\n", path);
+    free(data);
+    fclose(f);
+    return false;
+  }
+  fclose(f);
+  data[size] = '\0';
+
+  trace->records = NULL;
+  trace->numRecords = 0;
+  int32_t first = 0;
+  if (size >= (long)sizeof(int32_t))
+    memcpy(&first, data, sizeof(int32_t));
+  bool ok;
+  if (first == TRACE_NEW && size % sizeof(HeapTraceRecord) == 0)
+  {
+    trace->numRecords = size / sizeof(HeapTraceRecord);
+    trace->records = (HeapTraceRecord*)data;
+    data = NULL;
+    ok = true;
+  }
+  else
+  {
+    ok = parseTextTrace(data, trace);
+  }
+  free(data);
+
+  trace->numHeaps = 0;
+  for (long i = 0; ok && i < trace->numRecords; i++)
+  {
+    ok = trace->records[i].heap >= 0;
+    if (trace->records[i].heap >= trace->numHeaps)
+      trace->numHeaps = trace->records[i].heap + 1;
+  }
+  trace->capacities = (int*)calloc(trace->numHeaps + 1, sizeof(int));
+  for (long i = 0; ok && i < trace->numRecords; i++)
+    if (trace->records[i].op == TRACE_NEW)
+      trace->capacities[trace->records[i].heap] = trace->records[i].priority;
+  if (!ok)
+    printf("Malformed trace: %s\n", path);
+  return ok;
+}
+
+/***** The hold model *******************************************************/
+
+double nowSeconds(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/*
+ * Returns the next number of the splitmix64 sequence in 'state'.
+ */
+static uint64_t nextRandom(uint64_t* state)
+{
+  uint64_t z = (*state += 0x9e3779b97f4a7c15ULL);
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+  return z ^ (z >> 31);
+}
+
+/*
+ * Fills a new heap of 'impl' with 'size' nodes of random priorities, then
+ * 'size' times extracts the minimum and inserts it again with its priority
+ * increased by a random amount. Returns the seconds the extracts and
+ * inserts took, or a negative number if a smaller priority than the one
+ * before was ever extracted.
+ */
+double hold(HeapImpl* impl, int size, uint64_t seed)
+{
+  void* heap = impl->create(size);
+  for (int id = 0; id < size; id++)
+    impl->insert(heap, (int)(nextRandom(&seed) >> 34), id);
+
+  int last = INT_MIN;
+  bool ok = true;
+  double start = nowSeconds();
+  for (int i = 0; i < size; i++)
+  {
+    HeapNode node = impl->extractMin(heap);
+    ok = ok && node.priority >= last;
+    last = node.priority;
+    impl->insert(heap, node.priority + (int)(nextRandom(&seed) >> 44), node.id);
+  }
+  double seconds = nowSeconds() - start;
+  impl->destroy(heap);
+  return ok ? seconds : -1;
+}
+
+/***** Main *****************************************************************/
+
+int compareSeconds(const void* a, const void* b)
+{
+  double x = *(const double*)a;
+  double y = *(const double*)b;
+  return (x > y) - (x < y);
+}
+
+/*
+ * Times the hold model on 'size' nodes 'runs' times for each implementation,
+ * or only for 'only' if it is not NULL, and returns the exit status.
+ */
+int holdMain(int runs, const char* only, int size)
+{
+  printf("hold model on %d nodes\n", size);
+  double* seconds = (double*)malloc(runs * sizeof(double));
+  bool allOk = seconds != NULL;
+  for (int k = 0; k < NUM_IMPLS && allOk; k++)
+  {
+    HeapImpl* impl = &impls[k];
+    if (only && strcmp(only, impl->name) != 0)
+      continue;
+    for (int i = 0; i < runs && allOk; i++)
+    {
+      seconds[i] = hold(impl, size, i);
+      allOk = seconds[i] >= 0;
+    }
+    if (!allOk)
+    {
+      printf("%-12s FAILED\n", impl->name);
+      continue;
+    }
+    qsort(seconds, runs, sizeof(double), compareSeconds);
+    double median = seconds[runs / 2];
+    printf("%-12s median %.3f ms  %.1f ns per extractMin and insert\n",
+           impl->name, median * 1e3, median * 1e9 / size);
+  }
+  free(seconds);
+  return allOk ? 0 : 1;
+}
+
+int main(int argc, char* argv[])
+{
+  int runs = 5;
+  const char* only = NULL;
+  bool check = true;
+  int holdSize = 0;
+
+  int option;
+  while ((option = getopt(argc, argv, "r:i:nH:")) != -1)
+  {
+    switch (option)
+    {
+      case 'r':
+        runs = atoi(optarg);
+        break;
+      case 'i':
+        only = optarg;
+        break;
+      case 'n':
+        check = false;
+        break;
+      case 'H':
+        holdSize = atoi(optarg);
+        runs = holdSize > 0 ? runs : 0;
+        break;
+      default:
+        runs = 0;
+    }
+  }
+  if (runs < 1 || optind != argc - (holdSize > 0 ? 0 : 1))
+  {
+    printf("Usage: %s [-r runs] [-i implementation] [-n] trace\n"
+           "       %s [-r runs] [-i implementation] -H size\n",
+           argv[0], argv[0]);
+    return 1;
+  }
+  if (holdSize > 0)
+    return holdMain(runs, only, holdSize);
+
+  Trace trace;
+  if (!readTrace(argv[optind], &trace))
+    return 1;
+  printf("%ld operations on %d heaps\n", trace.numRecords, trace.numHeaps);
+
+  double* seconds = (double*)malloc(runs * sizeof(double));
+  bool allOk = seconds != NULL;
+  for (int k = 0; k < NUM_IMPLS && allOk; k++)
+  {
+    HeapImpl* impl = &impls[k];
+    if (only && strcmp(only, impl->name) != 0)
+      continue;
+    // the checked replay doubles as a warmup
+    if (!replay(impl, &trace, check))
+    {
+      printf("%-12s FAILED\n", impl->name);
+      allOk = false;
+      continue;
+    }
+    for (int i = 0; i < runs; i++)
+    {
+      double start = nowSeconds();
+      replay(impl, &trace, false);
+      seconds[i] = nowSeconds() - start;
+    }
+    qsort(seconds, runs, sizeof(double), compareSeconds);
+    double median = seconds[runs / 2];
+    printf("%-12s %s  median %.3f ms  %.1f ns/op  %.2f Mops/s\n", impl->name,
+           check ? "ok" : "unchecked", median * 1e3,
+           median * 1e9 / trace.numRecords, trace.numRecords / median / 1e6);
+  }
+
+  free(seconds);
+  free(trace.records);
+  free(trace.capacities);
+  return allOk ? 0 : 1;
+}
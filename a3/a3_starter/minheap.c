@@ -5,11 +5,137 @@
  * Based on implementation from A. Tafliovich
  */
 
+#if defined(MINHEAP_STATS) || defined(MINHEAP_TRACE)
+#include <pthread.h>
+#include <stdatomic.h>
+#include <string.h>
+#endif
+
 #include "minheap.h"
+#include "perf_counters.h"
 
 #define ROOT_INDEX 1
 #define NOTHING -1
 
+#ifdef MINHEAP_STATS
+#define COUNT(heap, field) ((heap)->stats.field++)
+#define RECORD_SIFT(heap, histogram, depth) \
+    recordSift((heap)->stats.histogram, depth)
+#else
+#define COUNT(heap, field) ((void)0)
+#define RECORD_SIFT(heap, histogram, depth) ((void)(depth))
+#endif
+
+#ifdef MINHEAP_TRACE
+#define TRACE(heap, op, id, priority, result) \
+    traceOperation(heap, op, id, priority, result)
+#else
+#define TRACE(heap, op, id, priority, result) ((void)0)
+#endif
+
+/*************************************************************************
+ ** Statistics and tracing (see minheap.h)
+ *************************************************************************/
+
+#ifdef MINHEAP_STATS
+HeapStats allHeapStats; // statistics of all deleted heaps
+pthread_mutex_t allHeapStatsLock = PTHREAD_MUTEX_INITIALIZER;
+
+/*
+ * Counts a sift that moved a node 'depth' levels in 'histogram'.
+ */
+void recordSift(long long *histogram, int depth)
+{
+    histogram[depth < SIFT_DEPTHS ? depth : SIFT_DEPTHS - 1]++;
+}
+
+/*
+ * Adds the statistics of minheap 'heap' to allHeapStats.
+ */
+void addHeapStats(MinHeap *heap)
+{
+    HeapStats *stats = &heap->stats;
+    pthread_mutex_lock(&allHeapStatsLock);
+    allHeapStats.inserts += stats->inserts;
+    allHeapStats.extracts += stats->extracts;
+    allHeapStats.swaps += stats->swaps;
+    allHeapStats.comparisons += stats->comparisons;
+    allHeapStats.decreaseHits += stats->decreaseHits;
+    allHeapStats.decreaseMisses += stats->decreaseMisses;
+    for (int d = 0; d < SIFT_DEPTHS; d++)
+    {
+        allHeapStats.siftUp[d] += stats->siftUp[d];
+        allHeapStats.siftDown[d] += stats->siftDown[d];
+    }
+    if (stats->peakSize > allHeapStats.peakSize)
+    {
+        allHeapStats.peakSize = stats->peakSize;
+    }
+    pthread_mutex_unlock(&allHeapStatsLock);
+}
+
+HeapStats getAllHeapStats(void)
+{
+    pthread_mutex_lock(&allHeapStatsLock);
+    HeapStats stats = allHeapStats;
+    pthread_mutex_unlock(&allHeapStatsLock);
+    return stats;
+}
+
+/*
+ * Prints the non-empty buckets of sift depth histogram 'histogram'.
+ */
+void printSiftHistogram(const char *name, long long *histogram, FILE *out)
+{
+    fprintf(out, "%s depths:", name);
+    for (int d = 0; d < SIFT_DEPTHS; d++)
+    {
+        if (histogram[d] > 0)
+        {
+            fprintf(out, " %d%s:%lld", d, d == SIFT_DEPTHS - 1 ? "+" : "",
+                    histogram[d]);
+        }
+    }
+    fprintf(out, "\n");
+}
+
+void printHeapStats(HeapStats *stats, FILE *out)
+{
+    fprintf(out, "inserts: %lld, extracts: %lld, peak size: %d\n",
+            stats->inserts, stats->extracts, stats->peakSize);
+    fprintf(out, "swaps: %lld, comparisons: %lld\n", stats->swaps,
+            stats->comparisons);
+    fprintf(out, "decreasePriority hits: %lld, misses: %lld\n",
+            stats->decreaseHits, stats->decreaseMisses);
+    printSiftHistogram("floatUp", stats->siftUp, out);
+    printSiftHistogram("heapify", stats->siftDown, out);
+}
+#endif
+
+#ifdef MINHEAP_TRACE
+FILE *_Atomic heapTrace; // where records go, or NULL
+atomic_int numTracedHeaps;
+
+void traceHeaps(FILE *trace)
+{
+    atomic_store(&heapTrace, trace);
+}
+
+/*
+ * Writes a record of operation 'op' on minheap 'heap' to the trace, if
+ * 'heap' is traced.
+ */
+void traceOperation(MinHeap *heap, int op, int id, int priority, int result)
+{
+    FILE *trace = atomic_load(&heapTrace);
+    if (trace != NULL && heap->traceId != NOTHING)
+    {
+        HeapTraceRecord record = {op, heap->traceId, id, priority, result};
+        fwrite(&record, sizeof(record), 1, trace);
+    }
+}
+#endif
+
 /*************************************************************************
  ** Suggested helper functions -- part of starter code
  *************************************************************************/
@@ -34,6 +160,7 @@ void swap(MinHeap *heap, int index1, int index2)
     {
         return;
     }
+    COUNT(heap, swaps);
     HeapNode temp = heap->arr[index1];
     heap->arr[index1] = heap->arr[index2];
     heap->arr[index2] = temp;
@@ -52,6 +179,19 @@ int priorityAt(MinHeap *heap, int nodeIndex)
     return heap->arr[nodeIndex].priority;
 }
 
+/*
+ * Writes 'node' to heap->arr[nodeIndex] and records its new index.
+ * Unlike swap, does no checks: the sifting loops below only call it with
+ * indices they know are valid, and move each node once instead of swapping
+ * it level by level.
+ * Precondition: 'nodeIndex' is a valid index of minheap 'heap'
+ */
+static inline void placeNode(MinHeap *heap, int nodeIndex, HeapNode node)
+{
+    heap->arr[nodeIndex] = node;
+    heap->indexMap[node.id] = nodeIndex;
+}
+
 /*
  * Returns the index of the parent of a node at index 'nodeIndex',
  * assuming it exists.
@@ -69,19 +209,28 @@ int getParentIdx(int nodeIndex)
  */
 void floatUp(MinHeap *heap, int nodeIndex)
 {
+    PERF_BEGIN(PERF_FLOAT_UP);
+    // Parents move down into the hole until the node fits, and then the
+    // node is written once
+    HeapNode node = heap->arr[nodeIndex];
+    int levels = 0;
     while (nodeIndex > ROOT_INDEX)
     {
         int parentIdx = getParentIdx(nodeIndex);
-        if (priorityAt(heap, nodeIndex) < priorityAt(heap, parentIdx))
-        {
-            swap(heap, nodeIndex, parentIdx);
-            nodeIndex = parentIdx;
-        }
-        else
+        HeapNode parent = heap->arr[parentIdx];
+        COUNT(heap, comparisons);
+        if (!(node.priority < parent.priority))
         {
             break;
         }
+        COUNT(heap, swaps);
+        placeNode(heap, nodeIndex, parent);
+        nodeIndex = parentIdx;
+        levels++;
     }
+    placeNode(heap, nodeIndex, node);
+    RECORD_SIFT(heap, siftUp, levels);
+    PERF_END(PERF_FLOAT_UP);
 }
 
 /*
@@ -144,29 +293,55 @@ HeapNode getMin(MinHeap *heap)
         printf("Heap is empty\n");
         exit(EXIT_FAILURE);
     }
+    TRACE(heap, TRACE_GET_MIN, heap->arr[ROOT_INDEX].id,
+          heap->arr[ROOT_INDEX].priority, true);
     return heap->arr[ROOT_INDEX];
 }
 
-void heapify(MinHeap *heap, int nodeIndex)
+/*
+ * Does the work of heapify, and returns the number of levels the node at
+ * 'nodeIndex' moved down.
+ * The smaller child moves up into the hole until the node fits, and then the
+ * node is written once. The smaller child is picked by adding the result of
+ * a comparison to the index, which compiles to a conditional move instead of
+ * a hard to predict branch. Ties keep the left child, and a child only moves
+ * up if it is strictly smaller than the node.
+ */
+int siftDown(MinHeap *heap, int nodeIndex)
 {
-    int smallest = nodeIndex;
-    int leftChild = getLeftChildIdx(nodeIndex);
-    int rightChild = getRightChildIdx(nodeIndex);
-
-    if (leftChild <= heap->size && priorityAt(heap, leftChild) < priorityAt(heap, smallest))
-    {
-        smallest = leftChild;
-    }
-    if (rightChild <= heap->size && priorityAt(heap, rightChild) < priorityAt(heap, smallest))
+    HeapNode *arr = heap->arr;
+    int size = heap->size;
+    HeapNode node = arr[nodeIndex];
+    int levels = 0;
+    int child = getLeftChildIdx(nodeIndex);
+    while (child <= size)
     {
-        smallest = rightChild;
+        if (child < size)
+        {
+            COUNT(heap, comparisons);
+            child += arr[child + 1].priority < arr[child].priority;
+        }
+        COUNT(heap, comparisons);
+        if (!(arr[child].priority < node.priority))
+        {
+            break;
+        }
+        COUNT(heap, swaps);
+        placeNode(heap, nodeIndex, arr[child]);
+        nodeIndex = child;
+        levels++;
+        child = getLeftChildIdx(nodeIndex);
     }
+    placeNode(heap, nodeIndex, node);
+    return levels;
+}
 
-    if (smallest != nodeIndex)
-    {
-        swap(heap, nodeIndex, smallest);
-        heapify(heap, smallest);
-    }
+void heapify(MinHeap *heap, int nodeIndex)
+{
+    PERF_BEGIN(PERF_HEAPIFY);
+    int levels = siftDown(heap, nodeIndex);
+    RECORD_SIFT(heap, siftDown, levels);
+    PERF_END(PERF_HEAPIFY);
 }
 
 HeapNode extractMin(MinHeap *heap)
@@ -177,7 +352,9 @@ HeapNode extractMin(MinHeap *heap)
         exit(EXIT_FAILURE);
     }
 
-    HeapNode minNode = getMin(heap);               // Get the root element
+    HeapNode minNode = heap->arr[ROOT_INDEX];      // Get the root element
+    TRACE(heap, TRACE_EXTRACT, minNode.id, minNode.priority, true);
+    COUNT(heap, extracts);
     heap->arr[ROOT_INDEX] = heap->arr[heap->size]; // Move the last element to root
     heap->indexMap[heap->arr[ROOT_INDEX].id] = ROOT_INDEX;
     heap->size--; // Decrement the size
@@ -193,10 +370,19 @@ bool insert(MinHeap *heap, int priority, int id)
 {
     if (heap->size == heap->capacity)
     {
+        TRACE(heap, TRACE_INSERT, id, priority, false);
         return false;
     }
+    TRACE(heap, TRACE_INSERT, id, priority, true);
+    COUNT(heap, inserts);
 
     heap->size++;
+#ifdef MINHEAP_STATS
+    if (heap->size > heap->stats.peakSize)
+    {
+        heap->stats.peakSize = heap->size;
+    }
+#endif
     int index = heap->size;
     heap->arr[index].priority = priority;
     heap->arr[index].id = id;
@@ -215,16 +401,22 @@ int getPriority(MinHeap *heap, int id)
         printf("Invalid ID at index: %d, heap cap: %d, heap size: %d\n", index, heap->capacity, heap->size);
         exit(EXIT_FAILURE);
     }
+    TRACE(heap, TRACE_PRIORITY, id, NOTHING, priorityAt(heap, index));
     return priorityAt(heap, index);
 }
 
 bool decreasePriority(MinHeap *heap, int id, int newPriority)
 {
     int index = indexOf(heap, id);
+    COUNT(heap, comparisons);
     if (!isValidIndex(heap, index) || priorityAt(heap, index) <= newPriority)
     {
+        TRACE(heap, TRACE_DECREASE, id, newPriority, false);
+        COUNT(heap, decreaseMisses);
         return false;
     }
+    TRACE(heap, TRACE_DECREASE, id, newPriority, true);
+    COUNT(heap, decreaseHits);
     heap->arr[index].priority = newPriority;
     floatUp(heap, index); // Ensure the node floats up if necessary
 
@@ -269,6 +461,15 @@ MinHeap *newHeap(int capacity)
     { // Initialize all entries
         heap->indexMap[i] = NOTHING;
     }
+#ifdef MINHEAP_STATS
+    memset(&heap->stats, 0, sizeof(HeapStats));
+#endif
+#ifdef MINHEAP_TRACE
+    heap->traceId = atomic_load(&heapTrace) != NULL
+                        ? atomic_fetch_add(&numTracedHeaps, 1)
+                        : NOTHING;
+    TRACE(heap, TRACE_NEW, NOTHING, capacity, true);
+#endif
     return heap;
 }
 
@@ -276,8 +477,18 @@ void deleteHeap(MinHeap *heap)
 {
     if (heap)
     {
+        TRACE(heap, TRACE_DELETE, NOTHING, NOTHING, true);
+#ifdef MINHEAP_STATS
+        addHeapStats(heap);
+#endif
         free(heap->arr);
         free(heap->indexMap);
         free(heap);
     }
 }
+
+void clearHeap(MinHeap *heap)
+{
+    TRACE(heap, TRACE_CLEAR, NOTHING, NOTHING, true);
+    heap->size = 0;
+}
@@ -9,6 +9,7 @@
  */
 
 #include <stdbool.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 
@@ -18,6 +19,57 @@
 #define ROOT_INDEX 1
 #define NOTHING -1
 
+/*
+ * Operation statistics, compiled in with -DMINHEAP_STATS. Every file that
+ * includes this header must then be compiled with the flag, since it adds
+ * a field to MinHeap.
+ */
+#define SIFT_DEPTHS 32  // sift depths >= SIFT_DEPTHS - 1 share the last bucket
+
+typedef struct heap_stats {
+  long long inserts;
+  long long extracts;
+  long long swaps;           // nodes exchanged while sifting
+  long long comparisons;     // priority comparisons
+  long long decreaseHits;    // decreasePriority calls that returned true
+  long long decreaseMisses;  // decreasePriority calls that returned false
+  long long siftUp[SIFT_DEPTHS];    // siftUp[d]: floatUps that moved d levels
+  long long siftDown[SIFT_DEPTHS];  // siftDown[d]: heapifys that moved d levels
+  int peakSize;              // largest size the heap reached
+} HeapStats;
+
+/*
+ * One operation in a heap trace, written with -DMINHEAP_TRACE. 'op' is one
+ * of the TRACE_* letters; 'heap' numbers the heap it was applied to, in the
+ * order heaps were created; 'id', 'priority' and 'result' are its arguments
+ * and outcome:
+ *   TRACE_NEW       priority: capacity
+ *   TRACE_INSERT    id, priority; result: whether it succeeded
+ *   TRACE_GET_MIN   id, priority of the node returned
+ *   TRACE_EXTRACT   id, priority of the node returned
+ *   TRACE_DECREASE  id, new priority; result: whether it succeeded
+ *   TRACE_PRIORITY  id; result: its priority
+ *   TRACE_CLEAR     (no arguments)
+ *   TRACE_DELETE    (no arguments)
+ * Records are written in host byte order.
+ */
+#define TRACE_NEW 'n'
+#define TRACE_INSERT 'i'
+#define TRACE_GET_MIN 'g'
+#define TRACE_EXTRACT 'e'
+#define TRACE_DECREASE 'c'
+#define TRACE_PRIORITY 'p'
+#define TRACE_CLEAR 'r'
+#define TRACE_DELETE 'x'
+
+typedef struct heap_trace_record {
+  int32_t op;
+  int32_t heap;
+  int32_t id;
+  int32_t priority;
+  int32_t result;
+} HeapTraceRecord;
+
 typedef struct heap_node {
   int priority;  // priority of this node
   int id;        // the unique ID of this node (vertex ID); (0 <= id < size
@@ -28,6 +80,12 @@ typedef struct min_heap {
   int capacity;   // the number of nodes that can be stored in this heap
   HeapNode* arr;  // the array that stores the nodes of this heap
   int* indexMap;  // indexMap[id] is the index of node with ID id in array arr
+#ifdef MINHEAP_STATS
+  HeapStats stats;
+#endif
+#ifdef MINHEAP_TRACE
+  int traceId;    // number of this heap in the trace, or NOTHING
+#endif
 } MinHeap;
 
 /*
@@ -90,4 +148,32 @@ MinHeap* newHeap(int capacity);
  */
 void deleteHeap(MinHeap* heap);
 
+/*
+ * Removes all nodes from minheap 'heap'.
+ */
+void clearHeap(MinHeap* heap);
+
+#ifdef MINHEAP_STATS
+/*
+ * Returns the statistics of all heaps deleted so far, added up; peakSize
+ * is the largest of their peak sizes.
+ */
+HeapStats getAllHeapStats(void);
+
+/*
+ * Prints 'stats' to 'out', including both sift depth histograms.
+ */
+void printHeapStats(HeapStats* stats, FILE* out);
+#endif
+
+#ifdef MINHEAP_TRACE
+/*
+ * Appends a HeapTraceRecord to 'trace' for every operation on every heap
+ * created from now on, until traceHeaps(NULL) is called. 'trace' must be
+ * open for binary writing, and stays open. Heaps may be used from several
+ * threads: each record is written with a single fwrite.
+ */
+void traceHeaps(FILE* trace);
+#endif
+
 #endif
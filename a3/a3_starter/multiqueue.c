@@ -0,0 +1,336 @@
+/*
+ * Our MultiQueue implementation.
+ *
+ * Each heap of a MultiQueue is a MinHeap whose node IDs are slots in the
+ * heap's 'ids', where the queue's IDs are kept: a MinHeap needs room for
+ * every ID it may hold, and the heaps together only hold 'capacity' nodes.
+ * heapOf[id] says which heap holds node 'id'. It is only changed under the
+ * lock of that heap, so a thread that read it checks it again once it holds
+ * the lock.
+ *
+ * The minimum priority and size of every heap are published in atomics, so
+ * that multiExtractMin can compare two heaps without locking either.
+ */
+
+#include <limits.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <string.h>
+
+#include "multiqueue.h"
+
+#define CACHE_LINE 64
+#define INSERT_TRIES 4  // random heaps tried per heap before sweeping them all
+
+/*
+ * One heap of a MultiQueue, on cache lines of its own.
+ */
+typedef struct locked_heap
+{
+  _Alignas(CACHE_LINE) atomic_bool locked;
+  atomic_int top;   // priority of the minimum of 'heap', if it is non-empty
+  atomic_int size;  // number of nodes in 'heap'
+  MinHeap *heap;    // IDs are slots in 'ids'
+  int *ids;         // ids[slot]: ID of the node in that slot
+  int *freeSlots;   // stack of slots not in use
+  int numFree;
+} LockedHeap;
+
+struct multi_queue
+{
+  int numHeaps;
+  int capacity;
+  LockedHeap *heaps;
+  atomic_int *heapOf;  // heapOf[id]: heap holding node 'id', or NOTHING
+  int *slotOf;         // slotOf[id]: slot of node 'id' in that heap
+};
+
+_Thread_local uint64_t heapRandomState; // 0 until the thread first needs it
+atomic_ullong heapRandomSeed;
+
+/*
+ * Returns the index of a pseudo-random heap of 'queue'. Each thread has its
+ * own splitmix64 sequence.
+ */
+static int randomHeap(MultiQueue *queue)
+{
+  if (heapRandomState == 0)
+  {
+    heapRandomState =
+        atomic_fetch_add(&heapRandomSeed, 1) * 0x2545f4914f6cdd1dull + 1;
+  }
+  uint64_t z = (heapRandomState += 0x9e3779b97f4a7c15ull);
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+  z ^= z >> 31;
+  return (int)(((z >> 32) * (uint64_t)queue->numHeaps) >> 32);
+}
+
+/*
+ * Locks 'heap' if no thread holds its lock. Returns true if it did.
+ */
+static inline bool tryLockHeap(LockedHeap *heap)
+{
+  return !atomic_load_explicit(&heap->locked, memory_order_relaxed) &&
+         !atomic_exchange_explicit(&heap->locked, true, memory_order_acquire);
+}
+
+/*
+ * Locks 'heap', waiting for the thread that holds its lock if needed.
+ */
+static void lockHeap(LockedHeap *heap)
+{
+  while (!tryLockHeap(heap))
+  {
+    sched_yield();
+  }
+}
+
+static inline void unlockHeap(LockedHeap *heap)
+{
+  atomic_store_explicit(&heap->locked, false, memory_order_release);
+}
+
+/*
+ * Publishes the minimum and size of 'heap' after it changed.
+ * Precondition: the calling thread holds the lock of 'heap'
+ */
+static void publishHeap(LockedHeap *heap)
+{
+  int size = heap->heap->size;
+  if (size > 0)
+  {
+    atomic_store_explicit(&heap->top, getMin(heap->heap).priority,
+                          memory_order_relaxed);
+  }
+  atomic_store_explicit(&heap->size, size, memory_order_release);
+}
+
+/*
+ * Inserts node 'id' into heap 'h' of 'queue', if it has room. Returns true
+ * if it did.
+ * Precondition: the calling thread holds the lock of heap 'h'
+ */
+static bool insertLocked(MultiQueue *queue, int h, int priority, int id)
+{
+  LockedHeap *heap = &queue->heaps[h];
+  if (heap->numFree == 0)
+  {
+    return false;
+  }
+  int slot = heap->freeSlots[--heap->numFree];
+  heap->ids[slot] = id;
+  queue->slotOf[id] = slot;
+  insert(heap->heap, priority, slot);
+  atomic_store_explicit(&queue->heapOf[id], h, memory_order_relaxed);
+  publishHeap(heap);
+  return true;
+}
+
+/*
+ * Returns the minimum priority of heap 'h' of 'queue' as last published,
+ * or a value larger than any priority if the heap is empty.
+ */
+static inline int64_t heapTop(MultiQueue *queue, int h)
+{
+  LockedHeap *heap = &queue->heaps[h];
+  if (atomic_load_explicit(&heap->size, memory_order_acquire) == 0)
+  {
+    return INT64_MAX;
+  }
+  return atomic_load_explicit(&heap->top, memory_order_relaxed);
+}
+
+MultiQueue *newMultiQueue(int numThreads, int capacity)
+{
+  MultiQueue *queue = (MultiQueue *)calloc(1, sizeof(MultiQueue));
+  if (!queue)
+  {
+    return NULL;
+  }
+  queue->numHeaps = MULTIQUEUE_FACTOR * numThreads;
+  queue->capacity = capacity;
+
+  // Random inserts fill the heaps unevenly, so each gets room for twice its
+  // share, and a little more for small queues
+  int64_t share =
+      ((int64_t)capacity + queue->numHeaps - 1) / queue->numHeaps;
+  int heapCapacity = 2 * share + 64 < capacity ? 2 * share + 64 : capacity;
+
+  queue->heaps = (LockedHeap *)aligned_alloc(
+      CACHE_LINE, queue->numHeaps * sizeof(LockedHeap));
+  if (queue->heaps)
+  {
+    // Cleared first, so that deleteMultiQueue can free a partial queue
+    memset(queue->heaps, 0, queue->numHeaps * sizeof(LockedHeap));
+  }
+  queue->heapOf = (atomic_int *)malloc(capacity * sizeof(atomic_int));
+  queue->slotOf = (int *)malloc(capacity * sizeof(int));
+  if (!queue->heaps || !queue->heapOf || !queue->slotOf)
+  {
+    deleteMultiQueue(queue);
+    return NULL;
+  }
+  for (int id = 0; id < capacity; id++)
+  {
+    atomic_init(&queue->heapOf[id], NOTHING);
+  }
+
+  for (int h = 0; h < queue->numHeaps; h++)
+  {
+    LockedHeap *heap = &queue->heaps[h];
+    atomic_init(&heap->locked, false);
+    atomic_init(&heap->top, 0);
+    atomic_init(&heap->size, 0);
+    heap->heap = newHeap(heapCapacity);
+    heap->ids = (int *)malloc(heapCapacity * sizeof(int));
+    heap->freeSlots = (int *)malloc(heapCapacity * sizeof(int));
+    if (!heap->heap || !heap->ids || !heap->freeSlots)
+    {
+      deleteMultiQueue(queue);
+      return NULL;
+    }
+    for (int slot = heapCapacity - 1; slot >= 0; slot--)
+    {
+      heap->freeSlots[heap->numFree++] = slot;
+    }
+  }
+  return queue;
+}
+
+bool multiInsert(MultiQueue *queue, int priority, int id)
+{
+  for (int tries = 0; tries < INSERT_TRIES * queue->numHeaps; tries++)
+  {
+    int h = randomHeap(queue);
+    if (tryLockHeap(&queue->heaps[h]))
+    {
+      bool inserted = insertLocked(queue, h, priority, id);
+      unlockHeap(&queue->heaps[h]);
+      if (inserted)
+      {
+        return true;
+      }
+    }
+  }
+
+  // The heaps are all either busy or full: go through them in turn
+  for (int h = 0; h < queue->numHeaps; h++)
+  {
+    lockHeap(&queue->heaps[h]);
+    bool inserted = insertLocked(queue, h, priority, id);
+    unlockHeap(&queue->heaps[h]);
+    if (inserted)
+    {
+      return true;
+    }
+  }
+  return false;
+}
+
+bool multiExtractMin(MultiQueue *queue, HeapNode *node)
+{
+  int emptyTries = 0;
+  while (true)
+  {
+    int a = randomHeap(queue);
+    int b = randomHeap(queue);
+    int h = heapTop(queue, b) < heapTop(queue, a) ? b : a;
+    LockedHeap *heap = &queue->heaps[h];
+
+    if (atomic_load_explicit(&heap->size, memory_order_acquire) == 0)
+    {
+      // Both looked empty; after as many tries as there are heaps, make sure
+      if (++emptyTries < queue->numHeaps)
+      {
+        continue;
+      }
+      if (multiQueueSize(queue) == 0)
+      {
+        return false;
+      }
+      emptyTries = 0;
+      continue;
+    }
+    if (!tryLockHeap(heap))
+    {
+      continue;
+    }
+    if (heap->heap->size == 0)
+    {
+      unlockHeap(heap);
+      continue;
+    }
+
+    HeapNode min = extractMin(heap->heap);
+    heap->freeSlots[heap->numFree++] = min.id;
+    node->priority = min.priority;
+    node->id = heap->ids[min.id];
+    atomic_store_explicit(&queue->heapOf[node->id], NOTHING,
+                          memory_order_relaxed);
+    publishHeap(heap);
+    unlockHeap(heap);
+    return true;
+  }
+}
+
+bool multiDecreasePriority(MultiQueue *queue, int id, int newPriority)
+{
+  while (true)
+  {
+    int h = atomic_load_explicit(&queue->heapOf[id], memory_order_relaxed);
+    if (h == NOTHING)
+    {
+      return false;
+    }
+    LockedHeap *heap = &queue->heaps[h];
+    lockHeap(heap);
+    // The node may have been extracted, or moved to another heap, meanwhile
+    if (atomic_load_explicit(&queue->heapOf[id], memory_order_relaxed) == h)
+    {
+      bool decreased =
+          decreasePriority(heap->heap, queue->slotOf[id], newPriority);
+      if (decreased)
+      {
+        publishHeap(heap);
+      }
+      unlockHeap(heap);
+      return decreased;
+    }
+    unlockHeap(heap);
+  }
+}
+
+int multiQueueSize(MultiQueue *queue)
+{
+  int size = 0;
+  for (int h = 0; h < queue->numHeaps; h++)
+  {
+    size += atomic_load_explicit(&queue->heaps[h].size, memory_order_relaxed);
+  }
+  return size;
+}
+
+void deleteMultiQueue(MultiQueue *queue)
+{
+  if (!queue)
+  {
+    return;
+  }
+  if (queue->heaps)
+  {
+    for (int h = 0; h < queue->numHeaps; h++)
+    {
+      if (queue->heaps[h].heap)
+      {
+        deleteHeap(queue->heaps[h].heap);
+      }
+      free(queue->heaps[h].ids);
+      free(queue->heaps[h].freeSlots);
+    }
+  }
+  free(queue->heaps);
+  free(queue->heapOf);
+  free(queue->slotOf);
+  free(queue);
+}
@@ -0,0 +1,77 @@
+/*
+ * Header file for our MultiQueue, a relaxed concurrent priority queue.
+ *
+ * A MultiQueue for P threads is MULTIQUEUE_FACTOR * P MinHeaps, each
+ * guarded by its own try-lock. multiInsert puts a node into a random heap;
+ * multiExtractMin looks at the minima of two random heaps and extracts the
+ * smaller one. A thread that finds a heap locked simply picks another, so
+ * threads never wait for each other, and nothing is shared by all of them.
+ *
+ * The price is that multiExtractMin need not return the minimum: it
+ * returns a node of small rank, the expected rank being O(number of
+ * heaps), independently of the number of nodes. Parallel schedulers such
+ * as Dijkstra with relaxed extraction tolerate this.
+ *
+ * As in a MinHeap, IDs are unique and less than the capacity, and any
+ * thread can decrease the priority of a node by its ID.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "minheap.h"
+
+#ifndef __MultiQueue_header
+#define __MultiQueue_header
+
+#define MULTIQUEUE_FACTOR 2  // heaps per thread, the 'c' of c * P
+
+typedef struct multi_queue MultiQueue;
+
+/*
+ * Returns a newly created empty MultiQueue for nodes with IDs
+ * 0, 1, ..., capacity-1, used by up to 'numThreads' threads at a time.
+ * Returns NULL if memory could not be allocated.
+ * Precondition: numThreads >= 1, capacity >= 0
+ */
+MultiQueue* newMultiQueue(int numThreads, int capacity);
+
+/*
+ * Inserts a node with priority 'priority' and ID 'id' into 'queue'.
+ * Returns: true if insert was successful, false otherwise
+ * Precondition: 0 <= 'id' < capacity of 'queue', and no node with ID 'id'
+ *               is in 'queue' or being inserted into it
+ */
+bool multiInsert(MultiQueue* queue, int priority, int id);
+
+/*
+ * Removes a node of small priority from 'queue' into '*node'.
+ * Returns: true if a node was removed, false if every heap of 'queue' was
+ * found empty (which, with concurrent inserts, does not mean that 'queue'
+ * is empty once this returns)
+ */
+bool multiExtractMin(MultiQueue* queue, HeapNode* node);
+
+/*
+ * Sets priority of node with ID 'id' in 'queue' to 'newPriority', if such a
+ * node exists in 'queue' and its priority is larger than 'newPriority', and
+ * returns True. Has no effect and returns False, otherwise.
+ * Precondition: 0 <= 'id' < capacity of 'queue'
+ */
+bool multiDecreasePriority(MultiQueue* queue, int id, int newPriority);
+
+/*
+ * Returns the number of nodes in 'queue'. Exact only while no other thread
+ * is changing it.
+ */
+int multiQueueSize(MultiQueue* queue);
+
+/*
+ * Frees all memory allocated for 'queue'.
+ * Precondition: no other thread is using 'queue'
+ */
+void deleteMultiQueue(MultiQueue* queue);
+
+#endif
@@ -0,0 +1,236 @@
+/*
+ * Hardware performance counter instrumentation.
+ *
+ * Each thread opens its own group of counters, with the first one that
+ * could be opened as the group leader, so that one read() returns them all
+ * as counted over exactly the same instructions. The group is kept in a
+ * pthread key, whose destructor closes it when the thread exits.
+ *
+ * Compiled only with -DPERF_COUNTERS; see perf_counters.h.
+ */
+
+#ifdef PERF_COUNTERS
+
+#include <linux/perf_event.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <string.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include "perf_counters.h"
+
+/*
+ * One hardware event as perf_event_open wants it.
+ */
+typedef struct perf_event_kind
+{
+  const char *name;
+  uint32_t type;
+  uint64_t config;
+} PerfEventKind;
+
+const PerfEventKind perfEvents[NUM_PERF_EVENTS] = {
+    {"cycles", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+    {"instructions", PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+    {"L1D_misses", PERF_TYPE_HW_CACHE,
+     PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+         (PERF_COUNT_HW_CACHE_RESULT_MISS << 16)},
+    {"LLC_misses", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES},
+    {"branch_misses", PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES},
+};
+
+const char *perfRegionNames[NUM_PERF_REGIONS] = {"heapify", "floatUp",
+                                                 "relax", "load_graph"};
+
+/*
+ * The counters of one thread, and the readings taken when it entered each
+ * region.
+ */
+typedef struct perf_thread
+{
+  int fds[NUM_PERF_EVENTS];   // -1 if the event could not be opened
+  int slots[NUM_PERF_EVENTS]; // position of the event in a group read
+  int leader;                 // fd of the group leader, or -1 if none
+  int numOpen;
+  int depth[NUM_PERF_REGIONS]; // how deeply nested the thread is in a region
+  uint64_t start[NUM_PERF_REGIONS][NUM_PERF_EVENTS];
+} PerfThread;
+
+pthread_once_t perfOnce = PTHREAD_ONCE_INIT;
+pthread_key_t perfKey;
+atomic_ullong perfTotals[NUM_PERF_REGIONS][NUM_PERF_EVENTS];
+atomic_ullong perfCalls[NUM_PERF_REGIONS];
+atomic_bool perfOpened[NUM_PERF_EVENTS]; // some thread opened this event
+atomic_bool perfWarned;
+
+/*
+ * Closes the counters of a thread that exits.
+ */
+void closePerfThread(void *state)
+{
+  PerfThread *thread = (PerfThread *)state;
+  for (int e = NUM_PERF_EVENTS - 1; e >= 0; e--)
+  {
+    if (thread->fds[e] != -1)
+    {
+      close(thread->fds[e]);
+    }
+  }
+  free(thread);
+}
+
+void createPerfKey(void)
+{
+  pthread_key_create(&perfKey, closePerfThread);
+}
+
+/*
+ * Returns the counters of the calling thread, opening them on first use,
+ * or NULL if memory could not be allocated.
+ */
+PerfThread *perfThread(void)
+{
+  pthread_once(&perfOnce, createPerfKey);
+  PerfThread *thread = (PerfThread *)pthread_getspecific(perfKey);
+  if (thread != NULL)
+  {
+    return thread;
+  }
+  thread = (PerfThread *)calloc(1, sizeof(PerfThread));
+  if (thread == NULL)
+  {
+    return NULL;
+  }
+
+  thread->leader = -1;
+  for (int e = 0; e < NUM_PERF_EVENTS; e++)
+  {
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = perfEvents[e].type;
+    attr.config = perfEvents[e].config;
+    attr.read_format = PERF_FORMAT_GROUP;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    int fd =
+        (int)syscall(SYS_perf_event_open, &attr, 0, -1, thread->leader, 0);
+    thread->fds[e] = fd;
+    thread->slots[e] = -1;
+    if (fd != -1)
+    {
+      thread->leader = thread->leader == -1 ? fd : thread->leader;
+      thread->slots[e] = thread->numOpen++;
+      atomic_store(&perfOpened[e], true);
+    }
+  }
+  if (thread->leader == -1 && !atomic_exchange(&perfWarned, true))
+  {
+    fprintf(stderr, "perf_event_open failed: only counting calls\n");
+  }
+  pthread_setspecific(perfKey, thread);
+  return thread;
+}
+
+/*
+ * Reads the current value of every counter of 'thread' into 'values';
+ * events that could not be opened read as 0.
+ */
+void readPerfCounters(PerfThread *thread, uint64_t *values)
+{
+  uint64_t group[1 + NUM_PERF_EVENTS] = {0};
+  if (thread->leader != -1 &&
+      read(thread->leader, group, sizeof(group)) <= 0)
+  {
+    memset(group, 0, sizeof(group));
+  }
+  for (int e = 0; e < NUM_PERF_EVENTS; e++)
+  {
+    values[e] = thread->slots[e] == -1 ? 0 : group[1 + thread->slots[e]];
+  }
+}
+
+void perfBegin(int region)
+{
+  PerfThread *thread = perfThread();
+  if (thread != NULL && thread->depth[region]++ == 0)
+  {
+    atomic_fetch_add_explicit(&perfCalls[region], 1, memory_order_relaxed);
+    readPerfCounters(thread, thread->start[region]);
+  }
+}
+
+void perfEnd(int region)
+{
+  PerfThread *thread = perfThread();
+  if (thread == NULL || --thread->depth[region] > 0)
+  {
+    return;
+  }
+  uint64_t now[NUM_PERF_EVENTS];
+  readPerfCounters(thread, now);
+  for (int e = 0; e < NUM_PERF_EVENTS; e++)
+  {
+    atomic_fetch_add_explicit(&perfTotals[region][e],
+                              now[e] - thread->start[region][e],
+                              memory_order_relaxed);
+  }
+}
+
+void perfReport(FILE *out)
+{
+  fprintf(out, "%-12s %12s", "region", "calls");
+  for (int e = 0; e < NUM_PERF_EVENTS; e++)
+  {
+    fprintf(out, " %14s", perfEvents[e].name);
+  }
+  fprintf(out, " %6s\n", "IPC");
+
+  for (int r = 0; r < NUM_PERF_REGIONS; r++)
+  {
+    unsigned long long calls = atomic_load(&perfCalls[r]);
+    if (calls == 0)
+    {
+      continue;
+    }
+    fprintf(out, "%-12s %12llu", perfRegionNames[r], calls);
+    for (int e = 0; e < NUM_PERF_EVENTS; e++)
+    {
+      if (atomic_load(&perfOpened[e]))
+      {
+        fprintf(out, " %14llu", atomic_load(&perfTotals[r][e]));
+      }
+      else
+      {
+        fprintf(out, " %14s", "n/a");
+      }
+    }
+    unsigned long long cycles = atomic_load(&perfTotals[r][PERF_CYCLES]);
+    if (cycles > 0 && atomic_load(&perfOpened[PERF_INSTRUCTIONS]))
+    {
+      fprintf(out, " %6.2f",
+              (double)atomic_load(&perfTotals[r][PERF_INSTRUCTIONS]) / cycles);
+    }
+    else
+    {
+      fprintf(out, " %6s", "n/a");
+    }
+    fprintf(out, "\n");
+  }
+}
+
+void perfReset(void)
+{
+  for (int r = 0; r < NUM_PERF_REGIONS; r++)
+  {
+    atomic_store(&perfCalls[r], 0);
+    for (int e = 0; e < NUM_PERF_EVENTS; e++)
+    {
+      atomic_store(&perfTotals[r][e], 0);
+    }
+  }
+}
+
+#endif
@@ -0,0 +1,80 @@
+/*
+ * Header file for our hardware performance counter instrumentation.
+ *
+ * Hot regions of the heap and graph code are wrapped in PERF_BEGIN and
+ * PERF_END. Built with -DPERF_COUNTERS (and perf_counters.c), every region
+ * counts the user-space cycles, instructions, L1 data cache read misses,
+ * last-level cache misses and branch mispredictions spent in it, using
+ * Linux's perf_event_open; PERF_REPORT prints the totals. Without
+ * -DPERF_COUNTERS the macros expand to nothing, and perf_counters.c need not
+ * be compiled at all.
+ *
+ * Reading the counters costs a system call at each end of a region, so
+ * instrumented runs are slower; the system calls themselves are not counted.
+ * Regions may nest, and counts are inclusive: a floatUp inside the Dijkstra
+ * relaxation loop counts towards both. A region entered again while the
+ * thread is already in it is only counted once. Counts from all threads are
+ * added up, but a region only counts the thread that entered it: the worker
+ * threads of a parallel loadGraphCSR are not included.
+ */
+
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#ifndef __Perf_Counters_header
+#define __Perf_Counters_header
+
+#define PERF_HEAPIFY 0         // heapify in minheap.c
+#define PERF_FLOAT_UP 1        // floatUp in minheap.c
+#define PERF_RELAX 2           // edge relaxation loops of Dijkstra and Prim
+#define PERF_LOAD_GRAPH 3      // loadGraph and loadGraphCSR
+#define NUM_PERF_REGIONS 4
+
+#define PERF_CYCLES 0
+#define PERF_INSTRUCTIONS 1
+#define PERF_L1D_MISSES 2
+#define PERF_LLC_MISSES 3
+#define PERF_BRANCH_MISSES 4
+#define NUM_PERF_EVENTS 5
+
+#ifdef PERF_COUNTERS
+#define PERF_BEGIN(region) perfBegin(region)
+#define PERF_END(region) perfEnd(region)
+#define PERF_REPORT(out) perfReport(out)
+#define PERF_RESET() perfReset()
+#else
+#define PERF_BEGIN(region) ((void)0)
+#define PERF_END(region) ((void)0)
+#define PERF_REPORT(out) ((void)0)
+#define PERF_RESET() ((void)0)
+#endif
+
+/*
+ * Starts counting for region 'region' on the calling thread. The first
+ * call on a thread opens its counters; if the kernel refuses (no PMU, or
+ * perf_event_paranoid is too strict), only calls are counted.
+ */
+void perfBegin(int region);
+
+/*
+ * Stops counting for region 'region' on the calling thread, and adds what
+ * was counted since the matching perfBegin to the totals.
+ * Precondition: every perfEnd follows a perfBegin of the same region on
+ * the same thread
+ */
+void perfEnd(int region);
+
+/*
+ * Prints the totals of every region that was entered to 'out': calls,
+ * each counter, and instructions per cycle. Counters that could not be
+ * opened are shown as n/a.
+ */
+void perfReport(FILE* out);
+
+/*
+ * Sets all totals back to zero.
+ */
+void perfReset(void);
+
+#endif
@@ -0,0 +1,294 @@
+/*
+ *  Benchmarks the concurrent priority queues against each other under
+ *  1, 2, 4, ... threads, and prints the median and minimum wall time of each
+ *  as CSV or JSON.
+ *
+ *  The workload is the hold model shared by all threads: the queue is filled
+ *  with random priorities, then the threads together repeatedly extract a
+ *  node and insert it again with its priority increased by a random amount,
+ *  so that the queue keeps its size, as it roughly does in the middle of a
+ *  parallel Dijkstra. The queues are those of queue_impls.h that threads
+ *  may share: locked_minheap, multiqueue and skiplist.
+ *
+ *  ---------------------------------------------------------------------------
+ *   Compile:
+ *   gcc -Wall -Werror -O2 -pthread minheap.c multiqueue.c skipqueue.c \
+ *       external_heap.c queue_impls.c queue_bench.c -o queue_bench
+ *
+ *   Run:
+ *   ./queue_bench -n 1000000 -p 4000000 -t 64 -r 5 -f csv > results.csv
+ *
+ *   Options:
+ *   -n nodes     nodes in the queue
+ *   -p pairs     extracts, each followed by an insert, per timed run, split
+ *                evenly between the threads
+ *   -t threads   largest number of threads
+ *   -r runs      timed runs per queue and number of threads
+ *   -i name      only time queue 'name'
+ *   -f format    csv or json
+ *  ---------------------------------------------------------------------------
+ */
+
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "queue_impls.h"
+
+/***** The hold model *******************************************************/
+
+double nowMillis(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1e3 + ts.tv_nsec / 1e6;
+}
+
+/*
+ * Returns the next number of the splitmix64 sequence in 'state'.
+ */
+static uint64_t nextRandom(uint64_t* state)
+{
+  uint64_t z = (*state += 0x9e3779b97f4a7c15ULL);
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+  return z ^ (z >> 31);
+}
+
+/*
+ * One thread of a timed run.
+ */
+typedef struct hold_thread
+{
+  QueueImpl* impl;
+  void* queue;
+  pthread_barrier_t* start;  // passed once every thread is ready
+  int workerId;
+  long pairs;                // extracts and inserts this thread does
+  bool ok;                   // no extract found the queue empty
+  double startTime;          // milliseconds, once past 'start'
+  double endTime;
+} HoldThread;
+
+void* holdThreadMain(void* arg)
+{
+  HoldThread* thread = (HoldThread*)arg;
+  QueueImpl* impl = thread->impl;
+  uint64_t seed = thread->workerId + 1;
+  pthread_barrier_wait(thread->start);
+  thread->startTime = nowMillis();
+  for (long i = 0; i < thread->pairs; i++)
+  {
+    HeapNode node;
+    if (!impl->extractMin(thread->queue, &node, thread->workerId))
+    {
+      thread->ok = false;
+      break;
+    }
+    impl->insert(thread->queue, node.priority + (int)(nextRandom(&seed) >> 44),
+                 node.id, thread->workerId);
+  }
+  thread->endTime = nowMillis();
+  return NULL;
+}
+
+/*
+ * Fills a new queue of 'impl' with 'numNodes' nodes, then has 'numThreads'
+ * threads do 'pairs' extracts and inserts on it. Returns the milliseconds
+ * from the first thread starting its work until the last one finished, or
+ * a negative number if a thread found the queue empty. The threads read
+ * the clock themselves, as they may all be done before this thread runs
+ * again after releasing them.
+ */
+double hold(QueueImpl* impl, int numThreads, int numNodes, long pairs,
+            uint64_t seed)
+{
+  void* queue = impl->create(numThreads, numNodes);
+  HoldThread* threads = (HoldThread*)malloc(numThreads * sizeof(HoldThread));
+  pthread_t* ids = (pthread_t*)malloc(numThreads * sizeof(pthread_t));
+  if (queue == NULL || threads == NULL || ids == NULL)
+  {
+    printf("Memory allocation failed\n");
+    exit(EXIT_FAILURE);
+  }
+  for (int id = 0; id < numNodes; id++)
+    impl->insert(queue, (int)(nextRandom(&seed) >> 34), id, 0);
+
+  pthread_barrier_t start;
+  pthread_barrier_init(&start, NULL, numThreads + 1);
+  for (int t = 0; t < numThreads; t++)
+  {
+    threads[t].impl = impl;
+    threads[t].queue = queue;
+    threads[t].start = &start;
+    threads[t].workerId = t;
+    threads[t].pairs = pairs / numThreads + (t < pairs % numThreads);
+    threads[t].ok = true;
+    if (pthread_create(&ids[t], NULL, holdThreadMain, &threads[t]) != 0)
+    {
+      printf("Unable to start %d threads\n", numThreads);
+      exit(EXIT_FAILURE);
+    }
+  }
+  pthread_barrier_wait(&start);
+  bool ok = true;
+  double startTime = 0;
+  double endTime = 0;
+  for (int t = 0; t < numThreads; t++)
+  {
+    pthread_join(ids[t], NULL);
+    ok = ok && threads[t].ok;
+    if (t == 0 || threads[t].startTime < startTime)
+      startTime = threads[t].startTime;
+    if (t == 0 || threads[t].endTime > endTime)
+      endTime = threads[t].endTime;
+  }
+  double millis = endTime - startTime;
+
+  pthread_barrier_destroy(&start);
+  impl->destroy(queue);
+  free(threads);
+  free(ids);
+  return ok ? millis : -1;
+}
+
+/***** Main *****************************************************************/
+
+int compareTimes(const void* a, const void* b)
+{
+  double x = *(const double*)a;
+  double y = *(const double*)b;
+  return (x > y) - (x < y);
+}
+
+/*
+ * Prints one result row in 'format'. 'times' holds 'runs' sorted times.
+ */
+void printResult(const char* format, bool first, const char* name,
+                 int numThreads, int numNodes, long pairs, double* times,
+                 int runs)
+{
+  double median = runs % 2 ? times[runs / 2]
+                           : (times[runs / 2 - 1] + times[runs / 2]) / 2;
+  double mpairs = pairs / median / 1e3;
+
+  if (strcmp(format, "json") == 0)
+    printf("%s\n  {\"queue\": \"%s\", \"threads\": %d, \"nodes\": %d, "
+           "\"pairs\": %ld, \"runs\": %d, \"median_ms\": %.4f, "
+           "\"min_ms\": %.4f, \"mpairs_per_s\": %.4f}",
+           first ? "" : ",", name, numThreads, numNodes, pairs, runs, median,
+           times[0], mpairs);
+  else
+    printf("%s,%d,%d,%ld,%d,%.4f,%.4f,%.4f\n", name, numThreads, numNodes,
+           pairs, runs, median, times[0], mpairs);
+}
+
+/*
+ * Returns the number of threads to time after 'threads': the next power of
+ * two, then 'maxThreads' itself, then more than 'maxThreads'.
+ */
+int nextThreadCount(int threads, int maxThreads)
+{
+  if (threads == maxThreads)
+    return maxThreads + 1;
+  return 2 * threads < maxThreads ? 2 * threads : maxThreads;
+}
+
+int main(int argc, char* argv[])
+{
+  int numNodes = 1000000;
+  long pairs = 4000000;
+  int maxThreads = 64;
+  int runs = 5;
+  const char* only = NULL;
+  const char* format = "csv";
+
+  int option;
+  while ((option = getopt(argc, argv, "n:p:t:r:i:f:")) != -1)
+  {
+    switch (option)
+    {
+      case 'n':
+        numNodes = atoi(optarg);
+        break;
+      case 'p':
+        pairs = atol(optarg);
+        break;
+      case 't':
+        maxThreads = atoi(optarg);
+        break;
+      case 'r':
+        runs = atoi(optarg);
+        break;
+      case 'i':
+        only = optarg;
+        break;
+      case 'f':
+        format = optarg;
+        break;
+      default:
+        runs = 0;
+    }
+  }
+  // Every thread may hold a node it extracted, so keep some for the others
+  if (maxThreads < 1 || numNodes < 2 * maxThreads || pairs < 1 || runs < 1 ||
+      optind != argc ||
+      (strcmp(format, "csv") != 0 && strcmp(format, "json") != 0))
+  {
+    printf("Usage: %s [-n nodes] [-p pairs] [-t threads] [-r runs] "
+           "[-i queue] [-f csv|json]\n"
+           "  (nodes must be at least twice the threads)\n",
+           argv[0]);
+    return 1;
+  }
+
+  double* times = (double*)malloc(runs * sizeof(double));
+  if (times == NULL)
+  {
+    printf("Memory allocation failed\n");
+    return 1;
+  }
+  if (strcmp(format, "json") == 0)
+    printf("[");
+  else
+    printf("queue,threads,nodes,pairs,runs,median_ms,min_ms,mpairs_per_s\n");
+
+  bool first = true;
+  bool allOk = true;
+  for (int k = 0; k < NUM_QUEUE_IMPLS; k++)
+  {
+    QueueImpl* impl = &queueImpls[k];
+    if (!impl->concurrent || (only && strcmp(only, impl->name) != 0))
+      continue;
+    for (int threads = 1; threads <= maxThreads;
+         threads = nextThreadCount(threads, maxThreads))
+    {
+      bool ok = hold(impl, threads, numNodes, pairs, 0) >= 0; // warmup
+      for (int i = 0; i < runs && ok; i++)
+      {
+        times[i] = hold(impl, threads, numNodes, pairs, i + 1);
+        ok = times[i] >= 0;
+      }
+      if (!ok)
+      {
+        fprintf(stderr, "%s FAILED with %d threads\n", impl->name, threads);
+        allOk = false;
+        continue;
+      }
+      qsort(times, runs, sizeof(double), compareTimes);
+      printResult(format, first, impl->name, threads, numNodes, pairs, times,
+                  runs);
+      first = false;
+      fflush(stdout);
+    }
+  }
+
+  if (strcmp(format, "json") == 0)
+    printf("\n]\n");
+  free(times);
+  return allOk ? 0 : 1;
+}
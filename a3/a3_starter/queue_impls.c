@@ -0,0 +1,198 @@
+/*
+ * The table of our priority queues (see queue_impls.h): a wrapper of each
+ * operation of each queue.
+ */
+
+#include <pthread.h>
+#include <stdlib.h>
+
+#include "external_heap.h"
+#include "multiqueue.h"
+#include "queue_impls.h"
+#include "skipqueue.h"
+
+/***** Our MinHeap behind a mutex *******************************************/
+
+typedef struct locked_minheap
+{
+  pthread_mutex_t lock;
+  MinHeap *heap;
+} LockedMinHeap;
+
+static void *lockedMinHeapCreate(int numThreads, int capacity)
+{
+  (void)numThreads;
+  LockedMinHeap *locked = (LockedMinHeap *)malloc(sizeof(LockedMinHeap));
+  if (locked == NULL)
+    return NULL;
+  pthread_mutex_init(&locked->lock, NULL);
+  locked->heap = newHeap(capacity);
+  return locked;
+}
+
+static void lockedMinHeapDestroy(void *queue)
+{
+  LockedMinHeap *locked = (LockedMinHeap *)queue;
+  deleteHeap(locked->heap);
+  pthread_mutex_destroy(&locked->lock);
+  free(locked);
+}
+
+static bool lockedMinHeapInsert(void *queue, int priority, int id,
+                                int workerId)
+{
+  (void)workerId;
+  LockedMinHeap *locked = (LockedMinHeap *)queue;
+  pthread_mutex_lock(&locked->lock);
+  bool inserted = insert(locked->heap, priority, id);
+  pthread_mutex_unlock(&locked->lock);
+  return inserted;
+}
+
+static bool lockedMinHeapExtractMin(void *queue, HeapNode *node,
+                                    int workerId)
+{
+  (void)workerId;
+  LockedMinHeap *locked = (LockedMinHeap *)queue;
+  pthread_mutex_lock(&locked->lock);
+  bool extracted = locked->heap->size > 0;
+  if (extracted)
+    *node = extractMin(locked->heap);
+  pthread_mutex_unlock(&locked->lock);
+  return extracted;
+}
+
+static bool lockedMinHeapDecreasePriority(void *queue, int id,
+                                          int newPriority)
+{
+  LockedMinHeap *locked = (LockedMinHeap *)queue;
+  pthread_mutex_lock(&locked->lock);
+  // MinHeap keeps the index of an extracted ID, which may now hold another
+  // node, so decrease only an ID that is still in the heap
+  MinHeap *heap = locked->heap;
+  int index = heap->indexMap[id];
+  bool decreased = index >= ROOT_INDEX && index <= heap->size &&
+                   heap->arr[index].id == id &&
+                   decreasePriority(heap, id, newPriority);
+  pthread_mutex_unlock(&locked->lock);
+  return decreased;
+}
+
+static int64_t lockedMinHeapSize(void *queue)
+{
+  LockedMinHeap *locked = (LockedMinHeap *)queue;
+  pthread_mutex_lock(&locked->lock);
+  int size = locked->heap->size;
+  pthread_mutex_unlock(&locked->lock);
+  return size;
+}
+
+/***** MultiQueue ***********************************************************/
+
+static void *multiQueueCreate(int numThreads, int capacity)
+{
+  return newMultiQueue(numThreads, capacity);
+}
+
+static void multiQueueDestroy(void *queue)
+{
+  deleteMultiQueue((MultiQueue *)queue);
+}
+
+static bool multiQueueInsert(void *queue, int priority, int id, int workerId)
+{
+  (void)workerId;
+  return multiInsert((MultiQueue *)queue, priority, id);
+}
+
+static bool multiQueueExtractMin(void *queue, HeapNode *node, int workerId)
+{
+  (void)workerId;
+  return multiExtractMin((MultiQueue *)queue, node);
+}
+
+static bool multiQueueDecreasePriority(void *queue, int id, int newPriority)
+{
+  return multiDecreasePriority((MultiQueue *)queue, id, newPriority);
+}
+
+static int64_t multiQueueSizeOf(void *queue)
+{
+  return multiQueueSize((MultiQueue *)queue);
+}
+
+/***** SkipQueue ************************************************************/
+
+static void *skipQueueCreate(int numThreads, int capacity)
+{
+  (void)capacity;
+  return newSkipQueue(numThreads);
+}
+
+static void skipQueueDestroy(void *queue)
+{
+  deleteSkipQueue((SkipQueue *)queue);
+}
+
+static bool skipQueueInsert(void *queue, int priority, int id, int workerId)
+{
+  return skipInsert((SkipQueue *)queue, priority, id, workerId);
+}
+
+static bool skipQueueExtractMin(void *queue, HeapNode *node, int workerId)
+{
+  return skipExtractMin((SkipQueue *)queue, node, workerId);
+}
+
+/***** ExternalHeap *********************************************************/
+
+static void *externalHeapCreate(int numThreads, int capacity)
+{
+  (void)numThreads;
+  // Small enough that a full queue spills to more than EXTERNAL_MAX_RUNS
+  // runs once capacity passes 4096
+  int bufferCapacity = 1;
+  while ((int64_t)bufferCapacity * bufferCapacity < capacity)
+    bufferCapacity++;
+  return newExternalHeap(bufferCapacity, NULL);
+}
+
+static void externalHeapDestroy(void *queue)
+{
+  deleteExternalHeap((ExternalHeap *)queue);
+}
+
+static bool externalHeapInsert(void *queue, int priority, int id,
+                               int workerId)
+{
+  (void)workerId;
+  return externalInsert((ExternalHeap *)queue, priority, id);
+}
+
+static bool externalHeapExtractMin(void *queue, HeapNode *node, int workerId)
+{
+  (void)workerId;
+  ExternalHeap *heap = (ExternalHeap *)queue;
+  if (externalHeapSize(heap) == 0)
+    return false;
+  *node = externalExtractMin(heap);
+  return true;
+}
+
+static int64_t externalHeapSizeOf(void *queue)
+{
+  return externalHeapSize((ExternalHeap *)queue);
+}
+
+QueueImpl queueImpls[NUM_QUEUE_IMPLS] = {
+    {"locked_minheap", true, false, lockedMinHeapCreate, lockedMinHeapDestroy,
+     lockedMinHeapInsert, lockedMinHeapExtractMin,
+     lockedMinHeapDecreasePriority, lockedMinHeapSize},
+    {"multiqueue", true, true, multiQueueCreate, multiQueueDestroy,
+     multiQueueInsert, multiQueueExtractMin, multiQueueDecreasePriority,
+     multiQueueSizeOf},
+    {"skiplist", true, false, skipQueueCreate, skipQueueDestroy,
+     skipQueueInsert, skipQueueExtractMin, NULL, NULL},
+    {"external_heap", false, false, externalHeapCreate, externalHeapDestroy,
+     externalHeapInsert, externalHeapExtractMin, NULL, externalHeapSizeOf},
+};
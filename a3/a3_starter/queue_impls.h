@@ -0,0 +1,51 @@
+/*
+ * Header file for the table of our priority queues, shared by queue_bench
+ * and queue_tester.
+ *
+ * Every queue is wrapped behind the same operations, so that a program can
+ * run each of them in turn. Queues hold nodes with IDs 0, ..., capacity-1,
+ * each at most once, and are used by workers 0, ..., numThreads-1. The
+ * queues differ in what else they promise, which a QueueImpl records:
+ * whether several threads may use it at once, whether extractMin returns
+ * the minimum or only a node of small priority, and whether it can
+ * decrease priorities and count its nodes.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "minheap.h"
+
+#ifndef __Queue_Impls_header
+#define __Queue_Impls_header
+
+typedef struct queue_impl
+{
+  const char* name;
+  bool concurrent;  // may be used by several threads at once
+  bool relaxed;     // extractMin need not return a node of minimum priority
+  void* (*create)(int numThreads, int capacity);
+  void (*destroy)(void* queue);
+  bool (*insert)(void* queue, int priority, int id, int workerId);
+  // Returns false if the queue was found empty
+  bool (*extractMin)(void* queue, HeapNode* node, int workerId);
+  // As MinHeap's decreasePriority; NULL if the queue cannot decrease
+  bool (*decreasePriority)(void* queue, int id, int newPriority);
+  // NULL if the queue does not count its nodes
+  int64_t (*size)(void* queue);
+} QueueImpl;
+
+/*
+ * The queues:
+ *   locked_minheap  our MinHeap behind one mutex
+ *   multiqueue      MultiQueue (see multiqueue.h), whose extracts are
+ *                   relaxed
+ *   skiplist        SkipQueue (see skipqueue.h), lock-free
+ *   external_heap   ExternalHeap (see external_heap.h) buffering about
+ *                   sqrt(capacity) nodes in memory; one thread only
+ */
+#define NUM_QUEUE_IMPLS 4
+
+extern QueueImpl queueImpls[NUM_QUEUE_IMPLS];
+
+#endif
@@ -0,0 +1,582 @@
+/*
+ *  Randomized testing of our priority queues (see queue_impls.h).
+ *
+ *  From one thread, every queue gets random inserts, extracts and, if it can
+ *  decrease priorities, decreases, checked against a plain array of the
+ *  nodes in the queue and a reference heap: an extracted node must be in
+ *  the queue with the priority it came out with, and must have the minimum
+ *  priority unless the queue's extracts are relaxed. Nodes are inserted and
+ *  extracted at random, or all inserted before any is extracted, or with
+ *  priorities that never drop below the last extracted one, as in
+ *  Dijkstra's algorithm. Each queue is also filled with distinct priorities
+ *  and drained, printing the mean and maximum rank error of its extracts:
+ *  it must be 0 for a strict queue, while a relaxed queue's mean may be at
+ *  most RANK_ERROR_PER_THREAD times the threads it was created for.
+ *
+ *  Several threads at once then insert nodes into each concurrent queue,
+ *  decrease the priorities of random IDs, extract nodes, and finally drain
+ *  the queue: every ID must have been extracted exactly once, with the
+ *  lowest priority it was given. Last, an ExternalHeap's getMin must return
+ *  the node that it extracts next, and it must refuse a node when its buffer
+ *  cannot be spilled. Prints the first mismatches found and exits with a
+ *  non-zero status if there were any.
+ *
+ *  ---------------------------------------------------------------------------
+ *   Compile:
+ *   gcc -Wall -Werror -pthread minheap.c multiqueue.c skipqueue.c \
+ *       external_heap.c queue_impls.c queue_tester.c -o queue_tester
+ *
+ *   Run:
+ *   ./queue_tester [seed]
+ *
+ *   ExternalHeap runs are kept in $TMPDIR, or /tmp.
+ *  ---------------------------------------------------------------------------
+ */
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "external_heap.h"
+#include "queue_impls.h"
+
+#define MAX_REPORTED 10  // mismatches printed before only counting them
+
+#define MIXED 0      // inserts and extracts interleaved at random
+#define DRAIN 1      // all inserts, then all extracts
+#define MONOTONE 2   // as MIXED, but never below the last extracted priority,
+                     // like Dijkstra's algorithm
+
+const char* modeNames[] = {"mixed", "drain", "monotone"};
+
+// The mean rank error allowed per thread a relaxed queue is created for
+#define RANK_ERROR_PER_THREAD 8
+
+uint64_t seed;
+atomic_int numMismatches;
+
+/*
+ * Returns a pseudo-random number in 0, 1, ..., bound-1 (splitmix64), and
+ * advances 'state'.
+ */
+int randomBelow(uint64_t* state, int bound)
+{
+  uint64_t z = (*state += 0x9e3779b97f4a7c15ULL);
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+  z ^= z >> 31;
+  return (int)((z >> 33) % (uint64_t)bound);
+}
+
+/*
+ * Prints a mismatch for node 'id' of queue 'name', and counts it.
+ */
+void reportMismatch(const char* name, const char* what, int id,
+                    int64_t expected, int64_t actual)
+{
+  if (atomic_fetch_add(&numMismatches, 1) < MAX_REPORTED)
+  {
+    printf("%s: ID %d: %s is %lld, expected %lld\n", name, id, what,
+           (long long)actual, (long long)expected);
+  }
+}
+
+/***** One thread ***********************************************************/
+
+/*
+ * The reference: a plain binary heap of node keys, priority first. It may
+ * hold keys of nodes that have since been extracted or decreased.
+ */
+typedef struct reference
+{
+  int64_t* keys;
+  int64_t size;
+} Reference;
+
+/*
+ * Returns 'priority' and 'id' as one key that sorts by priority first.
+ */
+int64_t nodeKey(int priority, int id)
+{
+  return (int64_t)priority * ((int64_t)1 << 32) + (uint32_t)id;
+}
+
+void referencePush(Reference* ref, int64_t key)
+{
+  int64_t i = ref->size++;
+  while (i > 0 && ref->keys[(i - 1) / 2] > key)
+  {
+    ref->keys[i] = ref->keys[(i - 1) / 2];
+    i = (i - 1) / 2;
+  }
+  ref->keys[i] = key;
+}
+
+int64_t referencePop(Reference* ref)
+{
+  int64_t top = ref->keys[0];
+  int64_t last = ref->keys[--ref->size];
+  int64_t i = 0;
+  while (2 * i + 1 < ref->size)
+  {
+    int64_t child = 2 * i + 1;
+    if (child + 1 < ref->size && ref->keys[child + 1] < ref->keys[child])
+      child++;
+    if (ref->keys[child] >= last)
+      break;
+    ref->keys[i] = ref->keys[child];
+    i = child;
+  }
+  ref->keys[i] = last;
+  return top;
+}
+
+/*
+ * Returns the minimum priority of the nodes in the queue, given by
+ * 'inQueue' and 'priorities', first dropping the keys of 'ref' that are no
+ * longer in the queue.
+ * Precondition: the queue is non-empty
+ */
+int referenceMin(Reference* ref, bool* inQueue, int* priorities)
+{
+  while (true)
+  {
+    int priority = (int)(ref->keys[0] >> 32);
+    int id = (int)(uint32_t)ref->keys[0];
+    if (inQueue[id] && priorities[id] == priority)
+      return priority;
+    referencePop(ref);
+  }
+}
+
+/*
+ * Makes 'numOperations' random inserts, decreases and extracts, in 'mode'
+ * (MIXED, DRAIN or MONOTONE), on a queue of 'impl' for 'numIds' IDs from
+ * one thread, then drains it, checking every result. Priorities are below
+ * 'maxPriority', and some negative.
+ */
+void testSequential(QueueImpl* impl, int numIds, int numOperations,
+                    int maxPriority, int mode)
+{
+  void* queue = impl->create(1, numIds);
+  int* priorities = (int*)malloc(numIds * sizeof(int));
+  bool* inQueue = (bool*)calloc(numIds, sizeof(bool));
+  Reference ref = {(int64_t*)malloc((numOperations + 1) * sizeof(int64_t)),
+                   0};
+  if (queue == NULL || priorities == NULL || inQueue == NULL ||
+      ref.keys == NULL)
+  {
+    printf("Memory allocation failed\n");
+    exit(EXIT_FAILURE);
+  }
+
+  uint64_t state = seed;
+  int size = 0;
+  int lastPriority = 0;
+  HeapNode node;
+  for (int op = 0; op < numOperations || size > 0; op++)
+  {
+    bool draining = op >= numOperations;
+    int id = randomBelow(&state, numIds);
+    int priority = randomBelow(&state, maxPriority) - maxPriority / 8;
+    if (mode == MONOTONE)
+      priority = lastPriority + randomBelow(&state, maxPriority);
+    bool extract = draining || (mode != DRAIN && size > 0 &&
+                                randomBelow(&state, 3) == 0);
+
+    if (!extract && impl->decreasePriority && randomBelow(&state, 2) == 0)
+    {
+      bool expected = inQueue[id] && priorities[id] > priority;
+      if (impl->decreasePriority(queue, id, priority) != expected)
+        reportMismatch(impl->name, "decreasePriority", id, expected,
+                       !expected);
+      if (expected)
+      {
+        priorities[id] = priority;
+        referencePush(&ref, nodeKey(priority, id));
+      }
+    }
+    else if (!extract && !inQueue[id])
+    {
+      if (!impl->insert(queue, priority, id, 0))
+        reportMismatch(impl->name, "insert", id, true, false);
+      priorities[id] = priority;
+      inQueue[id] = true;
+      size++;
+      referencePush(&ref, nodeKey(priority, id));
+    }
+    else if (!extract)
+    {
+      continue;  // 'id' is in the queue already
+    }
+    else if (!impl->extractMin(queue, &node, 0))
+    {
+      reportMismatch(impl->name, "extract from a queue of size", -1, 0, size);
+      break;
+    }
+    else if (node.id < 0 || node.id >= numIds || !inQueue[node.id])
+    {
+      reportMismatch(impl->name, "extracted ID", node.id, -1, node.id);
+      break;
+    }
+    else
+    {
+      if (node.priority != priorities[node.id])
+        reportMismatch(impl->name, "extracted priority", node.id,
+                       priorities[node.id], node.priority);
+      else if (!impl->relaxed &&
+               node.priority != referenceMin(&ref, inQueue, priorities))
+        reportMismatch(impl->name, "extracted priority, as the minimum",
+                       node.id, referenceMin(&ref, inQueue, priorities),
+                       node.priority);
+      inQueue[node.id] = false;
+      size--;
+      lastPriority = node.priority;
+    }
+    if (impl->size && impl->size(queue) != size)
+      reportMismatch(impl->name, "size", -1, size, impl->size(queue));
+  }
+  if (size == 0 && impl->extractMin(queue, &node, 0))
+    reportMismatch(impl->name, "extract from the drained queue", node.id,
+                   false, true);
+
+  printf("%s, 1 thread, %d IDs, %d operations, %s: %d mismatches so far\n",
+         impl->name, numIds, numOperations, modeNames[mode],
+         atomic_load(&numMismatches));
+  free(ref.keys);
+  free(inQueue);
+  free(priorities);
+  impl->destroy(queue);
+}
+
+/*
+ * Inserts 'numIds' nodes with the priorities 0, ..., numIds-1 in random
+ * order into a queue of 'impl' created for 'numThreads' threads, extracts
+ * them all from one thread, and prints the mean and maximum rank error of
+ * the extracted nodes: how many nodes still in the queue had a smaller
+ * priority. A queue whose extracts are not relaxed must always extract
+ * rank 0, and a relaxed one must keep the mean at most 'maxMeanRank'.
+ */
+void testRankError(QueueImpl* impl, int numThreads, int numIds,
+                   double maxMeanRank)
+{
+  void* queue = impl->create(numThreads, numIds);
+  int* priorities = (int*)malloc(numIds * sizeof(int));
+  int* counts = (int*)calloc(numIds + 1, sizeof(int));  // a Fenwick tree
+  if (queue == NULL || priorities == NULL || counts == NULL)
+  {
+    printf("Memory allocation failed\n");
+    exit(EXIT_FAILURE);
+  }
+
+  uint64_t state = seed;
+  for (int id = 0; id < numIds; id++)
+  {
+    int other = randomBelow(&state, id + 1);
+    priorities[id] = priorities[other];
+    priorities[other] = id;
+  }
+  for (int id = 0; id < numIds; id++)
+  {
+    if (!impl->insert(queue, priorities[id], id, 0))
+      reportMismatch(impl->name, "insert", id, true, false);
+    for (int i = priorities[id] + 1; i <= numIds; i += i & -i)
+      counts[i]++;
+  }
+
+  int64_t totalRank = 0;
+  int maxRank = 0;
+  HeapNode node;
+  for (int extracted = 0; extracted < numIds; extracted++)
+  {
+    if (!impl->extractMin(queue, &node, 0))
+    {
+      reportMismatch(impl->name, "extract from a queue of size", -1,
+                     numIds - extracted, 0);
+      break;
+    }
+    if (node.id < 0 || node.id >= numIds ||
+        node.priority != priorities[node.id])
+    {
+      reportMismatch(impl->name, "extracted priority", node.id, -1,
+                     node.priority);
+      break;
+    }
+    int rank = 0;  // nodes in the queue of a smaller priority
+    for (int i = node.priority; i > 0; i -= i & -i)
+      rank += counts[i];
+    for (int i = node.priority + 1; i <= numIds; i += i & -i)
+      counts[i]--;
+    totalRank += rank;
+    if (rank > maxRank)
+      maxRank = rank;
+  }
+
+  double meanRank = (double)totalRank / numIds;
+  if (!impl->relaxed && maxRank > 0)
+    reportMismatch(impl->name, "maximum rank error", -1, 0, maxRank);
+  if (impl->relaxed && meanRank > maxMeanRank)
+    reportMismatch(impl->name, "mean rank error, rounded", -1,
+                   (int64_t)maxMeanRank, (int64_t)(meanRank + 0.5));
+  printf("%s, %d thread(s), %d IDs: rank error mean %.1f, max %d: %d "
+         "mismatches so far\n", impl->name, numThreads, numIds, meanRank,
+         maxRank, atomic_load(&numMismatches));
+  free(counts);
+  free(priorities);
+  impl->destroy(queue);
+}
+
+/***** Several threads ******************************************************/
+
+/*
+ * What the threads of testConcurrent share. Thread t, as worker t, inserts
+ * the IDs t, t + numThreads, t + 2*numThreads, ...
+ */
+typedef struct shared
+{
+  QueueImpl* impl;
+  void* queue;
+  int numThreads;
+  int numIds;
+  int maxPriority;
+  atomic_int* lowestPriority;  // the lowest priority each ID was given
+  atomic_int* timesExtracted;
+  int* extractedPriority;      // written by the first extract of each ID
+} Shared;
+
+typedef struct worker
+{
+  Shared* shared;
+  int index;
+} Worker;
+
+/*
+ * Records that 'node' was extracted from the queue of 'shared'.
+ */
+void recordExtract(Shared* shared, HeapNode node)
+{
+  if (node.id < 0 || node.id >= shared->numIds)
+  {
+    reportMismatch(shared->impl->name, "extracted ID", node.id, 0, node.id);
+    return;
+  }
+  if (atomic_fetch_add(&shared->timesExtracted[node.id], 1) == 0)
+    shared->extractedPriority[node.id] = node.priority;
+}
+
+/*
+ * Lowers the recorded lowest priority of 'id' to 'priority'.
+ */
+void recordDecrease(Shared* shared, int id, int priority)
+{
+  int lowest = atomic_load(&shared->lowestPriority[id]);
+  while (priority < lowest &&
+         !atomic_compare_exchange_weak(&shared->lowestPriority[id], &lowest,
+                                       priority))
+    ;
+}
+
+void* workerMain(void* arg)
+{
+  Worker* worker = (Worker*)arg;
+  Shared* shared = worker->shared;
+  QueueImpl* impl = shared->impl;
+  uint64_t state = seed * 1000003 + worker->index;
+  HeapNode node;
+
+  for (int id = worker->index; id < shared->numIds; id += shared->numThreads)
+  {
+    int priority = randomBelow(&state, shared->maxPriority);
+    atomic_store(&shared->lowestPriority[id], priority);
+    if (!impl->insert(shared->queue, priority, id, worker->index))
+      reportMismatch(impl->name, "insert", id, true, false);
+
+    int other = randomBelow(&state, shared->numIds);
+    int newPriority = randomBelow(&state, shared->maxPriority);
+    if (impl->decreasePriority &&
+        impl->decreasePriority(shared->queue, other, newPriority))
+      recordDecrease(shared, other, newPriority);
+
+    if (randomBelow(&state, 2) == 0 &&
+        impl->extractMin(shared->queue, &node, worker->index))
+      recordExtract(shared, node);
+  }
+  while (impl->extractMin(shared->queue, &node, worker->index))
+    recordExtract(shared, node);
+  return NULL;
+}
+
+/*
+ * Has 'numThreads' threads insert 'numIds' nodes with priorities below
+ * 'maxPriority' into a new queue of 'impl', decreasing priorities and
+ * extracting as they go, and checks that every node came out once, with
+ * its lowest priority.
+ */
+void testConcurrent(QueueImpl* impl, int numThreads, int numIds,
+                    int maxPriority)
+{
+  Shared shared = {impl, impl->create(numThreads, numIds), numThreads, numIds,
+                   maxPriority,
+                   (atomic_int*)malloc(numIds * sizeof(atomic_int)),
+                   (atomic_int*)malloc(numIds * sizeof(atomic_int)),
+                   (int*)malloc(numIds * sizeof(int))};
+  Worker* workers = (Worker*)malloc(numThreads * sizeof(Worker));
+  pthread_t* threads = (pthread_t*)malloc(numThreads * sizeof(pthread_t));
+  if (shared.queue == NULL || shared.lowestPriority == NULL ||
+      shared.timesExtracted == NULL || shared.extractedPriority == NULL ||
+      workers == NULL || threads == NULL)
+  {
+    printf("Memory allocation failed\n");
+    exit(EXIT_FAILURE);
+  }
+  for (int id = 0; id < numIds; id++)
+  {
+    atomic_init(&shared.lowestPriority[id], maxPriority);
+    atomic_init(&shared.timesExtracted[id], 0);
+  }
+
+  for (int t = 0; t < numThreads; t++)
+  {
+    workers[t] = (Worker){&shared, t};
+    if (pthread_create(&threads[t], NULL, workerMain, &workers[t]) != 0)
+    {
+      printf("Could not create thread %d\n", t);
+      exit(EXIT_FAILURE);
+    }
+  }
+  for (int t = 0; t < numThreads; t++)
+    pthread_join(threads[t], NULL);
+
+  // A thread may have drained the queue while others were still inserting
+  HeapNode node;
+  while (impl->extractMin(shared.queue, &node, 0))
+    recordExtract(&shared, node);
+  if (impl->size && impl->size(shared.queue) != 0)
+    reportMismatch(impl->name, "size when drained", -1, 0,
+                   impl->size(shared.queue));
+
+  for (int id = 0; id < numIds; id++)
+  {
+    int times = atomic_load(&shared.timesExtracted[id]);
+    if (times != 1)
+      reportMismatch(impl->name, "times extracted", id, 1, times);
+    else if (shared.extractedPriority[id] !=
+             atomic_load(&shared.lowestPriority[id]))
+      reportMismatch(impl->name, "extracted priority", id,
+                     atomic_load(&shared.lowestPriority[id]),
+                     shared.extractedPriority[id]);
+  }
+
+  printf("%s, %d thread(s), %d IDs, priorities below %d: %d mismatches so "
+         "far\n", impl->name, numThreads, numIds, maxPriority,
+         atomic_load(&numMismatches));
+  free(threads);
+  free(workers);
+  free(shared.extractedPriority);
+  free(shared.timesExtracted);
+  free(shared.lowestPriority);
+  impl->destroy(shared.queue);
+}
+
+/***** ExternalHeap *********************************************************/
+
+/*
+ * Checks that externalGetMin returns the node that externalExtractMin then
+ * extracts, while 'numNodes' random nodes are drained from an ExternalHeap
+ * that spilled them to many runs.
+ */
+void testGetMin(int numNodes)
+{
+  ExternalHeap* heap = newExternalHeap(16, NULL);
+  if (heap == NULL)
+  {
+    printf("Memory allocation failed\n");
+    exit(EXIT_FAILURE);
+  }
+  uint64_t state = seed;
+  for (int id = 0; id < numNodes; id++)
+  {
+    if (!externalInsert(heap, randomBelow(&state, numNodes / 4 + 1), id))
+    {
+      printf("external_heap: a run could not be written\n");
+      exit(EXIT_FAILURE);
+    }
+  }
+  while (externalHeapSize(heap) > 0)
+  {
+    HeapNode min = externalGetMin(heap);
+    HeapNode node = externalExtractMin(heap);
+    if (min.priority != node.priority || min.id != node.id)
+      reportMismatch("external_heap", "getMin priority", node.id,
+                     node.priority, min.priority);
+  }
+  printf("external_heap, getMin of %d nodes: %d mismatches so far\n",
+         numNodes, atomic_load(&numMismatches));
+  deleteExternalHeap(heap);
+}
+
+/*
+ * Checks that an ExternalHeap whose runs cannot be written refuses the
+ * insert that would spill its buffer, and stays as it was.
+ */
+void testFailedSpill(void)
+{
+  ExternalHeap* heap = newExternalHeap(4, "/nonexistent/external_heap");
+  if (heap == NULL)
+  {
+    printf("Memory allocation failed\n");
+    exit(EXIT_FAILURE);
+  }
+  for (int i = 0; i < 4; i++)
+    externalInsert(heap, 10 - i, i);
+  if (externalInsert(heap, 0, 4))
+    reportMismatch("external_heap", "insert that spills to a missing "
+                   "directory", 4, false, true);
+  if (externalHeapSize(heap) != 4)
+    reportMismatch("external_heap", "size after a failed spill", -1, 4,
+                   externalHeapSize(heap));
+  for (int priority = 7; priority <= 10; priority++)
+  {
+    HeapNode node = externalExtractMin(heap);
+    if (node.priority != priority)
+      reportMismatch("external_heap", "priority after a failed spill",
+                     node.id, priority, node.priority);
+  }
+  printf("external_heap, failed spill (expected to report an error): %d "
+         "mismatches so far\n", atomic_load(&numMismatches));
+  deleteExternalHeap(heap);
+}
+
+int main(int argc, char* argv[])
+{
+  seed = argc > 1 ? strtoull(argv[1], NULL, 10) : 1;
+
+  for (int k = 0; k < NUM_QUEUE_IMPLS; k++)
+  {
+    QueueImpl* impl = &queueImpls[k];
+    testSequential(impl, 1, 100, 10, MIXED);
+    testSequential(impl, 100, 20000, 1000, MIXED);       // many ties
+    testSequential(impl, 10000, 200000, 1000000, MIXED);
+    testSequential(impl, 20000, 20000, 1000000, DRAIN);  // many runs
+    testSequential(impl, 5000, 100000, 100, MONOTONE);
+    for (int threads = 1; threads <= (impl->relaxed ? 16 : 1); threads *= 4)
+      testRankError(impl, threads, 100000, RANK_ERROR_PER_THREAD * threads);
+    if (!impl->concurrent)
+      continue;
+    testConcurrent(impl, 1, 10000, 1000);
+    testConcurrent(impl, 4, 100000, 100);                // many ties
+    testConcurrent(impl, 16, 200000, 1000000);  // more threads than cores
+  }
+  testGetMin(20000);
+  testFailedSpill();
+
+  if (atomic_load(&numMismatches) > 0)
+  {
+    printf("FAILED: %d mismatches\n", atomic_load(&numMismatches));
+    return EXIT_FAILURE;
+  }
+  printf("All queue results match the reference.\n");
+  return EXIT_SUCCESS;
+}
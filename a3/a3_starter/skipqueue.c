@@ -0,0 +1,433 @@
+/*
+ * Our lock-free skip list priority queue, after the pseudocode of Linden
+ * and Jonsson.
+ *
+ * Only level 0 holds every node and decides what is in the queue. Bit 0 of
+ * a node's next[0] marks its successor as deleted; deleted nodes always
+ * form a prefix of the list, right after the head. Upper levels are only an
+ * index into level 0, and are never marked: they are linked in after the
+ * node is in level 0, and skip past the deleted prefix when restructured.
+ *
+ * Memory is reclaimed by epochs. A worker announces the global epoch while
+ * it is inside an operation; the epoch advances once every worker inside
+ * an operation has announced it, so while a worker that announced a is
+ * inside, the epoch stays at a + 1 or below. An unlinked node is tagged
+ * with the global epoch e read once the head no longer leads to it on any
+ * level. Workers that can still reach it entered before that, so announced
+ * e or less, and it is freed once the global epoch reaches e + 2. Tagging
+ * it with the unlinking worker's own announcement would not do: that may be
+ * e - 1.
+ */
+
+#include <limits.h>
+#include <stdatomic.h>
+#include <string.h>
+
+#include "skipqueue.h"
+
+#define CACHE_LINE 64
+#define QUIESCENT 0       // epoch announced by a worker outside operations
+#define RETIRE_BATCH 64   // retired nodes between attempts to advance epochs
+
+typedef struct skip_node
+{
+  int priority;
+  int id;
+  atomic_bool inserting;          // upper levels are still being linked in
+  struct skip_node *nextRetired;  // in the retired list of a worker
+  _Atomic(uintptr_t) next[];      // successor at each level of the node
+} SkipNode;
+
+/*
+ * What each worker keeps to itself, on cache lines of its own.
+ */
+typedef struct skip_worker
+{
+  _Alignas(CACHE_LINE) atomic_ulong epoch;  // announced epoch, or QUIESCENT
+  SkipNode *retired[3];           // nodes unlinked in epoch retiredEpoch[i]
+  unsigned long retiredEpoch[3];  //   for the epochs that are i modulo 3
+  int numRetired;                 // since the last attempt to advance
+  uint64_t random;                // splitmix64 state for node levels
+} SkipWorker;
+
+struct skip_queue
+{
+  SkipNode *head;  // priority of no importance, on all levels
+  SkipNode *tail;  // priority INT_MAX, on level 0 only
+  atomic_ulong epoch;
+  int numWorkers;
+  SkipWorker *workers;
+};
+
+static inline bool isMarked(uintptr_t next)
+{
+  return next & 1;
+}
+
+static inline SkipNode *unmarked(uintptr_t next)
+{
+  return (SkipNode *)(next & ~(uintptr_t)1);
+}
+
+/*
+ * Returns a new node with 'levels' levels, or NULL if memory could not be
+ * allocated.
+ */
+static SkipNode *newSkipNode(int priority, int id, int levels)
+{
+  SkipNode *node = (SkipNode *)malloc(sizeof(SkipNode) +
+                                      levels * sizeof(_Atomic(uintptr_t)));
+  if (node)
+  {
+    node->priority = priority;
+    node->id = id;
+    atomic_init(&node->inserting, false);
+    node->nextRetired = NULL;
+  }
+  return node;
+}
+
+/*
+ * Returns a random number of levels for a new node: l levels with
+ * probability 2^-l.
+ */
+static int randomLevels(SkipWorker *worker)
+{
+  uint64_t z = (worker->random += 0x9e3779b97f4a7c15ull);
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+  z ^= z >> 31;
+  return 1 + __builtin_ctzll(z | (1ull << (SKIP_LEVELS - 1)));
+}
+
+/*************************************************************************
+ ** Epochs
+ *************************************************************************/
+
+/*
+ * Frees the nodes of a retired list.
+ */
+static void freeRetired(SkipNode *node)
+{
+  while (node)
+  {
+    SkipNode *next = node->nextRetired;
+    free(node);
+    node = next;
+  }
+}
+
+/*
+ * Announces that 'worker' starts an operation on 'queue', and frees the
+ * nodes it retired that no worker can be reading any more.
+ */
+static void enterEpoch(SkipQueue *queue, SkipWorker *worker)
+{
+  unsigned long epoch;
+  do
+  {
+    epoch = atomic_load(&queue->epoch);
+    atomic_store(&worker->epoch, epoch);
+  } while (atomic_load(&queue->epoch) != epoch);
+
+  for (int i = 0; i < 3; i++)
+  {
+    if (worker->retired[i] && worker->retiredEpoch[i] + 2 <= epoch)
+    {
+      freeRetired(worker->retired[i]);
+      worker->retired[i] = NULL;
+    }
+  }
+}
+
+static inline void exitEpoch(SkipWorker *worker)
+{
+  atomic_store_explicit(&worker->epoch, QUIESCENT, memory_order_release);
+}
+
+/*
+ * Advances the global epoch of 'queue' if every worker inside an operation
+ * has announced it.
+ */
+static void tryAdvanceEpoch(SkipQueue *queue)
+{
+  unsigned long epoch = atomic_load(&queue->epoch);
+  for (int w = 0; w < queue->numWorkers; w++)
+  {
+    unsigned long announced = atomic_load(&queue->workers[w].epoch);
+    if (announced != QUIESCENT && announced != epoch)
+    {
+      return;
+    }
+  }
+  atomic_compare_exchange_strong(&queue->epoch, &epoch, epoch + 1);
+}
+
+/*
+ * Hands 'node', unlinked by 'worker' before it read 'epoch' from the global
+ * epoch, over to be freed later.
+ */
+static void retireNode(SkipQueue *queue, SkipWorker *worker, SkipNode *node,
+                       unsigned long epoch)
+{
+  int i = epoch % 3;
+  if (worker->retiredEpoch[i] != epoch)
+  {
+    // Left over from epoch - 3 at the latest, which is safe to free
+    freeRetired(worker->retired[i]);
+    worker->retired[i] = NULL;
+    worker->retiredEpoch[i] = epoch;
+  }
+  node->nextRetired = worker->retired[i];
+  worker->retired[i] = node;
+  if (++worker->numRetired >= RETIRE_BATCH)
+  {
+    worker->numRetired = 0;
+    tryAdvanceEpoch(queue);
+  }
+}
+
+/*************************************************************************
+ ** The skip list
+ *************************************************************************/
+
+/*
+ * Finds the last node before 'priority' on every level of 'queue', in
+ * preds, and the node after it, in succs, skipping deleted nodes. Returns
+ * the last deleted node seen on level 0, or NULL if there was none.
+ */
+static SkipNode *locatePreds(SkipQueue *queue, int priority, SkipNode **preds,
+                             SkipNode **succs)
+{
+  SkipNode *pred = queue->head;
+  SkipNode *deleted = NULL;
+  for (int i = SKIP_LEVELS - 1; i >= 0; i--)
+  {
+    uintptr_t next = atomic_load(&pred->next[i]);
+    bool marked = isMarked(next);
+    SkipNode *cur = unmarked(next);
+    while (cur->priority < priority ||
+           isMarked(atomic_load(&cur->next[0])) || (i == 0 && marked))
+    {
+      if (i == 0 && marked)
+      {
+        deleted = cur;
+      }
+      pred = cur;
+      next = atomic_load(&pred->next[i]);
+      marked = isMarked(next);
+      cur = unmarked(next);
+    }
+    preds[i] = pred;
+    succs[i] = cur;
+  }
+  return deleted;
+}
+
+/*
+ * Moves the upper levels of the head of 'queue' past deleted nodes.
+ */
+static void restructure(SkipQueue *queue)
+{
+  SkipNode *head = queue->head;
+  SkipNode *pred = head;
+  int i = SKIP_LEVELS - 1;
+  while (i > 0)
+  {
+    uintptr_t first = atomic_load(&head->next[i]);
+    if (!isMarked(atomic_load(&unmarked(first)->next[0])))
+    {
+      i--;
+      continue;
+    }
+    SkipNode *cur = unmarked(atomic_load(&pred->next[i]));
+    while (isMarked(atomic_load(&cur->next[0])))
+    {
+      pred = cur;
+      cur = unmarked(atomic_load(&pred->next[i]));
+    }
+    if (atomic_compare_exchange_strong(&head->next[i], &first,
+                                       atomic_load(&pred->next[i])))
+    {
+      i--;
+    }
+  }
+}
+
+/*********************************************************************
+ * Public functions
+ ********************************************************************/
+
+SkipQueue *newSkipQueue(int numWorkers)
+{
+  SkipQueue *queue = (SkipQueue *)calloc(1, sizeof(SkipQueue));
+  if (!queue)
+  {
+    return NULL;
+  }
+  queue->numWorkers = numWorkers;
+  atomic_init(&queue->epoch, QUIESCENT + 1);
+  queue->head = newSkipNode(INT_MIN, NOTHING, SKIP_LEVELS);
+  queue->tail = newSkipNode(INT_MAX, NOTHING, 1);
+  queue->workers = (SkipWorker *)aligned_alloc(
+      CACHE_LINE, numWorkers * sizeof(SkipWorker));
+  if (!queue->head || !queue->tail || !queue->workers)
+  {
+    free(queue->head);
+    free(queue->tail);
+    free(queue->workers);
+    free(queue);
+    return NULL;
+  }
+
+  for (int i = 0; i < SKIP_LEVELS; i++)
+  {
+    atomic_init(&queue->head->next[i], (uintptr_t)queue->tail);
+  }
+  atomic_init(&queue->tail->next[0], (uintptr_t)NULL);
+  memset(queue->workers, 0, numWorkers * sizeof(SkipWorker));
+  for (int w = 0; w < numWorkers; w++)
+  {
+    atomic_init(&queue->workers[w].epoch, QUIESCENT);
+    queue->workers[w].random = (uint64_t)w * 0x2545f4914f6cdd1dull + 1;
+  }
+  return queue;
+}
+
+bool skipInsert(SkipQueue *queue, int priority, int id, int workerId)
+{
+  SkipWorker *worker = &queue->workers[workerId];
+  int levels = randomLevels(worker);
+  SkipNode *node = newSkipNode(priority, id, levels);
+  if (!node)
+  {
+    return false;
+  }
+  atomic_init(&node->inserting, true);
+
+  enterEpoch(queue, worker);
+  SkipNode *preds[SKIP_LEVELS];
+  SkipNode *succs[SKIP_LEVELS];
+  SkipNode *deleted;
+  uintptr_t expected;
+  do
+  {
+    deleted = locatePreds(queue, priority, preds, succs);
+    atomic_store(&node->next[0], (uintptr_t)succs[0]);
+    expected = (uintptr_t)succs[0];
+  } while (!atomic_compare_exchange_strong(&preds[0]->next[0], &expected,
+                                           (uintptr_t)node));
+
+  // The node is in the queue; link in its upper levels, unless it or its
+  // successors get deleted meanwhile
+  int i = 1;
+  while (i < levels)
+  {
+    atomic_store(&node->next[i], (uintptr_t)succs[i]);
+    if (isMarked(atomic_load(&node->next[0])) ||
+        isMarked(atomic_load(&succs[i]->next[0])) || deleted == succs[i])
+    {
+      break;
+    }
+    expected = (uintptr_t)succs[i];
+    if (atomic_compare_exchange_strong(&preds[i]->next[i], &expected,
+                                       (uintptr_t)node))
+    {
+      i++;
+    }
+    else
+    {
+      deleted = locatePreds(queue, priority, preds, succs);
+      if (succs[0] != node)
+      {
+        break;
+      }
+    }
+  }
+  atomic_store(&node->inserting, false);
+  exitEpoch(worker);
+  return true;
+}
+
+bool skipExtractMin(SkipQueue *queue, HeapNode *node, int workerId)
+{
+  SkipWorker *worker = &queue->workers[workerId];
+  enterEpoch(queue, worker);
+
+  // Claim the first node not yet deleted, marking the pointers to every
+  // deleted one on the way
+  SkipNode *head = queue->head;
+  SkipNode *x = head;
+  SkipNode *newHead = NULL;
+  uintptr_t oldHead = atomic_load(&head->next[0]);
+  int offset = 0;
+  uintptr_t next;
+  do
+  {
+    if (unmarked(atomic_load(&x->next[0])) == queue->tail)
+    {
+      exitEpoch(worker);
+      return false;
+    }
+    if (newHead == NULL && atomic_load(&x->inserting))
+    {
+      newHead = x; // its upper levels may not be linked in yet
+    }
+    next = atomic_fetch_or(&x->next[0], 1);
+    offset++;
+    x = unmarked(next);
+  } while (isMarked(next));
+  node->priority = x->priority;
+  node->id = x->id;
+
+  // Once enough deleted nodes have piled up, unlink them all: the head then
+  // points to the last of them (or to the first still being inserted)
+  if (offset >= SKIP_DELETED_BATCH)
+  {
+    if (newHead == NULL)
+    {
+      newHead = x;
+    }
+    if (atomic_compare_exchange_strong(&head->next[0], &oldHead,
+                                       (uintptr_t)newHead | 1))
+    {
+      restructure(queue);
+      unsigned long epoch = atomic_load(&queue->epoch); // once unreachable
+      SkipNode *cur = unmarked(oldHead);
+      while (cur != newHead)
+      {
+        SkipNode *after = unmarked(atomic_load(&cur->next[0]));
+        retireNode(queue, worker, cur, epoch);
+        cur = after;
+      }
+    }
+  }
+  exitEpoch(worker);
+  return true;
+}
+
+void deleteSkipQueue(SkipQueue *queue)
+{
+  if (!queue)
+  {
+    return;
+  }
+  SkipNode *node = unmarked(atomic_load(&queue->head->next[0]));
+  while (node != queue->tail)
+  {
+    SkipNode *next = unmarked(atomic_load(&node->next[0]));
+    free(node);
+    node = next;
+  }
+  for (int w = 0; w < queue->numWorkers; w++)
+  {
+    for (int i = 0; i < 3; i++)
+    {
+      freeRetired(queue->workers[w].retired[i]);
+    }
+  }
+  free(queue->head);
+  free(queue->tail);
+  free(queue->workers);
+  free(queue);
+}
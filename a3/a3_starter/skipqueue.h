@@ -0,0 +1,68 @@
+/*
+ * Header file for our lock-free skip list priority queue.
+ *
+ * A SkipQueue is the priority queue of Linden and Jonsson ("A Skiplist-Based
+ * Concurrent Priority Queue with Minimal Memory Contention", 2013): a
+ * skip list kept in priority order, which any number of threads change with
+ * compare-and-swap alone, so a thread that is descheduled never holds the
+ * others up.
+ *
+ * skipExtractMin deletes the first node logically, by setting a mark bit in
+ * the pointer to it, with one fetch-and-or. Deleted nodes stay at the front
+ * of the list and are only unlinked, all at once, when more than
+ * SKIP_DELETED_BATCH of them have piled up, so threads rarely write to the
+ * same words at the head of the list. Unlinked nodes are freed once no
+ * thread can still be reading them (epoch based reclamation).
+ *
+ * Unlike a MinHeap, a SkipQueue keeps no map from IDs to nodes: IDs are only
+ * carried along, and priorities cannot be decreased. Parallel Dijkstra
+ * inserts a vertex again instead, and skips it when it comes out stale.
+ *
+ * Threads identify themselves by a worker ID, as the tasks of a ThreadPool
+ * do: two threads must never use the same worker ID at the same time.
+ */
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "minheap.h"
+
+#ifndef __SkipQueue_header
+#define __SkipQueue_header
+
+#define SKIP_LEVELS 32          // levels of the skip list
+#define SKIP_DELETED_BATCH 32   // deleted nodes left at the front of the list
+
+typedef struct skip_queue SkipQueue;
+
+/*
+ * Returns a newly created empty SkipQueue for workers
+ * 0, 1, ..., numWorkers-1. Returns NULL if memory could not be allocated.
+ * Precondition: numWorkers >= 1
+ */
+SkipQueue* newSkipQueue(int numWorkers);
+
+/*
+ * Inserts a node with priority 'priority' and ID 'id' into 'queue', as
+ * worker 'workerId'.
+ * Returns: true if insert was successful, false if memory could not be
+ * allocated
+ */
+bool skipInsert(SkipQueue* queue, int priority, int id, int workerId);
+
+/*
+ * Removes the node with minimum priority from 'queue' into '*node', as
+ * worker 'workerId'.
+ * Returns: true if a node was removed, false if 'queue' was empty
+ */
+bool skipExtractMin(SkipQueue* queue, HeapNode* node, int workerId);
+
+/*
+ * Frees all memory allocated for 'queue'.
+ * Precondition: no other thread is using 'queue'
+ */
+void deleteSkipQueue(SkipQueue* queue);
+
+#endif
@@ -0,0 +1,736 @@
+/*
+ * Our thread pool implementation: a work-stealing scheduler.
+ *
+ * Every worker owns a Chase-Lev deque of tasks (Chase and Lev, "Dynamic
+ * Circular Work-Stealing Deque", 2005, with the C11 memory orders of Le et
+ * al., 2013). The owner pushes and pops at the bottom without locking;
+ * thieves take from the top with a compare-and-swap, and only compete with
+ * the owner for the last task. A deque grows by copying into an array twice
+ * the size; old arrays are kept until the pool is deleted, since a thief
+ * may still be reading one.
+ *
+ * A task is a range of indices of one parallelFor (a single index for
+ * spawnTask). Before running a range, a worker pushes its upper half, then
+ * the upper half of what is left, and so on, so the oldest task in a deque
+ * is always the largest. Task structs are recycled through a free list of
+ * the worker that ran them.
+ *
+ * A worker that finds nothing to steal for a while sleeps on a condition
+ * variable; pushing a task wakes one sleeper. The thread that called
+ * parallelFor, or started a TaskGroup, is worker 0 until it returns, unless
+ * it is a worker of the pool already. A worker of another pool gets its own
+ * pool and worker ID back afterwards.
+ */
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdalign.h>
+#include <stdatomic.h>
+#include <string.h>
+
+#include "threadpool.h"
+
+#define CACHE_LINE 64
+#define INITIAL_DEQUE_TASKS 256
+#define STEAL_ROUNDS 64             // failed steals before a worker sleeps
+#define ARENA_BLOCK_BYTES (1 << 20) // smallest block of a worker's arena
+
+typedef struct task
+{
+  TaskFn fn;
+  void *context;
+  int begin;           // first index still to run
+  int end;             // one past the last index to run
+  TaskGroup *group;    // finished when every one of its tasks has
+  struct task *next;   // in a free list
+} Task;
+
+/*
+ * The circular array of a deque, and the array it replaced.
+ */
+typedef struct task_array
+{
+  int64_t capacity;  // a power of two
+  struct task_array *previous;
+  _Atomic(Task *) tasks[];
+} TaskArray;
+
+/*
+ * A worker and its deque: tasks top, ..., bottom-1 of 'array' are queued.
+ */
+typedef struct worker
+{
+  alignas(CACHE_LINE) atomic_llong top;  // taken by thieves
+  alignas(CACHE_LINE) atomic_llong bottom;
+  _Atomic(TaskArray *) array;
+  Task *freeTasks;   // Task structs ready for reuse
+  uint64_t random;   // splitmix64 state for choosing victims
+  pthread_t thread;
+} Worker;
+
+struct thread_pool
+{
+  int numThreads;           // total number of workers, including the caller
+  int numStarted;           // background threads started so far
+  Worker *workers;
+  pthread_mutex_t lock;     // guards sleeping
+  pthread_cond_t wake;      // signalled when a task is pushed
+  atomic_int numSleeping;   // workers waiting on 'wake'
+  atomic_bool stopping;     // true once deleteThreadPool has been called
+};
+
+/*
+ * Argument of workerMain.
+ */
+typedef struct worker_arg
+{
+  ThreadPool *pool;
+  int workerId;
+} WorkerArg;
+
+/*
+ * A block of a worker's arena: memory is handed out from data[used].
+ */
+typedef struct arena_block
+{
+  struct arena_block *previous;  // the block that was in use before
+  size_t size;
+  size_t used;
+  max_align_t data[];
+} ArenaBlock;
+
+/*
+ * The arena of the calling thread, and the pool it is a worker of.
+ */
+_Thread_local ArenaBlock *arenaBlock; // the block in use, or NULL
+_Thread_local ArenaBlock *arenaSpare; // a block kept for reuse, or NULL
+_Thread_local ThreadPool *currentPool;
+_Thread_local int currentWorker;
+
+/*************************************************************************
+ ** Arenas
+ *************************************************************************/
+
+/*
+ * A position in the arena of the calling thread, to go back to.
+ */
+typedef struct arena_mark
+{
+  ArenaBlock *block;
+  size_t used;
+} ArenaMark;
+
+void *taskAlloc(size_t size)
+{
+  size = (size + sizeof(max_align_t) - 1) / sizeof(max_align_t) *
+         sizeof(max_align_t);
+  ArenaBlock *block = arenaBlock;
+  if (block == NULL || block->size - block->used < size)
+  {
+    if (arenaSpare != NULL && arenaSpare->size >= size)
+    {
+      block = arenaSpare;
+      arenaSpare = NULL;
+    }
+    else
+    {
+      size_t blockSize = size > ARENA_BLOCK_BYTES ? size : ARENA_BLOCK_BYTES;
+      block = (ArenaBlock *)malloc(sizeof(ArenaBlock) + blockSize);
+      if (block == NULL)
+      {
+        return NULL;
+      }
+      block->size = blockSize;
+    }
+    block->used = 0;
+    block->previous = arenaBlock;
+    arenaBlock = block;
+  }
+  void *memory = (char *)block->data + block->used;
+  block->used += size;
+  return memory;
+}
+
+static inline ArenaMark markArena(void)
+{
+  ArenaMark mark = {arenaBlock, arenaBlock ? arenaBlock->used : 0};
+  return mark;
+}
+
+/*
+ * Frees everything allocated in the arena of the calling thread since
+ * 'mark' was taken. One block is kept for reuse.
+ */
+static void releaseArena(ArenaMark mark)
+{
+  while (arenaBlock != mark.block)
+  {
+    ArenaBlock *block = arenaBlock;
+    arenaBlock = block->previous;
+    if (arenaSpare == NULL || arenaSpare->size < block->size)
+    {
+      free(arenaSpare);
+      arenaSpare = block;
+    }
+    else
+    {
+      free(block);
+    }
+  }
+  if (arenaBlock != NULL)
+  {
+    arenaBlock->used = mark.used;
+  }
+}
+
+/*
+ * Runs fn(index, workerId, context), then frees what it took from the
+ * arena.
+ */
+static inline void runIndex(TaskFn fn, int index, int workerId, void *context)
+{
+  ArenaMark mark = markArena();
+  fn(index, workerId, context);
+  releaseArena(mark);
+}
+
+/*************************************************************************
+ ** Deques
+ *************************************************************************/
+
+static TaskArray *newTaskArray(int64_t capacity, TaskArray *previous)
+{
+  TaskArray *array = (TaskArray *)malloc(sizeof(TaskArray) +
+                                         capacity * sizeof(_Atomic(Task *)));
+  if (array == NULL)
+  {
+    printf("Memory allocation failed\n");
+    exit(EXIT_FAILURE);
+  }
+  array->capacity = capacity;
+  array->previous = previous;
+  return array;
+}
+
+/*
+ * Pushes 'task' at the bottom of the deque of worker 'workerId', and wakes
+ * a sleeping worker to steal it.
+ * Precondition: called by the owner of the deque
+ */
+static void pushTask(ThreadPool *pool, int workerId, Task *task)
+{
+  Worker *worker = &pool->workers[workerId];
+  int64_t bottom = atomic_load_explicit(&worker->bottom, memory_order_relaxed);
+  int64_t top = atomic_load_explicit(&worker->top, memory_order_acquire);
+  TaskArray *array = atomic_load_explicit(&worker->array, memory_order_relaxed);
+  if (bottom - top >= array->capacity)
+  {
+    TaskArray *grown = newTaskArray(2 * array->capacity, array);
+    for (int64_t i = top; i < bottom; i++)
+    {
+      atomic_store_explicit(
+          &grown->tasks[i & (grown->capacity - 1)],
+          atomic_load_explicit(&array->tasks[i & (array->capacity - 1)],
+                               memory_order_relaxed),
+          memory_order_relaxed);
+    }
+    atomic_store_explicit(&worker->array, grown, memory_order_release);
+    array = grown;
+  }
+  atomic_store_explicit(&array->tasks[bottom & (array->capacity - 1)], task,
+                        memory_order_relaxed);
+  atomic_store_explicit(&worker->bottom, bottom + 1, memory_order_release);
+
+  atomic_thread_fence(memory_order_seq_cst);
+  if (atomic_load(&pool->numSleeping) > 0)
+  {
+    pthread_mutex_lock(&pool->lock);
+    pthread_cond_signal(&pool->wake);
+    pthread_mutex_unlock(&pool->lock);
+  }
+}
+
+/*
+ * Pops the task at the bottom of the deque of 'worker', or returns NULL if
+ * it is empty.
+ * Precondition: called by the owner of the deque
+ */
+static Task *popTask(Worker *worker)
+{
+  int64_t bottom =
+      atomic_load_explicit(&worker->bottom, memory_order_relaxed) - 1;
+  TaskArray *array = atomic_load_explicit(&worker->array, memory_order_relaxed);
+  atomic_store_explicit(&worker->bottom, bottom, memory_order_relaxed);
+  atomic_thread_fence(memory_order_seq_cst);
+  int64_t top = atomic_load_explicit(&worker->top, memory_order_relaxed);
+
+  Task *task = NULL;
+  if (top <= bottom)
+  {
+    task = atomic_load_explicit(&array->tasks[bottom & (array->capacity - 1)],
+                                memory_order_relaxed);
+    if (top == bottom)
+    {
+      // The last task: a thief may be taking it too
+      if (!atomic_compare_exchange_strong_explicit(&worker->top, &top,
+                                                   top + 1,
+                                                   memory_order_seq_cst,
+                                                   memory_order_relaxed))
+      {
+        task = NULL;
+      }
+      atomic_store_explicit(&worker->bottom, bottom + 1, memory_order_relaxed);
+    }
+  }
+  else
+  {
+    atomic_store_explicit(&worker->bottom, bottom + 1, memory_order_relaxed);
+  }
+  return task;
+}
+
+/*
+ * Takes the task at the top of the deque of 'victim', or returns NULL if
+ * it is empty or another thread got there first.
+ */
+static Task *stealTask(Worker *victim)
+{
+  int64_t top = atomic_load_explicit(&victim->top, memory_order_acquire);
+  atomic_thread_fence(memory_order_seq_cst);
+  int64_t bottom = atomic_load_explicit(&victim->bottom, memory_order_acquire);
+  if (top >= bottom)
+  {
+    return NULL;
+  }
+  TaskArray *array = atomic_load_explicit(&victim->array, memory_order_acquire);
+  Task *task = atomic_load_explicit(&array->tasks[top & (array->capacity - 1)],
+                                    memory_order_relaxed);
+  if (!atomic_compare_exchange_strong_explicit(&victim->top, &top, top + 1,
+                                               memory_order_seq_cst,
+                                               memory_order_relaxed))
+  {
+    return NULL;
+  }
+  return task;
+}
+
+/*
+ * Returns a task from the deque of worker 'workerId' of 'pool', or else
+ * one stolen from a random other worker, or NULL if none was found.
+ */
+static Task *findTask(ThreadPool *pool, int workerId)
+{
+  Worker *worker = &pool->workers[workerId];
+  Task *task = popTask(worker);
+  if (task != NULL)
+  {
+    return task;
+  }
+  uint64_t z = (worker->random += 0x9e3779b97f4a7c15ull);
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+  z ^= z >> 31;
+  // A random worker other than this one
+  int victim = (int)(((z >> 32) * (uint64_t)(pool->numThreads - 1)) >> 32);
+  victim += victim >= workerId;
+  return stealTask(&pool->workers[victim]);
+}
+
+/*
+ * Returns true if some deque of 'pool' seems to hold a task.
+ */
+static bool anyTasks(ThreadPool *pool)
+{
+  for (int w = 0; w < pool->numThreads; w++)
+  {
+    Worker *worker = &pool->workers[w];
+    if (atomic_load(&worker->top) < atomic_load(&worker->bottom))
+    {
+      return true;
+    }
+  }
+  return false;
+}
+
+/*************************************************************************
+ ** Tasks
+ *************************************************************************/
+
+/*
+ * Returns a task of 'group' for indices begin, ..., end-1, and counts it
+ * as pending.
+ */
+static Task *newTask(ThreadPool *pool, int workerId, TaskGroup *group,
+                     TaskFn fn, void *context, int begin, int end)
+{
+  Worker *worker = &pool->workers[workerId];
+  Task *task = worker->freeTasks;
+  if (task != NULL)
+  {
+    worker->freeTasks = task->next;
+  }
+  else
+  {
+    task = (Task *)malloc(sizeof(Task));
+    if (task == NULL)
+    {
+      printf("Memory allocation failed\n");
+      exit(EXIT_FAILURE);
+    }
+  }
+  task->fn = fn;
+  task->context = context;
+  task->begin = begin;
+  task->end = end;
+  task->group = group;
+  atomic_fetch_add_explicit(&group->pending, 1, memory_order_relaxed);
+  return task;
+}
+
+/*
+ * Runs 'task' as worker 'workerId', leaving all but its first index to
+ * be stolen, in halves, and recycles it.
+ */
+static void runTask(ThreadPool *pool, int workerId, Task *task)
+{
+  while (task->end - task->begin > 1)
+  {
+    int middle = task->begin + (task->end - task->begin) / 2;
+    pushTask(pool, workerId,
+             newTask(pool, workerId, task->group, task->fn, task->context,
+                     middle, task->end));
+    task->end = middle;
+  }
+  runIndex(task->fn, task->begin, workerId, task->context);
+
+  TaskGroup *group = task->group;
+  Worker *worker = &pool->workers[workerId];
+  task->next = worker->freeTasks;
+  worker->freeTasks = task;
+  // Last, as the group may be gone as soon as nothing is pending
+  atomic_fetch_sub_explicit(&group->pending, 1, memory_order_release);
+}
+
+/*
+ * Makes the calling thread worker 0 of 'pool' if it is not one of the
+ * pool's threads, saving its pool and worker ID in 'group' for leavePool.
+ */
+static void enterPool(TaskGroup *group, ThreadPool *pool)
+{
+  group->outerPool = currentPool;
+  group->outerWorker = currentWorker;
+  if (currentPool != pool)
+  {
+    currentPool = pool;
+    currentWorker = 0;
+  }
+}
+
+/*
+ * Gives the calling thread back the pool and worker ID it had before
+ * 'group' was started.
+ */
+static void leavePool(TaskGroup *group)
+{
+  currentPool = group->outerPool;
+  currentWorker = group->outerWorker;
+}
+
+static void *workerMain(void *arg)
+{
+  WorkerArg *workerArg = (WorkerArg *)arg;
+  ThreadPool *pool = workerArg->pool;
+  int workerId = workerArg->workerId;
+  free(workerArg);
+  currentPool = pool;
+  currentWorker = workerId;
+
+  int failedSteals = 0;
+  while (!atomic_load_explicit(&pool->stopping, memory_order_acquire))
+  {
+    Task *task = findTask(pool, workerId);
+    if (task != NULL)
+    {
+      runTask(pool, workerId, task);
+      failedSteals = 0;
+    }
+    else if (++failedSteals < STEAL_ROUNDS)
+    {
+      sched_yield();
+    }
+    else
+    {
+      // Check for tasks once more after announcing the sleep, so that a
+      // push either sees the sleeper or is seen by it
+      pthread_mutex_lock(&pool->lock);
+      atomic_fetch_add(&pool->numSleeping, 1);
+      if (!atomic_load(&pool->stopping) && !anyTasks(pool))
+      {
+        pthread_cond_wait(&pool->wake, &pool->lock);
+      }
+      atomic_fetch_sub(&pool->numSleeping, 1);
+      pthread_mutex_unlock(&pool->lock);
+      failedSteals = 0;
+    }
+  }
+  currentPool = NULL;
+  releaseArena((ArenaMark){NULL, 0});
+  free(arenaSpare);
+  arenaSpare = NULL;
+  return NULL;
+}
+
+ThreadPool *newThreadPool(int numThreads)
+{
+  if (numThreads < 1)
+  {
+    return NULL;
+  }
+
+  ThreadPool *pool = (ThreadPool *)malloc(sizeof(ThreadPool));
+  if (!pool)
+  {
+    return NULL;
+  }
+  pool->workers = (Worker *)aligned_alloc(CACHE_LINE,
+                                          numThreads * sizeof(Worker));
+  if (!pool->workers)
+  {
+    free(pool);
+    return NULL;
+  }
+
+  pool->numThreads = numThreads;
+  pool->numStarted = 0;
+  atomic_init(&pool->numSleeping, 0);
+  atomic_init(&pool->stopping, false);
+  pthread_mutex_init(&pool->lock, NULL);
+  pthread_cond_init(&pool->wake, NULL);
+  for (int w = 0; w < numThreads; w++)
+  {
+    Worker *worker = &pool->workers[w];
+    atomic_init(&worker->top, 0);
+    atomic_init(&worker->bottom, 0);
+    atomic_init(&worker->array, newTaskArray(INITIAL_DEQUE_TASKS, NULL));
+    worker->freeTasks = NULL;
+    worker->random = (uint64_t)w * 0x2545f4914f6cdd1dull + 1;
+  }
+
+  for (int w = 1; w < numThreads; w++)
+  {
+    WorkerArg *arg = (WorkerArg *)malloc(sizeof(WorkerArg));
+    if (!arg)
+    {
+      deleteThreadPool(pool);
+      return NULL;
+    }
+    arg->pool = pool;
+    arg->workerId = w;
+    if (pthread_create(&pool->workers[w].thread, NULL, workerMain, arg) != 0)
+    {
+      free(arg);
+      deleteThreadPool(pool);
+      return NULL;
+    }
+    pool->numStarted++;
+  }
+  return pool;
+}
+
+int poolSize(ThreadPool *pool)
+{
+  return pool ? pool->numThreads : 1;
+}
+
+void startTaskGroup(TaskGroup *group, ThreadPool *pool)
+{
+  group->pool = pool && pool->numThreads > 1 ? pool : NULL;
+  atomic_init(&group->pending, 0);
+  if (group->pool)
+  {
+    enterPool(group, group->pool);
+  }
+}
+
+void spawnTask(TaskGroup *group, TaskFn fn, int index, void *context)
+{
+  ThreadPool *pool = group->pool;
+  if (pool == NULL)
+  {
+    runIndex(fn, index, 0, context);
+    return;
+  }
+  pushTask(pool, currentWorker,
+           newTask(pool, currentWorker, group, fn, context, index,
+                   index + 1));
+}
+
+void waitTaskGroup(TaskGroup *group)
+{
+  ThreadPool *pool = group->pool;
+  if (pool == NULL)
+  {
+    return;
+  }
+  int workerId = currentWorker;
+  while (atomic_load_explicit(&group->pending, memory_order_acquire) > 0)
+  {
+    Task *task = findTask(pool, workerId);
+    if (task != NULL)
+    {
+      runTask(pool, workerId, task);
+    }
+    else
+    {
+      sched_yield(); // the rest is being run by thieves
+    }
+  }
+  leavePool(group);
+}
+
+void parallelFor(ThreadPool *pool, int numTasks, TaskFn fn, void *context)
+{
+  if (pool == NULL || pool->numThreads == 1 || numTasks <= 1)
+  {
+    int workerId = pool != NULL && currentPool == pool ? currentWorker : 0;
+    for (int i = 0; i < numTasks; i++)
+    {
+      runIndex(fn, i, workerId, context);
+    }
+    return;
+  }
+
+  TaskGroup group;
+  startTaskGroup(&group, pool);
+  runTask(pool, currentWorker,
+          newTask(pool, currentWorker, &group, fn, context, 0, numTasks));
+  waitTaskGroup(&group);
+}
+
+/*
+ * A prefix sum split into equal blocks, one task per block.
+ */
+typedef struct prefix_sum
+{
+  int64_t *values;     // the array being summed
+  int count;           // number of entries in 'values'
+  int blockSize;       // entries per block; the last block may be shorter
+  int64_t *blockSums;  // sum of each block, then the sum before each block
+} PrefixSum;
+
+/*
+ * Task 'index' of the first pass of parallelPrefixSum: sums one block.
+ */
+static void sumBlock(int index, int workerId, void *context)
+{
+  (void)workerId;
+  PrefixSum *sum = (PrefixSum *)context;
+  int start = index * sum->blockSize;
+  int end = start + sum->blockSize < sum->count ? start + sum->blockSize
+                                                 : sum->count;
+  int64_t total = 0;
+  for (int i = start; i < end; i++)
+  {
+    total += sum->values[i];
+  }
+  sum->blockSums[index] = total;
+}
+
+/*
+ * Task 'index' of the second pass of parallelPrefixSum: scans one block,
+ * starting from the sum of all blocks before it.
+ */
+static void scanBlock(int index, int workerId, void *context)
+{
+  (void)workerId;
+  PrefixSum *sum = (PrefixSum *)context;
+  int start = index * sum->blockSize;
+  int end = start + sum->blockSize < sum->count ? start + sum->blockSize
+                                                 : sum->count;
+  int64_t running = sum->blockSums[index];
+  for (int i = start; i < end; i++)
+  {
+    int64_t value = sum->values[i];
+    sum->values[i] = running;
+    running += value;
+  }
+}
+
+int64_t parallelPrefixSum(ThreadPool *pool, int64_t *values, int count)
+{
+  int numBlocks = 4 * poolSize(pool);
+  if (count < numBlocks * 4096)
+  {
+    numBlocks = 1; // not worth waking the workers
+  }
+  int64_t single = 0;
+  int64_t *blockSums =
+      numBlocks > 1 ? (int64_t *)malloc(numBlocks * sizeof(int64_t)) : &single;
+  if (blockSums == NULL)
+  {
+    numBlocks = 1;
+    blockSums = &single;
+  }
+
+  PrefixSum sum = {values, count, (count + numBlocks - 1) / numBlocks,
+                   blockSums};
+  if (numBlocks > 1)
+  {
+    parallelFor(pool, numBlocks, sumBlock, &sum);
+  }
+  else
+  {
+    sumBlock(0, 0, &sum);
+  }
+  int64_t total = 0;
+  for (int b = 0; b < numBlocks; b++)
+  {
+    int64_t blockTotal = blockSums[b];
+    blockSums[b] = total;
+    total += blockTotal;
+  }
+  parallelFor(pool, numBlocks, scanBlock, &sum);
+
+  if (blockSums != &single)
+  {
+    free(blockSums);
+  }
+  return total;
+}
+
+void deleteThreadPool(ThreadPool *pool)
+{
+  if (pool)
+  {
+    pthread_mutex_lock(&pool->lock);
+    atomic_store(&pool->stopping, true);
+    pthread_cond_broadcast(&pool->wake);
+    pthread_mutex_unlock(&pool->lock);
+
+    for (int w = 1; w <= pool->numStarted; w++)
+    {
+      pthread_join(pool->workers[w].thread, NULL);
+    }
+    for (int w = 0; w < pool->numThreads; w++)
+    {
+      TaskArray *array = atomic_load(&pool->workers[w].array);
+      while (array)
+      {
+        TaskArray *previous = array->previous;
+        free(array);
+        array = previous;
+      }
+      Task *task = pool->workers[w].freeTasks;
+      while (task)
+      {
+        Task *next = task->next;
+        free(task);
+        task = next;
+      }
+    }
+    pthread_cond_destroy(&pool->wake);
+    pthread_mutex_destroy(&pool->lock);
+    free(pool->workers);
+    free(pool);
+  }
+}
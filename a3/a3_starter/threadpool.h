@@ -0,0 +1,123 @@
+/*
+ * Header file for our thread pool.
+ *
+ * A ThreadPool owns a fixed set of worker threads that are shared by all
+ * parallel routines (e.g. batch Dijkstra), so that each algorithm does not
+ * spin up its own threads.
+ *
+ * Work is scheduled by work stealing: every worker keeps the tasks it
+ * creates in a deque of its own, runs them newest first, and when it runs
+ * out, takes the oldest task of a random other worker. parallelFor splits
+ * its range in halves lazily, so a worker that steals takes the largest
+ * piece left. A task may itself call parallelFor or spawn tasks: a worker
+ * that waits for tasks to finish runs other tasks meanwhile, so nested
+ * parallelism neither deadlocks nor starts more threads.
+ *
+ * Each worker also has an arena of scratch memory for the tasks it runs
+ * (see taskAlloc), so tasks need neither malloc nor per-worker buffers
+ * sized up front.
+ */
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#ifndef __ThreadPool_header
+#define __ThreadPool_header
+
+/*
+ * A task run by parallelFor: 'index' is the task number in
+ * 0, 1, ..., numTasks-1, and 'workerId' identifies the worker running it,
+ * 0 <= workerId < poolSize(pool). Two tasks never run in parallel on the
+ * same 'workerId'. But while a task waits in a nested parallelFor or
+ * waitTaskGroup, its thread runs other tasks with the same 'workerId', so
+ * scratch space indexed by it must not be relied on across such a call;
+ * taskAlloc gives each task memory of its own.
+ */
+typedef void (*TaskFn)(int index, int workerId, void* context);
+
+typedef struct thread_pool ThreadPool;
+
+/*
+ * Tasks spawned together, to be waited for together (fork/join). A
+ * TaskGroup is usually a local variable of the function that spawns the
+ * tasks.
+ */
+typedef struct task_group
+{
+  ThreadPool* pool;
+  atomic_int pending;      // spawned tasks that have not finished yet
+  ThreadPool* outerPool;   // pool and worker ID of the starting thread
+  int outerWorker;         //   before startTaskGroup
+} TaskGroup;
+
+/*
+ * Returns a newly created ThreadPool with 'numThreads' workers in total.
+ * The thread calling parallelFor counts as worker 0, so 'numThreads' - 1
+ * background threads are started.
+ * Returns NULL if the threads could not be created.
+ * Precondition: numThreads >= 1
+ */
+ThreadPool* newThreadPool(int numThreads);
+
+/*
+ * Returns the number of workers in 'pool', or 1 if 'pool' is NULL.
+ */
+int poolSize(ThreadPool* pool);
+
+/*
+ * Runs fn(i, workerId, context) for every i in 0, 1, ..., numTasks-1 on the
+ * workers of 'pool' and returns once all of them have finished.
+ * If 'pool' is NULL, all tasks run on the calling thread as worker 0.
+ * Every task is scheduled on its own, so callers should make each one a
+ * chunk of work rather than a single element.
+ * Precondition: at most one thread that is not a worker of 'pool' uses it
+ *               at a time (it runs tasks as worker 0)
+ */
+void parallelFor(ThreadPool* pool, int numTasks, TaskFn fn, void* context);
+
+/*
+ * Starts an empty TaskGroup 'group' on 'pool', which may be NULL.
+ * Precondition: as for parallelFor
+ */
+void startTaskGroup(TaskGroup* group, ThreadPool* pool);
+
+/*
+ * Has fn(index, workerId, context) run on some worker of the pool of
+ * 'group', possibly right away on the calling thread.
+ * Precondition: called by the thread that started 'group', or by a task of
+ *               'group'
+ */
+void spawnTask(TaskGroup* group, TaskFn fn, int index, void* context);
+
+/*
+ * Returns once every task spawned in 'group', including those spawned by
+ * its tasks, has finished. The calling thread runs tasks meanwhile.
+ * Precondition: called by the thread that started 'group'
+ */
+void waitTaskGroup(TaskGroup* group);
+
+/*
+ * Returns 'size' bytes of memory, aligned for any type, from the arena of
+ * the worker running the calling task, or NULL if memory could not be
+ * allocated. The memory is only valid until the task returns.
+ * Precondition: called by a task run by parallelFor or spawnTask
+ */
+void* taskAlloc(size_t size);
+
+/*
+ * Replaces each of the 'count' entries of 'values' by the sum of the entries
+ * before it (an exclusive prefix sum), using the workers of 'pool', and
+ * returns the sum of all entries.
+ */
+int64_t parallelPrefixSum(ThreadPool* pool, int64_t* values, int count);
+
+/*
+ * Stops all workers of 'pool' and frees its memory.
+ */
+void deleteThreadPool(ThreadPool* pool);
+
+#endif
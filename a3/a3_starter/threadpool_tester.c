@@ -0,0 +1,533 @@
+/*
+ *  Randomized testing of our ThreadPool (see threadpool.h).
+ *
+ *  Runs parallelFor nested several levels deep on one pool, tasks of one
+ *  pool that run parallelFor on another and then on their own again, and
+ *  trees of tasks that spawn their children into one TaskGroup, some of
+ *  them starting and waiting for a TaskGroup of their own. Every task must
+ *  run exactly once, with a worker ID below the pool size that no other
+ *  thread is using at the same time, and the memory each task takes with
+ *  taskAlloc must keep its contents across the nested calls it makes.
+ *  parallelPrefixSum must match a serial prefix sum. Everything runs with
+ *  no pool, a pool of one worker, and pools of several. Prints the first
+ *  mismatches found and exits with a non-zero status if there were any.
+ *
+ *  ---------------------------------------------------------------------------
+ *   Compile:
+ *   gcc -Wall -Werror -pthread threadpool.c threadpool_tester.c \
+ *       -o threadpool_tester
+ *
+ *   Run:
+ *   ./threadpool_tester [seed]
+ *
+ *   Also worth running built with -fsanitize=thread and with
+ *   -fsanitize=address,undefined.
+ *  ---------------------------------------------------------------------------
+ */
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "threadpool.h"
+
+#define MAX_WORKERS 8      // largest pool this tester makes
+#define MAX_TASK_BYTES 600 // taskAlloc sizes are mostly below this
+#define SUBGROUP_EVERY 97  // tree nodes that start a TaskGroup of their own
+#define SUBGROUP_TASKS 5   // tasks each such TaskGroup spawns
+#define MAX_REPORTED 10    // mismatches printed before only counting them
+
+uint64_t seed;
+atomic_int numMismatches;
+atomic_int numThreads;             // threads that have asked for a number
+_Thread_local int threadNumber;    // 1, 2, ... once asked for, else 0
+
+/*
+ * Returns a pseudo-random number in 0, 1, ..., bound-1 (splitmix64), and
+ * advances 'state'.
+ */
+int randomBelow(uint64_t* state, int bound)
+{
+  uint64_t z = (*state += 0x9e3779b97f4a7c15ULL);
+  z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+  z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+  z ^= z >> 31;
+  return (int)((z >> 33) % (uint64_t)bound);
+}
+
+/*
+ * Prints a mismatch found in test 'name', and counts it.
+ */
+void reportMismatch(const char* name, const char* what, int index,
+                    int64_t expected, int64_t actual)
+{
+  if (atomic_fetch_add(&numMismatches, 1) < MAX_REPORTED)
+  {
+    printf("%s: %s %d is %lld, expected %lld\n", name, what, index,
+           (long long)actual, (long long)expected);
+  }
+}
+
+/*
+ * Returns a number identifying the calling thread, 1 or more.
+ */
+int currentThread(void)
+{
+  if (threadNumber == 0)
+  {
+    threadNumber = atomic_fetch_add(&numThreads, 1) + 1;
+  }
+  return threadNumber;
+}
+
+/*
+ * The worker IDs of a pool in use: owners[w] is the number of the thread
+ * running a task as worker w, or 0.
+ */
+typedef struct owners
+{
+  ThreadPool* pool;
+  atomic_int owners[MAX_WORKERS];
+} Owners;
+
+/*
+ * Checks 'workerId', given to a task of test 'name', and claims it for the
+ * calling thread. Returns the previous owner, for leaveWorker.
+ */
+int enterWorker(const char* name, Owners* owners, int workerId)
+{
+  if (workerId < 0 || workerId >= poolSize(owners->pool))
+  {
+    reportMismatch(name, "worker ID of a task, pool size", poolSize(
+                   owners->pool), 0, workerId);
+    return 0;
+  }
+  int me = currentThread();
+  int previous = atomic_exchange(&owners->owners[workerId], me);
+  if (previous != 0 && previous != me)
+  {
+    reportMismatch(name, "thread also running as worker", workerId, previous,
+                   me);
+  }
+  return previous;
+}
+
+/*
+ * Gives 'workerId' back to the owner it had before enterWorker.
+ */
+void leaveWorker(Owners* owners, int workerId, int previous)
+{
+  if (workerId >= 0 && workerId < poolSize(owners->pool))
+  {
+    atomic_store(&owners->owners[workerId], previous);
+  }
+}
+
+/*
+ * Takes a random amount of memory with taskAlloc for task 'index', fills
+ * it with a pattern of 'index', and sets 'size' to its size.
+ */
+unsigned char* takeMemory(const char* name, int index, size_t* size)
+{
+  uint64_t state = seed ^ (uint64_t)index * 0x2545f4914f6cdd1dULL;
+  // Sometimes more than a block of the arena
+  *size = randomBelow(&state, 500) == 0 ? (3 << 19)
+                                        : randomBelow(&state, MAX_TASK_BYTES);
+  unsigned char* memory = (unsigned char*)taskAlloc(*size);
+  if (memory == NULL)
+  {
+    printf("Memory allocation failed\n");
+    exit(EXIT_FAILURE);
+  }
+  if ((uintptr_t)memory % _Alignof(max_align_t) != 0)
+  {
+    reportMismatch(name, "alignment of the memory of task", index, 0,
+                   (int64_t)((uintptr_t)memory % _Alignof(max_align_t)));
+  }
+  memset(memory, index & 0xff, *size);
+  return memory;
+}
+
+/*
+ * Checks that 'memory' still holds the pattern takeMemory wrote.
+ */
+void checkMemory(const char* name, int index, unsigned char* memory,
+                 size_t size)
+{
+  for (size_t i = 0; i < size; i++)
+  {
+    if (memory[i] != (index & 0xff))
+    {
+      reportMismatch(name, "byte of the memory of task", index, index & 0xff,
+                     memory[i]);
+      return;
+    }
+  }
+}
+
+/***** Nested parallelFor ***************************************************/
+
+/*
+ * What all levels of a nested parallelFor test share. The leaves count how
+ * often they ran in 'counts'.
+ */
+typedef struct nest_test
+{
+  const char* name;
+  Owners* owners;        // of the pool every level runs on
+  int fanout;            // tasks per parallelFor
+  atomic_int* counts;    // fanout^depth entries
+} NestTest;
+
+/*
+ * One parallelFor of a nested test: task i runs, 'depth' levels above the
+ * leaves, the tasks prefix * fanout + i of the level below.
+ */
+typedef struct nest
+{
+  NestTest* test;
+  int prefix;
+  int depth;
+} Nest;
+
+void runNest(int index, int workerId, void* context)
+{
+  Nest* nest = (Nest*)context;
+  NestTest* test = nest->test;
+  int previous = enterWorker(test->name, test->owners, workerId);
+  int task = nest->prefix * test->fanout + index;
+  size_t size;
+  unsigned char* memory = takeMemory(test->name, task, &size);
+
+  if (nest->depth == 1)
+  {
+    atomic_fetch_add(&test->counts[task], 1);
+  }
+  else
+  {
+    // While this task waits, only its own thread may run tasks as
+    // 'workerId'
+    Nest inner = {test, task, nest->depth - 1};
+    parallelFor(test->owners->pool, test->fanout, runNest, &inner);
+  }
+  checkMemory(test->name, task, memory, size);
+  leaveWorker(test->owners, workerId, previous);
+}
+
+/*
+ * Checks that each of the 'numCounts' entries of 'counts' is 1, and resets
+ * them to 0.
+ */
+void checkCounts(const char* name, const char* what, atomic_int* counts,
+                 int numCounts)
+{
+  for (int i = 0; i < numCounts; i++)
+  {
+    int count = atomic_exchange(&counts[i], 0);
+    if (count != 1)
+    {
+      reportMismatch(name, what, i, 1, count);
+    }
+  }
+}
+
+/*
+ * Runs parallelFor on 'pool' nested 'depth' levels deep, with 'fanout'
+ * tasks per call.
+ */
+void testNested(const char* name, ThreadPool* pool, int depth, int fanout)
+{
+  int numLeaves = 1;
+  for (int d = 0; d < depth; d++)
+  {
+    numLeaves *= fanout;
+  }
+  atomic_int* counts = (atomic_int*)calloc(numLeaves + 1, sizeof(atomic_int));
+  Owners owners = {pool};
+  if (counts == NULL)
+  {
+    printf("Memory allocation failed\n");
+    exit(EXIT_FAILURE);
+  }
+  NestTest test = {name, &owners, fanout, counts};
+  Nest top = {&test, 0, depth};
+  parallelFor(pool, fanout, runNest, &top);
+  checkCounts(name, "runs of leaf task", counts, numLeaves);
+  printf("%s: %d levels of %d tasks: %d mismatches so far\n", name, depth,
+         fanout, atomic_load(&numMismatches));
+  free(counts);
+}
+
+/***** Nesting across pools *************************************************/
+
+/*
+ * A test whose outer tasks run parallelFor on the inner pool, one at a time
+ * as threadpool.h requires, and then on the outer pool.
+ */
+typedef struct cross_test
+{
+  const char* name;
+  Owners* outer;
+  Owners* inner;
+  pthread_mutex_t innerLock;  // held by the outer task using the inner pool
+  int fanout;                 // tasks per nested parallelFor
+  atomic_int* innerCounts;    // runs of each inner task
+  atomic_int* outerCounts;    // runs of each nested task on the outer pool
+} CrossTest;
+
+/*
+ * Context of the nested parallelFor calls of outer task 'prefix'.
+ */
+typedef struct cross_call
+{
+  CrossTest* test;
+  int prefix;
+  bool inner;  // on the inner pool, else on the outer pool
+} CrossCall;
+
+void runCrossLeaf(int index, int workerId, void* context)
+{
+  CrossCall* call = (CrossCall*)context;
+  CrossTest* test = call->test;
+  Owners* owners = call->inner ? test->inner : test->outer;
+  int previous = enterWorker(test->name, owners, workerId);
+  int task = call->prefix * test->fanout + index;
+  atomic_fetch_add(call->inner ? &test->innerCounts[task]
+                               : &test->outerCounts[task], 1);
+  leaveWorker(owners, workerId, previous);
+}
+
+void runCrossOuter(int index, int workerId, void* context)
+{
+  CrossTest* test = (CrossTest*)context;
+  size_t size;
+  unsigned char* memory = takeMemory(test->name, index, &size);
+  int previous = enterWorker(test->name, test->outer, workerId);
+
+  pthread_mutex_lock(&test->innerLock);
+  CrossCall inner = {test, index, true};
+  parallelFor(test->inner->pool, test->fanout, runCrossLeaf, &inner);
+  pthread_mutex_unlock(&test->innerLock);
+
+  // Back on the outer pool, its tasks must run as 'workerId' on this thread
+  CrossCall outer = {test, index, false};
+  parallelFor(test->outer->pool, test->fanout, runCrossLeaf, &outer);
+  checkMemory(test->name, index, memory, size);
+  leaveWorker(test->outer, workerId, previous);
+}
+
+/*
+ * Runs 'numTasks' tasks on 'outerPool' that each run 'fanout' tasks on
+ * 'innerPool' and then 'fanout' on 'outerPool'.
+ */
+void testCrossPool(const char* name, ThreadPool* outerPool,
+                   ThreadPool* innerPool, int numTasks, int fanout)
+{
+  Owners outer = {outerPool};
+  Owners inner = {innerPool};
+  CrossTest test = {name, &outer, &inner, PTHREAD_MUTEX_INITIALIZER, fanout};
+  test.innerCounts = (atomic_int*)calloc(numTasks * fanout, sizeof(atomic_int));
+  test.outerCounts = (atomic_int*)calloc(numTasks * fanout, sizeof(atomic_int));
+  if (test.innerCounts == NULL || test.outerCounts == NULL)
+  {
+    printf("Memory allocation failed\n");
+    exit(EXIT_FAILURE);
+  }
+  parallelFor(outerPool, numTasks, runCrossOuter, &test);
+  checkCounts(name, "runs of inner pool task", test.innerCounts,
+              numTasks * fanout);
+  checkCounts(name, "runs of outer pool task", test.outerCounts,
+              numTasks * fanout);
+
+  // The calling thread too may use one pool after the other
+  CrossCall call = {&test, 0, true};
+  parallelFor(innerPool, fanout, runCrossLeaf, &call);
+  call.inner = false;
+  parallelFor(outerPool, fanout, runCrossLeaf, &call);
+  checkCounts(name, "runs of inner pool task", test.innerCounts, fanout);
+  checkCounts(name, "runs of outer pool task", test.outerCounts, fanout);
+
+  printf("%s: %d tasks: %d mismatches so far\n", name, numTasks,
+         atomic_load(&numMismatches));
+  pthread_mutex_destroy(&test.innerLock);
+  free(test.outerCounts);
+  free(test.innerCounts);
+}
+
+/***** Task trees ***********************************************************/
+
+/*
+ * A binary tree of 'numNodes' tasks: node i spawns nodes 2i+1 and 2i+2
+ * into 'group'. Every SUBGROUP_EVERY-th node also starts a TaskGroup of its
+ * own and waits for the SUBGROUP_TASKS tasks it spawns there.
+ */
+typedef struct tree_test
+{
+  const char* name;
+  Owners* owners;
+  TaskGroup* group;
+  int numNodes;
+  atomic_int* visits;      // runs of each node
+  atomic_int* subVisits;   // runs of each task of a node's own TaskGroup
+} TreeTest;
+
+void visitSubTask(int index, int workerId, void* context)
+{
+  TreeTest* test = (TreeTest*)context;
+  int previous = enterWorker(test->name, test->owners, workerId);
+  atomic_fetch_add(&test->subVisits[index], 1);
+  leaveWorker(test->owners, workerId, previous);
+}
+
+void visitNode(int index, int workerId, void* context)
+{
+  TreeTest* test = (TreeTest*)context;
+  int previous = enterWorker(test->name, test->owners, workerId);
+  atomic_fetch_add(&test->visits[index], 1);
+  for (int child = 2 * index + 1; child <= 2 * index + 2; child++)
+  {
+    if (child < test->numNodes)
+    {
+      spawnTask(test->group, visitNode, child, test);
+    }
+  }
+  leaveWorker(test->owners, workerId, previous);
+
+  if (index % SUBGROUP_EVERY == 0)
+  {
+    size_t size;
+    unsigned char* memory = takeMemory(test->name, index, &size);
+    TaskGroup group;
+    startTaskGroup(&group, test->owners->pool);
+    for (int i = 0; i < SUBGROUP_TASKS; i++)
+    {
+      spawnTask(&group, visitSubTask,
+                index / SUBGROUP_EVERY * SUBGROUP_TASKS + i, test);
+    }
+    waitTaskGroup(&group);
+    checkMemory(test->name, index, memory, size);
+  }
+}
+
+/*
+ * Runs a tree of 'numNodes' spawned tasks on 'pool'.
+ */
+void testTree(const char* name, ThreadPool* pool, int numNodes)
+{
+  int numSubTasks = (numNodes + SUBGROUP_EVERY - 1) / SUBGROUP_EVERY *
+                    SUBGROUP_TASKS;
+  Owners owners = {pool};
+  TaskGroup group;
+  TreeTest test = {name, &owners, &group, numNodes};
+  test.visits = (atomic_int*)calloc(numNodes, sizeof(atomic_int));
+  test.subVisits = (atomic_int*)calloc(numSubTasks, sizeof(atomic_int));
+  if (test.visits == NULL || test.subVisits == NULL)
+  {
+    printf("Memory allocation failed\n");
+    exit(EXIT_FAILURE);
+  }
+  startTaskGroup(&group, pool);
+  spawnTask(&group, visitNode, 0, &test);
+  waitTaskGroup(&group);
+  checkCounts(name, "runs of tree node", test.visits, numNodes);
+  checkCounts(name, "runs of TaskGroup task", test.subVisits, numSubTasks);
+  printf("%s: %d nodes: %d mismatches so far\n", name, numNodes,
+         atomic_load(&numMismatches));
+  free(test.subVisits);
+  free(test.visits);
+}
+
+/***** Prefix sums **********************************************************/
+
+/*
+ * Checks parallelPrefixSum on 'pool' against a serial sum of 'count'
+ * random values.
+ */
+void testPrefixSum(const char* name, ThreadPool* pool, int count,
+                   uint64_t* state)
+{
+  int64_t* values = (int64_t*)malloc((count + 1) * sizeof(int64_t));
+  int64_t* expected = (int64_t*)malloc((count + 1) * sizeof(int64_t));
+  if (values == NULL || expected == NULL)
+  {
+    printf("Memory allocation failed\n");
+    exit(EXIT_FAILURE);
+  }
+  int64_t total = 0;
+  for (int i = 0; i < count; i++)
+  {
+    values[i] = ((int64_t)randomBelow(state, 1 << 30) << 10) - (1LL << 39);
+    expected[i] = total;
+    total += values[i];
+  }
+  int64_t actual = parallelPrefixSum(pool, values, count);
+  if (actual != total)
+  {
+    reportMismatch(name, "prefix sum total, of entries", count, total,
+                   actual);
+  }
+  for (int i = 0; i < count; i++)
+  {
+    if (values[i] != expected[i])
+    {
+      reportMismatch(name, "prefix sum entry", i, expected[i], values[i]);
+      break;
+    }
+  }
+  free(expected);
+  free(values);
+}
+
+int main(int argc, char* argv[])
+{
+  seed = argc > 1 ? strtoull(argv[1], NULL, 10) : 1;
+  uint64_t state = seed;
+
+  ThreadPool* single = newThreadPool(1);
+  ThreadPool* pool = newThreadPool(4);
+  ThreadPool* other = newThreadPool(3);
+  if (single == NULL || pool == NULL || other == NULL)
+  {
+    printf("Memory allocation failed\n");
+    exit(EXIT_FAILURE);
+  }
+  const char* names[] = {"no pool", "one worker", "4 workers"};
+  ThreadPool* pools[] = {NULL, single, pool};
+
+  for (int p = 0; p < 3; p++)
+  {
+    testNested(names[p], pools[p], 1, 0);
+    testNested(names[p], pools[p], 1, 1);
+    testNested(names[p], pools[p], 1, 1000);
+    testNested(names[p], pools[p], 4, 9);
+    testNested(names[p], pools[p], 8, 3);
+    testTree(names[p], pools[p], 1);
+    testTree(names[p], pools[p], 20000);
+    int counts[] = {0, 1, 4095, 4 * 4 * 4096 + 1, (1 << 20) + 7};
+    for (int c = 0; c < 5; c++)
+    {
+      testPrefixSum(names[p], pools[p], counts[c], &state);
+    }
+    printf("%s: prefix sums: %d mismatches so far\n", names[p],
+           atomic_load(&numMismatches));
+  }
+  testCrossPool("4 workers, then 3", pool, other, 200, 20);
+  testCrossPool("3 workers, then 4", other, pool, 200, 20);
+  testCrossPool("4 workers, then no pool", pool, NULL, 50, 5);
+  testCrossPool("one worker, then 4", single, pool, 50, 5);
+
+  deleteThreadPool(other);
+  deleteThreadPool(pool);
+  deleteThreadPool(single);
+  if (atomic_load(&numMismatches) > 0)
+  {
+    printf("FAILED: %d mismatches\n", atomic_load(&numMismatches));
+    return EXIT_FAILURE;
+  }
+  printf("All ThreadPool tasks ran exactly once, with valid worker IDs.\n");
+  return EXIT_SUCCESS;
+}